@@ -0,0 +1,422 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+
+#ifdef __linux__
+  #include <linux/perf_event.h>
+  #include <sys/syscall.h>
+  #include <sys/ioctl.h>
+#endif
+
+#include "agg.h"
+
+
+// Optimisation level of the benchmark build, as reported in the output.
+#ifndef BENCH_OPT
+  #define BENCH_OPT "unknown"
+#endif
+
+// Define a type-correct constant for ten.
+#define AGGSTAT_10_0 AGGSTAT_NUM(10, 0, +, 0)
+
+/// Benchmarked aggregate function.
+struct function {
+  const char* f_nam; ///< Name.
+  uint8_t     f_fnc; ///< Aggregate function.
+  AGGSTAT_FLT f_par; ///< Aggregate function parameter.
+};
+
+/// Hardware performance counters.
+struct counters {
+  int      c_fds[4]; ///< File descriptors of the events (leader first).
+  uint64_t c_val[4]; ///< Values of the events: cycles, instructions, branch misses, cache misses.
+  bool     c_use;    ///< Whether the counters are available.
+};
+
+/// Settings.
+struct settings {
+  uintmax_t   s_rep; ///< Repetitions of each measurement.
+  const char* s_fnc; ///< Name of the only function to measure (optional).
+  bool        s_hwc; ///< Read hardware performance counters.
+  bool        s_hdr; ///< Print the header line.
+};
+
+/// All benchmarked functions.
+static const struct function fncs[] = {
+  {"fst",       AGGSTAT_FNC_FST, AGGSTAT_0_0 },
+  {"lst",       AGGSTAT_FNC_LST, AGGSTAT_0_0 },
+  {"cnt",       AGGSTAT_FNC_CNT, AGGSTAT_0_0 },
+  {"sum",       AGGSTAT_FNC_SUM, AGGSTAT_0_0 },
+  {"min",       AGGSTAT_FNC_MIN, AGGSTAT_0_0 },
+  {"max",       AGGSTAT_FNC_MAX, AGGSTAT_0_0 },
+  {"avg",       AGGSTAT_FNC_AVG, AGGSTAT_0_0 },
+  {"var",       AGGSTAT_FNC_VAR, AGGSTAT_0_0 },
+  {"dev",       AGGSTAT_FNC_DEV, AGGSTAT_0_0 },
+  {"skw",       AGGSTAT_FNC_SKW, AGGSTAT_0_0 },
+  {"krt",       AGGSTAT_FNC_KRT, AGGSTAT_0_0 },
+  {"qnt(0.1)",  AGGSTAT_FNC_QNT, AGGSTAT_0_1 },
+  {"qnt(0.75)", AGGSTAT_FNC_QNT, AGGSTAT_0_75},
+  {"qnt(0.9)",  AGGSTAT_FNC_QNT, AGGSTAT_0_9 },
+  {"qnt(0.99)", AGGSTAT_FNC_QNT, AGGSTAT_0_99},
+  {"med",       AGGSTAT_FNC_MED, AGGSTAT_0_0 },
+  {"twa",       AGGSTAT_FNC_TWA, AGGSTAT_0_0 },
+  {"itg",       AGGSTAT_FNC_ITG, AGGSTAT_0_0 },
+  {"rat",       AGGSTAT_FNC_RAT, AGGSTAT_0_0 }
+};
+
+/// Input lengths of the streams.
+static const uint64_t lens[] = {1000, 10000, 100000, 1000000};
+
+/// Generate a next random number from the inclusive interval (0.0, 10.0).
+/// @return random number
+static AGGSTAT_FLT
+random_number(void)
+{
+  static uint32_t num = 77;
+  uint32_t per;
+
+  per = ((uint32_t)1 << 31) - 1;
+  num = (num * 214013 + 2531011) & per;
+
+  return (AGGSTAT_FLT)num / (AGGSTAT_FLT)per * AGGSTAT_10_0;
+}
+
+/// Obtain the current time with minimal external effects.
+/// @return nanoseconds
+static uint64_t
+time_now(void)
+{
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/// Open the hardware performance counters for the calling thread.
+///
+/// The counters are optional: in case the kernel or the environment does not permit their use, the
+/// benchmark continues and reports empty counter fields.
+///
+/// @param[out] ctr counters
+static void
+counters_open(struct counters* ctr)
+{
+#ifdef __linux__
+  struct perf_event_attr attr;
+  uint64_t               cfg[4];
+  int                    grp;
+  int                    idx;
+
+  cfg[0] = PERF_COUNT_HW_CPU_CYCLES;
+  cfg[1] = PERF_COUNT_HW_INSTRUCTIONS;
+  cfg[2] = PERF_COUNT_HW_BRANCH_MISSES;
+  cfg[3] = PERF_COUNT_HW_CACHE_MISSES;
+
+  grp = -1;
+  for (idx = 0; idx < 4; idx += 1) {
+    (void)memset(&attr, 0, sizeof(attr));
+    attr.type           = PERF_TYPE_HARDWARE;
+    attr.size           = sizeof(attr);
+    attr.config         = cfg[idx];
+    attr.disabled       = (grp == -1);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_GROUP;
+
+    ctr->c_fds[idx] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, grp, 0);
+    if (ctr->c_fds[idx] == -1) {
+      (void)fprintf(stderr, "perf_event_open: %s, hardware counters disabled\n", strerror(errno));
+      while (idx > 0) {
+        idx -= 1;
+        (void)close(ctr->c_fds[idx]);
+      }
+
+      ctr->c_use = false;
+      return;
+    }
+
+    if (grp == -1) {
+      grp = ctr->c_fds[0];
+    }
+  }
+
+  ctr->c_use = true;
+#else
+  ctr->c_use = false;
+#endif
+}
+
+/// Reset and start the hardware performance counters.
+///
+/// @param[in] ctr counters
+static void
+counters_start(struct counters* ctr)
+{
+#ifdef __linux__
+  if (ctr->c_use == true) {
+    (void)ioctl(ctr->c_fds[0], PERF_EVENT_IOC_RESET,   PERF_IOC_FLAG_GROUP);
+    (void)ioctl(ctr->c_fds[0], PERF_EVENT_IOC_ENABLE,  PERF_IOC_FLAG_GROUP);
+  }
+#else
+  (void)ctr;
+#endif
+}
+
+/// Stop the hardware performance counters and accumulate their values.
+///
+/// @param[in] ctr counters
+static void
+counters_stop(struct counters* ctr)
+{
+#ifdef __linux__
+  uint64_t buf[5];
+  ssize_t  ret;
+  int      idx;
+
+  if (ctr->c_use == true) {
+    (void)ioctl(ctr->c_fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    // The group read format starts with the number of events, followed by their values.
+    ret = read(ctr->c_fds[0], buf, sizeof(buf));
+    if (ret == (ssize_t)sizeof(buf) && buf[0] == 4) {
+      for (idx = 0; idx < 4; idx += 1) {
+        ctr->c_val[idx] += buf[idx + 1];
+      }
+    }
+  }
+#else
+  (void)ctr;
+#endif
+}
+
+/// Compare two measured times.
+/// @return comparison
+///
+/// @param[in] a first time
+/// @param[in] b second time
+static int
+time_cmp(const void* a, const void* b)
+{
+  uint64_t x;
+  uint64_t y;
+
+  x = *(const uint64_t*)a;
+  y = *(const uint64_t*)b;
+
+  return (x > y) - (x < y);
+}
+
+/// Measure a single function in a single mode for a single input length.
+///
+/// The data generation and the restoration of the input array are excluded from the measurement.
+/// The reported time is the median of all repetitions, whereas the hardware counters are averaged.
+///
+/// @param[in] stg settings
+/// @param[in] ctr counters
+/// @param[in] tms memory for the measured times
+/// @param[in] src pristine input values
+/// @param[in] arr working copy of the input values
+/// @param[in] len length of the input
+/// @param[in] fnc benchmarked function
+/// @param[in] str streaming (true) or static (false) mode
+static void
+measure(const struct settings* stg,
+        struct counters*       ctr,
+        uint64_t*              tms,
+        const AGGSTAT_FLT*     src,
+        AGGSTAT_FLT*           arr,
+        const AGGSTAT_INT      len,
+        const struct function* fnc,
+        const bool             str)
+{
+  struct aggstat       agg;
+  volatile AGGSTAT_FLT snk;
+  AGGSTAT_FLT          val;
+  AGGSTAT_INT          idx;
+  uintmax_t            rep;
+  uint64_t             now;
+  double               nsv;
+  int                  cix;
+
+  (void)memset(ctr->c_val, 0, sizeof(ctr->c_val));
+
+  for (rep = 0; rep < stg->s_rep; rep += 1) {
+    // The static quantile algorithm sorts the array in-place, and thus every repetition needs to
+    // start with the original order of values.
+    (void)memcpy(arr, src, sizeof(*arr) * len);
+
+    counters_start(ctr);
+    now = time_now();
+
+    if (str == true) {
+      aggstat_new(&agg, fnc->f_fnc, fnc->f_par);
+      for (idx = 0; idx < len; idx += 1) {
+        aggstat_put(&agg, arr[idx]);
+      }
+      (void)aggstat_get(&agg, &val);
+    } else {
+      (void)aggstat_run(&val, arr, len, fnc->f_fnc, fnc->f_par);
+    }
+
+    tms[rep] = time_now() - now;
+    counters_stop(ctr);
+
+    // Prevent the compiler from eliminating the computation.
+    snk = val;
+    (void)snk;
+  }
+
+  qsort(tms, stg->s_rep, sizeof(*tms), time_cmp);
+  nsv = (double)tms[stg->s_rep / 2] / (double)len;
+
+  (void)printf("%d,%d,%s,%s,%s,%" PRIu64 ",%" PRIuMAX ",%.3f,%.0f",
+               AGGSTAT_FLT_BIT, AGGSTAT_INT_BIT, BENCH_OPT, fnc->f_nam, str ? "put" : "run",
+               (uint64_t)len, stg->s_rep, nsv, 1.0e9 / nsv);
+
+  for (cix = 0; cix < 4; cix += 1) {
+    if (ctr->c_use == true) {
+      (void)printf(",%.3f", (double)ctr->c_val[cix] / (double)stg->s_rep / (double)len);
+    } else {
+      (void)printf(",");
+    }
+  }
+
+  (void)printf("\n");
+}
+
+/// Parse the settings from the command-line arguments.
+/// @return success/failure indication
+///
+/// @param[in] stg  settings
+/// @param[in] argc argument count
+/// @param[in] argv argument vector
+static bool
+parse_settings(struct settings* stg, int argc, char* argv[])
+{
+  int opt;
+
+  stg->s_rep = 10;
+  stg->s_fnc = NULL;
+  stg->s_hwc = false;
+  stg->s_hdr = false;
+
+  while (true) {
+    opt = getopt(argc, argv, "cf:hr:");
+    if (opt == -1) {
+      break;
+    }
+
+    // Hardware performance counters.
+    if (opt == 'c') {
+      stg->s_hwc = true;
+    }
+
+    // Aggregate function to measure.
+    if (opt == 'f') {
+      stg->s_fnc = optarg;
+    }
+
+    // Header line.
+    if (opt == 'h') {
+      stg->s_hdr = true;
+    }
+
+    // Number of repetitions.
+    if (opt == 'r') {
+      errno = 0;
+      stg->s_rep = strtoumax(optarg, NULL, 10);
+      if (stg->s_rep == 0) {
+        (void)fprintf(stderr, "unable to parse the repetition count from '%s'\n", optarg);
+        return false;
+      }
+    }
+
+    // Unknown option.
+    if (opt == '?') {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/// The benchmark measures the throughput of all aggregate functions in both the streaming and the
+/// static mode, for multiple input lengths. The results are printed as comma-separated values, one
+/// measurement per line, so that the outputs of two builds can be compared mechanically.
+int
+main(int argc, char* argv[])
+{
+  struct settings stg;
+  struct counters ctr;
+  AGGSTAT_FLT*    src;
+  AGGSTAT_FLT*    arr;
+  uint64_t*       tms;
+  uint64_t        max;
+  size_t          fix;
+  size_t          lix;
+  AGGSTAT_INT     idx;
+  bool            ret;
+
+  ret = parse_settings(&stg, argc, argv);
+  if (ret == false) {
+    return EXIT_FAILURE;
+  }
+
+  ctr.c_use = false;
+  if (stg.s_hwc == true) {
+    counters_open(&ctr);
+  }
+
+  // Allocate the arrays for the longest input.
+  max = lens[sizeof(lens) / sizeof(lens[0]) - 1];
+  src = malloc(sizeof(*src) * max);
+  arr = malloc(sizeof(*arr) * max);
+  tms = malloc(sizeof(*tms) * stg.s_rep);
+  if (src == NULL || arr == NULL || tms == NULL) {
+    perror("malloc");
+    return EXIT_FAILURE;
+  }
+
+  for (lix = 0; lix < max; lix += 1) {
+    src[lix] = random_number();
+  }
+
+  if (stg.s_hdr == true) {
+    (void)printf("flt,int,opt,fnc,mode,len,rep,ns_per_val,val_per_s,"
+                 "cycles_per_val,instructions_per_val,"
+                 "branch_misses_per_val,cache_misses_per_val\n");
+  }
+
+  for (lix = 0; lix < sizeof(lens) / sizeof(lens[0]); lix += 1) {
+    // Ensure that we stop in case the integer width is not sufficient to hold the input length.
+    if (lens[lix] > AGGSTAT_INT_MAX) {
+      break;
+    }
+
+    idx = (AGGSTAT_INT)lens[lix];
+    for (fix = 0; fix < sizeof(fncs) / sizeof(fncs[0]); fix += 1) {
+      if (stg.s_fnc != NULL && strcmp(stg.s_fnc, fncs[fix].f_nam) != 0) {
+        continue;
+      }
+
+      measure(&stg, &ctr, tms, src, arr, idx, &fncs[fix], true);
+      measure(&stg, &ctr, tms, src, arr, idx, &fncs[fix], false);
+    }
+  }
+
+  free(tms);
+  free(arr);
+  free(src);
+
+  return EXIT_SUCCESS;
+}
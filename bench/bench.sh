@@ -0,0 +1,57 @@
+#!/bin/bash
+# Copyright (c) 2019-2021 Daniel Lovasko
+# All Rights Reserved
+#
+# Distributed under the terms of the 2-clause BSD License. The full
+# license is in the file LICENSE, distributed as part of this software.
+
+# Usage: bench.sh [-c]
+#  -c  read hardware performance counters (requires perf_event_open access)
+#
+# The results of all builds are collected in a single comma-separated file in
+# the res directory, named after the current commit. Two such files can be
+# compared by the cmp.sh script.
+
+set -x
+
+# Ensure that all relative paths remain correct.
+cd $(dirname $0)
+
+# C compilation settings.
+CC="cc"
+OPT="-march=native -mtune=native"
+CFLAGS="-I../src -D_POSIX_C_SOURCE=201912 -D_DEFAULT_SOURCE -std=c99 -Wall -Wextra -Werror"
+LDFLAGS="-lm"
+SRCS="./bench.c ../src/get.c ../src/put.c ../src/new.c ../src/run.c"
+ARGS="${CFLAGS} ${OPT} ${SRCS} ${LDFLAGS}"
+
+REV=$(git rev-parse --short HEAD 2>/dev/null || echo unknown)
+OUT="./res/bench_${REV}.csv"
+HWC="$1"
+
+# Build the benchmark for a selected configuration.
+# param 1: optimisation level
+# param 2: floating-point bit width
+# param 3: integer bit width
+build() {
+  ${CC} -DAGGSTAT_FLT_BIT=$2 -DAGGSTAT_INT_BIT=$3 -DBENCH_OPT=\"$1\" \
+    -o ./bin/bench_$1_f$2_i$3 -$1 ${ARGS}
+}
+
+for opt in O0 O2 O3; do
+  for flt in 32 64 80; do
+    for int in 32 64; do
+      build ${opt} ${flt} ${int}
+    done
+  done
+done
+
+# Print the header line once, followed by all measurements.
+./bin/bench_O0_f32_i32 -h -r1 -fnone > ${OUT}
+for opt in O0 O2 O3; do
+  for flt in 32 64 80; do
+    for int in 32 64; do
+      ./bin/bench_${opt}_f${flt}_i${int} ${HWC} >> ${OUT}
+    done
+  done
+done
@@ -0,0 +1,24 @@
+#!/bin/bash
+# Copyright (c) 2019-2021 Daniel Lovasko
+# All Rights Reserved
+#
+# Distributed under the terms of the 2-clause BSD License. The full
+# license is in the file LICENSE, distributed as part of this software.
+
+# Usage: cmp.sh OLD.csv NEW.csv
+#
+# Compare two outputs of the bench.sh script and print the ratio of the
+# nanoseconds per value for each measurement present in both files. Ratios
+# above 1.0 denote a slowdown of the new build.
+
+if [ $# -ne 2 ]; then
+  echo "usage: $0 OLD.csv NEW.csv" >&2
+  exit 1
+fi
+
+awk -F, '
+  FNR == 1 { next }
+  { key = $1 "," $2 "," $3 "," $4 "," $5 "," $6 }
+  NR == FNR { old[key] = $8; next }
+  key in old && old[key] > 0 { printf "%s,%s,%s,%.3f\n", key, old[key], $8, $8 / old[key] }
+' "$1" "$2"
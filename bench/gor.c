@@ -0,0 +1,382 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "agg.h"
+
+
+// Optimisation level of the benchmark build, as reported in the output.
+#ifndef BENCH_OPT
+  #define BENCH_OPT "unknown"
+#endif
+
+// Memory budget of the out-of-core quantile.
+#define BENCH_OOC (1 << 20)
+
+/// Benchmarked aggregate function.
+struct function {
+  const char* f_nam; ///< Name.
+  uint8_t     f_fnc; ///< Type.
+  AGGSTAT_FLT f_par; ///< Parameter.
+};
+
+/// Settings.
+struct settings {
+  uintmax_t s_rep; ///< Repetitions of each measurement.
+  uintmax_t s_len; ///< Number of values.
+  uintmax_t s_blk; ///< Number of values per block.
+  bool      s_hdr; ///< Print the header line.
+};
+
+/// Compressed series.
+struct series {
+  uint64_t*    s_blk; ///< Memory of all blocks.
+  size_t*      s_siz; ///< Size of each block in bytes.
+  size_t       s_cnt; ///< Number of blocks.
+  size_t       s_str; ///< Distance between the blocks in words.
+  size_t       s_tot; ///< Total size of the blocks in bytes.
+  AGGSTAT_FLT* s_tim; ///< Decoded timestamps.
+  AGGSTAT_FLT* s_arr; ///< Decoded values.
+};
+
+/// All benchmarked functions.
+static const struct function fncs[] = {
+  {"sum", AGGSTAT_FNC_SUM, AGGSTAT_0_0},
+  {"var", AGGSTAT_FNC_VAR, AGGSTAT_0_0},
+  {"twa", AGGSTAT_FNC_TWA, AGGSTAT_0_0},
+  {"qnt", AGGSTAT_FNC_QNT, AGGSTAT_0_99}
+};
+
+/// Names of the approaches.
+static const char* algs[] = {"decode", "stream", "ooc"};
+
+/// Generate a next random number.
+/// @return random number
+static uint32_t
+random_number(void)
+{
+  static uint32_t num = 77;
+
+  num = (num * 214013 + 2531011) & (((uint32_t)1 << 31) - 1);
+  return num;
+}
+
+/// Obtain the current time with minimal external effects.
+/// @return nanoseconds
+static uint64_t
+time_now(void)
+{
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/// Generate and compress a gauge that is sampled every ten seconds with a small jitter, and whose
+/// value is a random walk with two decimal places.
+/// @return success/failure indication
+///
+/// @param[out] ser series
+/// @param[in]  stg settings
+static bool
+generate(struct series* ser, const struct settings* stg)
+{
+  struct aggstat_gor gor;
+  uint64_t           tim;
+  uint64_t           cnt;
+  uintmax_t          idx;
+  AGGSTAT_FLT        val;
+  int64_t            cts;
+
+  ser->s_cnt = (stg->s_len + stg->s_blk - 1) / stg->s_blk;
+  ser->s_str = AGGSTAT_GOR_SIZ(stg->s_blk) / sizeof(uint64_t);
+  ser->s_blk = malloc(ser->s_cnt * ser->s_str * sizeof(uint64_t));
+  ser->s_siz = malloc(ser->s_cnt * sizeof(size_t));
+  ser->s_tim = malloc(stg->s_len * sizeof(AGGSTAT_FLT));
+  ser->s_arr = malloc(stg->s_len * sizeof(AGGSTAT_FLT));
+  if (ser->s_blk == NULL || ser->s_siz == NULL || ser->s_tim == NULL || ser->s_arr == NULL) {
+    return false;
+  }
+
+  tim        = 1600000000;
+  cts        = 2000;
+  ser->s_tot = 0;
+  for (idx = 0; idx < stg->s_len; idx += 1) {
+    cnt = idx / stg->s_blk;
+    if (idx % stg->s_blk == 0) {
+      (void)aggstat_gor_new(&gor, ser->s_blk + cnt * ser->s_str, ser->s_str * sizeof(uint64_t));
+    }
+
+    tim += random_number() % 10 == 0 ? 9 + random_number() % 3 : 10;
+    cts += (int64_t)(random_number() % 21) - 10;
+    val  = (AGGSTAT_FLT)cts / (AGGSTAT_FLT)100;
+    (void)aggstat_gor_put(&gor, tim, val);
+
+    if ((idx + 1) % stg->s_blk == 0 || idx + 1 == stg->s_len) {
+      ser->s_siz[cnt]  = aggstat_gor_siz(&gor);
+      ser->s_tot      += ser->s_siz[cnt];
+    }
+  }
+
+  return true;
+}
+
+/// Print a single measurement.
+///
+/// @param[in] stg settings
+/// @param[in] ser series
+/// @param[in] fnc function
+/// @param[in] alg algorithm
+/// @param[in] bst best time
+/// @param[in] chk checksum
+static void
+report(const struct settings*  stg,
+       const struct series*    ser,
+       const struct function*  fnc,
+       const char*             alg,
+       const uint64_t          bst,
+       const AGGSTAT_FLT       chk)
+{
+  (void)printf("%d,%d,%s,%s,%s,%" PRIuMAX ",%" PRIuMAX ",%.2f,%.2f,%.3f,%.6g\n",
+               AGGSTAT_FLT_BIT, AGGSTAT_INT_BIT, BENCH_OPT, fnc->f_nam, alg, stg->s_len,
+               stg->s_blk,
+               (double)ser->s_tot * 8.0 / (double)stg->s_len,
+               (double)bst / 1e6,
+               (double)bst / (double)stg->s_len,
+               (double)chk);
+}
+
+/// Decode all blocks into arrays and aggregate the arrays.
+/// @return aggregated value
+///
+/// @param[in] ser series
+/// @param[in] fnc function
+/// @param[in] len number of values
+static AGGSTAT_FLT
+decode_run(const struct series* ser, const struct function* fnc, const uintmax_t len)
+{
+  AGGSTAT_FLT val;
+  size_t      idx;
+  size_t      pos;
+
+  pos = 0;
+  for (idx = 0; idx < ser->s_cnt; idx += 1) {
+    (void)aggstat_gor_dec(ser->s_tim + pos, ser->s_arr + pos,
+                          ser->s_blk + idx * ser->s_str, ser->s_siz[idx]);
+    pos += (size_t)ser->s_blk[idx * ser->s_str];
+  }
+
+  val = AGGSTAT_0_0;
+  (void)aggstat_run_t(&val, ser->s_tim, ser->s_arr, (AGGSTAT_INT)len, fnc->f_fnc, fnc->f_par);
+  return val;
+}
+
+/// Aggregate all blocks directly by the streaming algorithm.
+/// @return aggregated value
+///
+/// @param[in] ser series
+/// @param[in] fnc function
+static AGGSTAT_FLT
+stream(const struct series* ser, const struct function* fnc)
+{
+  struct aggstat agg;
+  AGGSTAT_FLT    val;
+  size_t         idx;
+
+  aggstat_new(&agg, fnc->f_fnc, fnc->f_par);
+  for (idx = 0; idx < ser->s_cnt; idx += 1) {
+    (void)aggstat_gor_agg(&agg, 1, ser->s_blk + idx * ser->s_str, ser->s_siz[idx]);
+  }
+
+  val = AGGSTAT_0_0;
+  (void)aggstat_get(&agg, &val);
+  return val;
+}
+
+/// Aggregate all blocks directly by the out-of-core algorithm.
+/// @return aggregated value
+///
+/// @param[in] ser series
+/// @param[in] fnc function
+/// @param[in] mem memory of the out-of-core quantile
+static AGGSTAT_FLT
+out_of_core(const struct series* ser, const struct function* fnc, void* mem)
+{
+  struct aggstat_ooc ooc;
+  AGGSTAT_FLT        val;
+  size_t             idx;
+
+  (void)aggstat_ooc_new(&ooc, fnc->f_fnc, fnc->f_par, mem, BENCH_OOC);
+  do {
+    for (idx = 0; idx < ser->s_cnt; idx += 1) {
+      (void)aggstat_gor_ooc(&ooc, ser->s_blk + idx * ser->s_str, ser->s_siz[idx]);
+    }
+  } while (aggstat_ooc_end(&ooc) == true);
+
+  val = AGGSTAT_0_0;
+  (void)aggstat_ooc_get(&ooc, &val);
+  return val;
+}
+
+/// Measure all functions by all approaches.
+/// @return success/failure indication
+///
+/// @param[in] stg settings
+static bool
+measure(const struct settings* stg)
+{
+  struct series ser;
+  AGGSTAT_FLT   chk;
+  uintmax_t     rep;
+  uint64_t      tim;
+  uint64_t      bst;
+  size_t        fnc;
+  uint8_t       alg;
+  void*         mem;
+  bool          ret;
+
+  (void)memset(&ser, 0, sizeof(ser));
+  mem = malloc(BENCH_OOC);
+  ret = mem != NULL && generate(&ser, stg) == true;
+  for (fnc = 0; ret == true && fnc < sizeof(fncs) / sizeof(fncs[0]); fnc += 1) {
+    for (alg = 0; alg < 3; alg += 1) {
+      // The out-of-core algorithm does not use the timestamps.
+      if (alg == 2 && fncs[fnc].f_fnc == AGGSTAT_FNC_TWA) {
+        continue;
+      }
+
+      bst = UINT64_MAX;
+      chk = AGGSTAT_0_0;
+      for (rep = 0; rep < stg->s_rep; rep += 1) {
+        tim = time_now();
+        if (alg == 0) {
+          chk = decode_run(&ser, &fncs[fnc], stg->s_len);
+        } else if (alg == 1) {
+          chk = stream(&ser, &fncs[fnc]);
+        } else {
+          chk = out_of_core(&ser, &fncs[fnc], mem);
+        }
+        tim = time_now() - tim;
+
+        bst = tim < bst ? tim : bst;
+      }
+
+      report(stg, &ser, &fncs[fnc], algs[alg], bst, chk);
+    }
+  }
+
+  free(ser.s_blk);
+  free(ser.s_siz);
+  free(ser.s_tim);
+  free(ser.s_arr);
+  free(mem);
+  return ret;
+}
+
+/// Parse a positive number of a command-line option.
+/// @return success/failure indication
+///
+/// @param[out] num number
+/// @param[in]  nam name of the number
+static bool
+parse_number(uintmax_t* num, const char* nam)
+{
+  errno = 0;
+  *num = strtoumax(optarg, NULL, 10);
+  if (*num == 0) {
+    (void)fprintf(stderr, "unable to parse the %s from '%s'\n", nam, optarg);
+    return false;
+  }
+
+  return true;
+}
+
+/// Parse the settings from the command-line arguments.
+/// @return success/failure indication
+///
+/// @param[in] stg  settings
+/// @param[in] argc argument count
+/// @param[in] argv argument vector
+static bool
+parse_settings(struct settings* stg, int argc, char* argv[])
+{
+  int opt;
+
+  stg->s_rep = 3;
+  stg->s_len = 10000000;
+  stg->s_blk = 720;
+  stg->s_hdr = false;
+
+  while (true) {
+    opt = getopt(argc, argv, "b:hl:r:");
+    if (opt == -1) {
+      break;
+    }
+
+    // Number of values per block.
+    if (opt == 'b' && parse_number(&stg->s_blk, "block length") == false) {
+      return false;
+    }
+
+    // Header line.
+    if (opt == 'h') {
+      stg->s_hdr = true;
+    }
+
+    // Number of values.
+    if (opt == 'l' && parse_number(&stg->s_len, "value count") == false) {
+      return false;
+    }
+
+    // Number of repetitions.
+    if (opt == 'r' && parse_number(&stg->s_rep, "repetition count") == false) {
+      return false;
+    }
+
+    // Unknown option.
+    if (opt == '?') {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/// The benchmark compresses a gauge into blocks of two hours of values by default, and measures
+/// the aggregation of all blocks by decoding them into arrays for the off-line algorithm, and by
+/// aggregating the blocks directly by the streaming algorithm and by the out-of-core algorithm
+/// with a budget of one megabyte. The best of all repetitions is reported in milliseconds, along
+/// with the compressed size.
+int
+main(int argc, char* argv[])
+{
+  struct settings stg;
+  bool            ret;
+
+  ret = parse_settings(&stg, argc, argv);
+  if (ret == false) {
+    return EXIT_FAILURE;
+  }
+
+  if (stg.s_hdr == true) {
+    (void)printf("flt,int,opt,fnc,alg,len,blk,bits_per_value,ms,ns_per_value,chk\n");
+  }
+
+  ret = measure(&stg);
+  if (ret == false) {
+    perror("malloc");
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,540 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+// The affinity of the thread is a GNU extension.
+#ifdef __linux__
+  #define _GNU_SOURCE
+  #include <sched.h>
+#endif
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "agg.h"
+
+
+// Optimisation level of the benchmark build, as reported in the output.
+#ifndef BENCH_OPT
+  #define BENCH_OPT "unknown"
+#endif
+
+// Number of untimed values that precede the timed values of the steady state.
+#define BENCH_WRM 1000
+
+// Number of timed values after each reset in the warm-up scenario.
+#define BENCH_INI 8
+
+/// Benchmarked aggregate function.
+struct function {
+  const char* f_nam; ///< Name.
+  uint8_t     f_fnc; ///< Aggregate function.
+  AGGSTAT_FLT f_par; ///< Aggregate function parameter.
+};
+
+/// Settings.
+struct settings {
+  uintmax_t   s_cnt; ///< Number of timed batches of each scenario.
+  uintmax_t   s_bat; ///< Number of values per timed batch.
+  uintmax_t   s_cpu; ///< Core to run on.
+  const char* s_fnc; ///< Name of the only function to measure (optional).
+  bool        s_hdr; ///< Print the header line.
+};
+
+/// Timer.
+struct timer {
+  uint64_t t_ovh; ///< Median overhead of a timed region in ticks.
+  double   t_ghz; ///< Frequency of the ticks in gigahertz.
+};
+
+/// All benchmarked functions.
+static const struct function fncs[] = {
+  {"fst",       AGGSTAT_FNC_FST, AGGSTAT_0_0 },
+  {"lst",       AGGSTAT_FNC_LST, AGGSTAT_0_0 },
+  {"cnt",       AGGSTAT_FNC_CNT, AGGSTAT_0_0 },
+  {"sum",       AGGSTAT_FNC_SUM, AGGSTAT_0_0 },
+  {"min",       AGGSTAT_FNC_MIN, AGGSTAT_0_0 },
+  {"max",       AGGSTAT_FNC_MAX, AGGSTAT_0_0 },
+  {"avg",       AGGSTAT_FNC_AVG, AGGSTAT_0_0 },
+  {"var",       AGGSTAT_FNC_VAR, AGGSTAT_0_0 },
+  {"dev",       AGGSTAT_FNC_DEV, AGGSTAT_0_0 },
+  {"skw",       AGGSTAT_FNC_SKW, AGGSTAT_0_0 },
+  {"krt",       AGGSTAT_FNC_KRT, AGGSTAT_0_0 },
+  {"qnt(0.1)",  AGGSTAT_FNC_QNT, AGGSTAT_0_1 },
+  {"qnt(0.9)",  AGGSTAT_FNC_QNT, AGGSTAT_0_9 },
+  {"qnt(0.99)", AGGSTAT_FNC_QNT, AGGSTAT_0_99},
+  {"med",       AGGSTAT_FNC_MED, AGGSTAT_0_0 },
+  {"twa",       AGGSTAT_FNC_TWA, AGGSTAT_0_0 },
+  {"itg",       AGGSTAT_FNC_ITG, AGGSTAT_0_0 },
+  {"rat",       AGGSTAT_FNC_RAT, AGGSTAT_0_0 }
+};
+
+/// Names of the input distributions of the steady state.
+static const char* dsts[] = {"uni", "par", "inf", "asc"};
+
+/// Generate a next random number from the interval (0.0, 1.0].
+/// @return random number
+static AGGSTAT_FLT
+random_number(void)
+{
+  static uint32_t num = 77;
+  uint32_t per;
+
+  per = ((uint32_t)1 << 31) - 1;
+  num = (num * 214013 + 2531011) & per;
+
+  return ((AGGSTAT_FLT)num + AGGSTAT_1_0) / (AGGSTAT_FLT)per;
+}
+
+/// Obtain the current time with minimal external effects.
+/// @return nanoseconds
+static uint64_t
+time_now(void)
+{
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/// Read the cycle counter at the start of a timed region.
+/// @return ticks
+///
+/// The fences prevent the preceding instructions from being timed and the timed instructions from
+/// starting early. Other architectures fall back to the monotonic clock.
+static inline uint64_t
+tick_bgn(void)
+{
+#if defined(__x86_64__)
+  uint32_t lo;
+  uint32_t hi;
+
+  __asm__ volatile ("lfence\n\trdtsc\n\tlfence" : "=a" (lo), "=d" (hi) :: "memory");
+  return ((uint64_t)hi << 32) | lo;
+#elif defined(__aarch64__)
+  uint64_t val;
+
+  __asm__ volatile ("isb\n\tmrs %0, cntvct_el0" : "=r" (val) :: "memory");
+  return val;
+#else
+  return time_now();
+#endif
+}
+
+/// Read the cycle counter at the end of a timed region.
+/// @return ticks
+///
+/// The instruction waits for all timed instructions to finish before reading the counter.
+static inline uint64_t
+tick_end(void)
+{
+#if defined(__x86_64__)
+  uint32_t lo;
+  uint32_t hi;
+
+  __asm__ volatile ("rdtscp\n\tlfence" : "=a" (lo), "=d" (hi) :: "rcx", "memory");
+  return ((uint64_t)hi << 32) | lo;
+#else
+  return tick_bgn();
+#endif
+}
+
+/// Compare two measured times.
+/// @return comparison
+///
+/// @param[in] a first time
+/// @param[in] b second time
+static int
+time_cmp(const void* a, const void* b)
+{
+  uint64_t x;
+  uint64_t y;
+
+  x = *(const uint64_t*)a;
+  y = *(const uint64_t*)b;
+
+  return (x > y) - (x < y);
+}
+
+/// Pin the calling thread to a core.
+/// @return success/failure indication
+///
+/// @param[in] cpu core
+static bool
+pin_core(const uintmax_t cpu)
+{
+#ifdef __linux__
+  cpu_set_t set;
+
+  CPU_ZERO(&set);
+  CPU_SET((int)cpu, &set);
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  (void)cpu;
+  return true;
+#endif
+}
+
+/// Calibrate the frequency of the ticks and the overhead of a timed region.
+///
+/// @param[out] tmr timer
+/// @param[in]  smp memory for the samples
+/// @param[in]  cnt number of samples
+static void
+calibrate(struct timer* tmr, uint64_t* smp, const uintmax_t cnt)
+{
+  uint64_t  tck;
+  uint64_t  now;
+  uintmax_t idx;
+
+  now = time_now();
+  tck = tick_bgn();
+  while (time_now() - now < 100000000) {
+  }
+  tck = tick_end() - tck;
+  now = time_now() - now;
+  tmr->t_ghz = (double)tck / (double)now;
+
+  for (idx = 0; idx < cnt; idx += 1) {
+    tck      = tick_bgn();
+    smp[idx] = tick_end() - tck;
+  }
+
+  qsort(smp, cnt, sizeof(*smp), time_cmp);
+  tmr->t_ovh = smp[cnt / 2];
+}
+
+/// Generate the input values of a distribution.
+///
+/// The uniform distribution keeps the quantile estimates in the parabolic case, whereas the heavy
+/// tail of the Pareto distribution and the infinite values cause fallbacks to the linear estimate.
+/// Ascending values move the markers at almost every value.
+///
+/// @param[out] arr input values
+/// @param[in]  len number of values
+/// @param[in]  dst index of the distribution
+static void
+generate(AGGSTAT_FLT* arr, const size_t len, const size_t dst)
+{
+  size_t idx;
+
+  for (idx = 0; idx < len; idx += 1) {
+    if (dst == 0) {
+      arr[idx] = random_number();
+    } else if (dst == 1) {
+      arr[idx] = AGGSTAT_1_0 / AGGSTAT_POW(random_number(), AGGSTAT_NUM(0, 75, +, 0));
+    } else if (dst == 2) {
+      arr[idx] = idx % 100 == 0 ? (AGGSTAT_FLT)INFINITY : random_number();
+    } else {
+      arr[idx] = (AGGSTAT_FLT)idx;
+    }
+  }
+}
+
+/// Print the distribution of the latencies of a single scenario.
+///
+/// The counters of the quantile markers are those of all values of the scenario, and they remain
+/// empty unless the library counts its internal events.
+///
+/// @param[in] stg settings
+/// @param[in] tmr timer
+/// @param[in] fnc function
+/// @param[in] scn scenario
+/// @param[in] bat number of values per sample
+/// @param[in] smp samples
+/// @param[in] cnt number of samples
+static void
+report(const struct settings* stg,
+       const struct timer*    tmr,
+       const struct function* fnc,
+       const char*            scn,
+       const uintmax_t        bat,
+       uint64_t*              smp,
+       const uintmax_t        cnt)
+{
+  struct aggstat_ctr ctr;
+  uintmax_t          idx;
+  double             avg;
+
+  avg = 0.0;
+  for (idx = 0; idx < cnt; idx += 1) {
+    smp[idx]  = smp[idx] > tmr->t_ovh ? smp[idx] - tmr->t_ovh : 0;
+    avg      += (double)smp[idx];
+  }
+
+  qsort(smp, cnt, sizeof(*smp), time_cmp);
+  aggstat_ctr_get(&ctr);
+
+  (void)printf("%d,%d,%s,%" PRIuMAX ",%s,%s,%" PRIuMAX ",%" PRIuMAX ",%.3f,%" PRIu64
+               ",%.1f,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64,
+               AGGSTAT_FLT_BIT, AGGSTAT_INT_BIT, BENCH_OPT, stg->s_cpu, fnc->f_nam, scn, bat, cnt,
+               tmr->t_ghz, tmr->t_ovh, avg / (double)cnt,
+               smp[cnt / 2], smp[cnt * 99 / 100], smp[cnt * 999 / 1000], smp[cnt - 1]);
+
+#if AGGSTAT_CTR == 1
+  (void)printf(",%" PRIu64 ",%.4f\n", ctr.ac_mov,
+               ctr.ac_mov > 0 ? (double)ctr.ac_lin / (double)ctr.ac_mov : 0.0);
+#else
+  (void)ctr;
+  (void)printf(",,\n");
+#endif
+}
+
+/// Measure the latency of the first values after a reset of the aggregate, which includes the
+/// initial insertions and the sort of the quantile markers at the fifth value.
+///
+/// @param[in] stg settings
+/// @param[in] tmr timer
+/// @param[in] fnc function
+/// @param[in] arr input values
+/// @param[in] smp memory for the samples
+static void
+measure_reset(const struct settings* stg,
+              const struct timer*    tmr,
+              const struct function* fnc,
+              const AGGSTAT_FLT*     arr,
+              uint64_t*              smp)
+{
+  struct aggstat       agg;
+  volatile AGGSTAT_FLT snk;
+  AGGSTAT_FLT          val;
+  uintmax_t            rst;
+  uint64_t             tck;
+  uint8_t              pos;
+  uint8_t              idx;
+  char                 scn[8];
+
+  for (pos = 0; pos < BENCH_INI; pos += 1) {
+    aggstat_ctr_rst();
+    for (rst = 0; rst < stg->s_cnt; rst += 1) {
+      aggstat_new(&agg, fnc->f_fnc, fnc->f_par);
+      for (idx = 0; idx < pos; idx += 1) {
+        aggstat_put(&agg, arr[rst * BENCH_INI + idx]);
+      }
+
+      tck = tick_bgn();
+      aggstat_put(&agg, arr[rst * BENCH_INI + pos]);
+      smp[rst] = tick_end() - tck;
+
+      // Prevent the compiler from eliminating the computation.
+      (void)aggstat_get(&agg, &val);
+      snk = val;
+      (void)snk;
+    }
+
+    (void)snprintf(scn, sizeof(scn), "ini%u", (unsigned)pos + 1);
+    report(stg, tmr, fnc, scn, 1, smp, stg->s_cnt);
+  }
+}
+
+/// Measure the latency of batches of values in the steady state of the aggregate.
+///
+/// @param[in] stg settings
+/// @param[in] tmr timer
+/// @param[in] fnc function
+/// @param[in] arr input values
+/// @param[in] smp memory for the samples
+/// @param[in] dst index of the distribution
+static void
+measure_steady(const struct settings* stg,
+               const struct timer*    tmr,
+               const struct function* fnc,
+               const AGGSTAT_FLT*     arr,
+               uint64_t*              smp,
+               const size_t           dst)
+{
+  struct aggstat       agg;
+  volatile AGGSTAT_FLT snk;
+  AGGSTAT_FLT          val;
+  const AGGSTAT_FLT*   cur;
+  uintmax_t            idx;
+  uintmax_t            pos;
+  uint64_t             tck;
+
+  aggstat_new(&agg, fnc->f_fnc, fnc->f_par);
+  for (idx = 0; idx < BENCH_WRM; idx += 1) {
+    aggstat_put(&agg, arr[idx]);
+  }
+
+  aggstat_ctr_rst();
+  cur = arr + BENCH_WRM;
+  for (idx = 0; idx < stg->s_cnt; idx += 1) {
+    tck = tick_bgn();
+    for (pos = 0; pos < stg->s_bat; pos += 1) {
+      aggstat_put(&agg, cur[pos]);
+    }
+    smp[idx] = tick_end() - tck;
+
+    cur += stg->s_bat;
+  }
+
+  // Prevent the compiler from eliminating the computation.
+  (void)aggstat_get(&agg, &val);
+  snk = val;
+  (void)snk;
+
+  report(stg, tmr, fnc, dsts[dst], stg->s_bat, smp, stg->s_cnt);
+}
+
+/// Parse a positive number of a command-line option.
+/// @return success/failure indication
+///
+/// @param[out] num number
+/// @param[in]  nam name of the number
+static bool
+parse_number(uintmax_t* num, const char* nam)
+{
+  errno = 0;
+  *num = strtoumax(optarg, NULL, 10);
+  if (*num == 0) {
+    (void)fprintf(stderr, "unable to parse the %s from '%s'\n", nam, optarg);
+    return false;
+  }
+
+  return true;
+}
+
+/// Parse the settings from the command-line arguments.
+/// @return success/failure indication
+///
+/// @param[in] stg  settings
+/// @param[in] argc argument count
+/// @param[in] argv argument vector
+static bool
+parse_settings(struct settings* stg, int argc, char* argv[])
+{
+  int opt;
+
+  stg->s_cnt = 1000000;
+  stg->s_bat = 1;
+  stg->s_cpu = 0;
+  stg->s_fnc = NULL;
+  stg->s_hdr = false;
+
+  while (true) {
+    opt = getopt(argc, argv, "b:c:f:hn:");
+    if (opt == -1) {
+      break;
+    }
+
+    // Number of values per timed batch.
+    if (opt == 'b' && parse_number(&stg->s_bat, "batch length") == false) {
+      return false;
+    }
+
+    // Core to run on, which can be zero.
+    if (opt == 'c') {
+      errno = 0;
+      stg->s_cpu = strtoumax(optarg, NULL, 10);
+      if (errno != 0) {
+        (void)fprintf(stderr, "unable to parse the core from '%s'\n", optarg);
+        return false;
+      }
+    }
+
+    // Aggregate function to measure.
+    if (opt == 'f') {
+      stg->s_fnc = optarg;
+    }
+
+    // Header line.
+    if (opt == 'h') {
+      stg->s_hdr = true;
+    }
+
+    // Number of timed batches.
+    if (opt == 'n' && parse_number(&stg->s_cnt, "sample count") == false) {
+      return false;
+    }
+
+    // Unknown option.
+    if (opt == '?') {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/// The benchmark measures the latency of individual calls, or of small batches of calls, of
+/// `aggstat_put` by the cycle counter on a pinned core, and reports its distribution for every
+/// function: the first values after a reset of the aggregate one by one, and the steady state for
+/// several input distributions. The overhead of the timer is subtracted from all samples, and all
+/// latencies are reported in ticks of the counter, whose frequency is reported as well.
+int
+main(int argc, char* argv[])
+{
+  struct settings stg;
+  struct timer    tmr;
+  AGGSTAT_FLT*    ini;
+  AGGSTAT_FLT*    arr[sizeof(dsts) / sizeof(dsts[0])];
+  uint64_t*       smp;
+  size_t          len;
+  size_t          fix;
+  size_t          dst;
+  bool            ret;
+
+  ret = parse_settings(&stg, argc, argv);
+  if (ret == false) {
+    return EXIT_FAILURE;
+  }
+
+  if (stg.s_hdr == true) {
+    (void)printf("flt,int,opt,cpu,fnc,scn,bat,cnt,ghz,ovh,avg,p50,p99,p999,max,mov,lin\n");
+  }
+
+  if (pin_core(stg.s_cpu) == false) {
+    perror("sched_setaffinity");
+    return EXIT_FAILURE;
+  }
+
+  // Allocate and generate all inputs before any measurement.
+  len = BENCH_WRM + stg.s_cnt * stg.s_bat;
+  smp = malloc(stg.s_cnt * sizeof(*smp));
+  ini = malloc(stg.s_cnt * BENCH_INI * sizeof(*ini));
+  ret = smp != NULL && ini != NULL;
+  for (dst = 0; dst < sizeof(dsts) / sizeof(dsts[0]); dst += 1) {
+    arr[dst] = malloc(len * sizeof(AGGSTAT_FLT));
+    ret      = ret == true && arr[dst] != NULL;
+  }
+
+  if (ret == true) {
+    generate(ini, stg.s_cnt * BENCH_INI, 0);
+    for (dst = 0; dst < sizeof(dsts) / sizeof(dsts[0]); dst += 1) {
+      generate(arr[dst], len, dst);
+    }
+
+    calibrate(&tmr, smp, stg.s_cnt);
+    for (fix = 0; fix < sizeof(fncs) / sizeof(fncs[0]); fix += 1) {
+      if (stg.s_fnc != NULL && strcmp(stg.s_fnc, fncs[fix].f_nam) != 0) {
+        continue;
+      }
+
+      measure_reset(&stg, &tmr, &fncs[fix], ini, smp);
+      for (dst = 0; dst < sizeof(dsts) / sizeof(dsts[0]); dst += 1) {
+        measure_steady(&stg, &tmr, &fncs[fix], arr[dst], smp, dst);
+      }
+    }
+  }
+
+  free(smp);
+  free(ini);
+  for (dst = 0; dst < sizeof(dsts) / sizeof(dsts[0]); dst += 1) {
+    free(arr[dst]);
+  }
+
+  if (ret == false) {
+    perror("malloc");
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
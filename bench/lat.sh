@@ -0,0 +1,51 @@
+#!/bin/bash
+# Copyright (c) 2019-2021 Daniel Lovasko
+# All Rights Reserved
+#
+# Distributed under the terms of the 2-clause BSD License. The full
+# license is in the file LICENSE, distributed as part of this software.
+
+# Usage: lat.sh [core]
+#
+# Measure the distribution of the latency of individual calls of aggstat_put on
+# the given core (zero by default), for all floating-point widths. An
+# additional build counts the internal events of the quantile markers, which
+# shows the share of fallbacks to the linear estimate of each scenario, at the
+# cost of slightly higher latencies. The results are collected in a single
+# comma-separated file in the res directory, named after the current commit.
+
+set -e
+set -x
+
+# Ensure that all relative paths remain correct.
+cd $(dirname $0)
+
+# C compilation settings.
+CC="cc"
+OPT="-march=native -mtune=native"
+CFLAGS="-I../src -D_POSIX_C_SOURCE=201912 -D_DEFAULT_SOURCE -std=c99 -Wall -Wextra -Werror"
+LDFLAGS="-lm"
+SRCS="./lat.c ../src/get.c ../src/put.c ../src/new.c"
+ARGS="${CFLAGS} ${OPT} ${SRCS} ${LDFLAGS}"
+
+REV=$(git rev-parse --short HEAD 2>/dev/null || echo unknown)
+OUT="./res/lat_${REV}.csv"
+CPU="${1:-0}"
+
+for opt in O2 O3; do
+  for flt in 32 64 80; do
+    ${CC} -DAGGSTAT_FLT_BIT=${flt} -DAGGSTAT_INT_BIT=64 -DBENCH_OPT=\"${opt}\" \
+      -o ./bin/lat_${opt}_f${flt}_i64 -${opt} ${ARGS}
+  done
+done
+
+${CC} -DAGGSTAT_CTR=1 -DAGGSTAT_STD=0 -DBENCH_OPT=\"O2-ctr\" \
+  -o ./bin/lat_ctr_f64_i64 -O2 ${ARGS}
+
+./bin/lat_O2_f32_i64 -h -n1 -f none > ${OUT}
+for opt in O2 O3; do
+  for flt in 32 64 80; do
+    ./bin/lat_${opt}_f${flt}_i64 -c ${CPU} >> ${OUT}
+  done
+done
+./bin/lat_ctr_f64_i64 -c ${CPU} >> ${OUT}
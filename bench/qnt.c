@@ -0,0 +1,255 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "agg.h"
+
+
+// Optimisation level of the benchmark build, as reported in the output.
+#ifndef BENCH_OPT
+  #define BENCH_OPT "unknown"
+#endif
+
+/// Settings.
+struct settings {
+  uintmax_t s_rep; ///< Repetitions of each measurement.
+  uintmax_t s_len; ///< Number of values.
+  uintmax_t s_thr; ///< Largest number of threads.
+  bool      s_hdr; ///< Print the header line.
+};
+
+/// Quantiles computed by each measurement.
+static const AGGSTAT_FLT pars[] = {
+  AGGSTAT_0_5,
+  AGGSTAT_0_9,
+  AGGSTAT_0_99,
+  AGGSTAT_NUM(0, 999, +, 0)
+};
+
+/// Generate a next random number.
+/// @return random number
+static uint32_t
+random_number(void)
+{
+  static uint32_t num = 77;
+
+  num = (num * 214013 + 2531011) & (((uint32_t)1 << 31) - 1);
+  return num;
+}
+
+/// Obtain the current time with minimal external effects.
+/// @return nanoseconds
+static uint64_t
+time_now(void)
+{
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/// Print a single measurement.
+///
+/// @param[in] stg settings
+/// @param[in] alg algorithm
+/// @param[in] thr number of threads
+/// @param[in] bst best time
+/// @param[in] chk checksum
+static void
+report(const struct settings* stg,
+       const char*            alg,
+       const uintmax_t        thr,
+       const uint64_t         bst,
+       const AGGSTAT_FLT      chk)
+{
+  (void)printf("%d,%d,%s,%s,%" PRIuMAX ",%" PRIuMAX ",%" PRIuMAX ",%.2f,%.3f,%.6g\n",
+               AGGSTAT_FLT_BIT, AGGSTAT_INT_BIT, BENCH_OPT, alg, thr, stg->s_len, stg->s_rep,
+               (double)bst / 1e6,
+               (double)bst / (double)stg->s_len,
+               (double)chk);
+}
+
+/// Measure the exact quantiles by sorting and by the parallel algorithm.
+/// @return success/failure indication
+///
+/// @param[in] stg settings
+static bool
+measure(const struct settings* stg)
+{
+  AGGSTAT_FLT* arr;
+  AGGSTAT_FLT* cpy;
+  AGGSTAT_FLT  res[sizeof(pars) / sizeof(pars[0])];
+  AGGSTAT_FLT  chk;
+  uintmax_t    rep;
+  uintmax_t    thr;
+  uintmax_t    idx;
+  uint64_t     tim;
+  uint64_t     bst;
+  size_t       cnt;
+
+  cnt = sizeof(pars) / sizeof(pars[0]);
+  arr = malloc(stg->s_len * sizeof(AGGSTAT_FLT));
+  cpy = malloc(stg->s_len * sizeof(AGGSTAT_FLT));
+  if (arr == NULL || cpy == NULL) {
+    free(arr);
+    free(cpy);
+    return false;
+  }
+
+  for (idx = 0; idx < stg->s_len; idx += 1) {
+    arr[idx] = (AGGSTAT_FLT)random_number() / (AGGSTAT_FLT)65536;
+  }
+
+  // The off-line algorithm sorts the array once for each quantile, and the copy is not measured.
+  bst = UINT64_MAX;
+  chk = AGGSTAT_0_0;
+  for (rep = 0; rep < stg->s_rep; rep += 1) {
+    tim = 0;
+    chk = AGGSTAT_0_0;
+    for (idx = 0; idx < cnt; idx += 1) {
+      (void)memcpy(cpy, arr, stg->s_len * sizeof(AGGSTAT_FLT));
+
+      tim -= time_now();
+      (void)aggstat_run(&res[idx], cpy, (AGGSTAT_INT)stg->s_len, AGGSTAT_FNC_QNT, pars[idx]);
+      tim += time_now();
+
+      chk += res[idx];
+    }
+
+    bst = tim < bst ? tim : bst;
+  }
+
+  report(stg, "qsort", 1, bst, chk);
+
+  for (thr = 1; thr <= stg->s_thr; thr *= 2) {
+    bst = UINT64_MAX;
+    for (rep = 0; rep < stg->s_rep; rep += 1) {
+      tim = time_now();
+      (void)aggstat_run_par(res, arr, (AGGSTAT_INT)stg->s_len, pars, cnt, (uint32_t)thr);
+      tim = time_now() - tim;
+
+      bst = tim < bst ? tim : bst;
+    }
+
+    chk = AGGSTAT_0_0;
+    for (idx = 0; idx < cnt; idx += 1) {
+      chk += res[idx];
+    }
+
+    report(stg, "par", thr, bst, chk);
+  }
+
+  free(arr);
+  free(cpy);
+  return true;
+}
+
+/// Parse a positive number of a command-line option.
+/// @return success/failure indication
+///
+/// @param[out] num number
+/// @param[in]  nam name of the number
+static bool
+parse_number(uintmax_t* num, const char* nam)
+{
+  errno = 0;
+  *num = strtoumax(optarg, NULL, 10);
+  if (*num == 0) {
+    (void)fprintf(stderr, "unable to parse the %s from '%s'\n", nam, optarg);
+    return false;
+  }
+
+  return true;
+}
+
+/// Parse the settings from the command-line arguments.
+/// @return success/failure indication
+///
+/// @param[in] stg  settings
+/// @param[in] argc argument count
+/// @param[in] argv argument vector
+static bool
+parse_settings(struct settings* stg, int argc, char* argv[])
+{
+  long onl;
+  int  opt;
+
+  onl = sysconf(_SC_NPROCESSORS_ONLN);
+
+  stg->s_rep = 3;
+  stg->s_len = 10000000;
+  stg->s_thr = onl > 0 ? (uintmax_t)onl : 1;
+  stg->s_hdr = false;
+
+  while (true) {
+    opt = getopt(argc, argv, "hl:r:t:");
+    if (opt == -1) {
+      break;
+    }
+
+    // Header line.
+    if (opt == 'h') {
+      stg->s_hdr = true;
+    }
+
+    // Number of values.
+    if (opt == 'l' && parse_number(&stg->s_len, "value count") == false) {
+      return false;
+    }
+
+    // Number of repetitions.
+    if (opt == 'r' && parse_number(&stg->s_rep, "repetition count") == false) {
+      return false;
+    }
+
+    // Largest number of threads.
+    if (opt == 't' && parse_number(&stg->s_thr, "thread count") == false) {
+      return false;
+    }
+
+    // Unknown option.
+    if (opt == '?') {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/// The benchmark measures the computation of four exact quantiles of an array, by the off-line
+/// algorithm that sorts the array for each quantile, and by the parallel algorithm with a doubling
+/// number of threads up to the number of online processors. The best of all repetitions is
+/// reported in milliseconds.
+int
+main(int argc, char* argv[])
+{
+  struct settings stg;
+  bool            ret;
+
+  ret = parse_settings(&stg, argc, argv);
+  if (ret == false) {
+    return EXIT_FAILURE;
+  }
+
+  if (stg.s_hdr == true) {
+    (void)printf("flt,int,opt,alg,thr,len,rep,ms,ns_per_value,chk\n");
+  }
+
+  ret = measure(&stg);
+  if (ret == false) {
+    perror("malloc");
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,44 @@
+#!/bin/bash
+# Copyright (c) 2019-2021 Daniel Lovasko
+# All Rights Reserved
+#
+# Distributed under the terms of the 2-clause BSD License. The full
+# license is in the file LICENSE, distributed as part of this software.
+
+# Usage: qnt.sh
+#
+# Measure the exact quantiles of a large array by sorting and by the parallel
+# algorithm, for all floating-point widths. The results are collected in a
+# single comma-separated file in the res directory, named after the current
+# commit.
+
+set -e
+set -x
+
+# Ensure that all relative paths remain correct.
+cd $(dirname $0)
+
+# C compilation settings.
+CC="cc"
+OPT="-march=native -mtune=native"
+CFLAGS="-I../src -D_POSIX_C_SOURCE=201912 -D_DEFAULT_SOURCE -std=c99 -Wall -Wextra -Werror"
+LDFLAGS="-lm -lpthread"
+SRCS="./qnt.c ../src/par.c ../src/run.c ../src/get.c ../src/put.c ../src/new.c"
+ARGS="${CFLAGS} ${OPT} ${SRCS} ${LDFLAGS}"
+
+REV=$(git rev-parse --short HEAD 2>/dev/null || echo unknown)
+OUT="./res/qnt_${REV}.csv"
+
+for opt in O2 O3; do
+  for flt in 32 64 80; do
+    ${CC} -DAGGSTAT_FLT_BIT=${flt} -DAGGSTAT_INT_BIT=64 -DBENCH_OPT=\"${opt}\" \
+      -o ./bin/qnt_${opt}_f${flt}_i64 -${opt} ${ARGS}
+  done
+done
+
+./bin/qnt_O2_f32_i64 -h -r1 -l1 -t1 | head -n 1 > ${OUT}
+for opt in O2 O3; do
+  for flt in 32 64 80; do
+    ./bin/qnt_${opt}_f${flt}_i64 >> ${OUT}
+  done
+done
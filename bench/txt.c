@@ -0,0 +1,309 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "agg.h"
+
+
+// Optimisation level of the benchmark build, as reported in the output.
+#ifndef BENCH_OPT
+  #define BENCH_OPT "unknown"
+#endif
+
+// Number of bytes passed to the parser at once, similar to a buffered file read.
+#define BENCH_BUF 65536
+
+/// Benchmarked text format.
+struct format {
+  const char* f_nam; ///< Name.
+  uint32_t    f_cnt; ///< Number of columns per line.
+  uint32_t    f_col; ///< Selected column.
+  char        f_dlm; ///< Delimiter.
+};
+
+/// Settings.
+struct settings {
+  uintmax_t s_rep; ///< Repetitions of each measurement.
+  uintmax_t s_len; ///< Number of lines.
+  bool      s_hdr; ///< Print the header line.
+};
+
+/// All benchmarked formats.
+static const struct format fmts[] = {
+  {"lines", 1, 0, '\n'},
+  {"csv",   8, 3, ','},
+  {"tsv",   8, 7, '\t'}
+};
+
+/// Generate a next random number.
+/// @return random number
+static uint32_t
+random_number(void)
+{
+  static uint32_t num = 77;
+
+  num = (num * 214013 + 2531011) & (((uint32_t)1 << 31) - 1);
+  return num;
+}
+
+/// Obtain the current time with minimal external effects.
+/// @return nanoseconds
+static uint64_t
+time_now(void)
+{
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/// Generate the text of a format, with values that resemble measurements printed by common tools:
+/// fixed-point numbers with up to six fractional digits, and occasional scientific notation.
+/// @return text (must be freed)
+///
+/// @param[out] len length of the text
+/// @param[in]  fmt format
+/// @param[in]  lns number of lines
+static char*
+generate_text(size_t* len, const struct format* fmt, const uintmax_t lns)
+{
+  char*     txt;
+  size_t    cap;
+  size_t    pos;
+  uintmax_t lin;
+  uint32_t  col;
+  uint32_t  num;
+  int       ret;
+
+  cap = (size_t)lns * fmt->f_cnt * 24 + 1;
+  txt = malloc(cap);
+  if (txt == NULL) {
+    return NULL;
+  }
+
+  pos = 0;
+  for (lin = 0; lin < lns; lin += 1) {
+    for (col = 0; col < fmt->f_cnt; col += 1) {
+      num = random_number();
+      if (num % 16 == 0) {
+        ret = snprintf(txt + pos, cap - pos, "%.4e", (double)num * 1e-7);
+      } else {
+        ret = snprintf(txt + pos, cap - pos, "%.*f", (int)(num % 7), (double)num / 65536.0);
+      }
+
+      pos += (size_t)ret;
+      txt[pos] = col + 1 == fmt->f_cnt ? '\n' : fmt->f_dlm;
+      pos += 1;
+    }
+  }
+
+  txt[pos] = '\0';
+  *len     = pos;
+  return txt;
+}
+
+/// Parse the text by the library parser.
+///
+/// @param[in] agg aggregated values
+/// @param[in] txt text
+/// @param[in] len length of the text
+/// @param[in] fmt format
+static void
+parse_library(struct aggstat* agg, const char* txt, const size_t len, const struct format* fmt)
+{
+  struct aggstat_txt prs;
+  size_t             pos;
+  size_t             rem;
+
+  aggstat_txt_new(&prs, fmt->f_dlm, fmt->f_col);
+  for (pos = 0; pos < len; pos += rem) {
+    rem = len - pos < BENCH_BUF ? len - pos : BENCH_BUF;
+    aggstat_txt_put(&prs, txt + pos, rem, agg, 2);
+  }
+
+  aggstat_txt_end(&prs, agg, 2);
+}
+
+/// Parse the text by the standard library, as a baseline.
+///
+/// @param[in] agg aggregated values
+/// @param[in] txt text (must be terminated by a null character)
+/// @param[in] fmt format
+static void
+parse_standard(struct aggstat* agg, const char* txt, const struct format* fmt)
+{
+  const char* cur;
+  char*       end;
+  AGGSTAT_FLT val;
+  uint32_t    col;
+
+  cur = txt;
+  while (*cur != '\0') {
+    for (col = 0; col < fmt->f_col; col += 1) {
+      cur = strchr(cur, fmt->f_dlm) + 1;
+    }
+
+    val = AGGSTAT_STRTO(cur, &end);
+    aggstat_put(&agg[0], val);
+    aggstat_put(&agg[1], val);
+    cur = strchr(end, '\n') + 1;
+  }
+}
+
+/// Measure the throughput of both parsers.
+///
+/// @param[in] stg settings
+/// @param[in] tms array of measurements
+/// @param[in] fmt format
+static bool
+measure(const struct settings* stg, uint64_t* tms, const struct format* fmt)
+{
+  struct aggstat agg[2];
+  AGGSTAT_FLT    res[2];
+  char*          txt;
+  size_t         len;
+  uintmax_t      rep;
+  uint64_t       bst;
+  uint8_t        prs;
+
+  txt = generate_text(&len, fmt, stg->s_len);
+  if (txt == NULL) {
+    return false;
+  }
+
+  for (prs = 0; prs < 2; prs += 1) {
+    bst = UINT64_MAX;
+    for (rep = 0; rep < stg->s_rep; rep += 1) {
+      aggstat_new(&agg[0], AGGSTAT_FNC_AVG, AGGSTAT_0_0);
+      aggstat_new(&agg[1], AGGSTAT_FNC_MAX, AGGSTAT_0_0);
+
+      tms[rep] = time_now();
+      if (prs == 0) {
+        parse_library(agg, txt, len, fmt);
+      } else {
+        parse_standard(agg, txt, fmt);
+      }
+      tms[rep] = time_now() - tms[rep];
+
+      bst = tms[rep] < bst ? tms[rep] : bst;
+    }
+
+    // Ensure that the parsing is not optimised away.
+    (void)aggstat_get(&agg[0], &res[0]);
+    (void)aggstat_get(&agg[1], &res[1]);
+
+    (void)printf("%d,%d,%s,%s,%s,%zu,%" PRIuMAX ",%.2f,%.2f,%.6g\n",
+                 AGGSTAT_FLT_BIT, AGGSTAT_INT_BIT, BENCH_OPT, fmt->f_nam,
+                 prs == 0 ? "aggstat" : "strto", len, stg->s_rep,
+                 (double)len * 1e3 / (double)bst,
+                 (double)bst / (double)stg->s_len,
+                 (double)res[0] + (double)res[1]);
+  }
+
+  free(txt);
+  return true;
+}
+
+/// Parse the settings from the command-line arguments.
+/// @return success/failure indication
+///
+/// @param[in] stg  settings
+/// @param[in] argc argument count
+/// @param[in] argv argument vector
+static bool
+parse_settings(struct settings* stg, int argc, char* argv[])
+{
+  int opt;
+
+  stg->s_rep = 5;
+  stg->s_len = 1000000;
+  stg->s_hdr = false;
+
+  while (true) {
+    opt = getopt(argc, argv, "hl:r:");
+    if (opt == -1) {
+      break;
+    }
+
+    // Header line.
+    if (opt == 'h') {
+      stg->s_hdr = true;
+    }
+
+    // Number of lines.
+    if (opt == 'l') {
+      errno = 0;
+      stg->s_len = strtoumax(optarg, NULL, 10);
+      if (stg->s_len == 0) {
+        (void)fprintf(stderr, "unable to parse the line count from '%s'\n", optarg);
+        return false;
+      }
+    }
+
+    // Number of repetitions.
+    if (opt == 'r') {
+      errno = 0;
+      stg->s_rep = strtoumax(optarg, NULL, 10);
+      if (stg->s_rep == 0) {
+        (void)fprintf(stderr, "unable to parse the repetition count from '%s'\n", optarg);
+        return false;
+      }
+    }
+
+    // Unknown option.
+    if (opt == '?') {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/// The benchmark measures the throughput of the text ingestion into two aggregates, for multiple
+/// text formats, and compares it to a baseline that splits the lines and converts the selected
+/// field by the standard library. The best of all repetitions is reported in megabytes per second.
+int
+main(int argc, char* argv[])
+{
+  struct settings stg;
+  uint64_t*       tms;
+  size_t          fix;
+  bool            ret;
+
+  ret = parse_settings(&stg, argc, argv);
+  if (ret == false) {
+    return EXIT_FAILURE;
+  }
+
+  tms = malloc(sizeof(*tms) * stg.s_rep);
+  if (tms == NULL) {
+    perror("malloc");
+    return EXIT_FAILURE;
+  }
+
+  if (stg.s_hdr == true) {
+    (void)printf("flt,int,opt,fmt,prs,bytes,rep,mb_per_s,ns_per_line,chk\n");
+  }
+
+  for (fix = 0; fix < sizeof(fmts) / sizeof(fmts[0]); fix += 1) {
+    ret = measure(&stg, tms, &fmts[fix]);
+    if (ret == false) {
+      perror("malloc");
+      free(tms);
+      return EXIT_FAILURE;
+    }
+  }
+
+  free(tms);
+  return EXIT_SUCCESS;
+}
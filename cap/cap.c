@@ -7,39 +7,219 @@
 #include <unistd.h>
 #include <errno.h>
 #include <fenv.h>
+#include <pthread.h>
 
 #include "agg.h"
 
 
+// Input distributions of the values.
+#define CAP_DST_UNI 0 // Uniform.
+#define CAP_DST_NRM 1 // Normal.
+#define CAP_DST_LGN 2 // Log-normal.
+#define CAP_DST_SRT 3 // Sorted uniform.
+#define CAP_DST_PAR 4 // Heavy-tailed (Pareto with the shape of 1.5).
+
+// Number of random bits of a unit number, which leaves one more bit of the significand for the
+// half that keeps the number away from both ends of the interval.
+#if AGGSTAT_FLT_BIT == 32
+  #define CAP_BIT 23
+#else
+  #define CAP_BIT 52
+#endif
+
 /// Settings.
 struct settings {
   AGGSTAT_INT  s_len; ///< Length of the stream.
   uintmax_t    s_rep; ///< Repetitions of the test measurements.
-  AGGSTAT_FLT  s_scl; ///< Scale of the values. 
+  uintmax_t    s_thr; ///< Number of threads.
+  uint64_t     s_sed; ///< Seed of the random number generator.
+  AGGSTAT_FLT  s_scl; ///< Scale of the values.
   AGGSTAT_FLT  s_off; ///< Offset of the values.
   AGGSTAT_FLT  s_par; ///< Aggregate function parameter.
   uint8_t      s_fnc; ///< Aggregate function.
+  uint8_t      s_dst; ///< Input distribution.
+};
+
+/// Comparisons performed by a single thread.
+struct worker {
+  const struct settings* w_stg;    ///< Settings.
+  AGGSTAT_FLT*           w_arr;    ///< Memory for stream emulation.
+  uintmax_t              w_fst;    ///< First repetition.
+  uintmax_t              w_lst;    ///< Last repetition (exclusive).
+  AGGSTAT_FLT            w_max;    ///< Largest difference.
+  bool                   w_ovr[2]; ///< Overflow exceptions.
+  bool                   w_udr[2]; ///< Underflow exceptions.
+  bool                   w_ine[2]; ///< Inexact computation exceptions.
+  pthread_t              w_thr;    ///< Thread.
+  bool                   w_run;    ///< Thread was started.
 };
 
+/// Generate the next number of a 64-bit sequence that is used to seed the generator (SplitMix64).
+/// @return random number
+///
+/// @param[in] sta state
+static uint64_t
+random_seed(uint64_t* sta)
+{
+  uint64_t val;
+
+  *sta += UINT64_C(0x9e3779b97f4a7c15);
+  val   = *sta;
+  val   = (val ^ (val >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+  val   = (val ^ (val >> 27)) * UINT64_C(0x94d049bb133111eb);
+
+  return val ^ (val >> 31);
+}
+
+/// Rotate a 64-bit number to the left.
+/// @return rotated number
+///
+/// @param[in] val number
+/// @param[in] cnt number of bits
+static uint64_t
+rotate_left(const uint64_t val, const int cnt)
+{
+  return (val << cnt) | (val >> (64 - cnt));
+}
+
+/// Generate the next random number (xoshiro256**).
+/// @return random number
+///
+/// @param[in] sta state
+static uint64_t
+random_next(uint64_t* sta)
+{
+  uint64_t val;
+  uint64_t tmp;
+
+  val = rotate_left(sta[1] * 5, 7) * 9;
+  tmp = sta[1] << 17;
+
+  sta[2] ^= sta[0];
+  sta[3] ^= sta[1];
+  sta[1] ^= sta[2];
+  sta[0] ^= sta[3];
+  sta[2] ^= tmp;
+  sta[3]  = rotate_left(sta[3], 45);
+
+  return val;
+}
+
+/// Generate a random number from the interval (0.0, 1.0).
+/// @return random number
+///
+/// The number is the centre of one of the 2^CAP_BIT equal parts of the interval, which is exact in
+/// the floating-point type, and thus it is never rounded to either end.
+///
+/// @param[in] sta state
+static AGGSTAT_FLT
+random_unit(uint64_t* sta)
+{
+  return ((AGGSTAT_FLT)(random_next(sta) >> (64 - CAP_BIT)) + AGGSTAT_0_5)
+       / (AGGSTAT_FLT)(UINT64_C(1) << CAP_BIT);
+}
+
+/// Generate a random number from the standard normal distribution (Marsaglia polar method).
+/// @return random number
+///
+/// The method produces two independent numbers, and the second one is retained for the next call.
+///
+/// @param[in] sta state
+/// @param[in] spr spare number
+/// @param[in] has availability of the spare number
+static AGGSTAT_FLT
+random_normal(uint64_t* sta, AGGSTAT_FLT* spr, bool* has)
+{
+  AGGSTAT_FLT x;
+  AGGSTAT_FLT y;
+  AGGSTAT_FLT s;
+
+  if (*has == true) {
+    *has = false;
+    return *spr;
+  }
+
+  do {
+    x = AGGSTAT_2_0 * random_unit(sta) - AGGSTAT_1_0;
+    y = AGGSTAT_2_0 * random_unit(sta) - AGGSTAT_1_0;
+    s = x * x + y * y;
+  } while (s >= AGGSTAT_1_0 || s == AGGSTAT_0_0);
+
+  s    = AGGSTAT_SQRT(-AGGSTAT_2_0 * (AGGSTAT_FLT)log((double)s) / s);
+  *spr = y * s;
+  *has = true;
+
+  return x * s;
+}
+
 /// Fill the array with random values.
 ///
+/// The generator of each repetition is seeded from the seed and the index of the repetition, and
+/// thus the values do not depend on the number of threads. The sorted uniform values are the
+/// normalised sums of exponential spacings, which avoids the sort of the whole array.
+///
 /// @param[in] arr array
-/// @param[in] len length of the array
-/// @param[in] mul value multiplier
-/// @param[in] off value offset
+/// @param[in] stg settings
+/// @param[in] rep index of the repetition
 static void
-fill_array(      AGGSTAT_FLT* arr,
-           const AGGSTAT_INT  len,
-           const AGGSTAT_FLT  mul,
-           const AGGSTAT_FLT  off)
+fill_array(AGGSTAT_FLT* arr, const struct settings* stg, const uintmax_t rep)
 {
   AGGSTAT_INT idx;
   AGGSTAT_FLT val;
+  AGGSTAT_FLT spr;
+  double      sum;
+  uint64_t    sed;
+  uint64_t    sta[4];
+  bool        has;
+
+  sed    = (uint64_t)rep;
+  sed    = stg->s_sed ^ random_seed(&sed);
+  sta[0] = random_seed(&sed);
+  sta[1] = random_seed(&sed);
+  sta[2] = random_seed(&sed);
+  sta[3] = random_seed(&sed);
+  has    = false;
+  spr    = AGGSTAT_0_0;
+  sum    = 0.0;
+
+  for (idx = 0; idx < stg->s_len; idx += 1) {
+    switch (stg->s_dst) {
+      case CAP_DST_NRM:
+        val = random_normal(sta, &spr, &has);
+        break;
+
+      case CAP_DST_LGN:
+        val = (AGGSTAT_FLT)exp((double)random_normal(sta, &spr, &has));
+        break;
+
+      case CAP_DST_SRT:
+        sum -= log((double)random_unit(sta));
+        val  = (AGGSTAT_FLT)sum;
+        break;
+
+      case CAP_DST_PAR:
+        val = AGGSTAT_POW(random_unit(sta), -AGGSTAT_1_0 / AGGSTAT_1_5);
+        break;
+
+      default:
+        val = random_unit(sta);
+        break;
+    }
 
-  for (idx = 0; idx < len; idx += 1) {
-    val = (AGGSTAT_FLT)rand() / (AGGSTAT_FLT)RAND_MAX * mul + off;
     arr[idx] = val;
   }
+
+  // Normalise the sums of spacings to the unit interval.
+  if (stg->s_dst == CAP_DST_SRT) {
+    sum -= log((double)random_unit(sta));
+    for (idx = 0; idx < stg->s_len; idx += 1) {
+      arr[idx] /= (AGGSTAT_FLT)sum;
+    }
+  }
+
+  for (idx = 0; idx < stg->s_len; idx += 1) {
+    arr[idx] = arr[idx] * stg->s_scl + stg->s_off;
+  }
 }
 
 /// Perform the computation of the aggregated value using the streaming algorithms.
@@ -159,6 +339,27 @@ parse_function(const char* str)
   return 0;
 }
 
+/// Parse the input distribution from a shortcut.
+/// @return success/failure indication
+///
+/// @param[out] dst input distribution
+/// @param[in]  str input string
+static bool
+parse_distribution(uint8_t* dst, const char* str)
+{
+  static const char* nams[] = {"uni", "nrm", "lgn", "srt", "par"};
+  uint8_t            idx;
+
+  for (idx = 0; idx < sizeof(nams) / sizeof(nams[0]); idx += 1) {
+    if (strcmp(str, nams[idx]) == 0) {
+      *dst = idx;
+      return true;
+    }
+  }
+
+  return false;
+}
+
 /// Parse the settings from the command-line arguments.
 /// @return success/failure indication
 ///
@@ -170,14 +371,35 @@ parse_settings(struct settings* stg, int argc, char* argv[])
 {
   int       opt;
   int       ret;
+  long      onl;
   uintmax_t val;
 
+  onl = sysconf(_SC_NPROCESSORS_ONLN);
+
+  stg->s_len = 1000;
+  stg->s_rep = 1000;
+  stg->s_thr = onl > 0 ? (uintmax_t)onl : 1;
+  stg->s_sed = (uint64_t)time(NULL);
+  stg->s_scl = AGGSTAT_1_0;
+  stg->s_off = AGGSTAT_0_0;
+  stg->s_par = AGGSTAT_0_0;
+  stg->s_fnc = AGGSTAT_FNC_AVG;
+  stg->s_dst = CAP_DST_UNI;
+
   while (true) {
-    opt = getopt(argc, argv, "f:l:o:p:r:s:");
+    opt = getopt(argc, argv, "d:f:l:o:p:r:s:t:x:");
     if (opt == -1) {
       break;
     }
 
+    // Input distribution.
+    if (opt == 'd') {
+      if (parse_distribution(&stg->s_dst, optarg) == false) {
+        fprintf(stderr, "unable to parse the distribution from '%s'\n", optarg);
+        return false;
+      }
+    }
+
     // Aggregate function to test.
     if (opt == 'f') {
       stg->s_fnc = parse_function(optarg);
@@ -192,7 +414,7 @@ parse_settings(struct settings* stg, int argc, char* argv[])
       val = strtoumax(optarg, NULL, 10);
       if (val == 0 && errno != 0) {
         fprintf(stderr, "unable to parse the stream length from '%s'\n", optarg);
-        return false;	
+        return false;
       }
 
       if (val > AGGSTAT_INT_MAX) {
@@ -239,6 +461,20 @@ parse_settings(struct settings* stg, int argc, char* argv[])
       }
     }
 
+    // Number of threads.
+    if (opt == 't') {
+      stg->s_thr = strtoumax(optarg, NULL, 10);
+      if (stg->s_thr == 0) {
+        fprintf(stderr, "unable to parse the thread count from '%s'\n", optarg);
+        return false;
+      }
+    }
+
+    // Seed of the random number generator.
+    if (opt == 'x') {
+      stg->s_sed = (uint64_t)strtoumax(optarg, NULL, 10);
+    }
+
     // Unknown option.
     if (opt == '?') {
       fprintf(stderr, "unknown option '%c'\n", opt);
@@ -263,72 +499,138 @@ read_exceptions(bool* ovr, bool* udr, bool* ine)
   flag = FE_UNDERFLOW | FE_OVERFLOW | FE_INEXACT;
 
   test = fetestexcept(flag);
-  *udr = *udr || (test & FE_OVERFLOW);
-  *ovr = *ovr || (test & FE_UNDERFLOW);
+  *udr = *udr || (test & FE_UNDERFLOW);
+  *ovr = *ovr || (test & FE_OVERFLOW);
   *ine = *ine || (test & FE_INEXACT);
 
   feclearexcept(flag);
 }
 
-/// Perform repeated comparisons of streaming and standard algorithms and find
-/// their largest difference.
+/// Perform a range of repeated comparisons of streaming and standard algorithms and find their
+/// largest difference.
+/// @return NULL
 ///
-/// @param[in] arr memory for stream emulation
-/// @param[in] stg settings
-static void
-run_comparisons(AGGSTAT_FLT* arr, struct settings* stg)
+/// The floating-point environment is local to each thread, and so are the exceptions.
+///
+/// @param[in] arg worker
+static void*
+run_comparisons(void* arg)
 {
-  uintmax_t   rep;
-  AGGSTAT_FLT max;
-  AGGSTAT_FLT dif;
-  AGGSTAT_FLT val[2];
-  bool        ovr[2];
-  bool        udr[2];
-  bool        ine[2];
-  bool        dum;
-
-  // Assume no exceptions.
-  ovr[0] = false;
-  ovr[1] = false;
-  udr[0] = false;
-  udr[1] = false;
-  ine[0] = false;
-  ine[1] = false;
-  
-  // Repeatedly generate a new array and compute both values.
-  max = AGGSTAT_NUM(0, 0, +, 0);
-  for (rep = 0; rep < stg->s_rep; rep += 1) {
+  struct worker* wrk;
+  uintmax_t      rep;
+  AGGSTAT_FLT    dif;
+  AGGSTAT_FLT    val[2];
+  bool           dum;
+
+  wrk = arg;
+  for (rep = wrk->w_fst; rep < wrk->w_lst; rep += 1) {
     // Prepare the array and clear any exceptions that might have been caused
     // by the random number generation.
-    fill_array(arr, stg->s_len, stg->s_scl, stg->s_off);
+    fill_array(wrk->w_arr, wrk->w_stg, rep);
     read_exceptions(&dum, &dum, &dum);
 
     // Execute the streaming computation.
-    val[0] = compute_online(arr, stg->s_len, stg->s_fnc, stg->s_par);
-    read_exceptions(&ovr[0], &udr[0], &ine[0]);
-    
+    val[0] = compute_online(wrk->w_arr, wrk->w_stg->s_len, wrk->w_stg->s_fnc, wrk->w_stg->s_par);
+    read_exceptions(&wrk->w_ovr[0], &wrk->w_udr[0], &wrk->w_ine[0]);
+
     // Execute the standard computation.
-    val[1] = compute_offline(arr, stg->s_len, stg->s_fnc, stg->s_par);
-    read_exceptions(&ovr[1], &udr[1], &ine[1]);
+    val[1] = compute_offline(wrk->w_arr, wrk->w_stg->s_len, wrk->w_stg->s_fnc, wrk->w_stg->s_par);
+    read_exceptions(&wrk->w_ovr[1], &wrk->w_udr[1], &wrk->w_ine[1]);
 
     // Potentially set the new maximum.
     dif = AGGSTAT_ABS(val[0] - val[1]);
-    if (dif > max) {
-      max = dif;
+    if (dif > wrk->w_max) {
+      wrk->w_max = dif;
+    }
+  }
+
+  return NULL;
+}
+
+/// Distribute the repetitions among the threads and combine their results.
+/// @return success/failure indication
+///
+/// Each thread has its own array, and thus the memory grows with the number of threads, which is
+/// limited by the number of repetitions.
+///
+/// @param[in] stg settings
+static bool
+run_threads(const struct settings* stg)
+{
+  struct worker* wrk;
+  uintmax_t      cnt;
+  uintmax_t      idx;
+  AGGSTAT_FLT    max;
+  bool           ovr[2];
+  bool           udr[2];
+  bool           ine[2];
+  bool           ret;
+  uint8_t        alg;
+
+  cnt = stg->s_thr < stg->s_rep ? stg->s_thr : stg->s_rep;
+  cnt = cnt > 0 ? cnt : 1;
+  wrk = calloc(cnt, sizeof(*wrk));
+  if (wrk == NULL) {
+    return false;
+  }
+
+  // Start one thread for each contiguous range of repetitions.
+  ret = true;
+  for (idx = 0; idx < cnt; idx += 1) {
+    wrk[idx].w_stg = stg;
+    wrk[idx].w_fst = stg->s_rep * idx / cnt;
+    wrk[idx].w_lst = stg->s_rep * (idx + 1) / cnt;
+    wrk[idx].w_max = AGGSTAT_0_0;
+    wrk[idx].w_arr = calloc(sizeof(AGGSTAT_FLT), stg->s_len);
+    if (wrk[idx].w_arr == NULL) {
+      ret = false;
+      break;
+    }
+
+    wrk[idx].w_run = pthread_create(&wrk[idx].w_thr, NULL, run_comparisons, &wrk[idx]) == 0;
+    if (wrk[idx].w_run == false) {
+      ret = false;
+      break;
     }
   }
 
+  // Combine the results of all threads.
+  max = AGGSTAT_0_0;
+  (void)memset(ovr, 0, sizeof(ovr));
+  (void)memset(udr, 0, sizeof(udr));
+  (void)memset(ine, 0, sizeof(ine));
+  for (idx = 0; idx < cnt; idx += 1) {
+    if (wrk[idx].w_run == true) {
+      (void)pthread_join(wrk[idx].w_thr, NULL);
+    }
+
+    max = wrk[idx].w_max > max ? wrk[idx].w_max : max;
+    for (alg = 0; alg < 2; alg += 1) {
+      ovr[alg] = ovr[alg] || wrk[idx].w_ovr[alg];
+      udr[alg] = udr[alg] || wrk[idx].w_udr[alg];
+      ine[alg] = ine[alg] || wrk[idx].w_ine[alg];
+    }
+
+    free(wrk[idx].w_arr);
+  }
+
+  free(wrk);
+  if (ret == false) {
+    return false;
+  }
+
   (void)printf(AGGSTAT_FMT "(%s%s%s)(%s%s%s) ",
     max,
     ovr[0] ? "o" : "", udr[0] ? "u" : "", ine[0] ? "i" : "",
     ovr[1] ? "o" : "", udr[1] ? "u" : "", ine[1] ? "i" : "");
+
+  return true;
 }
 
 int
 main(int argc, char* argv[])
 {
   struct settings stg;
-  AGGSTAT_FLT*    arr;
   bool            ret;
 
   // Parse input from command-line.
@@ -337,18 +639,12 @@ main(int argc, char* argv[])
     return EXIT_FAILURE;
   }
 
-  // Initialise the random seed.
-  srand(time(NULL));
-
-  // Allocate the array of numbers.
-  arr = calloc(sizeof(AGGSTAT_FLT), stg.s_len);
-  if (arr == NULL) {
-    perror("calloc");
+  // Find the cap of the error value.
+  ret = run_threads(&stg);
+  if (ret == false) {
+    perror("run_threads");
     return EXIT_FAILURE;
   }
 
-  // Find the cap of the error value.
-  run_comparisons(arr, &stg);
-
   return EXIT_SUCCESS;
 }
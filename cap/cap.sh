@@ -5,6 +5,15 @@
 # Distributed under the terms of the 2-clause BSD License. The full
 # license is in the file LICENSE, distributed as part of this software.
 
+# Usage: cap.sh [distribution] [threads]
+#
+# Find the caps of the errors of all aggregate functions for all supported bit
+# widths, for values of the given distribution (uni, nrm, lgn, srt or par) that
+# defaults to the uniform one. Each run of cap splits its repetitions across the
+# given number of threads, which defaults to all online processors, and thus the
+# functions are measured one after another. The results are stored in the res
+# directory, named after the distribution, bit widths and function.
+
 set -x
 
 # Ensure that all relative paths remain correct.
@@ -12,15 +21,24 @@ cd $(dirname $0)
 
 # C compilation settings.
 CC="cc"
-OPT="-flto -march=native -mtune=native"
+OPT="-O2 -flto -march=native -mtune=native"
 CFLAGS="-I../src -D_POSIX_C_SOURCE=201912 -std=c99 -Wall -Wextra -Werror"
-LDFLAGS="-lm"
+LDFLAGS="-lm -lpthread"
 SRCS="./cap.c ../src/get.c ../src/put.c ../src/new.c ../src/run.c"
 ARGS="${CFLAGS} ${OPT} ${SRCS} ${LDFLAGS}"
 
+DIST=${1:-uni}
+THREADS=${2:-$(nproc)}
 REPEAT=1000
 SCALE=100.0
 OFFSET=0.0
+SEED=1
+
+# Lengths of the streams. Each thread holds a single stream in memory, and thus
+# the longest stream requires THREADS * length * sizeof(AGGSTAT_FLT) bytes,
+# which is 4 GB per thread for a billion values of the 32-bit floating-point
+# type. Append 100000000 and 1000000000 to extend the search to such lengths.
+LENGTHS="10 100 1000 10000 100000 1000000 10000000"
 
 # Execute the testing for a selected aggregate function.
 # param 1: floating-point bit width
@@ -29,15 +47,10 @@ OFFSET=0.0
 # param 4: aggregate function argument
 run_for_func() {
   echo -n "$2 "
-  ./bin/cap_o0_f$1_i$2 -f$3 -p$4 -s${SCALE} -o${OFFSET} -r${REPEAT} -l10
-  ./bin/cap_o0_f$1_i$2 -f$3 -p$4 -s${SCALE} -o${OFFSET} -r${REPEAT} -l100
-  ./bin/cap_o0_f$1_i$2 -f$3 -p$4 -s${SCALE} -o${OFFSET} -r${REPEAT} -l1000
-  ./bin/cap_o0_f$1_i$2 -f$3 -p$4 -s${SCALE} -o${OFFSET} -r${REPEAT} -l10000
-  ./bin/cap_o0_f$1_i$2 -f$3 -p$4 -s${SCALE} -o${OFFSET} -r${REPEAT} -l100000
-  ./bin/cap_o0_f$1_i$2 -f$3 -p$4 -s${SCALE} -o${OFFSET} -r${REPEAT} -l1000000
-  ./bin/cap_o0_f$1_i$2 -f$3 -p$4 -s${SCALE} -o${OFFSET} -r${REPEAT} -l10000000
-#  ./bin/cap_o0_f$1_i$2 -f$3 -p$4 -s${SCALE} -o${OFFSET} -r${REPEAT} -l100000000
-#  ./bin/cap_o0_f$1_i$2 -f$3 -p$4 -s${SCALE} -o${OFFSET} -r${REPEAT} -l1000000000
+  for len in ${LENGTHS}; do
+    ./bin/cap_o2_f$1_i$2 -f$3 -p$4 -s${SCALE} -o${OFFSET} -r${REPEAT} -l${len} \
+      -d${DIST} -t${THREADS} -x${SEED}
+  done
   echo
 }
 
@@ -45,71 +58,34 @@ run_for_func() {
 # param 1: floating-point bit width
 # param 2: integer bit width
 run_for_bits() {
-  run_for_func $1 $2 fst 0.0  > ./res/f$1_i$2_fst     &
-  run_for_func $1 $2 lst 0.0  > ./res/f$1_i$2_lst     &
-  wait
-
-  run_for_func $1 $2 cnt 0.0  > ./res/f$1_i$2_cnt     &
-  run_for_func $1 $2 sum 0.0  > ./res/f$1_i$2_sum     &
-  wait
-
-  run_for_func $1 $2 min 0.0  > ./res/f$1_i$2_min     &
-  run_for_func $1 $2 max 0.0  > ./res/f$1_i$2_max     &
-  wait
-
-  run_for_func $1 $2 avg 0.0  > ./res/f$1_i$2_avg     &
-  run_for_func $1 $2 var 0.0  > ./res/f$1_i$2_var     &
-  wait
-
-  run_for_func $1 $2 skw 0.0  > ./res/f$1_i$2_skw     &
-  run_for_func $1 $2 krt 0.0  > ./res/f$1_i$2_krt     &
-  wait
-
-  run_for_func $1 $2 qnt 0.1  > ./res/f$1_i$2_qnt_01  &
-  run_for_func $1 $2 qnt 0.75 > ./res/f$1_i$2_qnt_075 &
-  wait
-
-  run_for_func $1 $2 qnt 0.9  > ./res/f$1_i$2_qnt_09  &
-  run_for_func $1 $2 qnt 0.99 > ./res/f$1_i$2_qnt_099 &
-  wait
-
-  run_for_func $1 $2 med 0.0  > ./res/f$1_i$2_med     &
-  run_for_func $1 $2 dev 0.0  > ./res/f$1_i$2_dev     &
-  wait
+  run_for_func $1 $2 fst 0.0  > ./res/${DIST}_f$1_i$2_fst
+  run_for_func $1 $2 lst 0.0  > ./res/${DIST}_f$1_i$2_lst
+  run_for_func $1 $2 cnt 0.0  > ./res/${DIST}_f$1_i$2_cnt
+  run_for_func $1 $2 sum 0.0  > ./res/${DIST}_f$1_i$2_sum
+  run_for_func $1 $2 min 0.0  > ./res/${DIST}_f$1_i$2_min
+  run_for_func $1 $2 max 0.0  > ./res/${DIST}_f$1_i$2_max
+  run_for_func $1 $2 avg 0.0  > ./res/${DIST}_f$1_i$2_avg
+  run_for_func $1 $2 var 0.0  > ./res/${DIST}_f$1_i$2_var
+  run_for_func $1 $2 skw 0.0  > ./res/${DIST}_f$1_i$2_skw
+  run_for_func $1 $2 krt 0.0  > ./res/${DIST}_f$1_i$2_krt
+  run_for_func $1 $2 qnt 0.1  > ./res/${DIST}_f$1_i$2_qnt_01
+  run_for_func $1 $2 qnt 0.75 > ./res/${DIST}_f$1_i$2_qnt_075
+  run_for_func $1 $2 qnt 0.9  > ./res/${DIST}_f$1_i$2_qnt_09
+  run_for_func $1 $2 qnt 0.99 > ./res/${DIST}_f$1_i$2_qnt_099
+  run_for_func $1 $2 med 0.0  > ./res/${DIST}_f$1_i$2_med
+  run_for_func $1 $2 dev 0.0  > ./res/${DIST}_f$1_i$2_dev
 }
 
-${CC} -DAGGSTAT_FLT_BIT=32  -DAGGSTAT_INT_BIT=16  -o ./bin/cap_o0_f32_i16   -O0 ${ARGS}
-${CC} -DAGGSTAT_FLT_BIT=32  -DAGGSTAT_INT_BIT=32  -o ./bin/cap_o0_f32_i32   -O0 ${ARGS}
-${CC} -DAGGSTAT_FLT_BIT=32  -DAGGSTAT_INT_BIT=64  -o ./bin/cap_o0_f32_i64   -O0 ${ARGS}
-${CC} -DAGGSTAT_FLT_BIT=32  -DAGGSTAT_INT_BIT=128 -o ./bin/cap_o0_f32_i128  -O0 ${ARGS}
-${CC} -DAGGSTAT_FLT_BIT=64  -DAGGSTAT_INT_BIT=16  -o ./bin/cap_o0_f64_i16   -O0 ${ARGS}
-${CC} -DAGGSTAT_FLT_BIT=64  -DAGGSTAT_INT_BIT=32  -o ./bin/cap_o0_f64_i32   -O0 ${ARGS}
-${CC} -DAGGSTAT_FLT_BIT=64  -DAGGSTAT_INT_BIT=64  -o ./bin/cap_o0_f64_i64   -O0 ${ARGS}
-${CC} -DAGGSTAT_FLT_BIT=64  -DAGGSTAT_INT_BIT=128 -o ./bin/cap_o0_f64_i128  -O0 ${ARGS}
-${CC} -DAGGSTAT_FLT_BIT=80  -DAGGSTAT_INT_BIT=16  -o ./bin/cap_o0_f80_i16   -O0 ${ARGS}
-${CC} -DAGGSTAT_FLT_BIT=80  -DAGGSTAT_INT_BIT=32  -o ./bin/cap_o0_f80_i32   -O0 ${ARGS}
-${CC} -DAGGSTAT_FLT_BIT=80  -DAGGSTAT_INT_BIT=64  -o ./bin/cap_o0_f80_i64   -O0 ${ARGS}
-${CC} -DAGGSTAT_FLT_BIT=80  -DAGGSTAT_INT_BIT=128 -o ./bin/cap_o0_f80_i128  -O0 ${ARGS}
-${CC} -DAGGSTAT_FLT_BIT=128 -DAGGSTAT_INT_BIT=16  -o ./bin/cap_o0_f128_i16  -O0 ${ARGS}
-${CC} -DAGGSTAT_FLT_BIT=128 -DAGGSTAT_INT_BIT=32  -o ./bin/cap_o0_f128_i32  -O0 ${ARGS}
-${CC} -DAGGSTAT_FLT_BIT=128 -DAGGSTAT_INT_BIT=64  -o ./bin/cap_o0_f128_i64  -O0 ${ARGS}
-${CC} -DAGGSTAT_FLT_BIT=128 -DAGGSTAT_INT_BIT=128 -o ./bin/cap_o0_f128_i128 -O0 ${ARGS}
-
-run_for_bits 32  16
-run_for_bits 32  32
-run_for_bits 32  64
-run_for_bits 32  128
-run_for_bits 64  16
-run_for_bits 64  32
-run_for_bits 64  64
-run_for_bits 64  128
-run_for_bits 80  16
-run_for_bits 80  32
-run_for_bits 80  64
-run_for_bits 80  128
-run_for_bits 128 16
-run_for_bits 128 32
-run_for_bits 128 64
-run_for_bits 128 128
-
-wait
+${CC} -DAGGSTAT_FLT_BIT=32 -DAGGSTAT_INT_BIT=32 -o ./bin/cap_o2_f32_i32 ${ARGS}
+${CC} -DAGGSTAT_FLT_BIT=32 -DAGGSTAT_INT_BIT=64 -o ./bin/cap_o2_f32_i64 ${ARGS}
+${CC} -DAGGSTAT_FLT_BIT=64 -DAGGSTAT_INT_BIT=32 -o ./bin/cap_o2_f64_i32 ${ARGS}
+${CC} -DAGGSTAT_FLT_BIT=64 -DAGGSTAT_INT_BIT=64 -o ./bin/cap_o2_f64_i64 ${ARGS}
+${CC} -DAGGSTAT_FLT_BIT=80 -DAGGSTAT_INT_BIT=32 -o ./bin/cap_o2_f80_i32 ${ARGS}
+${CC} -DAGGSTAT_FLT_BIT=80 -DAGGSTAT_INT_BIT=64 -o ./bin/cap_o2_f80_i64 ${ARGS}
+
+run_for_bits 32 32
+run_for_bits 32 64
+run_for_bits 64 32
+run_for_bits 64 64
+run_for_bits 80 32
+run_for_bits 80 64
@@ -0,0 +1,726 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "agg.h"
+
+
+// Maximal number of functions computed in a single run.
+#define CLI_FNC_MAX 32
+
+// Maximal number of worker threads.
+#define CLI_THR_MAX 256
+
+// Number of values converted at once into the floating-point type.
+#define CLI_BLK 4096
+
+// Number of values that each worker requests to be read ahead of its position.
+#define CLI_AHD (1 << 22)
+
+// Number of significant digits that are printed for each result.
+#if AGGSTAT_FLT_BIT == 32
+  #define CLI_DIG 9
+#elif AGGSTAT_FLT_BIT == 64
+  #define CLI_DIG 17
+#else
+  #define CLI_DIG 21
+#endif
+
+/// Types of the values in the file.
+#define CLI_TYP_F32 0x1 // 32-bit floating-point.
+#define CLI_TYP_F64 0x2 // 64-bit floating-point.
+#define CLI_TYP_I64 0x3 // 64-bit signed integer.
+
+/// Aggregate function name.
+struct name {
+  const char* n_str; ///< Name.
+  uint8_t     n_fnc; ///< Aggregate function.
+};
+
+/// Requested aggregate function.
+struct function {
+  const char* f_nam; ///< Name.
+  uint8_t     f_fnc; ///< Aggregate function.
+  AGGSTAT_FLT f_par; ///< Parameter.
+};
+
+/// Settings.
+struct settings {
+  const char*     s_pth;              ///< Path to the file.
+  uint8_t         s_typ;              ///< Type of the values.
+  bool            s_jsn;              ///< Print the results in JSON.
+  uint32_t        s_thr;              ///< Number of worker threads.
+  uint8_t         s_cnt;              ///< Number of requested functions.
+  bool            s_qnt;              ///< Any of the functions is a quantile.
+  bool            s_tim;              ///< Any of the functions is time-weighted.
+  struct function s_fnc[CLI_FNC_MAX]; ///< Requested functions.
+};
+
+/// Worker that aggregates a contiguous range of values.
+struct worker {
+  pthread_t              w_thr;              ///< Thread.
+  const struct settings* w_stg;              ///< Settings.
+  const char*            w_map;              ///< Mapped file.
+  AGGSTAT_INT            w_fst;              ///< Index of the first value.
+  AGGSTAT_INT            w_lst;              ///< Index past the last value.
+  AGGSTAT_INT            w_ahd;              ///< Index past the values requested to be read.
+  struct aggstat         w_agg[CLI_FNC_MAX]; ///< Aggregated values.
+};
+
+/// All supported function names.
+static const struct name nams[] = {
+  {"fst", AGGSTAT_FNC_FST},
+  {"lst", AGGSTAT_FNC_LST},
+  {"cnt", AGGSTAT_FNC_CNT},
+  {"sum", AGGSTAT_FNC_SUM},
+  {"min", AGGSTAT_FNC_MIN},
+  {"max", AGGSTAT_FNC_MAX},
+  {"avg", AGGSTAT_FNC_AVG},
+  {"var", AGGSTAT_FNC_VAR},
+  {"dev", AGGSTAT_FNC_DEV},
+  {"skw", AGGSTAT_FNC_SKW},
+  {"krt", AGGSTAT_FNC_KRT},
+  {"qnt", AGGSTAT_FNC_QNT},
+  {"med", AGGSTAT_FNC_MED},
+  {"twa", AGGSTAT_FNC_TWA},
+  {"itg", AGGSTAT_FNC_ITG},
+  {"rat", AGGSTAT_FNC_RAT}
+};
+
+/// Obtain the size of a value in the file.
+/// @return size in bytes
+///
+/// @param[in] typ type of the values
+static size_t
+type_size(const uint8_t typ)
+{
+  return typ == CLI_TYP_F32 ? sizeof(float) : sizeof(int64_t);
+}
+
+/// Obtain the name of the type of values.
+/// @return name
+///
+/// @param[in] typ type of the values
+static const char*
+type_name(const uint8_t typ)
+{
+  switch (typ) {
+    case CLI_TYP_F32: return "f32";
+    case CLI_TYP_F64: return "f64";
+    default:          return "i64";
+  }
+}
+
+/// Convert a block of values from the file into the floating-point type.
+///
+/// @param[out] buf converted values
+/// @param[in]  ptr address of the first value in the file
+/// @param[in]  len number of values
+/// @param[in]  typ type of the values
+static void
+convert_block(      AGGSTAT_FLT *restrict buf,
+              const char        *restrict ptr,
+              const AGGSTAT_INT           len,
+              const uint8_t               typ)
+{
+  const float*   f32;
+  const double*  f64;
+  const int64_t* i64;
+  AGGSTAT_INT    idx;
+
+  // The loops are kept separate, so that each of them is subject to vectorization.
+  if (typ == CLI_TYP_F32) {
+    f32 = (const float*)(const void*)ptr;
+    for (idx = 0; idx < len; idx += 1) {
+      buf[idx] = (AGGSTAT_FLT)f32[idx];
+    }
+  } else if (typ == CLI_TYP_F64) {
+    f64 = (const double*)(const void*)ptr;
+    for (idx = 0; idx < len; idx += 1) {
+      buf[idx] = (AGGSTAT_FLT)f64[idx];
+    }
+  } else {
+    i64 = (const int64_t*)(const void*)ptr;
+    for (idx = 0; idx < len; idx += 1) {
+      buf[idx] = (AGGSTAT_FLT)i64[idx];
+    }
+  }
+}
+
+/// Read a block of values of the range assigned to the worker.
+///
+/// Ahead of each block, the worker advises the kernel to start reading the pages that it will need
+/// soon, so that the storage is kept busy while the values are aggregated.
+///
+/// @param[in]  wrk worker
+/// @param[out] buf converted values
+/// @param[in]  idx index of the first value
+/// @param[in]  len number of values
+static void
+read_block(      struct worker *restrict wrk,
+                 AGGSTAT_FLT   *restrict buf,
+           const AGGSTAT_INT             idx,
+           const AGGSTAT_INT             len)
+{
+  size_t siz;
+  size_t off;
+  size_t pag;
+
+  siz = type_size(wrk->w_stg->s_typ);
+  pag = (size_t)sysconf(_SC_PAGESIZE);
+
+  // Each pass over the range starts the reading ahead anew.
+  if (idx == wrk->w_fst) {
+    wrk->w_ahd = wrk->w_fst;
+  }
+
+  // Request the next window to be read ahead once the current one is half consumed.
+  if (idx + CLI_AHD / 2 >= wrk->w_ahd && wrk->w_ahd < wrk->w_lst) {
+    off        = (size_t)wrk->w_ahd * siz / pag * pag;
+    wrk->w_ahd = wrk->w_lst - wrk->w_ahd < CLI_AHD ? wrk->w_lst : wrk->w_ahd + CLI_AHD;
+    (void)posix_madvise((void*)(uintptr_t)(wrk->w_map + off),
+                        (size_t)wrk->w_ahd * siz - off,
+                        POSIX_MADV_WILLNEED);
+  }
+
+  convert_block(buf, wrk->w_map + (size_t)idx * siz, len, wrk->w_stg->s_typ);
+}
+
+/// Aggregate a block of values by all functions except the quantiles and medians.
+///
+/// @param[in] wrk worker
+/// @param[in] buf converted values
+/// @param[in] idx index of the first value
+/// @param[in] len number of values
+static void
+aggregate_block(      struct worker *restrict wrk,
+                const AGGSTAT_FLT   *restrict buf,
+                const AGGSTAT_INT             idx,
+                const AGGSTAT_INT             len)
+{
+  const struct settings* stg;
+  AGGSTAT_FLT            tim[CLI_BLK];
+  AGGSTAT_INT            jdx;
+  uint8_t                fnc;
+
+  stg = wrk->w_stg;
+
+  // The position of each value in the file serves as its timestamp.
+  if (stg->s_tim == true) {
+    for (jdx = 0; jdx < len; jdx += 1) {
+      tim[jdx] = (AGGSTAT_FLT)(idx + jdx);
+    }
+  }
+
+  for (fnc = 0; fnc < stg->s_cnt; fnc += 1) {
+    switch (stg->s_fnc[fnc].f_fnc) {
+      case AGGSTAT_FNC_QNT:
+      case AGGSTAT_FNC_MED:
+        break;
+
+      case AGGSTAT_FNC_TWA:
+      case AGGSTAT_FNC_ITG:
+      case AGGSTAT_FNC_RAT:
+        aggstat_put_t_arr(&wrk->w_agg[fnc], tim, buf, len);
+        break;
+
+      default:
+        aggstat_put_arr(&wrk->w_agg[fnc], buf, len);
+    }
+  }
+}
+
+/// Aggregate the range of values assigned to the worker.
+/// @return NULL
+///
+/// The worker reads its range sequentially in blocks, and aggregates each block by all requested
+/// functions.
+///
+/// @param[in] arg worker
+static void*
+worker_run(void* arg)
+{
+  struct worker* wrk;
+  AGGSTAT_FLT    buf[CLI_BLK];
+  AGGSTAT_INT    idx;
+  AGGSTAT_INT    len;
+
+  wrk = arg;
+  for (idx = wrk->w_fst; idx < wrk->w_lst; idx += len) {
+    len = wrk->w_lst - idx < CLI_BLK ? wrk->w_lst - idx : CLI_BLK;
+    read_block(wrk, buf, idx, len);
+    aggregate_block(wrk, buf, idx, len);
+  }
+
+  return NULL;
+}
+
+/// Read a block of values for the parallel exact quantiles.
+///
+/// The values of each part are aggregated by all other functions while they are counted in the
+/// buckets of the quantiles, so that the file is read only twice. The parts of the quantiles are
+/// the ranges of the workers.
+///
+/// @param[out] buf converted values
+/// @param[in]  src workers
+/// @param[in]  idx index of the first value
+/// @param[in]  len number of values
+/// @param[in]  wid index of the worker
+/// @param[in]  rdg reading of the values
+static void
+read_values(AGGSTAT_FLT* buf,
+            const void*  src,
+            size_t       idx,
+            size_t       len,
+            uint32_t     wid,
+            uint8_t      rdg)
+{
+  struct worker* wrk;
+
+  wrk = (struct worker*)(uintptr_t)src + wid;
+  if (rdg == AGGSTAT_RDR_SMP) {
+    convert_block(buf,
+                  wrk->w_map + idx * type_size(wrk->w_stg->s_typ),
+                  (AGGSTAT_INT)len,
+                  wrk->w_stg->s_typ);
+    return;
+  }
+
+  read_block(wrk, buf, (AGGSTAT_INT)idx, (AGGSTAT_INT)len);
+  if (rdg == AGGSTAT_RDR_CNT) {
+    aggregate_block(wrk, buf, (AGGSTAT_INT)idx, (AGGSTAT_INT)len);
+  }
+}
+
+/// Parse the list of aggregate functions.
+/// @return success/failure indication
+///
+/// The list is separated by commas, and each function can be followed by a parameter that is
+/// separated by a colon, e.g. `avg,dev,qnt:0.99`.
+///
+/// @param[in] stg settings
+/// @param[in] str input string (modified)
+static bool
+parse_functions(struct settings* stg, char* str)
+{
+  struct function* fnc;
+  char*            tok;
+  char*            sep;
+  char*            sav;
+  size_t           idx;
+  int              ret;
+
+  for (tok = strtok_r(str, ",", &sav); tok != NULL; tok = strtok_r(NULL, ",", &sav)) {
+    if (stg->s_cnt == CLI_FNC_MAX) {
+      (void)fprintf(stderr, "too many functions, at most %d are supported\n", CLI_FNC_MAX);
+      return false;
+    }
+
+    fnc        = &stg->s_fnc[stg->s_cnt];
+    fnc->f_nam = tok;
+    fnc->f_fnc = 0;
+    fnc->f_par = AGGSTAT_0_0;
+
+    // Separate the parameter.
+    sep = strchr(tok, ':');
+    if (sep != NULL) {
+      *sep = '\0';
+      ret  = sscanf(sep + 1, AGGSTAT_FMT, &fnc->f_par);
+      if (ret != 1) {
+        (void)fprintf(stderr, "unable to parse parameter from '%s'\n", sep + 1);
+        return false;
+      }
+    }
+
+    for (idx = 0; idx < sizeof(nams) / sizeof(nams[0]); idx += 1) {
+      if (strcmp(tok, nams[idx].n_str) == 0) {
+        fnc->f_fnc = nams[idx].n_fnc;
+      }
+    }
+
+    if (fnc->f_fnc == 0) {
+      (void)fprintf(stderr, "unable to parse the function from '%s'\n", tok);
+      return false;
+    }
+
+    stg->s_qnt = stg->s_qnt || fnc->f_fnc == AGGSTAT_FNC_QNT || fnc->f_fnc == AGGSTAT_FNC_MED;
+    stg->s_tim = stg->s_tim || fnc->f_fnc >= AGGSTAT_FNC_TWA;
+    stg->s_cnt += 1;
+  }
+
+  return true;
+}
+
+/// Print the usage information.
+static void
+print_usage(void)
+{
+  (void)fprintf(stderr,
+    "Usage: aggstat [-j] [-n THREADS] [-t f32|f64|i64] -f FNC[:PAR][,...] FILE\n"
+    "\n"
+    "Options:\n"
+    "  -f FNC  aggregate functions: fst lst cnt sum min max avg var dev skw krt\n"
+    "          qnt med twa itg rat, with an optional parameter, e.g. qnt:0.99\n"
+    "  -j      print the results in JSON\n"
+    "  -n NUM  number of worker threads (default: number of online processors)\n"
+    "  -t TYP  type of the raw values in the file (default: f64)\n");
+}
+
+/// Parse the settings from the command-line arguments.
+/// @return success/failure indication
+///
+/// @param[in] stg  settings
+/// @param[in] argc argument count
+/// @param[in] argv argument vector
+static bool
+parse_settings(struct settings* stg, int argc, char* argv[])
+{
+  int       opt;
+  uintmax_t val;
+  long      cpu;
+
+  // Default values.
+  cpu        = sysconf(_SC_NPROCESSORS_ONLN);
+  stg->s_pth = NULL;
+  stg->s_typ = CLI_TYP_F64;
+  stg->s_jsn = false;
+  stg->s_thr = cpu < 1 ? 1 : (cpu > CLI_THR_MAX ? CLI_THR_MAX : (uint32_t)cpu);
+  stg->s_cnt = 0;
+  stg->s_qnt = false;
+  stg->s_tim = false;
+
+  while (true) {
+    opt = getopt(argc, argv, "f:hjn:t:");
+    if (opt == -1) {
+      break;
+    }
+
+    // Aggregate functions.
+    if (opt == 'f') {
+      if (parse_functions(stg, optarg) == false) {
+        return false;
+      }
+    }
+
+    // Usage information.
+    if (opt == 'h') {
+      print_usage();
+      return false;
+    }
+
+    // JSON output.
+    if (opt == 'j') {
+      stg->s_jsn = true;
+    }
+
+    // Number of worker threads.
+    if (opt == 'n') {
+      errno = 0;
+      val   = strtoumax(optarg, NULL, 10);
+      if (val == 0 || val > CLI_THR_MAX || errno != 0) {
+        (void)fprintf(stderr, "unable to parse the thread count from '%s'\n", optarg);
+        return false;
+      }
+
+      stg->s_thr = (uint32_t)val;
+    }
+
+    // Type of the values.
+    if (opt == 't') {
+      if (strcmp(optarg, "f32") == 0) {
+        stg->s_typ = CLI_TYP_F32;
+      } else if (strcmp(optarg, "f64") == 0) {
+        stg->s_typ = CLI_TYP_F64;
+      } else if (strcmp(optarg, "i64") == 0) {
+        stg->s_typ = CLI_TYP_I64;
+      } else {
+        (void)fprintf(stderr, "unable to parse the type from '%s'\n", optarg);
+        return false;
+      }
+    }
+
+    // Unknown option.
+    if (opt == '?') {
+      print_usage();
+      return false;
+    }
+  }
+
+  if (optind != argc - 1 || stg->s_cnt == 0) {
+    print_usage();
+    return false;
+  }
+
+  stg->s_pth = argv[optind];
+  return true;
+}
+
+/// Print a JSON string with the necessary escaping.
+///
+/// @param[in] str string
+static void
+print_string(const char* str)
+{
+  (void)putchar('"');
+  for (; *str != '\0'; str += 1) {
+    if (*str == '"' || *str == '\\') {
+      (void)putchar('\\');
+    }
+
+    if ((unsigned char)*str < 0x20) {
+      (void)printf("\\u%04x", (unsigned)(unsigned char)*str);
+    } else {
+      (void)putchar(*str);
+    }
+  }
+  (void)putchar('"');
+}
+
+/// Print the results.
+///
+/// Values that could not be computed are printed as `n/a` in the text output, and as `null` in
+/// the JSON output, which applies to non-finite values too, as these are not valid JSON numbers.
+///
+/// @param[in] stg settings
+/// @param[in] len number of values in the file
+/// @param[in] val results
+/// @param[in] ret success indications of the results
+static void
+print_results(const struct settings* stg,
+              const AGGSTAT_INT      len,
+              const AGGSTAT_FLT*     val,
+              const bool*            ret)
+{
+  uint8_t fnc;
+
+  if (stg->s_jsn == false) {
+    for (fnc = 0; fnc < stg->s_cnt; fnc += 1) {
+      (void)printf("%s", stg->s_fnc[fnc].f_nam);
+      if (stg->s_fnc[fnc].f_fnc == AGGSTAT_FNC_QNT) {
+        (void)printf("(%Lg)", (long double)stg->s_fnc[fnc].f_par);
+      }
+
+      if (ret[fnc] == true) {
+        (void)printf(" %.*Lg\n", CLI_DIG, (long double)val[fnc]);
+      } else {
+        (void)printf(" n/a\n");
+      }
+    }
+
+    return;
+  }
+
+  (void)printf("{\"file\":");
+  print_string(stg->s_pth);
+  (void)printf(",\"type\":\"%s\",\"count\":%" PRIuMAX ",\"results\":[",
+               type_name(stg->s_typ), (uintmax_t)len);
+
+  for (fnc = 0; fnc < stg->s_cnt; fnc += 1) {
+    (void)printf("%s{\"function\":", fnc == 0 ? "" : ",");
+    print_string(stg->s_fnc[fnc].f_nam);
+    (void)printf(",\"parameter\":%Lg,\"value\":", (long double)stg->s_fnc[fnc].f_par);
+
+    if (ret[fnc] == true && isfinite(val[fnc])) {
+      (void)printf("%.*Lg}", CLI_DIG, (long double)val[fnc]);
+    } else {
+      (void)printf("null}");
+    }
+  }
+
+  (void)printf("]}\n");
+}
+
+/// Run all workers, each by its own thread, and wait for their completion.
+///
+/// @param[in] wrk workers
+/// @param[in] cnt number of workers
+static void
+run_workers(struct worker* wrk, const uint32_t cnt)
+{
+  uint32_t thr;
+  int      err;
+
+  for (thr = 0; thr < cnt; thr += 1) {
+    err = pthread_create(&wrk[thr].w_thr, NULL, worker_run, &wrk[thr]);
+    if (err != 0) {
+      (void)fprintf(stderr, "pthread_create: %s\n", strerror(err));
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  for (thr = 0; thr < cnt; thr += 1) {
+    (void)pthread_join(wrk[thr].w_thr, NULL);
+  }
+}
+
+/// Aggregate all values of the mapped file.
+/// @return success/failure indication
+///
+/// All functions except the quantiles and medians are computed in a single pass. The quantiles
+/// are computed by `aggstat_run_par_rdr`, which reads the file twice, and the other functions are
+/// computed during its first pass.
+///
+/// @param[in]  stg settings
+/// @param[in]  map mapped file
+/// @param[in]  len number of values
+/// @param[out] val results
+/// @param[out] ret success indications of the results
+static bool
+aggregate(const struct settings *restrict stg,
+          const char            *restrict map,
+          const AGGSTAT_INT               len,
+                AGGSTAT_FLT     *restrict val,
+                bool            *restrict ret)
+{
+  struct worker* wrk;
+  AGGSTAT_FLT    par[CLI_FNC_MAX];
+  AGGSTAT_FLT    qnt[CLI_FNC_MAX];
+  uint32_t       thr;
+  uint32_t       cnt;
+  uint8_t        fnc;
+  uint8_t        num;
+  bool           res;
+
+  // Do not start more threads than there are blocks of values.
+  cnt = stg->s_thr;
+  if ((AGGSTAT_INT)cnt > len / CLI_BLK) {
+    cnt = (uint32_t)(len / CLI_BLK) + 1;
+  }
+
+  wrk = calloc(cnt, sizeof(struct worker));
+  if (wrk == NULL) {
+    perror("malloc");
+    return false;
+  }
+
+  // Split the values into contiguous ranges of equal length, which are equal to the parts of the
+  // parallel exact quantiles.
+  for (thr = 0; thr < cnt; thr += 1) {
+    wrk[thr].w_stg = stg;
+    wrk[thr].w_map = map;
+    wrk[thr].w_fst = len * thr / cnt;
+    wrk[thr].w_lst = len * (thr + 1) / cnt;
+    wrk[thr].w_ahd = wrk[thr].w_fst;
+
+    for (fnc = 0; fnc < stg->s_cnt; fnc += 1) {
+      aggstat_new(&wrk[thr].w_agg[fnc], stg->s_fnc[fnc].f_fnc, stg->s_fnc[fnc].f_par);
+    }
+  }
+
+  // Collect the parameters of the quantiles. The quantiles of an empty file can not be computed.
+  num = 0;
+  for (fnc = 0; fnc < stg->s_cnt; fnc += 1) {
+    if (stg->s_fnc[fnc].f_fnc == AGGSTAT_FNC_QNT || stg->s_fnc[fnc].f_fnc == AGGSTAT_FNC_MED) {
+      par[num] = stg->s_fnc[fnc].f_fnc == AGGSTAT_FNC_MED ? AGGSTAT_0_5 : stg->s_fnc[fnc].f_par;
+      ret[fnc] = len > 0 && par[num] >= AGGSTAT_0_0 && par[num] <= AGGSTAT_1_0;
+      num     += ret[fnc] == true ? 1 : 0;
+    }
+  }
+
+  res = true;
+  if (stg->s_qnt == true && len > 0) {
+    res = aggstat_run_par_rdr(qnt, read_values, wrk, len, par, num, cnt);
+    if (res == false) {
+      (void)fprintf(stderr, "unable to compute the quantiles\n");
+    }
+  } else {
+    run_workers(wrk, cnt);
+  }
+
+  // Merge the partial results in the order of the ranges.
+  num = 0;
+  for (fnc = 0; fnc < stg->s_cnt && res == true; fnc += 1) {
+    if (stg->s_fnc[fnc].f_fnc == AGGSTAT_FNC_QNT || stg->s_fnc[fnc].f_fnc == AGGSTAT_FNC_MED) {
+      if (ret[fnc] == true) {
+        val[fnc]  = qnt[num];
+        num      += 1;
+      }
+
+      continue;
+    }
+
+    for (thr = 1; thr < cnt; thr += 1) {
+      (void)aggstat_mrg(&wrk[0].w_agg[fnc], &wrk[thr].w_agg[fnc]);
+    }
+
+    ret[fnc] = aggstat_get(&wrk[0].w_agg[fnc], &val[fnc]);
+  }
+
+  free(wrk);
+  return res;
+}
+
+int
+main(int argc, char* argv[])
+{
+  struct settings stg;
+  struct stat     sta;
+  AGGSTAT_FLT     val[CLI_FNC_MAX];
+  bool            ret[CLI_FNC_MAX];
+  AGGSTAT_INT     len;
+  size_t          siz;
+  char*           map;
+  int             fd;
+
+  // Parse input from command-line.
+  if (parse_settings(&stg, argc, argv) == false) {
+    return EXIT_FAILURE;
+  }
+
+  fd = open(stg.s_pth, O_RDONLY);
+  if (fd == -1) {
+    perror("open");
+    return EXIT_FAILURE;
+  }
+
+  if (fstat(fd, &sta) == -1) {
+    perror("fstat");
+    return EXIT_FAILURE;
+  }
+
+  siz = type_size(stg.s_typ);
+  len = (AGGSTAT_INT)((size_t)sta.st_size / siz);
+  if ((size_t)sta.st_size % siz != 0) {
+    (void)fprintf(stderr, "ignoring %zu trailing bytes\n", (size_t)sta.st_size % siz);
+  }
+
+  // Map the file and advise the kernel that it is going to be read sequentially, which enables
+  // aggressive readahead.
+  map = NULL;
+  if (len > 0) {
+    map = mmap(NULL, (size_t)len * siz, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      perror("mmap");
+      return EXIT_FAILURE;
+    }
+
+    (void)posix_madvise(map, (size_t)len * siz, POSIX_MADV_SEQUENTIAL);
+  }
+
+  if (aggregate(&stg, map, len, val, ret) == false) {
+    return EXIT_FAILURE;
+  }
+
+  print_results(&stg, len, val, ret);
+
+  if (map != NULL) {
+    (void)munmap(map, (size_t)len * siz);
+  }
+  (void)close(fd);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,26 @@
+#!/bin/bash
+# Copyright (c) 2019-2021 Daniel Lovasko
+# All Rights Reserved
+#
+# Distributed under the terms of the 2-clause BSD License. The full
+# license is in the file LICENSE, distributed as part of this software.
+
+# Build the aggstat command-line tool, which aggregates files of raw binary
+# values in parallel. The results are computed in 64-bit floating-point
+# arithmetic with 64-bit counters, so that files of any size can be processed.
+
+set -e
+set -x
+
+# Ensure that all relative paths remain correct.
+cd $(dirname $0)
+
+# C compilation settings.
+CC="cc"
+OPT="-O3 -march=native -mtune=native"
+CFLAGS="-I../src -D_POSIX_C_SOURCE=201912 -std=c99 -Wall -Wextra -Werror -pthread"
+CFLAGS="${CFLAGS} -DAGGSTAT_FLT_BIT=64 -DAGGSTAT_INT_BIT=64"
+LDFLAGS="-lm"
+SRCS="./cli.c ../src/get.c ../src/put.c ../src/new.c ../src/run.c ../src/mrg.c ../src/par.c"
+
+${CC} ${CFLAGS} ${OPT} -o ./bin/aggstat ${SRCS} ${LDFLAGS}
@@ -0,0 +1,38 @@
+#!/bin/bash
+# Copyright (c) 2019-2021 Daniel Lovasko
+# All Rights Reserved
+#
+# Distributed under the terms of the 2-clause BSD License. The full
+# license is in the file LICENSE, distributed as part of this software.
+
+# Build a single static archive that contains an instantiation of the library
+# for each standard pair of floating-point and integer widths. All names are
+# suffixed by the widths (AGGSTAT_SFX=1), and thus the instantiations do not
+# clash. Translation units that link against the archive must be compiled with
+# -DAGGSTAT_SFX=1 and their selected -DAGGSTAT_FLT_BIT and -DAGGSTAT_INT_BIT.
+
+set -e
+set -x
+
+# Ensure that all relative paths remain correct.
+cd $(dirname $0)
+
+# C compilation settings.
+CC="cc"
+AR="ar"
+OPT="-O2"
+CFLAGS="-D_POSIX_C_SOURCE=201912 -std=c99 -Wall -Wextra -Werror -DAGGSTAT_SFX=1"
+SRCS="get put new run int del vew mrg txt ooc buf rol frq bnk par hlf gor fwd snp"
+
+rm -f ./bin/*.o ./bin/libaggstat.a
+
+for flt in 32 64 80; do
+  for int in 16 32 64; do
+    for src in ${SRCS}; do
+      ${CC} -DAGGSTAT_FLT_BIT=${flt} -DAGGSTAT_INT_BIT=${int} ${CFLAGS} ${OPT} \
+        -c -o ./bin/${src}_f${flt}_i${int}.o ../src/${src}.c
+    done
+  done
+done
+
+${AR} rcs ./bin/libaggstat.a ./bin/*.o
@@ -8,9 +8,13 @@
 #define AGGSTAT_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <float.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 // This constant ensures that all code that is made available by this library is strictly compliant
 // with the C99 language standard.
@@ -36,6 +40,34 @@
   #define AGGSTAT_INT_BIT 64
 #endif
 
+// This constant selects whether the names of all types and functions provided by the library are
+// suffixed by the floating-point and integer widths, e.g. `struct aggstat_f64_i32` and
+// `aggstat_f64_i32_put`. The default value is 0, which denotes unsuffixed names. Value 1 makes it
+// possible to link multiple instantiations of the library into a single binary. Each translation
+// unit selects one pair of widths, and the unsuffixed names, e.g. `struct aggstat` and
+// `aggstat_put`, remain available as aliases of the suffixed names within that translation unit.
+#ifndef AGGSTAT_SFX
+  #define AGGSTAT_SFX 0
+#endif
+
+// This constant selects whether the streaming algorithms count internal events, such as the
+// movements of the quantile markers and the fallbacks from the parabolic to the linear estimate,
+// in counters of the calling thread. The default value is 0, which compiles the counting out
+// entirely, and the counters then always read as zero. Value 1 relies on thread-local storage,
+// which is a non-standard extension that will result in compile-time error unless the
+// `AGGSTAT_STD` macro evaluates to `0`.
+#ifndef AGGSTAT_CTR
+  #define AGGSTAT_CTR 0
+#endif
+
+#if AGGSTAT_CTR == 1
+  #if AGGSTAT_STD == 1
+    #error "AGGSTAT_CTR == 1 is a non-standard extension"
+  #endif
+#elif AGGSTAT_CTR != 0
+  #error "invalid value of AGGSTAT_CTR: " AGGSTAT_CTR
+#endif
+
 // Determine the appropriate type-related constants and functions.
 #if AGGSTAT_FLT_BIT == 32
   // Types.
@@ -44,11 +76,13 @@
   // Functions.
   #define AGGSTAT_SQRT sqrtf
   #define AGGSTAT_POW  powf
+  #define AGGSTAT_EXP  expf
   #define AGGSTAT_ABS  fabsf
   #define AGGSTAT_FMIN fminf
   #define AGGSTAT_FMAX fmaxf
   #define AGGSTAT_SIGN copysignf
   #define AGGSTAT_MODF modff
+  #define AGGSTAT_STRTO strtof
 
   // Constants.
   #define AGGSTAT_FMT  "%e"
@@ -62,11 +96,13 @@
   // Functions.
   #define AGGSTAT_SQRT sqrt
   #define AGGSTAT_POW  pow
+  #define AGGSTAT_EXP  exp
   #define AGGSTAT_ABS  fabs
   #define AGGSTAT_FMIN fmin
   #define AGGSTAT_FMAX fmax
   #define AGGSTAT_SIGN copysign
   #define AGGSTAT_MODF modf
+  #define AGGSTAT_STRTO strtod
 
   // Constants.
   #define AGGSTAT_FMT  "%le"
@@ -80,11 +116,13 @@
   // Functions.
   #define AGGSTAT_SQRT sqrtl
   #define AGGSTAT_POW  powl
+  #define AGGSTAT_EXP  expl
   #define AGGSTAT_ABS  fabsl
   #define AGGSTAT_FMIN fminl
   #define AGGSTAT_FMAX fmaxl
   #define AGGSTAT_SIGN copysignl
   #define AGGSTAT_MODF modfl
+  #define AGGSTAT_STRTO strtold
 
   // Constants.
   #define AGGSTAT_FMT  "%Le"
@@ -103,11 +141,13 @@
   // Functions.
   #define AGGSTAT_SQRT sqrtq
   #define AGGSTAT_POW  powq
+  #define AGGSTAT_EXP  expq
   #define AGGSTAT_ABS  fabsq
   #define AGGSTAT_FMIN fminq
   #define AGGSTAT_FMAX fmaxq
   #define AGGSTAT_SIGN copysignq
   #define AGGSTAT_MODF modfq
+  #define AGGSTAT_STRTO strtoflt128
 
   // Constants.
   #define AGGSTAT_FMT  "%Qe"
@@ -138,6 +178,106 @@
   #error "invalid value of AGGSTAT_INT_BIT: " AGGSTAT_INT_BIT
 #endif
 
+// Determine the names of the types and functions.
+#if AGGSTAT_SFX == 1
+  // Name construction.
+  #define AGGSTAT_CAT(F, I, N) aggstat_f ## F ## _i ## I ## N
+  #define AGGSTAT_SYM(F, I, N) AGGSTAT_CAT(F, I, N)
+  #define AGGSTAT_ID(N)        AGGSTAT_SYM(AGGSTAT_FLT_BIT, AGGSTAT_INT_BIT, N)
+
+  // Types.
+  #define aggstat             AGGSTAT_ID()
+  #define aggstat_int         AGGSTAT_ID(_int)
+
+  // Functions.
+  #define aggstat_new         AGGSTAT_ID(_new)
+  #define aggstat_put         AGGSTAT_ID(_put)
+  #define aggstat_get         AGGSTAT_ID(_get)
+  #define aggstat_run         AGGSTAT_ID(_run)
+  #define aggstat_new_int     AGGSTAT_ID(_new_int)
+  #define aggstat_put_i64     AGGSTAT_ID(_put_i64)
+  #define aggstat_put_u64     AGGSTAT_ID(_put_u64)
+  #define aggstat_put_i64_arr AGGSTAT_ID(_put_i64_arr)
+  #define aggstat_put_u64_arr AGGSTAT_ID(_put_u64_arr)
+  #define aggstat_get_int     AGGSTAT_ID(_get_int)
+  #define aggstat_get_i64     AGGSTAT_ID(_get_i64)
+  #define aggstat_get_u64     AGGSTAT_ID(_get_u64)
+  #define aggstat_run_i64     AGGSTAT_ID(_run_i64)
+  #define aggstat_run_u64     AGGSTAT_ID(_run_u64)
+  #define aggstat_put_f16_arr AGGSTAT_ID(_put_f16_arr)
+  #define aggstat_put_b16_arr AGGSTAT_ID(_put_b16_arr)
+  #define aggstat_run_f16     AGGSTAT_ID(_run_f16)
+  #define aggstat_run_b16     AGGSTAT_ID(_run_b16)
+  #define aggstat_put_w       AGGSTAT_ID(_put_w)
+  #define aggstat_run_w       AGGSTAT_ID(_run_w)
+  #define aggstat_del         AGGSTAT_ID(_del)
+  #define aggstat_del_arr     AGGSTAT_ID(_del_arr)
+  #define aggstat_put_t       AGGSTAT_ID(_put_t)
+  #define aggstat_put_t_arr   AGGSTAT_ID(_put_t_arr)
+  #define aggstat_run_t       AGGSTAT_ID(_run_t)
+  #define aggstat_run_strided AGGSTAT_ID(_run_strided)
+  #define aggstat_run_idx     AGGSTAT_ID(_run_idx)
+  #define aggstat_run_many    AGGSTAT_ID(_run_many)
+  #define aggstat_run_par     AGGSTAT_ID(_run_par)
+  #define aggstat_run_par_rdr AGGSTAT_ID(_run_par_rdr)
+  #define aggstat_put_arr     AGGSTAT_ID(_put_arr)
+  #define aggstat_mrg         AGGSTAT_ID(_mrg)
+  #define aggstat_txt         AGGSTAT_ID(_txt)
+  #define aggstat_txt_new     AGGSTAT_ID(_txt_new)
+  #define aggstat_txt_put     AGGSTAT_ID(_txt_put)
+  #define aggstat_txt_end     AGGSTAT_ID(_txt_end)
+  #define aggstat_txt_flt     AGGSTAT_ID(_txt_flt)
+  #define aggstat_ooc         AGGSTAT_ID(_ooc)
+  #define aggstat_ooc_new     AGGSTAT_ID(_ooc_new)
+  #define aggstat_ooc_put     AGGSTAT_ID(_ooc_put)
+  #define aggstat_ooc_end     AGGSTAT_ID(_ooc_end)
+  #define aggstat_ooc_get     AGGSTAT_ID(_ooc_get)
+  #define aggstat_buf         AGGSTAT_ID(_buf)
+  #define aggstat_buf_new     AGGSTAT_ID(_buf_new)
+  #define aggstat_buf_put     AGGSTAT_ID(_buf_put)
+  #define aggstat_buf_put_arr AGGSTAT_ID(_buf_put_arr)
+  #define aggstat_buf_get     AGGSTAT_ID(_buf_get)
+  #define aggstat_buf_free    AGGSTAT_ID(_buf_free)
+  #define aggstat_rol         AGGSTAT_ID(_rol)
+  #define aggstat_rol_new     AGGSTAT_ID(_rol_new)
+  #define aggstat_rol_put     AGGSTAT_ID(_rol_put)
+  #define aggstat_rol_get     AGGSTAT_ID(_rol_get)
+  #define aggstat_frq         AGGSTAT_ID(_frq)
+  #define aggstat_frq_new     AGGSTAT_ID(_frq_new)
+  #define aggstat_frq_put     AGGSTAT_ID(_frq_put)
+  #define aggstat_frq_put_arr AGGSTAT_ID(_frq_put_arr)
+  #define aggstat_frq_mrg     AGGSTAT_ID(_frq_mrg)
+  #define aggstat_frq_top     AGGSTAT_ID(_frq_top)
+  #define aggstat_bnk         AGGSTAT_ID(_bnk)
+  #define aggstat_bnk_new     AGGSTAT_ID(_bnk_new)
+  #define aggstat_bnk_put_row AGGSTAT_ID(_bnk_put_row)
+  #define aggstat_bnk_get     AGGSTAT_ID(_bnk_get)
+  #define aggstat_gor         AGGSTAT_ID(_gor)
+  #define aggstat_gor_new     AGGSTAT_ID(_gor_new)
+  #define aggstat_gor_put     AGGSTAT_ID(_gor_put)
+  #define aggstat_gor_siz     AGGSTAT_ID(_gor_siz)
+  #define aggstat_gor_dec     AGGSTAT_ID(_gor_dec)
+  #define aggstat_gor_agg     AGGSTAT_ID(_gor_agg)
+  #define aggstat_gor_ooc     AGGSTAT_ID(_gor_ooc)
+  #define aggstat_fwd         AGGSTAT_ID(_fwd)
+  #define aggstat_fwd_new     AGGSTAT_ID(_fwd_new)
+  #define aggstat_fwd_put     AGGSTAT_ID(_fwd_put)
+  #define aggstat_fwd_put_arr AGGSTAT_ID(_fwd_put_arr)
+  #define aggstat_fwd_get     AGGSTAT_ID(_fwd_get)
+  #define aggstat_snp         AGGSTAT_ID(_snp)
+  #define aggstat_snp_new     AGGSTAT_ID(_snp_new)
+  #define aggstat_snp_bgn     AGGSTAT_ID(_snp_bgn)
+  #define aggstat_snp_end     AGGSTAT_ID(_snp_end)
+  #define aggstat_snp_put     AGGSTAT_ID(_snp_put)
+  #define aggstat_snp_put_arr AGGSTAT_ID(_snp_put_arr)
+  #define aggstat_snp_swp     AGGSTAT_ID(_snp_swp)
+  #define aggstat_ctr         AGGSTAT_ID(_ctr)
+  #define aggstat_ctr_get     AGGSTAT_ID(_ctr_get)
+  #define aggstat_ctr_rst     AGGSTAT_ID(_ctr_rst)
+#elif AGGSTAT_SFX != 0
+  #error "invalid value of AGGSTAT_SFX: " AGGSTAT_SFX
+#endif
+
 // Numerical constants.
 #define AGGSTAT_0_0  AGGSTAT_NUM(0,  0, +, 0)
 #define AGGSTAT_0_1  AGGSTAT_NUM(0,  1, +, 0)
@@ -153,6 +293,28 @@
 #define AGGSTAT_5_0  AGGSTAT_NUM(5,  0, +, 0)
 #define AGGSTAT_6_0  AGGSTAT_NUM(6,  0, +, 0)
 
+// Number of partition boundaries retained by the buffer of values between queries.
+#define AGGSTAT_BUF_BND 64
+
+// Largest number of levels of a rollup.
+#define AGGSTAT_ROL_LVL 4
+
+// Size in bytes of the memory of a number of counters of frequent values. The values are followed
+// by the counts and the bounds, aligned to eight bytes, and by an index of twice as many slots.
+#define AGGSTAT_FRQ_SIZ(C) \
+  (((C) * sizeof(AGGSTAT_FLT) + 7) / 8 * 8 + (C) * 2 * sizeof(uint64_t) \
+   + (C) * 2 * sizeof(uint32_t))
+
+// Size in bytes of the memory of the state variables of a number of lanes of a bank.
+#define AGGSTAT_BNK_SIZ(N) ((N) * 4 * sizeof(AGGSTAT_FLT))
+
+// Size in bytes of the memory of a compressed block that holds a number of timestamped values. The
+// number of values is followed by at most 145 bits of each value.
+#define AGGSTAT_GOR_SIZ(N) ((1 + ((N) * 145 + 63) / 64) * sizeof(uint64_t))
+
+// Size in bytes of the memory of both copies of a snapshot of a number of aggregates.
+#define AGGSTAT_SNP_SIZ(N) ((N) * 2 * sizeof(struct aggstat))
+
 /// Aggregate function types.
 #define AGGSTAT_FNC_FST 0x1 // First.
 #define AGGSTAT_FNC_LST 0x2 // Last.
@@ -167,6 +329,14 @@
 #define AGGSTAT_FNC_KRT 0xb // Kurtosis.
 #define AGGSTAT_FNC_QNT 0xc // Quantile.
 #define AGGSTAT_FNC_MED 0xd // Median.
+#define AGGSTAT_FNC_TWA 0xe // Time-weighted average.
+#define AGGSTAT_FNC_ITG 0xf // Time integral.
+#define AGGSTAT_FNC_RAT 0x10 // Rate of change.
+
+/// Readings of the values by the parallel exact quantiles.
+#define AGGSTAT_RDR_SMP 0x1 // Sample of the splitters.
+#define AGGSTAT_RDR_CNT 0x2 // Counting of the values in the buckets.
+#define AGGSTAT_RDR_CPY 0x3 // Copying of the values of the requested buckets.
 
 
 /// Aggregate function.
@@ -178,10 +348,178 @@ struct aggstat {
   AGGSTAT_FLT ag_val[10]; ///< State variables.
 };
 
+/// Aggregate function of integer values.
+struct aggstat_int {
+  uint8_t     ai_fnc;     ///< Type.
+  uint8_t     ai_sgn;     ///< Signedness of the values.
+  uint8_t     ai_pad[6];  ///< Padding (unused).
+  AGGSTAT_INT ai_cnt;     ///< Number of observations.
+  uint64_t    ai_sum[2];  ///< Sum of values (low and high word of a 128-bit integer).
+  uint64_t    ai_ext[2];  ///< Minimum and maximum (order-preserving unsigned encoding).
+  AGGSTAT_FLT ai_val[2];  ///< State variables.
+};
+
+/// Parser of numbers in delimited text.
+struct aggstat_txt {
+  char        at_dlm;      ///< Column delimiter.
+  uint8_t     at_len;      ///< Length of the partial field.
+  bool        at_ovf;      ///< Partial field exceeds the buffer.
+  uint8_t     at_pad[5];   ///< Padding (unused).
+  uint32_t    at_col;      ///< Selected column.
+  uint32_t    at_cur;      ///< Column at the current position.
+  AGGSTAT_INT at_cnt;      ///< Number of parsed values.
+  AGGSTAT_INT at_err;      ///< Number of fields that are not numbers.
+  char        at_fld[128]; ///< Partial field that spans two buffers.
+};
+
+/// Aggregate function of a stream that is passed in chunks, possibly multiple times.
+struct aggstat_ooc {
+  struct aggstat ao_agg;    ///< Aggregate function of the non-quantile functions.
+  uint8_t        ao_stg;    ///< Stage of the passes.
+  uint8_t        ao_bit;    ///< Width of the key interval.
+  uint8_t        ao_hbt;    ///< Width of the histogram index.
+  uint8_t        ao_pad[5]; ///< Padding (unused).
+  uint64_t*      ao_hst;    ///< Histogram of keys.
+  AGGSTAT_FLT*   ao_arr;    ///< Collected values.
+  uint64_t       ao_cap;    ///< Capacity of the collected values.
+  uint64_t       ao_len;    ///< Number of collected values.
+  uint64_t       ao_cnt;    ///< Number of values in the stream.
+  uint64_t       ao_chk;    ///< Number of values in the current pass.
+  uint64_t       ao_blw;    ///< Number of values below the key interval.
+  uint64_t       ao_rnk;    ///< Rank of the quantile.
+  uint64_t       ao_klo;    ///< Lowest key of the interval.
+  uint64_t       ao_inn;    ///< Number of values within the key interval.
+  AGGSTAT_FLT    ao_frp;    ///< Fractional part of the rank.
+  AGGSTAT_FLT    ao_abv;    ///< Least value above the key interval.
+  AGGSTAT_FLT    ao_res;    ///< Quantile.
+};
+
+/// Buffer of values for exact quantiles.
+struct aggstat_buf {
+  uint8_t      ab_fnc;                  ///< Type.
+  uint8_t      ab_pad[7];               ///< Padding (unused).
+  AGGSTAT_FLT  ab_par;                  ///< Function argument.
+  AGGSTAT_FLT* ab_arr;                  ///< Values.
+  size_t       ab_cap;                  ///< Capacity of the values.
+  size_t       ab_len;                  ///< Number of values.
+  size_t       ab_prt;                  ///< Number of values within the partitions.
+  size_t       ab_cnt;                  ///< Number of boundaries.
+  size_t       ab_bnd[AGGSTAT_BUF_BND]; ///< Starts of the partitions, except the first one.
+  AGGSTAT_FLT  ab_piv[AGGSTAT_BUF_BND]; ///< Pivots between adjacent partitions.
+};
+
+/// Rollup of aggregate functions over rings of time buckets of increasing granularity.
+struct aggstat_rol {
+  uint8_t         ar_fnc;                  ///< Type.
+  uint8_t         ar_cnt;                  ///< Number of levels.
+  uint8_t         ar_pad[6];               ///< Padding (unused).
+  AGGSTAT_FLT     ar_par;                  ///< Function argument.
+  uint64_t        ar_lat;                  ///< Tolerated lateness.
+  uint64_t        ar_wtm;                  ///< Newest timestamp.
+  uint64_t        ar_fst;                  ///< Oldest bucket of the finest level with values.
+  uint64_t        ar_gra[AGGSTAT_ROL_LVL]; ///< Granularity of the buckets of each level.
+  uint64_t        ar_len[AGGSTAT_ROL_LVL]; ///< Number of buckets of each level.
+  uint64_t        ar_top[AGGSTAT_ROL_LVL]; ///< Newest bucket of each level.
+  uint64_t        ar_cls[AGGSTAT_ROL_LVL]; ///< Oldest bucket of each level that is not closed.
+  struct aggstat* ar_bkt[AGGSTAT_ROL_LVL]; ///< Ring of buckets of each level.
+};
+
+/// Most frequent values of a stream, counted by a fixed number of counters (Space-Saving).
+struct aggstat_frq {
+  uint32_t     af_cap;    ///< Number of counters.
+  uint32_t     af_len;    ///< Number of used counters.
+  uint32_t     af_tsz;    ///< Number of slots of the index.
+  uint32_t     af_cur;    ///< Counter replaced last.
+  uint64_t     af_min;    ///< Lower bound of the lowest count.
+  uint64_t     af_tot;    ///< Number of values.
+  AGGSTAT_FLT* af_val;    ///< Values of the counters.
+  uint64_t*    af_cnt;    ///< Counts of the values.
+  uint64_t*    af_err;    ///< Bounds of the overestimation of the counts.
+  uint32_t*    af_tbl;    ///< Index of the counters by their values.
+};
+
+/// Aggregates of the same function for many lanes, in the structure-of-arrays layout.
+struct aggstat_bnk {
+  uint8_t      ak_fnc;    ///< Type.
+  uint8_t      ak_pad[3]; ///< Padding (unused).
+  uint32_t     ak_len;    ///< Number of lanes.
+  AGGSTAT_INT  ak_cnt;    ///< Number of rows.
+  AGGSTAT_FLT* ak_val[4]; ///< State variables of all lanes.
+};
+
+/// Encoder of timestamped values into a block of compressed values (Gorilla).
+struct aggstat_gor {
+  uint64_t* ax_blk;    ///< Words of the block.
+  size_t    ax_cap;    ///< Capacity of the block in bits.
+  size_t    ax_pos;    ///< Number of written bits.
+  uint64_t  ax_tim;    ///< Previous timestamp.
+  uint64_t  ax_dlt;    ///< Previous difference of timestamps.
+  uint64_t  ax_val;    ///< Binary representation of the previous value.
+  uint8_t   ax_lzc;    ///< Leading zero bits of the window of meaningful bits.
+  uint8_t   ax_tzc;    ///< Trailing zero bits of the window of meaningful bits.
+  uint8_t   ax_pad[6]; ///< Padding (unused).
+};
+
+/// Aggregate function of timestamped values with forward-decayed weights.
+struct aggstat_fwd {
+  uint8_t     ad_fnc;     ///< Type.
+  uint8_t     ad_pad[7];  ///< Padding (unused).
+  AGGSTAT_INT ad_cnt;     ///< Number of values.
+  AGGSTAT_FLT ad_par;     ///< Function argument.
+  AGGSTAT_FLT ad_rat;     ///< Decay rate per unit of time.
+  AGGSTAT_FLT ad_lnd;     ///< Landmark timestamp.
+  AGGSTAT_FLT ad_wgt[2];  ///< Sum of weights and sum of squared weights.
+  AGGSTAT_FLT ad_val[10]; ///< State variables.
+};
+
+/// Two copies of an array of aggregates, updated by writers and swapped by a reader.
+struct aggstat_snp {
+  struct aggstat* as_agg[2]; ///< Both copies of the aggregates.
+  uint32_t        as_len;    ///< Number of aggregates of each copy.
+  uint8_t         as_pad[4]; ///< Padding (unused).
+  uint64_t        as_epc;    ///< Number of swaps, whose lowest bit selects the active copy.
+  uint64_t        as_wrt[2]; ///< Number of writers within each copy.
+};
+
+/// Counters of internal events of the streaming algorithms.
+struct aggstat_ctr {
+  uint64_t ac_inp;    ///< Number of input values.
+  uint64_t ac_nan;    ///< Number of input values that are not a number.
+  uint64_t ac_inf;    ///< Number of infinite input values.
+  uint64_t ac_mov;    ///< Number of movements of the quantile markers.
+  uint64_t ac_prb;    ///< Number of parabolic estimates of the quantile markers.
+  uint64_t ac_lin;    ///< Number of fallbacks to the linear estimate.
+};
+
 /// On-line algorithms.
 void aggstat_new(struct aggstat* agg, const uint8_t fnc, const AGGSTAT_FLT par);
 void aggstat_put(struct aggstat* agg, const AGGSTAT_FLT val);
 bool aggstat_get(const struct aggstat *restrict agg, AGGSTAT_FLT *restrict val);
+void aggstat_put_arr(struct aggstat    *restrict agg,
+                     const AGGSTAT_FLT *restrict arr,
+                     const AGGSTAT_INT           len);
+bool aggstat_mrg(struct aggstat *restrict dst, const struct aggstat *restrict src);
+
+/// On-line algorithms for timestamped values.
+void aggstat_put_t(struct aggstat* agg, const AGGSTAT_FLT tim, const AGGSTAT_FLT val);
+void aggstat_put_t_arr(struct aggstat    *restrict agg,
+                       const AGGSTAT_FLT *restrict tim,
+                       const AGGSTAT_FLT *restrict arr,
+                       const AGGSTAT_INT           len);
+
+/// Off-line algorithms for timestamped values.
+bool aggstat_run_t(      AGGSTAT_FLT *restrict val,
+                   const AGGSTAT_FLT *restrict tim,
+                   const AGGSTAT_FLT *restrict arr,
+                   const AGGSTAT_INT           len,
+                   const uint8_t               fnc,
+                   const AGGSTAT_FLT           par);
+
+/// Retraction of values.
+bool aggstat_del(struct aggstat* agg, const AGGSTAT_FLT val);
+bool aggstat_del_arr(struct aggstat    *restrict agg,
+                     const AGGSTAT_FLT *restrict arr,
+                     const AGGSTAT_INT           len);
 
 /// Off-line algorithms.
 bool aggstat_run(      AGGSTAT_FLT *restrict val,
@@ -189,5 +527,209 @@ bool aggstat_run(      AGGSTAT_FLT *restrict val,
                  const AGGSTAT_INT           len,
                  const uint8_t               fnc,
                  const AGGSTAT_FLT           par);
+bool aggstat_run_many(      AGGSTAT_FLT *restrict val,
+                            AGGSTAT_FLT *restrict arr,
+                      const AGGSTAT_INT           len,
+                      const uint8_t     *restrict fnc,
+                      const AGGSTAT_FLT *restrict par,
+                      const size_t                cnt);
+bool aggstat_run_par(      AGGSTAT_FLT *restrict val,
+                     const AGGSTAT_FLT *restrict arr,
+                     const AGGSTAT_INT           len,
+                     const AGGSTAT_FLT *restrict par,
+                     const size_t                cnt,
+                     const uint32_t              thr);
+bool aggstat_run_par_rdr(      AGGSTAT_FLT *restrict val,
+                         void (*rdr)(AGGSTAT_FLT*, const void*, size_t, size_t, uint32_t, uint8_t),
+                         const void        *restrict src,
+                         const AGGSTAT_INT           len,
+                         const AGGSTAT_FLT *restrict par,
+                         const size_t                cnt,
+                         const uint32_t              thr);
+
+/// Off-line algorithms for non-contiguous streams.
+bool aggstat_run_strided(      AGGSTAT_FLT *restrict val,
+                         const void        *restrict ptr,
+                         const size_t                str,
+                         const AGGSTAT_INT           len,
+                         const uint8_t               fnc,
+                         const AGGSTAT_FLT           par);
+bool aggstat_run_idx(      AGGSTAT_FLT *restrict val,
+                     const AGGSTAT_FLT *restrict arr,
+                     const AGGSTAT_INT *restrict idx,
+                     const AGGSTAT_INT           len,
+                     const uint8_t               fnc,
+                     const AGGSTAT_FLT           par);
+
+/// On-line algorithms for weighted values.
+void aggstat_put_w(struct aggstat* agg, const AGGSTAT_FLT val, const AGGSTAT_INT wgt);
+
+/// Off-line algorithms for weighted values.
+bool aggstat_run_w(      AGGSTAT_FLT *restrict val,
+                         AGGSTAT_FLT *restrict arr,
+                         AGGSTAT_INT *restrict wgt,
+                   const AGGSTAT_INT           len,
+                   const uint8_t               fnc,
+                   const AGGSTAT_FLT           par);
+
+/// Ingestion of delimited text.
+void aggstat_txt_new(struct aggstat_txt* txt, const char dlm, const uint32_t col);
+void aggstat_txt_put(struct aggstat_txt *restrict txt,
+                     const char         *restrict buf,
+                     const size_t                 len,
+                     struct aggstat     *restrict agg,
+                     const size_t                 cnt);
+void aggstat_txt_end(struct aggstat_txt *restrict txt,
+                     struct aggstat     *restrict agg,
+                     const size_t                 cnt);
+bool aggstat_txt_flt(AGGSTAT_FLT *restrict val, const char *restrict str, const size_t len);
+
+/// Out-of-core algorithms.
+bool aggstat_ooc_new(struct aggstat_ooc* ooc,
+                     const uint8_t       fnc,
+                     const AGGSTAT_FLT   par,
+                     void*               mem,
+                     const size_t        siz);
+void aggstat_ooc_put(struct aggstat_ooc *restrict ooc,
+                     const AGGSTAT_FLT  *restrict arr,
+                     const AGGSTAT_INT            len);
+bool aggstat_ooc_end(struct aggstat_ooc* ooc);
+bool aggstat_ooc_get(const struct aggstat_ooc *restrict ooc, AGGSTAT_FLT *restrict val);
+
+/// Exact quantiles of buffered values.
+bool aggstat_buf_new(struct aggstat_buf* buf, const uint8_t fnc, const AGGSTAT_FLT par);
+bool aggstat_buf_put(struct aggstat_buf* buf, const AGGSTAT_FLT val);
+bool aggstat_buf_put_arr(struct aggstat_buf *restrict buf,
+                         const AGGSTAT_FLT  *restrict arr,
+                         const AGGSTAT_INT            len);
+bool aggstat_buf_get(struct aggstat_buf *restrict buf, AGGSTAT_FLT *restrict val);
+void aggstat_buf_free(struct aggstat_buf* buf);
+
+/// Rollups of timestamped values.
+bool aggstat_rol_new(struct aggstat_rol *restrict rol,
+                     const uint8_t                fnc,
+                     const AGGSTAT_FLT            par,
+                     struct aggstat     *restrict bkt,
+                     const uint64_t     *restrict gra,
+                     const uint64_t     *restrict len,
+                     const uint8_t                cnt,
+                     const uint64_t               lat);
+bool aggstat_rol_put(struct aggstat_rol* rol, const uint64_t tim, const AGGSTAT_FLT val);
+bool aggstat_rol_get(const struct aggstat_rol *restrict rol,
+                     const uint64_t                     beg,
+                     const uint64_t                     end,
+                     AGGSTAT_FLT              *restrict val);
+
+/// Most frequent values.
+bool aggstat_frq_new(struct aggstat_frq* frq, void* mem, const uint32_t cap);
+void aggstat_frq_put(struct aggstat_frq* frq, const AGGSTAT_FLT val);
+void aggstat_frq_put_arr(struct aggstat_frq *restrict frq,
+                         const AGGSTAT_FLT  *restrict arr,
+                         const AGGSTAT_INT            len);
+void aggstat_frq_mrg(struct aggstat_frq *restrict dst, const struct aggstat_frq *restrict src);
+uint32_t aggstat_frq_top(struct aggstat_frq *restrict frq,
+                         AGGSTAT_FLT        *restrict val,
+                         uint64_t           *restrict cnt,
+                         uint64_t           *restrict err,
+                         const uint32_t               num);
+
+/// Banks of aggregates.
+bool aggstat_bnk_new(struct aggstat_bnk* bnk, const uint8_t fnc, void* mem, const uint32_t len);
+void aggstat_bnk_put_row(struct aggstat_bnk *restrict bnk, const AGGSTAT_FLT *restrict row);
+bool aggstat_bnk_get(const struct aggstat_bnk *restrict bnk, AGGSTAT_FLT *restrict val);
+
+/// Compressed blocks of timestamped values.
+bool aggstat_gor_new(struct aggstat_gor* gor, void* mem, const size_t siz);
+bool aggstat_gor_put(struct aggstat_gor* gor, const uint64_t tim, const AGGSTAT_FLT val);
+size_t aggstat_gor_siz(const struct aggstat_gor* gor);
+bool aggstat_gor_dec(      AGGSTAT_FLT *restrict tim,
+                           AGGSTAT_FLT *restrict arr,
+                     const uint64_t    *restrict blk,
+                     const size_t                siz);
+bool aggstat_gor_agg(struct aggstat *restrict agg,
+                     const size_t             cnt,
+                     const uint64_t *restrict blk,
+                     const size_t             siz);
+bool aggstat_gor_ooc(struct aggstat_ooc *restrict ooc,
+                     const uint64_t     *restrict blk,
+                     const size_t                 siz);
+
+/// Forward-decayed aggregates.
+bool aggstat_fwd_new(struct aggstat_fwd* fwd,
+                     const uint8_t       fnc,
+                     const AGGSTAT_FLT   par,
+                     const AGGSTAT_FLT   rat);
+void aggstat_fwd_put(struct aggstat_fwd* fwd, const AGGSTAT_FLT tim, const AGGSTAT_FLT val);
+void aggstat_fwd_put_arr(struct aggstat_fwd *restrict fwd,
+                         const AGGSTAT_FLT  *restrict tim,
+                         const AGGSTAT_FLT  *restrict arr,
+                         const AGGSTAT_INT            len);
+bool aggstat_fwd_get(const struct aggstat_fwd *restrict fwd,
+                     const AGGSTAT_FLT                  tim,
+                           AGGSTAT_FLT        *restrict val);
+
+/// Snapshots of aggregates.
+bool aggstat_snp_new(struct aggstat_snp*   snp,
+                     const struct aggstat* ini,
+                     void*                 mem,
+                     const uint32_t        len);
+struct aggstat* aggstat_snp_bgn(struct aggstat_snp* snp);
+void aggstat_snp_end(struct aggstat_snp* snp, const struct aggstat* agg);
+void aggstat_snp_put(struct aggstat_snp* snp, const uint32_t idx, const AGGSTAT_FLT val);
+void aggstat_snp_put_arr(struct aggstat_snp *restrict snp,
+                         const uint32_t               idx,
+                         const AGGSTAT_FLT  *restrict arr,
+                         const AGGSTAT_INT            len);
+const struct aggstat* aggstat_snp_swp(struct aggstat_snp* snp);
+
+/// Instrumentation.
+void aggstat_ctr_get(struct aggstat_ctr* ctr);
+void aggstat_ctr_rst(void);
+
+/// On-line algorithms for integer values.
+bool aggstat_new_int(struct aggstat_int* agg, const uint8_t fnc, const bool sgn);
+void aggstat_put_i64(struct aggstat_int* agg, const int64_t inp);
+void aggstat_put_u64(struct aggstat_int* agg, const uint64_t inp);
+void aggstat_put_i64_arr(struct aggstat_int *restrict agg,
+                         const int64_t      *restrict arr,
+                         const AGGSTAT_INT            len);
+void aggstat_put_u64_arr(struct aggstat_int *restrict agg,
+                         const uint64_t     *restrict arr,
+                         const AGGSTAT_INT            len);
+bool aggstat_get_int(const struct aggstat_int *restrict agg, AGGSTAT_FLT *restrict val);
+bool aggstat_get_i64(const struct aggstat_int *restrict agg, int64_t *restrict val);
+bool aggstat_get_u64(const struct aggstat_int *restrict agg, uint64_t *restrict val);
+
+/// Off-line algorithms for integer values.
+bool aggstat_run_i64(      AGGSTAT_FLT *restrict val,
+                     const int64_t     *restrict arr,
+                     const AGGSTAT_INT           len,
+                     const uint8_t               fnc);
+bool aggstat_run_u64(      AGGSTAT_FLT *restrict val,
+                     const uint64_t    *restrict arr,
+                     const AGGSTAT_INT           len,
+                     const uint8_t               fnc);
+
+/// Half-precision and bfloat16 values.
+void aggstat_put_f16_arr(struct aggstat *restrict agg,
+                         const uint16_t *restrict arr,
+                         const AGGSTAT_INT        len);
+void aggstat_put_b16_arr(struct aggstat *restrict agg,
+                         const uint16_t *restrict arr,
+                         const AGGSTAT_INT        len);
+bool aggstat_run_f16(      AGGSTAT_FLT *restrict val,
+                     const uint16_t    *restrict arr,
+                     const AGGSTAT_INT           len,
+                     const uint8_t               fnc,
+                     const AGGSTAT_FLT           par);
+bool aggstat_run_b16(      AGGSTAT_FLT *restrict val,
+                     const uint16_t    *restrict arr,
+                     const AGGSTAT_INT           len,
+                     const uint8_t               fnc,
+                     const AGGSTAT_FLT           par);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif
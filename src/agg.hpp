@@ -0,0 +1,278 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#ifndef AGGSTAT_HPP
+#define AGGSTAT_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <execution>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include <math.h>
+
+// The C header uses the C99 `restrict` qualifier, which is available as an extension in C++. Any
+// definition of the macro by the including code is restored afterwards.
+#pragma push_macro("restrict")
+#undef restrict
+#define restrict __restrict
+#include "agg.h"
+#pragma pop_macro("restrict")
+
+
+namespace agg {
+
+/// Aggregate function types.
+struct fst { static constexpr uint8_t fnc = AGGSTAT_FNC_FST; };
+struct lst { static constexpr uint8_t fnc = AGGSTAT_FNC_LST; };
+struct cnt { static constexpr uint8_t fnc = AGGSTAT_FNC_CNT; };
+struct sum { static constexpr uint8_t fnc = AGGSTAT_FNC_SUM; };
+struct min { static constexpr uint8_t fnc = AGGSTAT_FNC_MIN; };
+struct max { static constexpr uint8_t fnc = AGGSTAT_FNC_MAX; };
+struct avg { static constexpr uint8_t fnc = AGGSTAT_FNC_AVG; };
+struct var { static constexpr uint8_t fnc = AGGSTAT_FNC_VAR; };
+struct dev { static constexpr uint8_t fnc = AGGSTAT_FNC_DEV; };
+struct skw { static constexpr uint8_t fnc = AGGSTAT_FNC_SKW; };
+struct krt { static constexpr uint8_t fnc = AGGSTAT_FNC_KRT; };
+struct qnt { static constexpr uint8_t fnc = AGGSTAT_FNC_QNT; };
+struct med { static constexpr uint8_t fnc = AGGSTAT_FNC_MED; };
+struct twa { static constexpr uint8_t fnc = AGGSTAT_FNC_TWA; };
+struct itg { static constexpr uint8_t fnc = AGGSTAT_FNC_ITG; };
+struct rat { static constexpr uint8_t fnc = AGGSTAT_FNC_RAT; };
+
+/// Whether the states of two consecutive streams can be merged.
+template <class F>
+inline constexpr bool mergeable = F::fnc != AGGSTAT_FNC_QNT && F::fnc != AGGSTAT_FNC_MED;
+
+/// Number of values of each part of the array processed by the parallel static algorithm.
+inline constexpr size_t run_prt = size_t(1) << 16;
+
+/// Streaming aggregate function selected at compile time.
+///
+/// The class holds nothing but `struct aggstat`, and thus a state can be shared with the C API in
+/// both directions, e.g. by `state` or by constructing the class from a state. The update of the
+/// first value up to kurtosis is resolved at compile time and inlined, and produces the same state
+/// as `aggstat_put`. The remaining functions are updated by the C API, and so are all functions if
+/// the library counts internal events (`AGGSTAT_CTR`), as the counters are kept by the C API.
+template <class F, class T = AGGSTAT_FLT>
+class stream {
+  static_assert(std::is_same_v<T, AGGSTAT_FLT>, "the type must be selected by AGGSTAT_FLT_BIT");
+
+public:
+  /// Initialise the aggregate function.
+  ///
+  /// @param[in] par function parameter
+  explicit stream(const T par = T(0)) noexcept
+  {
+    aggstat_new(&agg_, F::fnc, par);
+  }
+
+  /// Adopt the state of the aggregate function from the C API.
+  ///
+  /// @param[in] agg state of the same function type
+  explicit stream(const struct aggstat& agg) noexcept : agg_(agg)
+  {
+    assert(agg.ag_fnc == F::fnc);
+  }
+
+  /// Update the aggregate function with a value.
+  ///
+  /// @param[in] inp input value
+  void put(const T inp) noexcept
+  {
+    if constexpr (AGGSTAT_CTR == 1) {
+      aggstat_put(&agg_, inp);
+      return;
+    } else if constexpr (F::fnc == AGGSTAT_FNC_FST) {
+      agg_.ag_val[agg_.ag_cnt[0] != 0] = inp;
+    } else if constexpr (F::fnc == AGGSTAT_FNC_LST) {
+      agg_.ag_val[0] = inp;
+    } else if constexpr (F::fnc == AGGSTAT_FNC_SUM) {
+      agg_.ag_val[0] += inp;
+    } else if constexpr (F::fnc == AGGSTAT_FNC_MIN) {
+      agg_.ag_val[0] = AGGSTAT_FMIN(inp, agg_.ag_val[0]);
+    } else if constexpr (F::fnc == AGGSTAT_FNC_MAX) {
+      agg_.ag_val[0] = AGGSTAT_FMAX(inp, agg_.ag_val[0]);
+    } else if constexpr (F::fnc >= AGGSTAT_FNC_AVG && F::fnc <= AGGSTAT_FNC_KRT) {
+      const AGGSTAT_INT cur = agg_.ag_cnt[0];
+      const T           x   = inp - agg_.ag_val[0];
+      const T           y   = x / T(cur + 1);
+      const T           z   = x * y * T(cur);
+
+      agg_.ag_val[0] += y;
+
+      if constexpr (F::fnc == AGGSTAT_FNC_KRT) {
+        const T n = T(cur + 1);
+        agg_.ag_val[3] += z * (y * y) * (n * n - AGGSTAT_3_0 * n + AGGSTAT_3_0)
+                        + AGGSTAT_6_0 * (y * y) * agg_.ag_val[1]
+                        - AGGSTAT_4_0 * y * agg_.ag_val[2];
+      }
+
+      if constexpr (F::fnc >= AGGSTAT_FNC_SKW) {
+        agg_.ag_val[2] += z * y * T(cur - 1) - AGGSTAT_3_0 * y * agg_.ag_val[1];
+      }
+
+      if constexpr (F::fnc >= AGGSTAT_FNC_VAR) {
+        agg_.ag_val[1] += z;
+      }
+    } else if constexpr (F::fnc != AGGSTAT_FNC_CNT) {
+      aggstat_put(&agg_, inp);
+      return;
+    }
+
+    agg_.ag_cnt[0] += 1;
+  }
+
+  /// Update the aggregate function with a timestamped value.
+  ///
+  /// @param[in] tim timestamp
+  /// @param[in] inp input value
+  void put(const T tim, const T inp) noexcept
+  {
+    aggstat_put_t(&agg_, tim, inp);
+  }
+
+  /// Update the aggregate function with a span of values.
+  ///
+  /// @param[in] arr span of values
+  void put(const std::span<const T> arr) noexcept
+  {
+    for (const T inp : arr) {
+      put(inp);
+    }
+  }
+
+  /// Obtain the aggregated value.
+  /// @return aggregated value, or no value if it is not defined
+  std::optional<T> get() const noexcept
+  {
+    T val;
+
+    if (aggstat_get(&agg_, &val) == false) {
+      return std::nullopt;
+    }
+
+    return val;
+  }
+
+  /// Merge the state of a succeeding stream.
+  /// @return merged state
+  ///
+  /// @param[in] src state of the succeeding stream
+  stream& operator+=(const stream& src) noexcept requires mergeable<F>
+  {
+    (void)aggstat_mrg(&agg_, &src.agg_);
+    return *this;
+  }
+
+  /// Merge the states of two consecutive streams.
+  /// @return merged state
+  ///
+  /// @param[in] dst state of the preceding stream
+  /// @param[in] src state of the succeeding stream
+  friend stream operator+(stream dst, const stream& src) noexcept requires mergeable<F>
+  {
+    dst += src;
+    return dst;
+  }
+
+  /// Access the state shared with the C API.
+  /// @return state
+  struct aggstat& state() noexcept
+  {
+    return agg_;
+  }
+
+  /// Access the state shared with the C API.
+  /// @return state
+  const struct aggstat& state() const noexcept
+  {
+    return agg_;
+  }
+
+private:
+  struct aggstat agg_; ///< State.
+};
+
+static_assert(sizeof(stream<var>) == sizeof(struct aggstat), "the state must be shared with C");
+static_assert(std::is_standard_layout_v<stream<var>>, "the state must be shared with C");
+
+/// Compute an aggregate of a span with full information.
+/// @return aggregate, or no value if it is not defined
+///
+/// @param[in] arr span of values
+/// @param[in] par function parameter
+template <class F, class T = AGGSTAT_FLT>
+std::optional<T> run(const std::type_identity_t<std::span<const T>> arr,
+                     const std::type_identity_t<T>                  par = T(0))
+{
+  static_assert(std::is_same_v<T, AGGSTAT_FLT>, "the type must be selected by AGGSTAT_FLT_BIT");
+
+  T val;
+
+  if (arr.size() > size_t(AGGSTAT_INT_MAX)) {
+    return std::nullopt;
+  }
+
+  if (aggstat_run(&val, arr.data(), AGGSTAT_INT(arr.size()), F::fnc, par) == false) {
+    return std::nullopt;
+  }
+
+  return val;
+}
+
+/// Compute an aggregate of a span with full information under an execution policy.
+/// @return aggregate, or no value if it is not defined
+///
+/// The span is divided into parts of `run_prt` values, whose streaming states are computed under
+/// the policy and merged in their order. The time-weighted functions receive the positions of the
+/// values in the span as their timestamps, as `run` does, so that each value is held up to the
+/// first value of the next part. The result is thus that of the streaming algorithm, and can
+/// differ from `run` by rounding. The quantile and median functions can not be merged and are
+/// computed by `run`.
+///
+/// @param[in] pol execution policy
+/// @param[in] arr span of values
+/// @param[in] par function parameter
+template <class F, class T = AGGSTAT_FLT, class P>
+  requires std::is_execution_policy_v<std::remove_cvref_t<P>>
+std::optional<T> run(P&&                                           pol,
+                     const std::type_identity_t<std::span<const T>> arr,
+                     const std::type_identity_t<T>                  par = T(0))
+{
+  if constexpr (mergeable<F> == false) {
+    (void)pol;
+    return run<F, T>(arr, par);
+  } else {
+    std::vector<stream<F, T>> prt((arr.size() + run_prt - 1) / run_prt, stream<F, T>(par));
+    stream<F, T>              res(par);
+
+    std::for_each(std::forward<P>(pol), prt.begin(), prt.end(), [&](stream<F, T>& str) {
+      const size_t idx = size_t(&str - prt.data()) * run_prt;
+      const size_t len = std::min(run_prt, arr.size() - idx);
+
+      if constexpr (F::fnc >= AGGSTAT_FNC_TWA) {
+        for (size_t pos = idx; pos < idx + len; pos += 1) {
+          str.put(T(pos), arr[pos]);
+        }
+      } else {
+        str.put(arr.subspan(idx, len));
+      }
+    });
+
+    for (const stream<F, T>& str : prt) {
+      res += str;
+    }
+
+    return res.get();
+  }
+}
+
+} // namespace agg
+
+#endif
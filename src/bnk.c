@@ -0,0 +1,316 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include "agg.h"
+
+
+/// Update the first values of the lanes.
+///
+/// @param[in] bnk bank of aggregates
+/// @param[in] row row of input values
+static void
+bnk_fst(struct aggstat_bnk *restrict bnk, const AGGSTAT_FLT *restrict row)
+{
+  AGGSTAT_FLT *restrict fst;
+  uint32_t              idx;
+
+  if (bnk->ak_cnt > 0) {
+    return;
+  }
+
+  fst = bnk->ak_val[0];
+  for (idx = 0; idx < bnk->ak_len; idx += 1) {
+    fst[idx] = row[idx];
+  }
+}
+
+/// Update the last values of the lanes.
+///
+/// @param[in] bnk bank of aggregates
+/// @param[in] row row of input values
+static void
+bnk_lst(struct aggstat_bnk *restrict bnk, const AGGSTAT_FLT *restrict row)
+{
+  AGGSTAT_FLT *restrict lst;
+  uint32_t              idx;
+
+  lst = bnk->ak_val[0];
+  for (idx = 0; idx < bnk->ak_len; idx += 1) {
+    lst[idx] = row[idx];
+  }
+}
+
+/// Update the sums of the lanes.
+///
+/// @param[in] bnk bank of aggregates
+/// @param[in] row row of input values
+static void
+bnk_sum(struct aggstat_bnk *restrict bnk, const AGGSTAT_FLT *restrict row)
+{
+  AGGSTAT_FLT *restrict sum;
+  uint32_t              idx;
+
+  sum = bnk->ak_val[0];
+  for (idx = 0; idx < bnk->ak_len; idx += 1) {
+    sum[idx] += row[idx];
+  }
+}
+
+/// Update the minimal values of the lanes.
+///
+/// The state is never a NaN, and thus the comparison yields the same result as the `fmin` function
+/// of the streaming algorithm, while it can be vectorised.
+///
+/// @param[in] bnk bank of aggregates
+/// @param[in] row row of input values
+static void
+bnk_min(struct aggstat_bnk *restrict bnk, const AGGSTAT_FLT *restrict row)
+{
+  AGGSTAT_FLT *restrict min;
+  uint32_t              idx;
+
+  min = bnk->ak_val[0];
+  for (idx = 0; idx < bnk->ak_len; idx += 1) {
+    min[idx] = row[idx] < min[idx] ? row[idx] : min[idx];
+  }
+}
+
+/// Update the maximal values of the lanes.
+///
+/// @param[in] bnk bank of aggregates
+/// @param[in] row row of input values
+static void
+bnk_max(struct aggstat_bnk *restrict bnk, const AGGSTAT_FLT *restrict row)
+{
+  AGGSTAT_FLT *restrict max;
+  uint32_t              idx;
+
+  max = bnk->ak_val[0];
+  for (idx = 0; idx < bnk->ak_len; idx += 1) {
+    max[idx] = row[idx] > max[idx] ? row[idx] : max[idx];
+  }
+}
+
+/// Update the first moments of the lanes.
+///
+/// @param[in] bnk bank of aggregates
+/// @param[in] row row of input values
+static void
+bnk_avg(struct aggstat_bnk *restrict bnk, const AGGSTAT_FLT *restrict row)
+{
+  AGGSTAT_FLT *restrict avg;
+  AGGSTAT_FLT           nxt;
+  uint32_t              idx;
+
+  avg = bnk->ak_val[0];
+  nxt = (AGGSTAT_FLT)(bnk->ak_cnt + 1);
+  for (idx = 0; idx < bnk->ak_len; idx += 1) {
+    avg[idx] += (row[idx] - avg[idx]) / nxt;
+  }
+}
+
+/// Update the first two moments of the lanes.
+///
+/// @param[in] bnk bank of aggregates
+/// @param[in] row row of input values
+static void
+bnk_var(struct aggstat_bnk *restrict bnk, const AGGSTAT_FLT *restrict row)
+{
+  AGGSTAT_FLT *restrict avg;
+  AGGSTAT_FLT *restrict snd;
+  AGGSTAT_FLT           cur;
+  AGGSTAT_FLT           nxt;
+  AGGSTAT_FLT           x;
+  AGGSTAT_FLT           y;
+  uint32_t              idx;
+
+  avg = bnk->ak_val[0];
+  snd = bnk->ak_val[1];
+  cur = (AGGSTAT_FLT)bnk->ak_cnt;
+  nxt = (AGGSTAT_FLT)(bnk->ak_cnt + 1);
+  for (idx = 0; idx < bnk->ak_len; idx += 1) {
+    x = row[idx] - avg[idx];
+    y = x / nxt;
+
+    avg[idx] += y;
+    snd[idx] += x * y * cur;
+  }
+}
+
+/// Update the first three moments of the lanes.
+///
+/// @param[in] bnk bank of aggregates
+/// @param[in] row row of input values
+static void
+bnk_skw(struct aggstat_bnk *restrict bnk, const AGGSTAT_FLT *restrict row)
+{
+  AGGSTAT_FLT *restrict avg;
+  AGGSTAT_FLT *restrict snd;
+  AGGSTAT_FLT *restrict trd;
+  AGGSTAT_FLT           cur;
+  AGGSTAT_FLT           nxt;
+  AGGSTAT_FLT           prv;
+  AGGSTAT_FLT           x;
+  AGGSTAT_FLT           y;
+  AGGSTAT_FLT           z;
+  uint32_t              idx;
+
+  avg = bnk->ak_val[0];
+  snd = bnk->ak_val[1];
+  trd = bnk->ak_val[2];
+  cur = (AGGSTAT_FLT)bnk->ak_cnt;
+  nxt = (AGGSTAT_FLT)(bnk->ak_cnt + 1);
+  prv = (AGGSTAT_FLT)(bnk->ak_cnt - 1);
+  for (idx = 0; idx < bnk->ak_len; idx += 1) {
+    x = row[idx] - avg[idx];
+    y = x / nxt;
+    z = x * y * cur;
+
+    avg[idx] += y;
+    trd[idx] += z * y * prv - AGGSTAT_3_0 * y * snd[idx];
+    snd[idx] += z;
+  }
+}
+
+/// Update the first four moments of the lanes.
+///
+/// @param[in] bnk bank of aggregates
+/// @param[in] row row of input values
+static void
+bnk_krt(struct aggstat_bnk *restrict bnk, const AGGSTAT_FLT *restrict row)
+{
+  AGGSTAT_FLT *restrict avg;
+  AGGSTAT_FLT *restrict snd;
+  AGGSTAT_FLT *restrict trd;
+  AGGSTAT_FLT *restrict fth;
+  AGGSTAT_FLT           cur;
+  AGGSTAT_FLT           nxt;
+  AGGSTAT_FLT           prv;
+  AGGSTAT_FLT           pol;
+  AGGSTAT_FLT           x;
+  AGGSTAT_FLT           y;
+  AGGSTAT_FLT           z;
+  uint32_t              idx;
+
+  avg = bnk->ak_val[0];
+  snd = bnk->ak_val[1];
+  trd = bnk->ak_val[2];
+  fth = bnk->ak_val[3];
+  cur = (AGGSTAT_FLT)bnk->ak_cnt;
+  nxt = (AGGSTAT_FLT)(bnk->ak_cnt + 1);
+  prv = (AGGSTAT_FLT)(bnk->ak_cnt - 1);
+  pol = nxt * nxt - AGGSTAT_3_0 * nxt + AGGSTAT_3_0;
+  for (idx = 0; idx < bnk->ak_len; idx += 1) {
+    x = row[idx] - avg[idx];
+    y = x / nxt;
+    z = x * y * cur;
+
+    avg[idx] += y;
+    fth[idx] += z * (y * y) * pol
+              + AGGSTAT_6_0 * (y * y) * snd[idx]
+              - AGGSTAT_4_0 * y * trd[idx];
+    trd[idx] += z * y * prv - AGGSTAT_3_0 * y * snd[idx];
+    snd[idx] += z;
+  }
+}
+
+/// Initialise the bank of aggregates.
+/// @return success/failure indication
+///
+/// The bank keeps the state of the same aggregate function for a number of lanes, e.g. the metrics
+/// of a row, in the structure-of-arrays layout: each state variable of all lanes is contiguous. The
+/// memory is provided by the caller and must hold `AGGSTAT_BNK_SIZ(len)` bytes. The quantile,
+/// median and time-weighted functions are not supported.
+///
+/// @param[in] bnk bank of aggregates
+/// @param[in] fnc function type
+/// @param[in] mem memory of the state variables
+/// @param[in] len number of lanes
+bool
+aggstat_bnk_new(struct aggstat_bnk* bnk, const uint8_t fnc, void* mem, const uint32_t len)
+{
+  AGGSTAT_FLT* val;
+  AGGSTAT_FLT  ini;
+  uint32_t     idx;
+
+  if (fnc < AGGSTAT_FNC_FST || fnc > AGGSTAT_FNC_KRT || mem == NULL) {
+    return false;
+  }
+
+  ini = fnc == AGGSTAT_FNC_MIN ? AGGSTAT_MAX
+      : fnc == AGGSTAT_FNC_MAX ? AGGSTAT_MIN
+      : AGGSTAT_0_0;
+
+  val = mem;
+  for (idx = 0; idx < 4 * len; idx += 1) {
+    val[idx] = idx < len ? ini : AGGSTAT_0_0;
+  }
+
+  bnk->ak_fnc    = fnc;
+  bnk->ak_len    = len;
+  bnk->ak_cnt    = 0;
+  bnk->ak_val[0] = val;
+  bnk->ak_val[1] = val + len;
+  bnk->ak_val[2] = val + 2 * len;
+  bnk->ak_val[3] = val + 3 * len;
+
+  return true;
+}
+
+/// Update all lanes of the bank with a row of values.
+///
+/// Each lane receives the value at its index in the row. All lanes share the number of values, and
+/// thus each state variable is updated by a single loop over contiguous memory, which the compiler
+/// vectorises. The resulting states are equal to those of `aggstat_put`.
+///
+/// @param[in] bnk bank of aggregates
+/// @param[in] row row of input values, one for each lane
+void
+aggstat_bnk_put_row(struct aggstat_bnk *restrict bnk, const AGGSTAT_FLT *restrict row)
+{
+  switch (bnk->ak_fnc) {
+    case AGGSTAT_FNC_FST: bnk_fst(bnk, row); break;
+    case AGGSTAT_FNC_LST: bnk_lst(bnk, row); break;
+    case AGGSTAT_FNC_SUM: bnk_sum(bnk, row); break;
+    case AGGSTAT_FNC_MIN: bnk_min(bnk, row); break;
+    case AGGSTAT_FNC_MAX: bnk_max(bnk, row); break;
+    case AGGSTAT_FNC_AVG: bnk_avg(bnk, row); break;
+    case AGGSTAT_FNC_VAR: bnk_var(bnk, row); break;
+    case AGGSTAT_FNC_DEV: bnk_var(bnk, row); break;
+    case AGGSTAT_FNC_SKW: bnk_skw(bnk, row); break;
+    case AGGSTAT_FNC_KRT: bnk_krt(bnk, row); break;
+    default: break;
+  }
+
+  bnk->ak_cnt += 1;
+}
+
+/// Obtain the aggregated values of all lanes.
+/// @return success/failure indication
+///
+/// @param[in]  bnk bank of aggregates
+/// @param[out] val aggregated values, one for each lane
+bool
+aggstat_bnk_get(const struct aggstat_bnk *restrict bnk, AGGSTAT_FLT *restrict val)
+{
+  struct aggstat agg;
+  uint32_t       idx;
+  bool           ret;
+
+  ret = true;
+  for (idx = 0; idx < bnk->ak_len; idx += 1) {
+    aggstat_new(&agg, bnk->ak_fnc, AGGSTAT_0_0);
+    agg.ag_cnt[0] = bnk->ak_cnt;
+    agg.ag_val[0] = bnk->ak_val[0][idx];
+    agg.ag_val[1] = bnk->ak_val[1][idx];
+    agg.ag_val[2] = bnk->ak_val[2][idx];
+    agg.ag_val[3] = bnk->ak_val[3][idx];
+
+    ret &= aggstat_get(&agg, &val[idx]);
+  }
+
+  return ret;
+}
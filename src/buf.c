@@ -0,0 +1,322 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "agg.h"
+#include "sel.h"
+
+
+// Smallest capacity of the buffer.
+#define BUF_MIN 256
+
+/// Ensure that the buffer has room for additional values.
+/// @return success/failure indication
+///
+/// The capacity grows geometrically, so that the values are copied a constant number of times on
+/// average.
+///
+/// @param[in] buf buffer of values
+/// @param[in] len number of additional values
+static bool
+buf_grw(struct aggstat_buf* buf, const size_t len)
+{
+  AGGSTAT_FLT* arr;
+  size_t       cap;
+
+  if (buf->ab_len + len <= buf->ab_cap) {
+    return true;
+  }
+
+  cap = buf->ab_cap > BUF_MIN ? buf->ab_cap : BUF_MIN;
+  while (cap < buf->ab_len + len) {
+    cap *= 2;
+  }
+
+  arr = realloc(buf->ab_arr, cap * sizeof(AGGSTAT_FLT));
+  if (arr == NULL) {
+    return false;
+  }
+
+  buf->ab_arr = arr;
+  buf->ab_cap = cap;
+  return true;
+}
+
+/// Find the partition of a value.
+/// @return index of the partition
+///
+/// @param[in] buf buffer of values
+/// @param[in] val value
+static size_t
+buf_fnd(const struct aggstat_buf* buf, const AGGSTAT_FLT val)
+{
+  size_t lop;
+  size_t hip;
+  size_t mid;
+
+  lop = 0;
+  hip = buf->ab_cnt;
+  while (lop < hip) {
+    mid = lop + (hip - lop) / 2;
+    if (buf->ab_piv[mid] < val) {
+      lop = mid + 1;
+    } else {
+      hip = mid;
+    }
+  }
+
+  return lop;
+}
+
+/// Move the values appended since the last query into their partitions.
+///
+/// A value joins its partition by moving the first value of each following partition to the end of
+/// that partition, which makes room at the end of the partition of the value. The cost is
+/// proportional to the number of boundaries, and thus the boundaries are dropped when the new
+/// values are numerous enough that partitioning the whole buffer anew is cheaper.
+///
+/// @param[in] buf buffer of values
+static void
+buf_mov(struct aggstat_buf* buf)
+{
+  AGGSTAT_FLT val;
+  size_t      idx;
+  size_t      hol;
+  size_t      prt;
+  size_t      bnd;
+
+  if ((buf->ab_len - buf->ab_prt) * buf->ab_cnt > 2 * buf->ab_prt) {
+    buf->ab_cnt = 0;
+  }
+
+  for (idx = buf->ab_prt; buf->ab_cnt > 0 && idx < buf->ab_len; idx += 1) {
+    val = buf->ab_arr[idx];
+    hol = idx;
+    prt = buf_fnd(buf, val);
+
+    for (bnd = buf->ab_cnt; bnd > prt; bnd -= 1) {
+      buf->ab_arr[hol]      = buf->ab_arr[buf->ab_bnd[bnd - 1]];
+      hol                   = buf->ab_bnd[bnd - 1];
+      buf->ab_bnd[bnd - 1] += 1;
+    }
+
+    buf->ab_arr[hol] = val;
+  }
+
+  buf->ab_prt = buf->ab_len;
+}
+
+/// Record a boundary between two partitions.
+/// @return success/failure indication
+///
+/// @param[in] buf buffer of values
+/// @param[in] pos index of the boundary
+/// @param[in] bnd position of the boundary in the buffer
+/// @param[in] piv pivot between the partitions
+static bool
+buf_add(struct aggstat_buf* buf, const size_t pos, const size_t bnd, const AGGSTAT_FLT piv)
+{
+  size_t idx;
+
+  if (buf->ab_cnt == AGGSTAT_BUF_BND) {
+    return false;
+  }
+
+  for (idx = buf->ab_cnt; idx > pos; idx -= 1) {
+    buf->ab_bnd[idx] = buf->ab_bnd[idx - 1];
+    buf->ab_piv[idx] = buf->ab_piv[idx - 1];
+  }
+
+  buf->ab_bnd[pos] = bnd;
+  buf->ab_piv[pos] = piv;
+  buf->ab_cnt     += 1;
+
+  return true;
+}
+
+/// Select the order statistic of a rank.
+/// @return order statistic
+///
+/// The selection starts from the partition that contains the rank, and records the boundaries of
+/// the partitions it creates, so that subsequent queries of nearby ranks partition only a small
+/// range of the buffer.
+///
+/// @param[in] buf buffer of values
+/// @param[in] rnk rank
+static AGGSTAT_FLT
+buf_sel(struct aggstat_buf* buf, const size_t rnk)
+{
+  AGGSTAT_FLT piv;
+  uint32_t    dep;
+  size_t      pos;
+  size_t      lop;
+  size_t      hip;
+  size_t      mid;
+
+  // Find the partition that contains the rank.
+  lop = 0;
+  hip = buf->ab_cnt;
+  while (lop < hip) {
+    mid = lop + (hip - lop) / 2;
+    if (buf->ab_bnd[mid] <= rnk) {
+      lop = mid + 1;
+    } else {
+      hip = mid;
+    }
+  }
+
+  pos = lop;
+  lop = pos > 0           ? buf->ab_bnd[pos - 1] : 0;
+  hip = pos < buf->ab_cnt ? buf->ab_bnd[pos]     : buf->ab_len;
+
+  dep = sel_dep(hip - lop);
+  while (hip - lop > SEL_INS) {
+    if (dep == 0) {
+      (void)qsort((void*)(buf->ab_arr + lop), hip - lop, sizeof(AGGSTAT_FLT), sel_cmp);
+      return buf->ab_arr[rnk];
+    }
+
+    sel_mdn(buf->ab_arr, lop, hip);
+    piv = buf->ab_arr[lop];
+    mid = sel_hoa(buf->ab_arr, lop, hip);
+
+    if (rnk <= mid) {
+      (void)buf_add(buf, pos, mid + 1, piv);
+      hip = mid + 1;
+    } else {
+      pos += buf_add(buf, pos, mid + 1, piv) == true ? 1 : 0;
+      lop  = mid + 1;
+    }
+
+    dep -= 1;
+  }
+
+  sel_ins(buf->ab_arr, lop, hip);
+  return buf->ab_arr[rnk];
+}
+
+/// Initialise the buffer of values.
+/// @return success/failure indication
+///
+/// @param[in] buf buffer of values
+/// @param[in] fnc function type
+/// @param[in] par function parameter
+bool
+aggstat_buf_new(struct aggstat_buf* buf, const uint8_t fnc, const AGGSTAT_FLT par)
+{
+  buf->ab_fnc = fnc;
+  buf->ab_par = fnc == AGGSTAT_FNC_MED ? AGGSTAT_0_5 : par;
+  buf->ab_arr = NULL;
+  buf->ab_cap = 0;
+  buf->ab_len = 0;
+  buf->ab_prt = 0;
+  buf->ab_cnt = 0;
+
+  if (fnc != AGGSTAT_FNC_QNT && fnc != AGGSTAT_FNC_MED) {
+    return false;
+  }
+
+  return buf->ab_par >= AGGSTAT_0_0 && buf->ab_par <= AGGSTAT_1_0;
+}
+
+/// Append a value to the buffer.
+/// @return success/failure indication
+///
+/// @param[in] buf buffer of values
+/// @param[in] val value
+bool
+aggstat_buf_put(struct aggstat_buf* buf, const AGGSTAT_FLT val)
+{
+  if (buf_grw(buf, 1) == false) {
+    return false;
+  }
+
+  buf->ab_arr[buf->ab_len] = val;
+  buf->ab_len += 1;
+
+  return true;
+}
+
+/// Append an array of values to the buffer.
+/// @return success/failure indication
+///
+/// @param[in] buf buffer of values
+/// @param[in] arr array of values
+/// @param[in] len length of the array
+bool
+aggstat_buf_put_arr(struct aggstat_buf *restrict buf,
+                    const AGGSTAT_FLT  *restrict arr,
+                    const AGGSTAT_INT            len)
+{
+  AGGSTAT_INT idx;
+
+  if (buf_grw(buf, (size_t)len) == false) {
+    return false;
+  }
+
+  for (idx = 0; idx < len; idx += 1) {
+    buf->ab_arr[buf->ab_len + idx] = arr[idx];
+  }
+  buf->ab_len += (size_t)len;
+
+  return true;
+}
+
+/// Obtain the exact quantile of the buffered values.
+/// @return success/failure indication
+///
+/// The result is equal to that of `aggstat_run` on the same values. The buffer retains its
+/// partitions between queries, and thus repeated queries with few new values are cheap.
+///
+/// @param[in]  buf buffer of values
+/// @param[out] val quantile
+bool
+aggstat_buf_get(struct aggstat_buf *restrict buf, AGGSTAT_FLT *restrict val)
+{
+  AGGSTAT_FLT inp;
+  AGGSTAT_FLT frp;
+  AGGSTAT_FLT fst;
+  AGGSTAT_FLT snd;
+  size_t      idx;
+
+  if (buf->ab_len == 0) {
+    return false;
+  }
+
+  buf_mov(buf);
+
+  // Select the appropriate values in the same manner as the off-line algorithm.
+  frp = AGGSTAT_MODF((AGGSTAT_FLT)(buf->ab_len - 1) * buf->ab_par, &inp);
+  idx = (size_t)inp;
+  idx = idx < buf->ab_len ? idx : buf->ab_len - 1;
+
+  fst = buf_sel(buf, idx);
+  if (idx == buf->ab_len - 1) {
+    *val = fst;
+  } else {
+    snd  = buf_sel(buf, idx + 1);
+    *val = fst + frp * (snd - fst);
+  }
+
+  return true;
+}
+
+/// Release the memory of the buffer.
+///
+/// @param[in] buf buffer of values
+void
+aggstat_buf_free(struct aggstat_buf* buf)
+{
+  free(buf->ab_arr);
+
+  buf->ab_arr = NULL;
+  buf->ab_cap = 0;
+  buf->ab_len = 0;
+  buf->ab_prt = 0;
+  buf->ab_cnt = 0;
+}
@@ -0,0 +1,248 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include <stddef.h>
+#include <math.h>
+
+#include "agg.h"
+
+
+/// Retract a value from the number of values in the stream.
+///
+/// @param[in] agg aggregate function (unused)
+/// @param[in] inp input value (unused)
+static void
+del_cnt(struct aggstat* agg, const AGGSTAT_FLT inp)
+{
+  (void)agg;
+  (void)inp;
+}
+
+/// Retract a value from the sum of values in the stream.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+static void
+del_sum(struct aggstat* agg, const AGGSTAT_FLT inp)
+{
+  agg->ag_val[0] -= inp;
+}
+
+/// Pre-compute temporary variables for the retraction of a value.
+///
+/// The variables are equal to those computed by `set_tmp` when the value was originally applied,
+/// albeit derived from the current state rather than the preceding one.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+static void
+del_tmp(struct aggstat* agg, const AGGSTAT_FLT inp)
+{
+  AGGSTAT_FLT x;
+  AGGSTAT_FLT y;
+
+  y = (inp - agg->ag_val[0]) / (AGGSTAT_FLT)(agg->ag_cnt[0] - 1);
+  x = y * (AGGSTAT_FLT)agg->ag_cnt[0];
+
+  agg->ag_val[4] = y;
+  agg->ag_val[5] = y * y;
+  agg->ag_val[6] = x * y * (AGGSTAT_FLT)(agg->ag_cnt[0] - 1);
+}
+
+/// Retract a value from the first moment.
+///
+/// @param[in] agg aggregate function
+static void
+fst_mnt(struct aggstat* agg)
+{
+  agg->ag_val[0] -= agg->ag_val[4];
+}
+
+/// Retract a value from the second moment.
+///
+/// Due to the cancellation of nearly equal terms, the result might be a small negative number
+/// instead of zero, and is therefore clamped.
+///
+/// @param[in] agg aggregate function
+static void
+snd_mnt(struct aggstat* agg)
+{
+  agg->ag_val[1] -= agg->ag_val[6];
+  agg->ag_val[1]  = agg->ag_val[1] < AGGSTAT_0_0 ? AGGSTAT_0_0 : agg->ag_val[1];
+}
+
+/// Retract a value from the third moment.
+///
+/// @param[in] agg aggregate function
+static void
+trd_mnt(struct aggstat* agg)
+{
+  agg->ag_val[2] -= agg->ag_val[6] * agg->ag_val[4] * (AGGSTAT_FLT)(agg->ag_cnt[0] - 2)
+                  - AGGSTAT_3_0    * agg->ag_val[4] * agg->ag_val[1];
+}
+
+/// Retract a value from the fourth moment.
+///
+/// @param[in] agg aggregate function
+static void
+fth_mnt(struct aggstat* agg)
+{
+  AGGSTAT_FLT x;
+
+  x = (AGGSTAT_FLT)agg->ag_cnt[0];
+  agg->ag_val[3] -= agg->ag_val[6]
+                  * agg->ag_val[5]
+                  * (x * x - AGGSTAT_3_0 * x + AGGSTAT_3_0)
+                  + AGGSTAT_6_0 * agg->ag_val[5] * agg->ag_val[1]
+                  - AGGSTAT_4_0 * agg->ag_val[4] * agg->ag_val[2];
+}
+
+/// Retract a value from the average value in the stream.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+static void
+del_avg(struct aggstat* agg, const AGGSTAT_FLT inp)
+{
+  del_tmp(agg, inp);
+  fst_mnt(agg);
+}
+
+/// Retract a value from the variance of the stream.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+static void
+del_var(struct aggstat* agg, const AGGSTAT_FLT inp)
+{
+  del_tmp(agg, inp);
+  fst_mnt(agg);
+  snd_mnt(agg);
+}
+
+/// Retract a value from the standard deviation of the stream.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+static void
+del_dev(struct aggstat* agg, const AGGSTAT_FLT inp)
+{
+  del_var(agg, inp);
+}
+
+/// Retract a value from the skewness of the stream.
+///
+/// The moments are retracted in the reverse order of their update, as each of the higher moments
+/// depends on the lower moments of the resulting state.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+static void
+del_skw(struct aggstat* agg, const AGGSTAT_FLT inp)
+{
+  del_tmp(agg, inp);
+  fst_mnt(agg);
+  snd_mnt(agg);
+  trd_mnt(agg);
+}
+
+/// Retract a value from the kurtosis of the stream.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+static void
+del_krt(struct aggstat* agg, const AGGSTAT_FLT inp)
+{
+  del_tmp(agg, inp);
+  fst_mnt(agg);
+  snd_mnt(agg);
+  trd_mnt(agg);
+  fth_mnt(agg);
+}
+
+/// Function table for del_* functions based on ag_fnc. Functions that can not be inverted, as the
+/// state does not retain enough information about the removed value, are not supported.
+static void (*del_fnc[])(struct aggstat*, const AGGSTAT_FLT) = {
+  NULL,
+  NULL,
+  NULL,
+  del_cnt,
+  del_sum,
+  NULL,
+  NULL,
+  del_avg,
+  del_var,
+  del_dev,
+  del_skw,
+  del_krt,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL
+};
+
+/// Retract a value previously applied to the aggregated value.
+/// @return success/failure indication
+///
+/// The function inverts the effect of `aggstat_put` for the count, sum, average, variance,
+/// standard deviation, skewness and kurtosis functions, and fails for all other functions or an
+/// empty stream. The retraction of the last remaining value resets the state.
+///
+/// The retraction is exact only in exact arithmetic. Each retraction accumulates rounding errors,
+/// and the subtraction of nearly equal numbers amplifies them when the remaining values are close
+/// to each other, or far from the retracted value. Retracting a value that was never applied is
+/// not detected and corrupts the state. Long-lived states with many retractions should be rebuilt
+/// from time to time.
+///
+/// @param[in] agg aggregated value
+/// @param[in] inp input value
+bool
+aggstat_del(struct aggstat* agg, const AGGSTAT_FLT inp)
+{
+  if (del_fnc[agg->ag_fnc] == NULL || agg->ag_cnt[0] == 0) {
+    return false;
+  }
+
+  if (agg->ag_cnt[0] == 1) {
+    agg->ag_val[0] = AGGSTAT_0_0;
+    agg->ag_val[1] = AGGSTAT_0_0;
+    agg->ag_val[2] = AGGSTAT_0_0;
+    agg->ag_val[3] = AGGSTAT_0_0;
+  } else {
+    del_fnc[agg->ag_fnc](agg, inp);
+  }
+
+  agg->ag_cnt[0] -= 1;
+  return true;
+}
+
+/// Retract an array of values previously applied to the aggregated value.
+/// @return success/failure indication
+///
+/// The function fails without any change to the state if the function is not supported, or if
+/// the array is longer than the stream.
+///
+/// @param[in] agg aggregated value
+/// @param[in] arr array of input values
+/// @param[in] len length of the array
+bool
+aggstat_del_arr(struct aggstat    *restrict agg,
+                const AGGSTAT_FLT *restrict arr,
+                const AGGSTAT_INT           len)
+{
+  AGGSTAT_INT idx;
+
+  if (del_fnc[agg->ag_fnc] == NULL || agg->ag_cnt[0] < len) {
+    return false;
+  }
+
+  for (idx = 0; idx < len; idx += 1) {
+    (void)aggstat_del(agg, arr[idx]);
+  }
+
+  return true;
+}
@@ -0,0 +1,384 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include <string.h>
+
+#include "agg.h"
+
+
+/// Compute the slot of a value in the index of the counters.
+/// @return slot
+///
+/// The value is hashed through its double-precision representation, as wider types contain unused
+/// bits. Negative zero is first converted to positive zero, as the two are equal.
+///
+/// @param[in] frq frequent values
+/// @param[in] val value
+static uint32_t
+frq_hsh(const struct aggstat_frq* frq, const AGGSTAT_FLT val)
+{
+  uint64_t bit;
+  double   dbl;
+
+  dbl = (double)val + 0.0;
+  (void)memcpy(&bit, &dbl, sizeof(bit));
+  bit = (bit * UINT64_C(0x9E3779B97F4A7C15)) >> 32;
+
+  return (uint32_t)((bit * frq->af_tsz) >> 32);
+}
+
+/// Find the counter of a value.
+/// @return slot of the counter in the index, or the free slot where it belongs
+///
+/// The index is an open-addressing hash table with linear probing, which holds the positions of
+/// the counters and has twice as many slots as there are counters.
+///
+/// @param[in] frq frequent values
+/// @param[in] val value
+static uint32_t
+frq_fnd(const struct aggstat_frq* frq, const AGGSTAT_FLT val)
+{
+  uint32_t slt;
+
+  slt = frq_hsh(frq, val);
+  while (frq->af_tbl[slt] != UINT32_MAX && frq->af_val[frq->af_tbl[slt]] != val) {
+    slt = slt + 1 < frq->af_tsz ? slt + 1 : 0;
+  }
+
+  return slt;
+}
+
+/// Remove a value from the index of the counters.
+///
+/// The following entries of the probe sequence are shifted backwards to fill the gap, so that no
+/// deleted markers are necessary.
+///
+/// @param[in] frq frequent values
+/// @param[in] slt slot of the value
+static void
+frq_rem(struct aggstat_frq* frq, uint32_t slt)
+{
+  uint32_t nxt;
+  uint32_t hom;
+
+  nxt = slt;
+  while (true) {
+    nxt = nxt + 1 < frq->af_tsz ? nxt + 1 : 0;
+    if (frq->af_tbl[nxt] == UINT32_MAX) {
+      break;
+    }
+
+    // Move the entry if the gap lies between its home slot and its current slot.
+    hom = frq_hsh(frq, frq->af_val[frq->af_tbl[nxt]]);
+    if ((nxt + frq->af_tsz - hom) % frq->af_tsz >= (nxt + frq->af_tsz - slt) % frq->af_tsz) {
+      frq->af_tbl[slt] = frq->af_tbl[nxt];
+      slt              = nxt;
+    }
+  }
+
+  frq->af_tbl[slt] = UINT32_MAX;
+}
+
+/// Rebuild the index of the counters.
+///
+/// @param[in] frq frequent values
+static void
+frq_idx(struct aggstat_frq* frq)
+{
+  uint32_t idx;
+
+  for (idx = 0; idx < frq->af_tsz; idx += 1) {
+    frq->af_tbl[idx] = UINT32_MAX;
+  }
+
+  for (idx = 0; idx < frq->af_len; idx += 1) {
+    frq->af_tbl[frq_fnd(frq, frq->af_val[idx])] = idx;
+  }
+}
+
+/// Find the counter with the lowest count.
+/// @return index of the counter
+///
+/// @param[in] frq frequent values
+static uint32_t
+frq_low(const struct aggstat_frq* frq)
+{
+  uint32_t idx;
+  uint32_t min;
+
+  min = 0;
+  for (idx = 1; idx < frq->af_len; idx += 1) {
+    if (frq->af_cnt[idx] < frq->af_cnt[min]) {
+      min = idx;
+    }
+  }
+
+  return min;
+}
+
+/// Find a counter with the lowest count to be replaced.
+/// @return index of the counter
+///
+/// Counts never decrease, and the lowest count is thus remembered and the search for a counter
+/// with that count resumes after the counter replaced last. Many counters tend to share the lowest
+/// count, and the search usually ends after a few steps instead of scanning all counters.
+///
+/// @param[in] frq frequent values
+static uint32_t
+frq_min(struct aggstat_frq* frq)
+{
+  uint32_t idx;
+
+  for (idx = 0; idx < frq->af_len; idx += 1) {
+    frq->af_cur = frq->af_cur + 1 < frq->af_len ? frq->af_cur + 1 : 0;
+    if (frq->af_cnt[frq->af_cur] <= frq->af_min) {
+      return frq->af_cur;
+    }
+  }
+
+  frq->af_cur = frq_low(frq);
+  frq->af_min = frq->af_cnt[frq->af_cur];
+
+  return frq->af_cur;
+}
+
+/// Add a weighted value to the counters.
+///
+/// A value without a counter takes over a free counter, or the counter with the lowest count, whose
+/// count then bounds the overestimation of the count of the value.
+///
+/// @param[in] frq frequent values
+/// @param[in] val value
+/// @param[in] wgt weight
+static void
+frq_put(struct aggstat_frq* frq, const AGGSTAT_FLT val, const uint64_t wgt)
+{
+  uint32_t slt;
+  uint32_t idx;
+
+  frq->af_tot += wgt;
+
+  slt = frq_fnd(frq, val);
+  if (frq->af_tbl[slt] != UINT32_MAX) {
+    frq->af_cnt[frq->af_tbl[slt]] += wgt;
+    return;
+  }
+
+  if (frq->af_len < frq->af_cap) {
+    idx = frq->af_len;
+    frq->af_cnt[idx] = 0;
+    frq->af_err[idx] = 0;
+    frq->af_len     += 1;
+  } else {
+    idx = frq_min(frq);
+    frq->af_err[idx] = frq->af_cnt[idx];
+
+    // The removal can shift the free slot of the value.
+    frq_rem(frq, frq_fnd(frq, frq->af_val[idx]));
+    slt = frq_fnd(frq, val);
+  }
+
+  frq->af_val[idx]  = val;
+  frq->af_cnt[idx] += wgt;
+  frq->af_tbl[slt]  = idx;
+}
+
+/// Initialise the frequent values.
+/// @return success/failure indication
+///
+/// The memory is provided by the caller and must hold `AGGSTAT_FRQ_SIZ(cap)` bytes, suitably
+/// aligned, e.g. obtained from `malloc`. The values, counts and bounds of the counters are kept in
+/// separate arrays, and a hash index of the values finds the counter of a value in constant time.
+/// The index has twice as many slots as there are counters, and thus the number of counters must
+/// not exceed `UINT32_MAX / 2`.
+///
+/// @param[in] frq frequent values
+/// @param[in] mem memory of the counters
+/// @param[in] cap number of counters
+bool
+aggstat_frq_new(struct aggstat_frq* frq, void* mem, const uint32_t cap)
+{
+  if (mem == NULL || cap == 0 || cap > UINT32_MAX / 2) {
+    return false;
+  }
+
+  frq->af_cap = cap;
+  frq->af_len = 0;
+  frq->af_tsz = 2 * cap;
+  frq->af_cur = 0;
+  frq->af_min = 0;
+  frq->af_tot = 0;
+  frq->af_val = mem;
+  frq->af_cnt = (uint64_t*)((char*)mem + ((size_t)cap * sizeof(AGGSTAT_FLT) + 7) / 8 * 8);
+  frq->af_err = frq->af_cnt + cap;
+  frq->af_tbl = (uint32_t*)(frq->af_err + cap);
+
+  frq_idx(frq);
+
+  return true;
+}
+
+/// Update the frequent values with a value.
+///
+/// Values that are not a number are ignored, as they are not equal to any value.
+///
+/// @param[in] frq frequent values
+/// @param[in] val value
+void
+aggstat_frq_put(struct aggstat_frq* frq, const AGGSTAT_FLT val)
+{
+  if (val != val) {
+    return;
+  }
+
+  frq_put(frq, val, 1);
+}
+
+/// Update the frequent values with an array of values.
+///
+/// Runs of equal values are counted first and added to the counters at once.
+///
+/// @param[in] frq frequent values
+/// @param[in] arr array of values
+/// @param[in] len length of the array
+void
+aggstat_frq_put_arr(struct aggstat_frq *restrict frq,
+                    const AGGSTAT_FLT  *restrict arr,
+                    const AGGSTAT_INT            len)
+{
+  AGGSTAT_INT idx;
+  AGGSTAT_INT run;
+
+  for (idx = 0; idx < len; idx += run) {
+    for (run = 1; idx + run < len && arr[idx + run] == arr[idx]; run += 1) {
+    }
+
+    if (arr[idx] == arr[idx]) {
+      frq_put(frq, arr[idx], (uint64_t)run);
+    }
+  }
+}
+
+/// Merge the frequent values of a succeeding stream into the frequent values of a preceding stream.
+///
+/// A value that has no counter in one of the summaries occurred at most as many times as the lowest
+/// count of that summary, if it has no free counters. This count is added to the count and the
+/// bound of the value, and the counters with the highest counts of the union are retained.
+///
+/// @param[in] dst frequent values of the preceding stream
+/// @param[in] src frequent values of the succeeding stream
+void
+aggstat_frq_mrg(struct aggstat_frq *restrict dst, const struct aggstat_frq *restrict src)
+{
+  uint64_t mnd;
+  uint64_t mns;
+  uint64_t cnt;
+  uint32_t slt;
+  uint32_t idx;
+  uint32_t jdx;
+
+  mnd = dst->af_len == dst->af_cap ? dst->af_cnt[frq_low(dst)] : 0;
+  mns = src->af_len == src->af_cap ? src->af_cnt[frq_low(src)] : 0;
+
+  // Update the counters of the preceding stream.
+  for (idx = 0; idx < dst->af_len; idx += 1) {
+    jdx = src->af_tbl[frq_fnd(src, dst->af_val[idx])];
+    if (jdx != UINT32_MAX) {
+      dst->af_cnt[idx] += src->af_cnt[jdx];
+      dst->af_err[idx] += src->af_err[jdx];
+    } else {
+      dst->af_cnt[idx] += mns;
+      dst->af_err[idx] += mns;
+    }
+  }
+
+  // Add the counters of values that occur only in the succeeding stream. A counter of both streams
+  // that was replaced meanwhile is not added again, as its count in the succeeding stream does not
+  // exceed the lowest count.
+  for (jdx = 0; jdx < src->af_len; jdx += 1) {
+    slt = frq_fnd(dst, src->af_val[jdx]);
+    if (dst->af_tbl[slt] != UINT32_MAX) {
+      continue;
+    }
+
+    cnt = src->af_cnt[jdx] + mnd;
+    if (dst->af_len < dst->af_cap) {
+      idx = dst->af_len;
+      dst->af_len += 1;
+    } else {
+      idx = frq_low(dst);
+      if (dst->af_cnt[idx] >= cnt) {
+        continue;
+      }
+
+      frq_rem(dst, frq_fnd(dst, dst->af_val[idx]));
+      slt = frq_fnd(dst, src->af_val[jdx]);
+    }
+
+    dst->af_val[idx] = src->af_val[jdx];
+    dst->af_cnt[idx] = cnt;
+    dst->af_err[idx] = src->af_err[jdx] + mnd;
+    dst->af_tbl[slt] = idx;
+  }
+
+  dst->af_min  = 0;
+  dst->af_tot += src->af_tot;
+}
+
+/// Obtain the most frequent values in the order of decreasing counts.
+/// @return number of obtained values
+///
+/// The count of each value is at least its true count, and exceeds it by at most its bound. The
+/// bound itself is at most the number of values divided by the number of counters. The counters
+/// are reordered and their index is rebuilt.
+///
+/// @param[in]  frq frequent values
+/// @param[out] val values
+/// @param[out] cnt counts
+/// @param[out] err bounds of the overestimation of the counts
+/// @param[in]  num number of values to obtain
+uint32_t
+aggstat_frq_top(struct aggstat_frq *restrict frq,
+                AGGSTAT_FLT        *restrict val,
+                uint64_t           *restrict cnt,
+                uint64_t           *restrict err,
+                const uint32_t               num)
+{
+  AGGSTAT_FLT tmv;
+  uint64_t    tmc;
+  uint64_t    tme;
+  uint32_t    idx;
+  uint32_t    jdx;
+  uint32_t    max;
+
+  for (idx = 0; idx < num && idx < frq->af_len; idx += 1) {
+    max = idx;
+    for (jdx = idx + 1; jdx < frq->af_len; jdx += 1) {
+      if (frq->af_cnt[jdx] > frq->af_cnt[max]) {
+        max = jdx;
+      }
+    }
+
+    tmv = frq->af_val[idx];
+    tmc = frq->af_cnt[idx];
+    tme = frq->af_err[idx];
+
+    frq->af_val[idx] = frq->af_val[max];
+    frq->af_cnt[idx] = frq->af_cnt[max];
+    frq->af_err[idx] = frq->af_err[max];
+
+    frq->af_val[max] = tmv;
+    frq->af_cnt[max] = tmc;
+    frq->af_err[max] = tme;
+
+    val[idx] = frq->af_val[idx];
+    cnt[idx] = frq->af_cnt[idx];
+    err[idx] = frq->af_err[idx];
+  }
+
+  frq_idx(frq);
+  return idx;
+}
@@ -0,0 +1,434 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include <string.h>
+#include <math.h>
+
+#include "agg.h"
+
+
+// Largest exponent of the weights, beyond which the landmark is moved to the current timestamp.
+// The squared weights of many values thus remain far from the overflow of all floating-point types.
+#define FWD_EXP AGGSTAT_NUM(16, 0, +, 0)
+
+/// Rescale the weights of all values, as if the landmark was moved by the exponent of the factor.
+///
+/// The mean and the heights of the markers do not depend on the scale of the weights, whereas the
+/// moments and the positions of the markers are sums of weights. A factor that underflows to zero
+/// discards all values.
+///
+/// @param[in] fwd forward-decayed aggregate
+/// @param[in] fct factor
+static void
+fwd_scl(struct aggstat_fwd* fwd, const AGGSTAT_FLT fct)
+{
+  uint8_t idx;
+
+  fwd->ad_wgt[0] *= fct;
+  fwd->ad_wgt[1] *= fct * fct;
+  if (fwd->ad_wgt[0] == AGGSTAT_0_0) {
+    fwd->ad_cnt    = 0;
+    fwd->ad_wgt[1] = AGGSTAT_0_0;
+    (void)memset(fwd->ad_val, 0, sizeof(fwd->ad_val));
+    return;
+  }
+
+  if (fwd->ad_fnc == AGGSTAT_FNC_QNT || fwd->ad_fnc == AGGSTAT_FNC_MED) {
+    for (idx = 5; idx < 10; idx += 1) {
+      fwd->ad_val[idx] *= fct;
+    }
+  } else {
+    fwd->ad_val[1] *= fct;
+    fwd->ad_val[2] *= fct;
+    fwd->ad_val[3] *= fct;
+  }
+}
+
+/// Compute the weight of a timestamp.
+/// @return weight
+///
+/// The weight grows exponentially with the distance of the timestamp from the landmark. Once the
+/// exponent exceeds its limit, the landmark is moved to the timestamp and the weights of all
+/// previous values are renormalised.
+///
+/// @param[in] fwd forward-decayed aggregate
+/// @param[in] tim timestamp
+static AGGSTAT_FLT
+fwd_wgt(struct aggstat_fwd* fwd, const AGGSTAT_FLT tim)
+{
+  AGGSTAT_FLT exn;
+
+  if (fwd->ad_cnt == 0) {
+    fwd->ad_lnd = tim;
+  }
+
+  exn = fwd->ad_rat * (tim - fwd->ad_lnd);
+  if (exn > FWD_EXP) {
+    fwd_scl(fwd, AGGSTAT_EXP(-exn));
+    fwd->ad_lnd = tim;
+    return AGGSTAT_1_0;
+  }
+
+  return AGGSTAT_EXP(exn);
+}
+
+/// Update the moments with a weighted value.
+///
+/// The value is merged into the state as a group of a single value, and only the moments required
+/// by the function are updated. The higher moments are updated first, as they depend on the lower
+/// moments before the update.
+///
+/// @param[in] fwd forward-decayed aggregate
+/// @param[in] inp input value
+/// @param[in] wgt weight
+static void
+fwd_mnt(struct aggstat_fwd* fwd, const AGGSTAT_FLT inp, const AGGSTAT_FLT wgt)
+{
+  AGGSTAT_FLT old;
+  AGGSTAT_FLT tot;
+  AGGSTAT_FLT dlt;
+  AGGSTAT_FLT rel;
+  AGGSTAT_FLT scd;
+
+  old = fwd->ad_wgt[0];
+  tot = old + wgt;
+  dlt = inp - fwd->ad_val[0];
+  rel = dlt / tot;
+  scd = dlt * rel * old * wgt;
+
+  if (fwd->ad_fnc == AGGSTAT_FNC_KRT) {
+    fwd->ad_val[3] += scd * rel * rel * (old * old - old * wgt + wgt * wgt)
+                    + AGGSTAT_6_0 * rel * rel * wgt * wgt * fwd->ad_val[1]
+                    - AGGSTAT_4_0 * rel * wgt * fwd->ad_val[2];
+  }
+
+  if (fwd->ad_fnc == AGGSTAT_FNC_SKW || fwd->ad_fnc == AGGSTAT_FNC_KRT) {
+    fwd->ad_val[2] += scd * rel * (old - wgt)
+                    - AGGSTAT_3_0 * rel * wgt * fwd->ad_val[1];
+  }
+
+  fwd->ad_val[1] += scd;
+  fwd->ad_val[0] += rel * wgt;
+}
+
+/// Order the first five heights along with their weights.
+///
+/// @param[in] val heights followed by weights
+/// @param[in] len number of heights
+static void
+fwd_srt(AGGSTAT_FLT* val, const uint8_t len)
+{
+  AGGSTAT_FLT hgt;
+  AGGSTAT_FLT wgt;
+  uint8_t     idx;
+  uint8_t     pos;
+
+  for (idx = 1; idx < len; idx += 1) {
+    hgt = val[idx];
+    wgt = val[idx + 5];
+    for (pos = idx; pos > 0 && val[pos - 1] > hgt; pos -= 1) {
+      val[pos]     = val[pos - 1];
+      val[pos + 5] = val[pos + 4];
+    }
+
+    val[pos]     = hgt;
+    val[pos + 5] = wgt;
+  }
+}
+
+/// Estimate the height of a marker after its movement.
+/// @return estimated height
+///
+/// The estimate is that of the unweighted quantile, with the positions being sums of weights.
+///
+/// @param[in] fwd forward-decayed aggregate
+/// @param[in] idx index of the marker
+/// @param[in] dir signed weight to move by
+/// @param[in] lft distance to the left neighbour
+/// @param[in] rgt distance to the right neighbour
+static AGGSTAT_FLT
+fwd_est(const struct aggstat_fwd* fwd,
+        const uint8_t             idx,
+        const AGGSTAT_FLT         dir,
+        const AGGSTAT_FLT         lft,
+        const AGGSTAT_FLT         rgt)
+{
+  AGGSTAT_FLT hgt;
+  AGGSTAT_FLT est;
+
+  hgt = fwd->ad_val[idx];
+
+  // Piecewise parabolic estimation.
+  est = hgt + dir
+      * ((lft + dir) * (fwd->ad_val[idx + 1] - hgt) * lft
+       + (rgt - dir) * (hgt - fwd->ad_val[idx - 1]) * rgt)
+      / ((lft + rgt) * lft * rgt);
+
+  if (fwd->ad_val[idx - 1] < est && est < fwd->ad_val[idx + 1]) {
+    return est;
+  }
+
+  // Linear estimation towards the neighbour in the direction of the movement.
+  if (dir > AGGSTAT_0_0) {
+    return hgt + dir * (fwd->ad_val[idx + 1] - hgt) / rgt;
+  } else {
+    return hgt + dir * (hgt - fwd->ad_val[idx - 1]) / lft;
+  }
+}
+
+/// Move a marker towards its desired position by the weight of the current value.
+///
+/// The weight of the current value takes the role of a single position of the unweighted quantile,
+/// and thus a marker is moved only if it lags behind its desired position by at least that weight.
+///
+/// @param[in] fwd forward-decayed aggregate
+/// @param[in] idx index of the marker
+/// @param[in] des desired position
+/// @param[in] wgt weight of the current value
+static void
+fwd_adj(struct aggstat_fwd* fwd, const uint8_t idx, const AGGSTAT_FLT des, const AGGSTAT_FLT wgt)
+{
+  AGGSTAT_FLT dlt;
+  AGGSTAT_FLT lft;
+  AGGSTAT_FLT rgt;
+  bool        inc;
+  bool        dec;
+
+  lft = fwd->ad_val[idx + 5] - fwd->ad_val[idx + 4];
+  rgt = fwd->ad_val[idx + 6] - fwd->ad_val[idx + 5];
+  dlt = des - fwd->ad_val[idx + 5];
+  inc = (dlt >=  wgt) & (rgt > wgt);
+  dec = (dlt <= -wgt) & (lft > wgt);
+  if ((inc | dec) == false) {
+    return;
+  }
+
+  fwd->ad_val[idx]     = fwd_est(fwd, idx, inc ? wgt : -wgt, lft, rgt);
+  fwd->ad_val[idx + 5] = inc ? fwd->ad_val[idx + 5] + wgt : fwd->ad_val[idx + 5] - wgt;
+}
+
+/// Update the decayed p-quantile with a weighted value.
+///
+/// The state consists of the heights of five markers followed by their positions, which are the
+/// sums of weights of the values up to each height. The first five values are stored along with
+/// their weights, and afterwards the markers are moved as in the unweighted quantile, with their
+/// desired positions computed from the sum of all weights.
+///
+/// @param[in] fwd forward-decayed aggregate
+/// @param[in] inp input value
+/// @param[in] wgt weight
+static void
+fwd_qnt(struct aggstat_fwd* fwd, const AGGSTAT_FLT inp, const AGGSTAT_FLT wgt)
+{
+  AGGSTAT_FLT bse;
+  AGGSTAT_FLT spn;
+  uint8_t     idx;
+
+  // Store the first five values along with their weights.
+  if (fwd->ad_cnt < 5) {
+    fwd->ad_val[fwd->ad_cnt]     = inp;
+    fwd->ad_val[fwd->ad_cnt + 5] = wgt;
+    if (fwd->ad_cnt < 4) {
+      return;
+    }
+
+    // Sort the values and turn their weights into positions.
+    fwd_srt(fwd->ad_val, 5);
+    for (idx = 6; idx < 10; idx += 1) {
+      fwd->ad_val[idx] += fwd->ad_val[idx - 1];
+    }
+
+    return;
+  }
+
+  // Increment the positions of all markers above the value.
+  fwd->ad_val[6] += inp < fwd->ad_val[1] ? wgt : AGGSTAT_0_0;
+  fwd->ad_val[7] += inp < fwd->ad_val[2] ? wgt : AGGSTAT_0_0;
+  fwd->ad_val[8] += inp < fwd->ad_val[3] ? wgt : AGGSTAT_0_0;
+  fwd->ad_val[9] += wgt;
+
+  // Adjust minimum and maximum.
+  fwd->ad_val[0] = inp < fwd->ad_val[0] ? inp : fwd->ad_val[0];
+  fwd->ad_val[4] = inp > fwd->ad_val[4] ? inp : fwd->ad_val[4];
+
+  // Adjust the middle markers towards their desired positions.
+  bse = fwd->ad_val[5];
+  spn = fwd->ad_val[9] - bse;
+  fwd_adj(fwd, 1, bse + spn * fwd->ad_par / AGGSTAT_2_0, wgt);
+  fwd_adj(fwd, 2, bse + spn * fwd->ad_par, wgt);
+  fwd_adj(fwd, 3, bse + spn * (AGGSTAT_1_0 + fwd->ad_par) / AGGSTAT_2_0, wgt);
+}
+
+/// Obtain the decayed p-quantile of fewer than five values.
+/// @return success/failure indication
+///
+/// The stored values are sorted, and the quantile is the least value whose cumulative weight
+/// reaches the given share of the sum of weights.
+///
+/// @param[in]  fwd forward-decayed aggregate
+/// @param[out] out p-quantile of values
+static bool
+fwd_few(const struct aggstat_fwd *restrict fwd, AGGSTAT_FLT *restrict out)
+{
+  AGGSTAT_FLT val[10];
+  AGGSTAT_FLT sum;
+  uint8_t     idx;
+
+  if (fwd->ad_cnt == 0) {
+    return false;
+  }
+
+  (void)memcpy(val, fwd->ad_val, sizeof(val));
+  fwd_srt(val, (uint8_t)fwd->ad_cnt);
+
+  sum = AGGSTAT_0_0;
+  for (idx = 0; (AGGSTAT_INT)idx + 1 < fwd->ad_cnt; idx += 1) {
+    sum += val[idx + 5];
+    if (sum >= fwd->ad_par * fwd->ad_wgt[0]) {
+      break;
+    }
+  }
+
+  *out = val[idx];
+  return true;
+}
+
+/// Initialise the forward-decayed aggregate.
+/// @return success/failure indication
+///
+/// The weight of a value is the exponential of the decay rate multiplied by the distance of its
+/// timestamp from the landmark, which is initially the first timestamp. A rate of zero disables
+/// the decay. Only the count, sum, moment and quantile functions are supported.
+///
+/// @param[out] fwd forward-decayed aggregate
+/// @param[in]  fnc function type
+/// @param[in]  par function argument
+/// @param[in]  rat decay rate per unit of time
+bool
+aggstat_fwd_new(struct aggstat_fwd* fwd,
+                const uint8_t       fnc,
+                const AGGSTAT_FLT   par,
+                const AGGSTAT_FLT   rat)
+{
+  if (fnc != AGGSTAT_FNC_CNT && (fnc < AGGSTAT_FNC_SUM || fnc > AGGSTAT_FNC_MED)) {
+    return false;
+  }
+
+  if (fnc == AGGSTAT_FNC_MIN || fnc == AGGSTAT_FNC_MAX || (rat >= AGGSTAT_0_0) == false) {
+    return false;
+  }
+
+  (void)memset(fwd, 0, sizeof(*fwd));
+  fwd->ad_fnc = fnc;
+  fwd->ad_par = fnc == AGGSTAT_FNC_MED ? AGGSTAT_0_5 : par;
+  fwd->ad_rat = rat;
+
+  return true;
+}
+
+/// Update the forward-decayed aggregate with a timestamped value.
+///
+/// The weights of later timestamps are larger, and the relative weight of each value thus decays
+/// exponentially as time progresses. The update takes constant time.
+///
+/// @param[in] fwd forward-decayed aggregate
+/// @param[in] tim timestamp
+/// @param[in] inp input value
+void
+aggstat_fwd_put(struct aggstat_fwd* fwd, const AGGSTAT_FLT tim, const AGGSTAT_FLT inp)
+{
+  AGGSTAT_FLT wgt;
+
+  wgt = fwd_wgt(fwd, tim);
+  if (fwd->ad_fnc == AGGSTAT_FNC_QNT || fwd->ad_fnc == AGGSTAT_FNC_MED) {
+    fwd->ad_wgt[0] += wgt;
+    fwd_qnt(fwd, inp, wgt);
+  } else {
+    fwd_mnt(fwd, inp, wgt);
+    fwd->ad_wgt[0] += wgt;
+  }
+
+  fwd->ad_wgt[1] += wgt * wgt;
+  fwd->ad_cnt    += 1;
+}
+
+/// Update the forward-decayed aggregate with columns of timestamps and values.
+///
+/// @param[in] fwd forward-decayed aggregate
+/// @param[in] tim timestamps
+/// @param[in] arr input values
+/// @param[in] len number of values
+void
+aggstat_fwd_put_arr(struct aggstat_fwd *restrict fwd,
+                    const AGGSTAT_FLT  *restrict tim,
+                    const AGGSTAT_FLT  *restrict arr,
+                    const AGGSTAT_INT            len)
+{
+  AGGSTAT_INT idx;
+
+  for (idx = 0; idx < len; idx += 1) {
+    aggstat_fwd_put(fwd, tim[idx], arr[idx]);
+  }
+}
+
+/// Obtain the forward-decayed aggregate.
+/// @return success/failure indication
+///
+/// The count and sum are decayed to the given timestamp of the query, whereas the mean, moments
+/// and quantiles are ratios of weights, which do not depend on it. The variance is corrected by
+/// the effective number of values that follows from the sum of squared weights, and is thus equal
+/// to that of `aggstat_get` without decay.
+///
+/// @param[in]  fwd forward-decayed aggregate
+/// @param[in]  tim timestamp of the query
+/// @param[out] val aggregate value
+bool
+aggstat_fwd_get(const struct aggstat_fwd *restrict fwd,
+                const AGGSTAT_FLT                  tim,
+                      AGGSTAT_FLT        *restrict val)
+{
+  AGGSTAT_FLT wgt;
+  AGGSTAT_FLT eff;
+
+  wgt = fwd->ad_wgt[0];
+  switch (fwd->ad_fnc) {
+    case AGGSTAT_FNC_CNT:
+      *val = fwd->ad_cnt > 0 ? wgt * AGGSTAT_EXP(fwd->ad_rat * (fwd->ad_lnd - tim)) : wgt;
+      return true;
+
+    case AGGSTAT_FNC_SUM:
+      *val = fwd->ad_cnt > 0 ? wgt * AGGSTAT_EXP(fwd->ad_rat * (fwd->ad_lnd - tim)) : wgt;
+      *val = *val * fwd->ad_val[0];
+      return true;
+
+    case AGGSTAT_FNC_AVG:
+      *val = fwd->ad_val[0];
+      return fwd->ad_cnt > 0;
+
+    case AGGSTAT_FNC_VAR:
+    case AGGSTAT_FNC_DEV:
+      eff  = wgt - fwd->ad_wgt[1] / wgt;
+      *val = fwd->ad_val[1] / eff;
+      *val = fwd->ad_fnc == AGGSTAT_FNC_DEV ? AGGSTAT_SQRT(*val) : *val;
+      return fwd->ad_cnt > 1;
+
+    case AGGSTAT_FNC_SKW:
+      *val = AGGSTAT_SQRT(wgt) * fwd->ad_val[2] / AGGSTAT_POW(fwd->ad_val[1], AGGSTAT_1_5);
+      return fwd->ad_cnt > 1;
+
+    case AGGSTAT_FNC_KRT:
+      *val = wgt * fwd->ad_val[3] / (fwd->ad_val[1] * fwd->ad_val[1]) - AGGSTAT_3_0;
+      return fwd->ad_cnt > 1;
+
+    default:
+      if (fwd->ad_cnt < 5) {
+        return fwd_few(fwd, val);
+      }
+
+      *val = fwd->ad_val[2];
+      return true;
+  }
+}
@@ -178,6 +178,58 @@ get_med(const struct aggstat *restrict agg, AGGSTAT_FLT *restrict out)
   return get_qtl(agg, out);
 }
 
+/// Obtain the time integral of the values in the stream.
+/// @return success/failure indication
+///
+/// @param[in]  agg aggregate function
+/// @param[out] out time integral of values
+static bool
+get_itg(const struct aggstat *restrict agg, AGGSTAT_FLT *restrict out)
+{
+  *out = agg->ag_val[3];
+  return true;
+}
+
+/// Obtain the time-weighted average of the values in the stream.
+/// @return success/failure indication
+///
+/// The last value has no duration, unless it is the only timestamp in the stream, in which case
+/// the average is equal to the last value.
+///
+/// @param[in]  agg aggregate function
+/// @param[out] out time-weighted average of values
+static bool
+get_twa(const struct aggstat *restrict agg, AGGSTAT_FLT *restrict out)
+{
+  AGGSTAT_FLT dur;
+
+  dur = agg->ag_val[1] - agg->ag_val[0];
+  if (dur > AGGSTAT_0_0) {
+    *out = agg->ag_val[3] / dur;
+  } else {
+    *out = agg->ag_val[2];
+  }
+
+  return agg->ag_cnt[0] > 0;
+}
+
+/// Obtain the rate of change of the values in the stream per unit of time.
+/// @return success/failure indication
+///
+/// @param[in]  agg aggregate function
+/// @param[out] out rate of change of values
+static bool
+get_rat(const struct aggstat *restrict agg, AGGSTAT_FLT *restrict out)
+{
+  AGGSTAT_FLT dur;
+
+  // Similarly to the variance, the potential division by zero is well-defined, and the function
+  // returns `false` in such case.
+  dur  = agg->ag_val[1] - agg->ag_val[0];
+  *out = (agg->ag_val[2] - agg->ag_val[4]) / dur;
+  return dur > AGGSTAT_0_0;
+}
+
 /// Function table for get_* functions based on ag_fnc.
 static bool (*get_fnc[])(const struct aggstat*, AGGSTAT_FLT*) = {
   NULL,
@@ -193,7 +245,10 @@ static bool (*get_fnc[])(const struct aggstat*, AGGSTAT_FLT*) = {
   get_skw,
   get_krt,
   get_qtl,
-  get_med
+  get_med,
+  get_twa,
+  get_itg,
+  get_rat
 };
 
 /// Obtain the aggregated value.
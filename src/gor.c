@@ -0,0 +1,571 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include <string.h>
+
+#include "agg.h"
+
+
+// Largest number of bits of an encoded value: the code of the timestamp with its 64-bit
+// difference, and the code of the value with its window header and 64 meaningful bits.
+#define GOR_MAX (4 + 64 + 2 + 11 + 64)
+
+// Number of values decoded at once, which fits into the first-level cache.
+#define GOR_BAT 512
+
+// Leading zero bits of the window before the first window is established.
+#define GOR_NON 64
+
+// Width of the difference of timestamp differences, selected by the number of leading ones of its
+// code from 0 to 4: 0, 7, 9, 12 and 64 bits. The widths are packed into a constant, so that the
+// decoder does not load them.
+#define GOR_WID(T) ((uint8_t)(UINT64_C(0x400c090700) >> ((T) * 8)))
+
+/// State of the decoder of a block.
+struct gor_dcd {
+  const uint64_t* gd_blk;    ///< Words of the block, or of the copy of its end.
+  size_t          gd_pos;    ///< Position of the next bit.
+  size_t          gd_end;    ///< Number of bits of the block.
+  uint64_t        gd_rem;    ///< Number of values that remain to be decoded.
+  uint64_t        gd_tim;    ///< Previous timestamp.
+  uint64_t        gd_dlt;    ///< Previous difference of timestamps.
+  uint64_t        gd_val;    ///< Binary representation of the previous value.
+  uint8_t         gd_lzc;    ///< Leading zero bits of the window of meaningful bits.
+  uint8_t         gd_tzc;    ///< Trailing zero bits of the window of meaningful bits.
+  bool            gd_fst;    ///< The next value is the first one of the block.
+  bool            gd_err;    ///< The block is malformed.
+  uint64_t        gd_tal[8]; ///< Copy of the end of the block, followed by zero words.
+};
+
+/// Count the leading zero bits of a non-zero word.
+/// @return number of bits
+///
+/// @param[in] wrd word
+static inline uint8_t
+gor_lzc(const uint64_t wrd)
+{
+#if defined(__GNUC__)
+  return (uint8_t)__builtin_clzll(wrd);
+#else
+  uint8_t cnt;
+
+  for (cnt = 0; (wrd << cnt) >> 63 == 0; cnt += 1) {
+  }
+
+  return cnt;
+#endif
+}
+
+/// Count the trailing zero bits of a non-zero word.
+/// @return number of bits
+///
+/// @param[in] wrd word
+static inline uint8_t
+gor_tzc(const uint64_t wrd)
+{
+#if defined(__GNUC__)
+  return (uint8_t)__builtin_ctzll(wrd);
+#else
+  uint8_t cnt;
+
+  for (cnt = 0; ((wrd >> cnt) & 1) == 0; cnt += 1) {
+  }
+
+  return cnt;
+#endif
+}
+
+/// Compute the mask of the lowest bits of a word.
+/// @return mask
+///
+/// @param[in] len number of bits
+static inline uint64_t
+gor_msk(const uint8_t len)
+{
+  return len == 64 ? UINT64_MAX : ((uint64_t)1 << len) - 1;
+}
+
+/// Append bits to the block.
+///
+/// The bits are stored from the most significant bit of each word. A word is cleared when the
+/// first bit is stored into it, so that the memory of the block does not have to be cleared.
+///
+/// @param[in] gor encoder
+/// @param[in] bit bits aligned to the least significant bit
+/// @param[in] len number of bits (1 to 64)
+static void
+gor_wrt(struct aggstat_gor* gor, const uint64_t bit, const uint8_t len)
+{
+  size_t  wrd;
+  uint8_t fre;
+
+  wrd = gor->ax_pos / 64;
+  fre = (uint8_t)(64 - gor->ax_pos % 64);
+  if (fre == 64) {
+    gor->ax_blk[wrd] = 0;
+  }
+
+  if (len <= fre) {
+    gor->ax_blk[wrd] |= (bit & gor_msk(len)) << (fre - len);
+  } else {
+    gor->ax_blk[wrd]     |= (bit & gor_msk(len)) >> (len - fre);
+    gor->ax_blk[wrd + 1]  = bit << (64 - (len - fre));
+  }
+
+  gor->ax_pos += len;
+}
+
+/// Read the next 64 bits of the block.
+/// @return bits aligned to the most significant bit
+///
+/// The word that follows the word of the position is read even if none of its bits are needed,
+/// and must therefore exist.
+///
+/// @param[in] blk words of the block
+/// @param[in] pos position of the first bit
+static inline uint64_t
+gor_pek(const uint64_t* blk, const size_t pos)
+{
+  uint8_t off;
+
+  off = (uint8_t)(pos % 64);
+  return (blk[pos / 64] << off) | ((blk[pos / 64 + 1] >> 1) >> (63 - off));
+}
+
+/// Initialise the decoder of a block.
+/// @return success/failure indication
+///
+/// @param[in] dcd decoder
+/// @param[in] blk block
+/// @param[in] siz size of the block in bytes
+static bool
+gor_ini(struct gor_dcd *restrict dcd, const uint64_t *restrict blk, const size_t siz)
+{
+  if (blk == NULL || siz < sizeof(uint64_t)) {
+    return false;
+  }
+
+  dcd->gd_blk = blk;
+  dcd->gd_pos = 64;
+  dcd->gd_end = siz / sizeof(uint64_t) * 64;
+  dcd->gd_rem = blk[0];
+  dcd->gd_tim = 0;
+  dcd->gd_dlt = 0;
+  dcd->gd_val = 0;
+  dcd->gd_lzc = GOR_NON;
+  dcd->gd_tzc = 0;
+  dcd->gd_fst = true;
+  dcd->gd_err = false;
+
+  return true;
+}
+
+/// Continue the decoding from a copy of the end of the block, followed by zero words.
+///
+/// The decoder reads whole words ahead of its position without bounds checks, which is safe as
+/// long as at least one value of the largest size and another word remain. The last values are
+/// decoded from the copy instead, where any read beyond the end of the block yields zero bits.
+///
+/// @param[in] dcd decoder
+static void
+gor_tal(struct gor_dcd* dcd)
+{
+  size_t wrd;
+  size_t idx;
+
+  wrd = dcd->gd_pos / 64;
+  for (idx = 0; idx < 8; idx += 1) {
+    dcd->gd_tal[idx] = wrd + idx < dcd->gd_end / 64 ? dcd->gd_blk[wrd + idx] : 0;
+  }
+
+  dcd->gd_blk  = dcd->gd_tal;
+  dcd->gd_pos -= wrd * 64;
+  dcd->gd_end -= wrd * 64;
+}
+
+/// Decode the next batch of values of a block.
+/// @return number of decoded values
+///
+/// The decoder is marked as failed if the block is malformed, and the batch must be discarded.
+///
+/// @param[in]  dcd decoder
+/// @param[out] tim timestamps
+/// @param[out] arr values
+static size_t
+gor_dec(struct gor_dcd *restrict dcd, AGGSTAT_FLT *restrict tim, AGGSTAT_FLT *restrict arr)
+{
+  const uint64_t* blk;
+  uint64_t        pek;
+  uint64_t        dif;
+  uint64_t        cur;
+  uint64_t        dlt;
+  uint64_t        val;
+  size_t          pos;
+  size_t          num;
+  size_t          idx;
+  double          dbl;
+  uint8_t         lzc;
+  uint8_t         tzc;
+  uint8_t         tag;
+  uint8_t         len;
+  uint8_t         use;
+  uint8_t         avl;
+
+  num = dcd->gd_rem < GOR_BAT ? (size_t)dcd->gd_rem : GOR_BAT;
+  idx = 0;
+  while (idx < num) {
+    if (dcd->gd_blk != dcd->gd_tal && dcd->gd_end - dcd->gd_pos < GOR_MAX + 64) {
+      gor_tal(dcd);
+    }
+
+    blk = dcd->gd_blk;
+    pos = dcd->gd_pos;
+    cur = dcd->gd_tim;
+    dlt = dcd->gd_dlt;
+    val = dcd->gd_val;
+    lzc = dcd->gd_lzc;
+    tzc = dcd->gd_tzc;
+    pek = 0;
+    avl = 0;
+
+    // Decode the values while the whole words ahead are readable.
+    for (; idx < num && (blk == dcd->gd_tal || dcd->gd_end - pos >= GOR_MAX + 64); idx += 1) {
+      if (dcd->gd_fst == true) {
+        cur          = gor_pek(blk, pos);
+        val          = gor_pek(blk, pos + 64);
+        pos         += 128;
+        dcd->gd_fst  = false;
+      } else {
+        // The codes of the timestamp and of the value take at most 29 bits, unless the timestamp
+        // takes the widest code, and are decoded from the bits ahead of the position, which are
+        // read again only once fewer bits remain.
+        if (avl < 29) {
+          pek = gor_pek(blk, pos);
+          avl = 64;
+        }
+
+        // The timestamp is coded by the difference of consecutive differences, whose width is
+        // given by the number of leading ones of the code.
+        tag = gor_lzc(~pek | ((uint64_t)1 << 59));
+        len = GOR_WID(tag);
+        if (tag == 4) {
+          dlt += gor_pek(blk, pos + 4);
+          pos += 68;
+          pek  = gor_pek(blk, pos);
+          avl  = 64;
+        } else {
+          if (tag > 0) {
+            dif  = (pek << (tag + 1)) >> (64 - len);
+            dlt += (dif ^ ((uint64_t)1 << (len - 1))) - ((uint64_t)1 << (len - 1));
+          }
+
+          use  = (uint8_t)(tag + 1 + len);
+          pek <<= use;
+          avl  -= use;
+          pos  += use;
+        }
+
+        cur += dlt;
+
+        // The value is coded by its exclusive-or with the previous value, whose meaningful bits
+        // either fit into the previous window, or are preceded by a new window.
+        if ((pek >> 63) == 0) {
+          use = 1;
+        } else if ((pek >> 62) == 3) {
+          len = (uint8_t)((pek >> 51) & 63);
+          len = len == 0 ? 64 : len;
+          lzc = (uint8_t)((pek >> 57) & 31);
+          tzc = (uint8_t)(64 - len - lzc);
+          use = 13;
+          if (lzc + len > 64) {
+            dcd->gd_err = true;
+            break;
+          }
+        } else if (lzc == GOR_NON) {
+          dcd->gd_err = true;
+          break;
+        } else {
+          use = 2;
+        }
+
+        pek <<= use;
+        avl  -= use;
+        pos  += use;
+
+        if (use > 1) {
+          len  = (uint8_t)(64 - lzc - tzc);
+          val ^= (gor_pek(blk, pos) >> (64 - len)) << tzc;
+          pos += len;
+          pek  = len < avl ? pek << len : 0;
+          avl  = len < avl ? (uint8_t)(avl - len) : 0;
+        }
+      }
+
+      if (pos > dcd->gd_end) {
+        dcd->gd_err = true;
+        break;
+      }
+
+      (void)memcpy(&dbl, &val, sizeof(dbl));
+      tim[idx] = (AGGSTAT_FLT)cur;
+      arr[idx] = (AGGSTAT_FLT)dbl;
+    }
+
+    dcd->gd_pos = pos;
+    dcd->gd_tim = cur;
+    dcd->gd_dlt = dlt;
+    dcd->gd_val = val;
+    dcd->gd_lzc = lzc;
+    dcd->gd_tzc = tzc;
+
+    if (dcd->gd_err == true) {
+      return 0;
+    }
+  }
+
+  dcd->gd_rem -= num;
+  return num;
+}
+
+/// Initialise the encoder of a block of timestamped values.
+/// @return success/failure indication
+///
+/// The block is stored in the memory provided by the caller, which must be aligned to eight bytes
+/// and hold at least `AGGSTAT_GOR_SIZ(1)` bytes. A block of `AGGSTAT_GOR_SIZ(len)` bytes holds at
+/// least `len` values.
+///
+/// @param[in] gor encoder
+/// @param[in] mem memory of the block
+/// @param[in] siz size of the memory in bytes
+bool
+aggstat_gor_new(struct aggstat_gor* gor, void* mem, const size_t siz)
+{
+  if (mem == NULL || siz < AGGSTAT_GOR_SIZ(1)) {
+    return false;
+  }
+
+  gor->ax_blk    = mem;
+  gor->ax_cap    = siz / sizeof(uint64_t) * 64;
+  gor->ax_pos    = 64;
+  gor->ax_tim    = 0;
+  gor->ax_dlt    = 0;
+  gor->ax_val    = 0;
+  gor->ax_lzc    = GOR_NON;
+  gor->ax_tzc    = 0;
+  gor->ax_blk[0] = 0;
+
+  return true;
+}
+
+/// Append a timestamped value to the block.
+/// @return success/failure indication
+///
+/// The first value is stored as is. Each further timestamp is stored as the difference between
+/// its difference from the previous timestamp and the previous difference, which is zero for
+/// regular intervals and takes a single bit. Each further value is stored as its exclusive-or
+/// with the previous value, which is zero for repeated values, and otherwise only its meaningful
+/// bits between the leading and trailing zero bits are stored. The values are stored in double
+/// precision. The function fails if the block can not hold another value of the largest size.
+///
+/// @param[in] gor encoder
+/// @param[in] tim timestamp
+/// @param[in] val value
+bool
+aggstat_gor_put(struct aggstat_gor* gor, const uint64_t tim, const AGGSTAT_FLT val)
+{
+  uint64_t bit;
+  uint64_t dlt;
+  uint64_t dod;
+  uint64_t dif;
+  double   dbl;
+  uint8_t  tag;
+  uint8_t  lzc;
+  uint8_t  tzc;
+  uint8_t  len;
+
+  if (gor->ax_pos + GOR_MAX > gor->ax_cap) {
+    return false;
+  }
+
+  dbl = (double)val;
+  (void)memcpy(&bit, &dbl, sizeof(bit));
+
+  if (gor->ax_blk[0] == 0) {
+    gor_wrt(gor, tim, 64);
+    gor_wrt(gor, bit, 64);
+  } else {
+    // Select the narrowest width that holds the signed difference of differences.
+    dlt = tim - gor->ax_tim;
+    dod = dlt - gor->ax_dlt;
+    for (tag = 0; tag < 4; tag += 1) {
+      len = GOR_WID(tag);
+      if (len == 0 ? dod == 0 : dod + ((uint64_t)1 << (len - 1)) <= gor_msk(len)) {
+        break;
+      }
+    }
+
+    gor_wrt(gor, tag < 4 ? gor_msk(tag) << 1 : gor_msk(4), tag < 4 ? tag + 1 : 4);
+    if (tag > 0) {
+      gor_wrt(gor, dod, GOR_WID(tag));
+    }
+
+    // Store the meaningful bits in the previous window if they fit, and otherwise establish a new
+    // window, whose number of leading zero bits is limited to five bits.
+    dif = bit ^ gor->ax_val;
+    if (dif == 0) {
+      gor_wrt(gor, 0, 1);
+    } else {
+      lzc = gor_lzc(dif);
+      lzc = lzc < 31 ? lzc : 31;
+      tzc = gor_tzc(dif);
+      if (gor->ax_lzc != GOR_NON && lzc >= gor->ax_lzc && tzc >= gor->ax_tzc) {
+        gor_wrt(gor, 2, 2);
+      } else {
+        len = (uint8_t)(64 - lzc - tzc);
+        gor_wrt(gor, ((uint64_t)3 << 11) | ((uint64_t)lzc << 6) | (len & 63), 13);
+        gor->ax_lzc = lzc;
+        gor->ax_tzc = tzc;
+      }
+
+      gor_wrt(gor, dif >> gor->ax_tzc, (uint8_t)(64 - gor->ax_lzc - gor->ax_tzc));
+    }
+
+    gor->ax_dlt = dlt;
+  }
+
+  gor->ax_tim     = tim;
+  gor->ax_val     = bit;
+  gor->ax_blk[0] += 1;
+
+  return true;
+}
+
+/// Obtain the size of the block.
+/// @return size in bytes
+///
+/// The block consists of the number of its values in the first word, followed by the encoded
+/// values. The bits beyond the size are not part of the block and do not need to be stored.
+///
+/// @param[in] gor encoder
+size_t
+aggstat_gor_siz(const struct aggstat_gor* gor)
+{
+  return (gor->ax_pos + 63) / 64 * sizeof(uint64_t);
+}
+
+/// Decode a block into arrays of timestamps and values.
+/// @return success/failure indication
+///
+/// The arrays must hold the number of values of the block, which is its first word.
+///
+/// @param[out] tim timestamps (optional)
+/// @param[out] arr values
+/// @param[in]  blk block
+/// @param[in]  siz size of the block in bytes
+bool
+aggstat_gor_dec(      AGGSTAT_FLT *restrict tim,
+                      AGGSTAT_FLT *restrict arr,
+                const uint64_t    *restrict blk,
+                const size_t                siz)
+{
+  struct gor_dcd dcd;
+  AGGSTAT_FLT    dum[GOR_BAT];
+  size_t         len;
+
+  if (gor_ini(&dcd, blk, siz) == false) {
+    return false;
+  }
+
+  while (dcd.gd_rem > 0) {
+    len = gor_dec(&dcd, tim != NULL ? tim : dum, arr);
+    if (dcd.gd_err == true) {
+      return false;
+    }
+
+    tim  = tim != NULL ? tim + len : NULL;
+    arr += len;
+  }
+
+  return true;
+}
+
+/// Decode a block and apply its timestamped values to all aggregates.
+/// @return success/failure indication
+///
+/// The values are decoded in batches that remain in the cache, and each batch updates the
+/// aggregates by `aggstat_put_t_arr`, so that the block is never decoded into memory as a whole.
+/// Consecutive blocks of a series continue the streams of the aggregates. A malformed block fails,
+/// and the aggregates might have been updated by some of its values.
+///
+/// @param[in] agg array of aggregated values
+/// @param[in] cnt number of aggregated values
+/// @param[in] blk block
+/// @param[in] siz size of the block in bytes
+bool
+aggstat_gor_agg(struct aggstat *restrict agg,
+                const size_t             cnt,
+                const uint64_t *restrict blk,
+                const size_t             siz)
+{
+  struct gor_dcd dcd;
+  AGGSTAT_FLT    tim[GOR_BAT];
+  AGGSTAT_FLT    arr[GOR_BAT];
+  size_t         len;
+  size_t         idx;
+
+  if (gor_ini(&dcd, blk, siz) == false) {
+    return false;
+  }
+
+  while (dcd.gd_rem > 0) {
+    len = gor_dec(&dcd, tim, arr);
+    if (dcd.gd_err == true) {
+      return false;
+    }
+
+    for (idx = 0; idx < cnt; idx += 1) {
+      aggstat_put_t_arr(&agg[idx], tim, arr, (AGGSTAT_INT)len);
+    }
+  }
+
+  return true;
+}
+
+/// Decode a block and pass its values to an out-of-core aggregate function.
+/// @return success/failure indication
+///
+/// The blocks of a series are passed in their order in each pass of the out-of-core aggregate
+/// function. The quantile and median are thus exact, as computed by `aggstat_run` over the decoded
+/// series, without the series being decoded into memory. The timestamps are ignored.
+///
+/// @param[in] ooc out-of-core aggregate function
+/// @param[in] blk block
+/// @param[in] siz size of the block in bytes
+bool
+aggstat_gor_ooc(struct aggstat_ooc *restrict ooc,
+                const uint64_t     *restrict blk,
+                const size_t                 siz)
+{
+  struct gor_dcd dcd;
+  AGGSTAT_FLT    tim[GOR_BAT];
+  AGGSTAT_FLT    arr[GOR_BAT];
+  size_t         len;
+
+  if (gor_ini(&dcd, blk, siz) == false) {
+    return false;
+  }
+
+  while (dcd.gd_rem > 0) {
+    len = gor_dec(&dcd, tim, arr);
+    if (dcd.gd_err == true) {
+      return false;
+    }
+
+    aggstat_ooc_put(ooc, arr, (AGGSTAT_INT)len);
+  }
+
+  return true;
+}
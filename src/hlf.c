@@ -0,0 +1,221 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "agg.h"
+
+
+// Number of values converted at once, which fits into the first-level cache.
+#define HLF_BLK 256
+
+/// Convert a half-precision value to single precision.
+/// @return converted value
+///
+/// The exponent and mantissa are shifted into place and the exponent bias is corrected by a
+/// multiplication, which also normalises subnormal values. Infinities and NaNs receive the largest
+/// exponent, and NaNs are quiet so that the minimum and maximum ignore them. The conversion is
+/// exact and without branches.
+///
+/// @param[in] inp half-precision value
+static float
+hlf_f16(const uint16_t inp)
+{
+  uint32_t bit;
+  uint32_t sgn;
+  uint32_t mag;
+  float    flt;
+
+  sgn = (uint32_t)(inp & 0x8000) << 16;
+  mag = (uint32_t)(inp & 0x7fff);
+
+  bit = mag << 13;
+  (void)memcpy(&flt, &bit, sizeof(flt));
+  flt *= 0x1p112f;
+  (void)memcpy(&bit, &flt, sizeof(bit));
+
+  bit |= mag >= 0x7c00 ? UINT32_C(0x7f800000) : 0;
+  bit |= mag >  0x7c00 ? UINT32_C(0x00400000) : 0;
+  bit |= sgn;
+  (void)memcpy(&flt, &bit, sizeof(flt));
+
+  return flt;
+}
+
+/// Convert a bfloat16 value to single precision.
+/// @return converted value
+///
+/// The format is the upper half of the single-precision format, and NaNs are quiet as above.
+///
+/// @param[in] inp bfloat16 value
+static float
+hlf_b16(const uint16_t inp)
+{
+  uint32_t bit;
+  float    flt;
+
+  bit  = (uint32_t)inp << 16;
+  bit |= (inp & 0x7fff) > 0x7f80 ? UINT32_C(0x00400000) : 0;
+  (void)memcpy(&flt, &bit, sizeof(flt));
+
+  return flt;
+}
+
+/// Update the state with an array of half-precision values.
+///
+/// The values are converted in blocks that remain in the cache, and each block updates the state
+/// as a whole. The conversion loop is subject to vectorization.
+///
+/// @param[in] agg aggregate function
+/// @param[in] arr input values
+/// @param[in] len number of values
+void
+aggstat_put_f16_arr(struct aggstat *restrict agg,
+                    const uint16_t *restrict arr,
+                    const AGGSTAT_INT        len)
+{
+  AGGSTAT_FLT blk[HLF_BLK];
+  AGGSTAT_INT pos;
+  AGGSTAT_INT rem;
+  AGGSTAT_INT idx;
+
+  for (pos = 0; pos < len; pos += rem) {
+    rem = len - pos < HLF_BLK ? len - pos : HLF_BLK;
+    for (idx = 0; idx < rem; idx += 1) {
+      blk[idx] = (AGGSTAT_FLT)hlf_f16(arr[pos + idx]);
+    }
+
+    aggstat_put_arr(agg, blk, rem);
+  }
+}
+
+/// Update the state with an array of bfloat16 values.
+///
+/// @param[in] agg aggregate function
+/// @param[in] arr input values
+/// @param[in] len number of values
+void
+aggstat_put_b16_arr(struct aggstat *restrict agg,
+                    const uint16_t *restrict arr,
+                    const AGGSTAT_INT        len)
+{
+  AGGSTAT_FLT blk[HLF_BLK];
+  AGGSTAT_INT pos;
+  AGGSTAT_INT rem;
+  AGGSTAT_INT idx;
+
+  for (pos = 0; pos < len; pos += rem) {
+    rem = len - pos < HLF_BLK ? len - pos : HLF_BLK;
+    for (idx = 0; idx < rem; idx += 1) {
+      blk[idx] = (AGGSTAT_FLT)hlf_b16(arr[pos + idx]);
+    }
+
+    aggstat_put_arr(agg, blk, rem);
+  }
+}
+
+/// Compute the p-quantile or the median of an array of half-precision or bfloat16 values.
+/// @return success/failure indication
+///
+/// The quantile requires the values to be reordered, and as the array can not be reordered in its
+/// original type, the values are converted into a temporary buffer. These are the only functions
+/// of the half-precision values that allocate memory.
+///
+/// @param[out] val p-quantile or median of the values
+/// @param[in]  arr array of values
+/// @param[in]  len length of the array
+/// @param[in]  fnc aggregate function
+/// @param[in]  par parameter
+/// @param[in]  b16 values are bfloat16
+static bool
+hlf_qnt(      AGGSTAT_FLT *restrict val,
+        const uint16_t    *restrict arr,
+        const AGGSTAT_INT           len,
+        const uint8_t               fnc,
+        const AGGSTAT_FLT           par,
+        const bool                  b16)
+{
+  AGGSTAT_FLT* buf;
+  AGGSTAT_INT  idx;
+  bool         ret;
+
+  if (len == 0) {
+    return false;
+  }
+
+  buf = malloc((size_t)len * sizeof(AGGSTAT_FLT));
+  if (buf == NULL) {
+    return false;
+  }
+
+  for (idx = 0; idx < len; idx += 1) {
+    buf[idx] = (AGGSTAT_FLT)(b16 == true ? hlf_b16(arr[idx]) : hlf_f16(arr[idx]));
+  }
+
+  ret = aggstat_run(val, buf, len, fnc, par);
+  free(buf);
+
+  return ret;
+}
+
+/// Compute an aggregate of an array of half-precision values.
+/// @return success/failure indication
+///
+/// The aggregate is computed by the streaming algorithm, except for the quantile and median
+/// functions, which are computed exactly by `aggstat_run` from a temporary buffer of the converted
+/// values. The array is not modified.
+///
+/// @param[out] val aggregate of the stream
+/// @param[in]  arr array representing the stream
+/// @param[in]  len length of the stream
+/// @param[in]  fnc aggregate function
+/// @param[in]  par parameter
+bool
+aggstat_run_f16(      AGGSTAT_FLT *restrict val,
+                const uint16_t    *restrict arr,
+                const AGGSTAT_INT           len,
+                const uint8_t               fnc,
+                const AGGSTAT_FLT           par)
+{
+  struct aggstat agg;
+
+  if (fnc == AGGSTAT_FNC_QNT || fnc == AGGSTAT_FNC_MED) {
+    return hlf_qnt(val, arr, len, fnc, par, false);
+  }
+
+  aggstat_new(&agg, fnc, par);
+  aggstat_put_f16_arr(&agg, arr, len);
+  return aggstat_get(&agg, val);
+}
+
+/// Compute an aggregate of an array of bfloat16 values.
+/// @return success/failure indication
+///
+/// The aggregate is computed as by `aggstat_run_f16`.
+///
+/// @param[out] val aggregate of the stream
+/// @param[in]  arr array representing the stream
+/// @param[in]  len length of the stream
+/// @param[in]  fnc aggregate function
+/// @param[in]  par parameter
+bool
+aggstat_run_b16(      AGGSTAT_FLT *restrict val,
+                const uint16_t    *restrict arr,
+                const AGGSTAT_INT           len,
+                const uint8_t               fnc,
+                const AGGSTAT_FLT           par)
+{
+  struct aggstat agg;
+
+  if (fnc == AGGSTAT_FNC_QNT || fnc == AGGSTAT_FNC_MED) {
+    return hlf_qnt(val, arr, len, fnc, par, true);
+  }
+
+  aggstat_new(&agg, fnc, par);
+  aggstat_put_b16_arr(&agg, arr, len);
+  return aggstat_get(&agg, val);
+}
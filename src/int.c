@@ -0,0 +1,737 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include <stddef.h>
+#include <math.h>
+
+#include "agg.h"
+
+
+// Sign bit of a 64-bit integer.
+#define INT_SGN ((uint64_t)1 << 63)
+
+// Number of values that are converted to floating-point at once by the batch algorithms.
+#define INT_BLK 256
+
+// Number of values that can be summed in two 64-bit halves without an overflow.
+#define INT_SUM ((uint64_t)1 << 31)
+
+// Floating-point value of 2^64.
+#define INT_TWO ((AGGSTAT_FLT)UINT64_MAX + AGGSTAT_1_0)
+
+/// Interpret a raw 64-bit word as a two's complement signed integer.
+/// @return signed integer
+///
+/// @param[in] raw raw word
+static int64_t
+int_sig(const uint64_t raw)
+{
+  if (raw & INT_SGN) {
+    return -(int64_t)(~raw) - 1;
+  }
+
+  return (int64_t)raw;
+}
+
+/// Convert a raw 64-bit word to floating-point.
+/// @return floating-point value
+///
+/// @param[in] sgn signedness
+/// @param[in] raw raw word
+static AGGSTAT_FLT
+int_flt(const uint8_t sgn, const uint64_t raw)
+{
+  if (sgn == 1) {
+    return (AGGSTAT_FLT)int_sig(raw);
+  }
+
+  return (AGGSTAT_FLT)raw;
+}
+
+/// Add a 128-bit integer to the sum of values.
+///
+/// @param[in] agg aggregate function
+/// @param[in] low low word
+/// @param[in] hig high word
+static void
+int_add(struct aggstat_int* agg, const uint64_t low, const uint64_t hig)
+{
+  agg->ai_sum[0] += low;
+  agg->ai_sum[1] += hig + (agg->ai_sum[0] < low);
+}
+
+/// Convert the 128-bit sum of values to floating-point.
+/// @return floating-point value
+///
+/// @param[in] agg aggregate function
+static AGGSTAT_FLT
+int_wid(const struct aggstat_int* agg)
+{
+  AGGSTAT_FLT val;
+  uint64_t    low;
+  uint64_t    hig;
+  bool        neg;
+
+  low = agg->ai_sum[0];
+  hig = agg->ai_sum[1];
+  neg = (hig & INT_SGN) != 0;
+
+  // Convert the magnitude of the sum, so that the rounding is symmetric for both signs.
+  if (neg == true) {
+    low = ~low + 1;
+    hig = ~hig + (low == 0);
+  }
+
+  val = (AGGSTAT_FLT)hig * INT_TWO + (AGGSTAT_FLT)low;
+  return neg ? -val : val;
+}
+
+/// Obtain the exact integer result of the aggregate function as a 128-bit integer.
+/// @return success/failure indication
+///
+/// @param[in]  agg aggregate function
+/// @param[out] low low word
+/// @param[out] hig high word
+static bool
+int_res(const struct aggstat_int *restrict agg, uint64_t *restrict low, uint64_t *restrict hig)
+{
+  uint64_t raw;
+
+  if (agg->ai_fnc == AGGSTAT_FNC_CNT) {
+    *low = (uint64_t)agg->ai_cnt;
+    *hig = 0;
+    return true;
+  }
+
+  if (agg->ai_fnc == AGGSTAT_FNC_SUM) {
+    *low = agg->ai_sum[0];
+    *hig = agg->ai_sum[1];
+    return true;
+  }
+
+  if (agg->ai_fnc == AGGSTAT_FNC_MIN || agg->ai_fnc == AGGSTAT_FNC_MAX) {
+    raw  = agg->ai_ext[agg->ai_fnc == AGGSTAT_FNC_MAX] ^ ((uint64_t)agg->ai_sgn << 63);
+    *low = raw;
+    *hig = (uint64_t)0 - (agg->ai_sgn & (raw >> 63));
+    return agg->ai_cnt > 0;
+  }
+
+  return false;
+}
+
+/// Update the number of values in the stream.
+///
+/// @param[in] agg aggregate function (unused)
+/// @param[in] inp input value (unused)
+static void
+put_cnt(struct aggstat_int* agg, const uint64_t inp)
+{
+  (void)agg;
+  (void)inp;
+}
+
+/// Update the sum of values in the stream.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+static void
+put_sum(struct aggstat_int* agg, const uint64_t inp)
+{
+  // The high word of a negative value is all ones.
+  int_add(agg, inp, (uint64_t)0 - (agg->ai_sgn & (inp >> 63)));
+}
+
+/// Update the minimal value in the stream.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+static void
+put_min(struct aggstat_int* agg, const uint64_t inp)
+{
+  uint64_t key;
+
+  key = inp ^ ((uint64_t)agg->ai_sgn << 63);
+  agg->ai_ext[0] = key < agg->ai_ext[0] ? key : agg->ai_ext[0];
+}
+
+/// Update the maximal value in the stream.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+static void
+put_max(struct aggstat_int* agg, const uint64_t inp)
+{
+  uint64_t key;
+
+  key = inp ^ ((uint64_t)agg->ai_sgn << 63);
+  agg->ai_ext[1] = key > agg->ai_ext[1] ? key : agg->ai_ext[1];
+}
+
+/// Update the average value in the stream.
+///
+/// Note: The average is computed from the exact sum of values only when requested.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+static void
+put_avg(struct aggstat_int* agg, const uint64_t inp)
+{
+  put_sum(agg, inp);
+}
+
+/// Update the variance of the stream.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+static void
+put_var(struct aggstat_int* agg, const uint64_t inp)
+{
+  AGGSTAT_FLT x;
+  AGGSTAT_FLT y;
+
+  x = int_flt(agg->ai_sgn, inp) - agg->ai_val[0];
+  y = x / (AGGSTAT_FLT)(agg->ai_cnt + 1);
+
+  agg->ai_val[0] += y;
+  agg->ai_val[1] += x * y * (AGGSTAT_FLT)agg->ai_cnt;
+}
+
+/// Update the standard deviation of the stream.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+static void
+put_dev(struct aggstat_int* agg, const uint64_t inp)
+{
+  put_var(agg, inp);
+}
+
+/// Update the number of values in the stream with an array of values.
+///
+/// @param[in] agg aggregate function (unused)
+/// @param[in] arr input values (unused)
+/// @param[in] len number of values (unused)
+static void
+arr_cnt(struct aggstat_int *restrict agg, const uint64_t *restrict arr, const AGGSTAT_INT len)
+{
+  (void)agg;
+  (void)arr;
+  (void)len;
+}
+
+/// Update the sum of values in the stream with an array of values.
+///
+/// Each value is split into its low and high 32-bit halves, which are summed separately in 64-bit
+/// accumulators, and the number of negative values is counted to correct the high word. The loop
+/// thus consists only of independent 64-bit additions, which are subject to vectorization.
+///
+/// @param[in] agg aggregate function
+/// @param[in] arr input values
+/// @param[in] len number of values
+static void
+arr_sum(struct aggstat_int *restrict agg, const uint64_t *restrict arr, const AGGSTAT_INT len)
+{
+  AGGSTAT_INT idx;
+  AGGSTAT_INT end;
+  uint64_t    low;
+  uint64_t    hig;
+  uint64_t    neg;
+
+  for (idx = 0; idx < len; idx = end) {
+    end = (uint64_t)(len - idx) > INT_SUM ? idx + (AGGSTAT_INT)INT_SUM : len;
+
+    low = 0;
+    hig = 0;
+    neg = 0;
+    for (; idx < end; idx += 1) {
+      low += arr[idx] & UINT32_MAX;
+      hig += arr[idx] >> 32;
+      neg += arr[idx] >> 63;
+    }
+
+    int_add(agg, low, 0);
+    int_add(agg, hig << 32, hig >> 32);
+    int_add(agg, 0, (uint64_t)0 - neg * agg->ai_sgn);
+  }
+}
+
+/// Update the minimal value in the stream with an array of values.
+///
+/// @param[in] agg aggregate function
+/// @param[in] arr input values
+/// @param[in] len number of values
+static void
+arr_min(struct aggstat_int *restrict agg, const uint64_t *restrict arr, const AGGSTAT_INT len)
+{
+  AGGSTAT_INT idx;
+  uint64_t    msk;
+  uint64_t    key;
+  uint64_t    min;
+
+  msk = (uint64_t)agg->ai_sgn << 63;
+  min = agg->ai_ext[0];
+  for (idx = 0; idx < len; idx += 1) {
+    key = arr[idx] ^ msk;
+    min = key < min ? key : min;
+  }
+
+  agg->ai_ext[0] = min;
+}
+
+/// Update the maximal value in the stream with an array of values.
+///
+/// @param[in] agg aggregate function
+/// @param[in] arr input values
+/// @param[in] len number of values
+static void
+arr_max(struct aggstat_int *restrict agg, const uint64_t *restrict arr, const AGGSTAT_INT len)
+{
+  AGGSTAT_INT idx;
+  uint64_t    msk;
+  uint64_t    key;
+  uint64_t    max;
+
+  msk = (uint64_t)agg->ai_sgn << 63;
+  max = agg->ai_ext[1];
+  for (idx = 0; idx < len; idx += 1) {
+    key = arr[idx] ^ msk;
+    max = key > max ? key : max;
+  }
+
+  agg->ai_ext[1] = max;
+}
+
+/// Update the average value in the stream with an array of values.
+///
+/// @param[in] agg aggregate function
+/// @param[in] arr input values
+/// @param[in] len number of values
+static void
+arr_avg(struct aggstat_int *restrict agg, const uint64_t *restrict arr, const AGGSTAT_INT len)
+{
+  arr_sum(agg, arr, len);
+}
+
+/// Update the variance of the stream with an array of values.
+///
+/// The values are processed in blocks: the mean and the sum of squared differences of each block
+/// are computed by a two-pass algorithm with four independent accumulators, and the block is then
+/// merged into the running state.
+///
+/// @param[in] agg aggregate function
+/// @param[in] arr input values
+/// @param[in] len number of values
+static void
+arr_var(struct aggstat_int *restrict agg, const uint64_t *restrict arr, const AGGSTAT_INT len)
+{
+  AGGSTAT_FLT buf[INT_BLK];
+  AGGSTAT_FLT acc[4];
+  AGGSTAT_FLT cnt;
+  AGGSTAT_FLT num;
+  AGGSTAT_FLT avg;
+  AGGSTAT_FLT dlt;
+  AGGSTAT_FLT sqr;
+  AGGSTAT_INT idx;
+  size_t      blk;
+  size_t      pos;
+
+  cnt = (AGGSTAT_FLT)agg->ai_cnt;
+  for (idx = 0; idx < len; idx += (AGGSTAT_INT)blk) {
+    blk = (uint64_t)(len - idx) > INT_BLK ? INT_BLK : (size_t)(len - idx);
+    for (pos = 0; pos < blk; pos += 1) {
+      buf[pos] = int_flt(agg->ai_sgn, arr[idx + pos]);
+    }
+
+    // Compute the mean of the block.
+    acc[0] = AGGSTAT_0_0;
+    acc[1] = AGGSTAT_0_0;
+    acc[2] = AGGSTAT_0_0;
+    acc[3] = AGGSTAT_0_0;
+    for (pos = 0; pos + 4 <= blk; pos += 4) {
+      acc[0] += buf[pos + 0];
+      acc[1] += buf[pos + 1];
+      acc[2] += buf[pos + 2];
+      acc[3] += buf[pos + 3];
+    }
+    for (; pos < blk; pos += 1) {
+      acc[0] += buf[pos];
+    }
+
+    num = (AGGSTAT_FLT)blk;
+    avg = (acc[0] + acc[1] + acc[2] + acc[3]) / num;
+
+    // Compute the sum of squared differences of the block.
+    acc[0] = AGGSTAT_0_0;
+    acc[1] = AGGSTAT_0_0;
+    acc[2] = AGGSTAT_0_0;
+    acc[3] = AGGSTAT_0_0;
+    for (pos = 0; pos + 4 <= blk; pos += 4) {
+      acc[0] += (buf[pos + 0] - avg) * (buf[pos + 0] - avg);
+      acc[1] += (buf[pos + 1] - avg) * (buf[pos + 1] - avg);
+      acc[2] += (buf[pos + 2] - avg) * (buf[pos + 2] - avg);
+      acc[3] += (buf[pos + 3] - avg) * (buf[pos + 3] - avg);
+    }
+    for (; pos < blk; pos += 1) {
+      acc[0] += (buf[pos] - avg) * (buf[pos] - avg);
+    }
+
+    sqr = acc[0] + acc[1] + acc[2] + acc[3];
+
+    // Merge the block into the running state.
+    dlt = avg - agg->ai_val[0];
+    agg->ai_val[0] += dlt * num / (cnt + num);
+    agg->ai_val[1] += sqr + dlt * dlt * cnt * num / (cnt + num);
+    cnt += num;
+  }
+}
+
+/// Update the standard deviation of the stream with an array of values.
+///
+/// @param[in] agg aggregate function
+/// @param[in] arr input values
+/// @param[in] len number of values
+static void
+arr_dev(struct aggstat_int *restrict agg, const uint64_t *restrict arr, const AGGSTAT_INT len)
+{
+  arr_var(agg, arr, len);
+}
+
+/// Obtain the number of values in the stream.
+/// @return always true
+///
+/// @param[in]  agg aggregate function
+/// @param[out] out number of values
+static bool
+get_cnt(const struct aggstat_int *restrict agg, AGGSTAT_FLT *restrict out)
+{
+  *out = (AGGSTAT_FLT)agg->ai_cnt;
+  return true;
+}
+
+/// Obtain a sum of all values in the stream.
+/// @return always true
+///
+/// @param[in]  agg aggregate function
+/// @param[out] out sum of values
+static bool
+get_sum(const struct aggstat_int *restrict agg, AGGSTAT_FLT *restrict out)
+{
+  *out = int_wid(agg);
+  return true;
+}
+
+/// Obtain the minimal value in the stream.
+/// @return success/failure indication
+///
+/// @param[in]  agg aggregate function
+/// @param[out] out minimal value
+static bool
+get_min(const struct aggstat_int *restrict agg, AGGSTAT_FLT *restrict out)
+{
+  *out = int_flt(agg->ai_sgn, agg->ai_ext[0] ^ ((uint64_t)agg->ai_sgn << 63));
+  return agg->ai_cnt > 0;
+}
+
+/// Obtain the maximal value in the stream.
+/// @return success/failure indication
+///
+/// @param[in]  agg aggregate function
+/// @param[out] out maximal value
+static bool
+get_max(const struct aggstat_int *restrict agg, AGGSTAT_FLT *restrict out)
+{
+  *out = int_flt(agg->ai_sgn, agg->ai_ext[1] ^ ((uint64_t)agg->ai_sgn << 63));
+  return agg->ai_cnt > 0;
+}
+
+/// Obtain the average value in the stream.
+/// @return success/failure indication
+///
+/// @param[in]  agg aggregate function
+/// @param[out] out average value
+static bool
+get_avg(const struct aggstat_int *restrict agg, AGGSTAT_FLT *restrict out)
+{
+  *out = int_wid(agg) / (AGGSTAT_FLT)agg->ai_cnt;
+  return agg->ai_cnt > 0;
+}
+
+/// Obtain the variance of the values in the stream.
+/// @return success/failure indication
+///
+/// @param[in]  agg aggregate function
+/// @param[out] out variance of values
+static bool
+get_var(const struct aggstat_int *restrict agg, AGGSTAT_FLT *restrict out)
+{
+  // The potential division by zero yields an infinity, but the function returns `false` in that
+  // case, meaning that the resulting value shall not be consulted.
+  *out = agg->ai_val[1] / (AGGSTAT_FLT)(agg->ai_cnt - 1);
+  return agg->ai_cnt > 1;
+}
+
+/// Obtain the standard deviation of the values in the stream.
+/// @return success/failure indication
+///
+/// @param[in]  agg aggregate function
+/// @param[out] out standard deviation of values
+static bool
+get_dev(const struct aggstat_int *restrict agg, AGGSTAT_FLT *restrict out)
+{
+  bool ret;
+
+  ret = get_var(agg, out);
+  *out = AGGSTAT_SQRT(*out);
+  return ret;
+}
+
+/// Function table for put_* functions based on ai_fnc.
+static void (*put_fnc[])(struct aggstat_int*, const uint64_t) = {
+  NULL,
+  NULL,
+  NULL,
+  put_cnt,
+  put_sum,
+  put_min,
+  put_max,
+  put_avg,
+  put_var,
+  put_dev,
+  NULL,
+  NULL,
+  NULL,
+  NULL
+};
+
+/// Function table for arr_* functions based on ai_fnc.
+static void (*arr_fnc[])(struct aggstat_int*, const uint64_t*, const AGGSTAT_INT) = {
+  NULL,
+  NULL,
+  NULL,
+  arr_cnt,
+  arr_sum,
+  arr_min,
+  arr_max,
+  arr_avg,
+  arr_var,
+  arr_dev,
+  NULL,
+  NULL,
+  NULL,
+  NULL
+};
+
+/// Function table for get_* functions based on ai_fnc.
+static bool (*get_fnc[])(const struct aggstat_int*, AGGSTAT_FLT*) = {
+  NULL,
+  NULL,
+  NULL,
+  get_cnt,
+  get_sum,
+  get_min,
+  get_max,
+  get_avg,
+  get_var,
+  get_dev,
+  NULL,
+  NULL,
+  NULL,
+  NULL
+};
+
+/// Initialise the aggregate function of integer values.
+/// @return success/failure indication
+///
+/// Only the count, sum, minimum, maximum, average, variance and standard deviation functions are
+/// supported. The signedness selects whether the values passed to the aggregate function are to
+/// be interpreted as `int64_t` or `uint64_t`.
+///
+/// @param[in] agg aggregate function
+/// @param[in] fnc function type
+/// @param[in] sgn signedness of values
+bool
+aggstat_new_int(struct aggstat_int* agg, const uint8_t fnc, const bool sgn)
+{
+  // Select aggregate function.
+  agg->ai_fnc    = fnc;
+  agg->ai_sgn    = sgn ? 1 : 0;
+
+  // Reset all state variables.
+  agg->ai_cnt    = 0;
+  agg->ai_sum[0] = 0;
+  agg->ai_sum[1] = 0;
+  agg->ai_ext[0] = UINT64_MAX;
+  agg->ai_ext[1] = 0;
+  agg->ai_val[0] = AGGSTAT_0_0;
+  agg->ai_val[1] = AGGSTAT_0_0;
+
+  return fnc < sizeof(put_fnc) / sizeof(put_fnc[0]) && put_fnc[fnc] != NULL;
+}
+
+/// Update the aggregated value with a signed integer.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+void
+aggstat_put_i64(struct aggstat_int* agg, const int64_t inp)
+{
+  put_fnc[agg->ai_fnc](agg, (uint64_t)inp);
+  agg->ai_cnt += 1;
+}
+
+/// Update the aggregated value with an unsigned integer.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+void
+aggstat_put_u64(struct aggstat_int* agg, const uint64_t inp)
+{
+  put_fnc[agg->ai_fnc](agg, inp);
+  agg->ai_cnt += 1;
+}
+
+/// Update the aggregated value with an array of signed integers.
+///
+/// @param[in] agg aggregate function
+/// @param[in] arr input values
+/// @param[in] len number of values
+void
+aggstat_put_i64_arr(struct aggstat_int *restrict agg,
+                    const int64_t      *restrict arr,
+                    const AGGSTAT_INT            len)
+{
+  // Signed and unsigned variants of the same type are permitted to alias each other.
+  arr_fnc[agg->ai_fnc](agg, (const uint64_t*)arr, len);
+  agg->ai_cnt += len;
+}
+
+/// Update the aggregated value with an array of unsigned integers.
+///
+/// @param[in] agg aggregate function
+/// @param[in] arr input values
+/// @param[in] len number of values
+void
+aggstat_put_u64_arr(struct aggstat_int *restrict agg,
+                    const uint64_t     *restrict arr,
+                    const AGGSTAT_INT            len)
+{
+  arr_fnc[agg->ai_fnc](agg, arr, len);
+  agg->ai_cnt += len;
+}
+
+/// Obtain the aggregated value.
+/// @return success/failure indication
+///
+/// @param[in]  agg aggregate function
+/// @param[out] out aggregate value
+bool
+aggstat_get_int(const struct aggstat_int *restrict agg, AGGSTAT_FLT *restrict out)
+{
+  return get_fnc[agg->ai_fnc](agg, out);
+}
+
+/// Obtain the exact aggregated value as a signed integer.
+/// @return success/failure indication
+///
+/// The function fails for aggregate functions other than count, sum, minimum and maximum, and in
+/// case the exact value is not representable by the `int64_t` type.
+///
+/// @param[in]  agg aggregate function
+/// @param[out] out aggregate value
+bool
+aggstat_get_i64(const struct aggstat_int *restrict agg, int64_t *restrict out)
+{
+  uint64_t low;
+  uint64_t hig;
+  bool     ret;
+
+  ret = int_res(agg, &low, &hig);
+  if (ret == false) {
+    return false;
+  }
+
+  // Ensure that the high word is a mere sign extension of the low word.
+  if (hig != (uint64_t)0 - (low >> 63)) {
+    return false;
+  }
+
+  *out = int_sig(low);
+  return true;
+}
+
+/// Obtain the exact aggregated value as an unsigned integer.
+/// @return success/failure indication
+///
+/// The function fails for aggregate functions other than count, sum, minimum and maximum, and in
+/// case the exact value is not representable by the `uint64_t` type.
+///
+/// @param[in]  agg aggregate function
+/// @param[out] out aggregate value
+bool
+aggstat_get_u64(const struct aggstat_int *restrict agg, uint64_t *restrict out)
+{
+  uint64_t low;
+  uint64_t hig;
+  bool     ret;
+
+  ret = int_res(agg, &low, &hig);
+  if (ret == false || hig != 0) {
+    return false;
+  }
+
+  *out = low;
+  return true;
+}
+
+/// Compute an aggregate of an array of signed integers.
+/// @return success/failure indication
+///
+/// @param[out] val aggregate of the stream
+/// @param[in]  arr array representing the stream
+/// @param[in]  len length of the stream
+/// @param[in]  fnc aggregate function
+bool
+aggstat_run_i64(      AGGSTAT_FLT *restrict val,
+                const int64_t     *restrict arr,
+                const AGGSTAT_INT           len,
+                const uint8_t               fnc)
+{
+  struct aggstat_int agg;
+  bool               ret;
+
+  ret = aggstat_new_int(&agg, fnc, true);
+  if (ret == false) {
+    return false;
+  }
+
+  aggstat_put_i64_arr(&agg, arr, len);
+  return aggstat_get_int(&agg, val);
+}
+
+/// Compute an aggregate of an array of unsigned integers.
+/// @return success/failure indication
+///
+/// @param[out] val aggregate of the stream
+/// @param[in]  arr array representing the stream
+/// @param[in]  len length of the stream
+/// @param[in]  fnc aggregate function
+bool
+aggstat_run_u64(      AGGSTAT_FLT *restrict val,
+                const uint64_t    *restrict arr,
+                const AGGSTAT_INT           len,
+                const uint8_t               fnc)
+{
+  struct aggstat_int agg;
+  bool               ret;
+
+  ret = aggstat_new_int(&agg, fnc, false);
+  if (ret == false) {
+    return false;
+  }
+
+  aggstat_put_u64_arr(&agg, arr, len);
+  return aggstat_get_int(&agg, val);
+}
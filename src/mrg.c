@@ -0,0 +1,245 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include <stddef.h>
+#include <math.h>
+
+#include "agg.h"
+
+
+/// Merge the first value of two streams.
+///
+/// @param[in] dst aggregate function of the preceding stream
+/// @param[in] src aggregate function of the succeeding stream
+static void
+mrg_fst(struct aggstat *restrict dst, const struct aggstat *restrict src)
+{
+  if (dst->ag_cnt[0] == 0) {
+    dst->ag_val[0] = src->ag_val[0];
+  }
+}
+
+/// Merge the last value of two streams.
+///
+/// @param[in] dst aggregate function of the preceding stream
+/// @param[in] src aggregate function of the succeeding stream
+static void
+mrg_lst(struct aggstat *restrict dst, const struct aggstat *restrict src)
+{
+  if (src->ag_cnt[0] > 0) {
+    dst->ag_val[0] = src->ag_val[0];
+  }
+}
+
+/// Merge the number of values of two streams.
+///
+/// @param[in] dst aggregate function of the preceding stream (unused)
+/// @param[in] src aggregate function of the succeeding stream (unused)
+static void
+mrg_cnt(struct aggstat *restrict dst, const struct aggstat *restrict src)
+{
+  (void)dst;
+  (void)src;
+}
+
+/// Merge the sum of values of two streams.
+///
+/// @param[in] dst aggregate function of the preceding stream
+/// @param[in] src aggregate function of the succeeding stream
+static void
+mrg_sum(struct aggstat *restrict dst, const struct aggstat *restrict src)
+{
+  dst->ag_val[0] += src->ag_val[0];
+}
+
+/// Merge the minimal value of two streams.
+///
+/// @param[in] dst aggregate function of the preceding stream
+/// @param[in] src aggregate function of the succeeding stream
+static void
+mrg_min(struct aggstat *restrict dst, const struct aggstat *restrict src)
+{
+  dst->ag_val[0] = AGGSTAT_FMIN(dst->ag_val[0], src->ag_val[0]);
+}
+
+/// Merge the maximal value of two streams.
+///
+/// @param[in] dst aggregate function of the preceding stream
+/// @param[in] src aggregate function of the succeeding stream
+static void
+mrg_max(struct aggstat *restrict dst, const struct aggstat *restrict src)
+{
+  dst->ag_val[0] = AGGSTAT_FMAX(dst->ag_val[0], src->ag_val[0]);
+}
+
+/// Merge the central moments of two streams up to the selected order.
+///
+/// The moments are merged by the pairwise formulas of Chan et al. for the second moment, and their
+/// generalisation by Pébay for the third and fourth moment. The higher moments are updated first,
+/// as they depend on the lower moments of both streams.
+///
+/// @param[in] dst aggregate function of the preceding stream
+/// @param[in] src aggregate function of the succeeding stream
+/// @param[in] ord highest order of the moments
+static void
+mrg_mnt(struct aggstat *restrict dst, const struct aggstat *restrict src, const uint8_t ord)
+{
+  AGGSTAT_FLT na;
+  AGGSTAT_FLT nb;
+  AGGSTAT_FLT dlt;
+  AGGSTAT_FLT dln;
+
+  na  = (AGGSTAT_FLT)dst->ag_cnt[0];
+  nb  = (AGGSTAT_FLT)src->ag_cnt[0];
+  dlt = src->ag_val[0] - dst->ag_val[0];
+  dln = dlt / (na + nb);
+
+  if (ord > 3) {
+    dst->ag_val[3] += src->ag_val[3]
+                    + dlt * dln * dln * dln * na * nb * (na * na - na * nb + nb * nb)
+                    + AGGSTAT_6_0 * dln * dln * (na * na * src->ag_val[1]
+                                               + nb * nb * dst->ag_val[1])
+                    + AGGSTAT_4_0 * dln * (na * src->ag_val[2] - nb * dst->ag_val[2]);
+  }
+
+  if (ord > 2) {
+    dst->ag_val[2] += src->ag_val[2]
+                    + dlt * dln * dln * na * nb * (na - nb)
+                    + AGGSTAT_3_0 * dln * (na * src->ag_val[1] - nb * dst->ag_val[1]);
+  }
+
+  if (ord > 1) {
+    dst->ag_val[1] += src->ag_val[1] + dlt * dln * na * nb;
+  }
+
+  dst->ag_val[0] += dln * nb;
+}
+
+/// Merge the average value of two streams.
+///
+/// @param[in] dst aggregate function of the preceding stream
+/// @param[in] src aggregate function of the succeeding stream
+static void
+mrg_avg(struct aggstat *restrict dst, const struct aggstat *restrict src)
+{
+  mrg_mnt(dst, src, 1);
+}
+
+/// Merge the variance of two streams.
+///
+/// @param[in] dst aggregate function of the preceding stream
+/// @param[in] src aggregate function of the succeeding stream
+static void
+mrg_var(struct aggstat *restrict dst, const struct aggstat *restrict src)
+{
+  mrg_mnt(dst, src, 2);
+}
+
+/// Merge the standard deviation of two streams.
+///
+/// @param[in] dst aggregate function of the preceding stream
+/// @param[in] src aggregate function of the succeeding stream
+static void
+mrg_dev(struct aggstat *restrict dst, const struct aggstat *restrict src)
+{
+  mrg_mnt(dst, src, 2);
+}
+
+/// Merge the skewness of two streams.
+///
+/// @param[in] dst aggregate function of the preceding stream
+/// @param[in] src aggregate function of the succeeding stream
+static void
+mrg_skw(struct aggstat *restrict dst, const struct aggstat *restrict src)
+{
+  mrg_mnt(dst, src, 3);
+}
+
+/// Merge the kurtosis of two streams.
+///
+/// @param[in] dst aggregate function of the preceding stream
+/// @param[in] src aggregate function of the succeeding stream
+static void
+mrg_krt(struct aggstat *restrict dst, const struct aggstat *restrict src)
+{
+  mrg_mnt(dst, src, 4);
+}
+
+/// Merge the time-weighted state of two streams.
+///
+/// The preceding stream holds its last value until the first timestamp of the succeeding stream.
+///
+/// @param[in] dst aggregate function of the preceding stream
+/// @param[in] src aggregate function of the succeeding stream
+static void
+mrg_tim(struct aggstat *restrict dst, const struct aggstat *restrict src)
+{
+  AGGSTAT_FLT dur;
+
+  if (dst->ag_cnt[0] == 0) {
+    dst->ag_val[0] = src->ag_val[0];
+    dst->ag_val[1] = src->ag_val[1];
+    dst->ag_val[2] = src->ag_val[2];
+    dst->ag_val[3] = src->ag_val[3];
+    dst->ag_val[4] = src->ag_val[4];
+    return;
+  }
+
+  dur = src->ag_val[0] - dst->ag_val[1];
+  dur = dur > AGGSTAT_0_0 ? dur : AGGSTAT_0_0;
+
+  dst->ag_val[3] += dst->ag_val[2] * dur + src->ag_val[3];
+  dst->ag_val[1] += dur + (src->ag_val[1] - src->ag_val[0]);
+  dst->ag_val[2]  = src->ag_val[2];
+}
+
+/// Function table for mrg_* functions based on ag_fnc. The quantile estimates can not be merged,
+/// as the markers of two streams do not determine the markers of their concatenation.
+static void (*mrg_fnc[])(struct aggstat*, const struct aggstat*) = {
+  NULL,
+  mrg_fst,
+  mrg_lst,
+  mrg_cnt,
+  mrg_sum,
+  mrg_min,
+  mrg_max,
+  mrg_avg,
+  mrg_var,
+  mrg_dev,
+  mrg_skw,
+  mrg_krt,
+  NULL,
+  NULL,
+  mrg_tim,
+  mrg_tim,
+  mrg_tim
+};
+
+/// Merge the aggregated value of a succeeding stream into the aggregated value of a preceding
+/// stream.
+/// @return success/failure indication
+///
+/// Both aggregated values must use the same function and parameter. The result is equal to the
+/// aggregated value of the concatenation of both streams, up to rounding errors. This allows the
+/// stream to be split into chunks that are processed independently, e.g. in parallel. The
+/// function fails for the quantile and median functions.
+///
+/// @param[in] dst aggregated value of the preceding stream
+/// @param[in] src aggregated value of the succeeding stream
+bool
+aggstat_mrg(struct aggstat *restrict dst, const struct aggstat *restrict src)
+{
+  if (dst->ag_fnc != src->ag_fnc || mrg_fnc[dst->ag_fnc] == NULL) {
+    return false;
+  }
+
+  if (src->ag_cnt[0] > 0) {
+    mrg_fnc[dst->ag_fnc](dst, src);
+    dst->ag_cnt[0] += src->ag_cnt[0];
+  }
+
+  return true;
+}
@@ -0,0 +1,420 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include <string.h>
+#include <math.h>
+
+#include "agg.h"
+#include "sel.h"
+
+
+// Stages of the passes over the stream.
+#define OOC_FST 0 // First pass: counting, histogram of keys and collection of values.
+#define OOC_HST 1 // Narrowing pass: histogram of keys within the interval.
+#define OOC_COL 2 // Final pass: collection of values within the interval.
+#define OOC_END 3 // Result is available.
+#define OOC_ERR 4 // Result can not be determined.
+
+// Smallest accepted memory budget in bytes, and the largest width of the histogram index.
+#define OOC_MIN 512
+#define OOC_HBT 16
+
+// Width of the keys. Values that are wider than double precision are mapped through the double
+// precision, which preserves their order but not their distinctness.
+#if AGGSTAT_FLT_BIT == 32
+  #define OOC_KBT 32
+#else
+  #define OOC_KBT 64
+#endif
+
+/// Compute the key of a value. The unsigned order of the keys follows the order of the values.
+/// @return key
+///
+/// @param[in] val value
+static inline uint64_t
+ooc_key(const AGGSTAT_FLT val)
+{
+#if AGGSTAT_FLT_BIT == 32
+  uint32_t bit;
+
+  (void)memcpy(&bit, &val, sizeof(bit));
+  return (bit >> 31) != 0 ? ~bit : bit | ((uint32_t)1 << 31);
+#else
+  uint64_t bit;
+  double   dbl;
+
+  dbl = (double)val;
+  (void)memcpy(&bit, &dbl, sizeof(bit));
+  return (bit >> 63) != 0 ? ~bit : bit | ((uint64_t)1 << 63);
+#endif
+}
+
+/// Compute the largest offset of a key within an interval.
+/// @return offset mask
+///
+/// @param[in] bit width of the interval
+static inline uint64_t
+ooc_msk(const uint8_t bit)
+{
+  return bit == 64 ? UINT64_MAX : ((uint64_t)1 << bit) - 1;
+}
+
+/// Update the moments of the stream with a chunk of values.
+///
+/// The moments of the chunk are computed by two passes over its values, and merged into the
+/// moments of the stream. This is more accurate than the on-line update, and faster, as it does
+/// not divide for each value.
+///
+/// @param[in] agg aggregate function
+/// @param[in] arr chunk of values
+/// @param[in] len length of the chunk
+static void
+ooc_mnt(struct aggstat *restrict agg, const AGGSTAT_FLT *restrict arr, const AGGSTAT_INT len)
+{
+  struct aggstat chk;
+  AGGSTAT_FLT    avg;
+  AGGSTAT_FLT    dlt;
+  AGGSTAT_FLT    sqr;
+  AGGSTAT_INT    idx;
+
+  if (len == 0) {
+    return;
+  }
+
+  aggstat_new(&chk, agg->ag_fnc, agg->ag_par);
+
+  avg = AGGSTAT_0_0;
+  for (idx = 0; idx < len; idx += 1) {
+    avg += arr[idx];
+  }
+  avg /= (AGGSTAT_FLT)len;
+
+  for (idx = 0; idx < len; idx += 1) {
+    dlt = arr[idx] - avg;
+    sqr = dlt * dlt;
+
+    chk.ag_val[1] += sqr;
+    chk.ag_val[2] += sqr * dlt;
+    chk.ag_val[3] += sqr * sqr;
+  }
+
+  chk.ag_val[0] = avg;
+  chk.ag_cnt[0] = len;
+  (void)aggstat_mrg(agg, &chk);
+}
+
+/// Select the quantile among the collected values.
+///
+/// All values below the key interval were counted, and all values within the interval were
+/// collected. The value that follows the selected one in the sorted stream is either the least of
+/// the collected values above it, or the least value above the interval.
+///
+/// @param[in] ooc out-of-core aggregate function
+static void
+ooc_sel(struct aggstat_ooc* ooc)
+{
+  AGGSTAT_FLT val;
+  AGGSTAT_FLT nxt;
+  uint64_t    rnk;
+  uint64_t    idx;
+
+  rnk = ooc->ao_rnk - ooc->ao_blw;
+
+  if (ooc->ao_inn > ooc->ao_cap) {
+    // Select among the equal values of a single key.
+    val = ooc->ao_arr[0];
+    nxt = rnk + 1 < ooc->ao_inn ? val : ooc->ao_abv;
+  } else {
+    if (rnk >= ooc->ao_len) {
+      ooc->ao_stg = OOC_ERR;
+      return;
+    }
+
+    sel_kth(ooc->ao_arr, 0, (size_t)ooc->ao_len, (size_t)rnk);
+    val = ooc->ao_arr[rnk];
+
+    nxt = ooc->ao_abv;
+    for (idx = rnk + 1; idx < ooc->ao_len; idx += 1) {
+      nxt = ooc->ao_arr[idx] < nxt ? ooc->ao_arr[idx] : nxt;
+    }
+  }
+
+  if (ooc->ao_rnk == ooc->ao_cnt - 1) {
+    ooc->ao_res = val;
+  } else {
+    ooc->ao_res = val + ooc->ao_frp * (nxt - val);
+  }
+
+  ooc->ao_stg = OOC_END;
+}
+
+/// Narrow the key interval to the histogram bucket that contains the quantile.
+///
+/// @param[in] ooc out-of-core aggregate function
+static void
+ooc_nrw(struct aggstat_ooc* ooc)
+{
+  uint64_t tgt;
+  uint64_t sum;
+  uint64_t bkt;
+  uint64_t num;
+  uint8_t  sft;
+
+  sft = ooc->ao_bit > ooc->ao_hbt ? ooc->ao_bit - ooc->ao_hbt : 0;
+  num = (uint64_t)1 << (ooc->ao_bit - sft);
+  tgt = ooc->ao_rnk - ooc->ao_blw;
+
+  sum = 0;
+  for (bkt = 0; bkt < num - 1; bkt += 1) {
+    if (sum + ooc->ao_hst[bkt] > tgt) {
+      break;
+    }
+
+    sum += ooc->ao_hst[bkt];
+  }
+
+  ooc->ao_blw += sum;
+  ooc->ao_inn  = ooc->ao_hst[bkt];
+  ooc->ao_klo += bkt << sft;
+  ooc->ao_bit  = sft;
+
+  // Collect the values of the bucket if they fit, or if the bucket consists of a single key,
+  // otherwise subdivide it further.
+  if (ooc->ao_inn <= ooc->ao_cap || sft == 0) {
+    ooc->ao_stg = OOC_COL;
+  } else {
+    ooc->ao_stg = OOC_HST;
+  }
+
+  (void)memset(ooc->ao_hst, 0, sizeof(uint64_t) << ooc->ao_hbt);
+}
+
+/// Initialise the out-of-core aggregate function.
+/// @return success/failure indication
+///
+/// The memory is provided by the caller and its size is the budget of the computation. A quarter
+/// of the budget, up to half a megabyte, holds the histogram of keys, and the rest holds the
+/// collected values. The memory must be suitably aligned for both, e.g. obtained from `malloc`.
+/// Only the quantile and median functions use the memory.
+///
+/// @param[in] ooc out-of-core aggregate function
+/// @param[in] fnc function type
+/// @param[in] par function parameter
+/// @param[in] mem memory
+/// @param[in] siz size of the memory in bytes
+bool
+aggstat_ooc_new(struct aggstat_ooc* ooc,
+                const uint8_t       fnc,
+                const AGGSTAT_FLT   par,
+                void*               mem,
+                const size_t        siz)
+{
+  aggstat_new(&ooc->ao_agg, fnc, par);
+
+  ooc->ao_stg = OOC_FST;
+  ooc->ao_bit = OOC_KBT;
+  ooc->ao_hbt = 0;
+  ooc->ao_hst = NULL;
+  ooc->ao_arr = NULL;
+  ooc->ao_cap = 0;
+  ooc->ao_len = 0;
+  ooc->ao_cnt = 0;
+  ooc->ao_chk = 0;
+  ooc->ao_blw = 0;
+  ooc->ao_rnk = 0;
+  ooc->ao_klo = 0;
+  ooc->ao_inn = 0;
+  ooc->ao_frp = AGGSTAT_0_0;
+  ooc->ao_abv = (AGGSTAT_FLT)INFINITY;
+  ooc->ao_res = AGGSTAT_0_0;
+
+  if (fnc != AGGSTAT_FNC_QNT && fnc != AGGSTAT_FNC_MED) {
+    return true;
+  }
+
+  // Validate the parameter and the memory budget.
+  if (ooc->ao_agg.ag_par < AGGSTAT_0_0 || ooc->ao_agg.ag_par > AGGSTAT_1_0) {
+    return false;
+  }
+
+  if (mem == NULL || siz < OOC_MIN) {
+    return false;
+  }
+
+  // Select the largest histogram that fits into a quarter of the budget.
+  ooc->ao_hbt = 1;
+  while (ooc->ao_hbt < OOC_HBT && (sizeof(uint64_t) << (ooc->ao_hbt + 1)) <= siz / 4) {
+    ooc->ao_hbt += 1;
+  }
+
+  ooc->ao_hst = mem;
+  ooc->ao_arr = (AGGSTAT_FLT*)((char*)mem + (sizeof(uint64_t) << ooc->ao_hbt));
+  ooc->ao_cap = (siz - (sizeof(uint64_t) << ooc->ao_hbt)) / sizeof(AGGSTAT_FLT);
+  (void)memset(ooc->ao_hst, 0, sizeof(uint64_t) << ooc->ao_hbt);
+
+  return true;
+}
+
+/// Pass a chunk of the stream to the out-of-core aggregate function.
+///
+/// @param[in] ooc out-of-core aggregate function
+/// @param[in] arr chunk of values
+/// @param[in] len length of the chunk
+void
+aggstat_ooc_put(struct aggstat_ooc *restrict ooc,
+                const AGGSTAT_FLT  *restrict arr,
+                const AGGSTAT_INT            len)
+{
+  AGGSTAT_INT idx;
+  uint64_t    key;
+  uint64_t    msk;
+  uint8_t     sft;
+
+  ooc->ao_chk += len;
+
+  switch (ooc->ao_stg) {
+    case OOC_FST:
+      if (ooc->ao_hst == NULL) {
+        if (ooc->ao_agg.ag_fnc >= AGGSTAT_FNC_AVG && ooc->ao_agg.ag_fnc <= AGGSTAT_FNC_KRT) {
+          ooc_mnt(&ooc->ao_agg, arr, len);
+        } else {
+          aggstat_put_arr(&ooc->ao_agg, arr, len);
+        }
+        return;
+      }
+
+      // Collect the values while they fit, so that streams that fit into the budget need only a
+      // single pass.
+      sft = OOC_KBT - ooc->ao_hbt;
+      for (idx = 0; idx < len; idx += 1) {
+        ooc->ao_hst[ooc_key(arr[idx]) >> sft] += 1;
+        if (ooc->ao_len < ooc->ao_cap) {
+          ooc->ao_arr[ooc->ao_len] = arr[idx];
+          ooc->ao_len += 1;
+        }
+      }
+      break;
+
+    case OOC_HST:
+      sft = ooc->ao_bit > ooc->ao_hbt ? ooc->ao_bit - ooc->ao_hbt : 0;
+      msk = ooc_msk(ooc->ao_bit);
+      for (idx = 0; idx < len; idx += 1) {
+        key = ooc_key(arr[idx]) - ooc->ao_klo;
+        if (key <= msk) {
+          ooc->ao_hst[key >> sft] += 1;
+        }
+      }
+      break;
+
+    case OOC_COL:
+      msk = ooc_msk(ooc->ao_bit);
+      for (idx = 0; idx < len; idx += 1) {
+        key = ooc_key(arr[idx]);
+        if (key < ooc->ao_klo) {
+          continue;
+        }
+
+        if (key - ooc->ao_klo > msk) {
+          ooc->ao_abv = arr[idx] < ooc->ao_abv ? arr[idx] : ooc->ao_abv;
+          continue;
+        }
+
+        // A single key with more values than the capacity is represented by its first value. Its
+        // values are all equal, unless the key is shared by distinct values due to the mapping
+        // through the double precision.
+        if (ooc->ao_inn > ooc->ao_cap && ooc->ao_len > 0) {
+          if (arr[idx] != ooc->ao_arr[0]) {
+            ooc->ao_stg = OOC_ERR;
+            return;
+          }
+
+          continue;
+        }
+
+        // Guard against a stream that differs from the previous passes.
+        if (ooc->ao_len == ooc->ao_cap) {
+          ooc->ao_stg = OOC_ERR;
+          return;
+        }
+
+        ooc->ao_arr[ooc->ao_len] = arr[idx];
+        ooc->ao_len += 1;
+      }
+      break;
+  }
+}
+
+/// Finish a pass over the stream.
+/// @return another pass is necessary
+///
+/// The quantile functions need further passes over the same stream in the same order when the
+/// stream does not fit into the memory budget. Each pass narrows the range of values that contains
+/// the quantile by a histogram, until the values in the range fit into the memory, and the final
+/// pass collects these values for selection. Streams that fit into the budget need a single pass,
+/// as do all other functions.
+///
+/// @param[in] ooc out-of-core aggregate function
+bool
+aggstat_ooc_end(struct aggstat_ooc* ooc)
+{
+  AGGSTAT_FLT inp;
+
+  if (ooc->ao_hst == NULL || ooc->ao_stg >= OOC_END) {
+    return false;
+  }
+
+  if (ooc->ao_stg == OOC_FST) {
+    ooc->ao_cnt = ooc->ao_chk;
+    if (ooc->ao_cnt == 0) {
+      ooc->ao_stg = OOC_ERR;
+      return false;
+    }
+
+    // Determine the rank of the quantile in the same manner as the off-line algorithm.
+    ooc->ao_frp = AGGSTAT_MODF((AGGSTAT_FLT)(ooc->ao_cnt - 1) * ooc->ao_agg.ag_par, &inp);
+    ooc->ao_rnk = (uint64_t)inp;
+    ooc->ao_rnk = ooc->ao_rnk < ooc->ao_cnt ? ooc->ao_rnk : ooc->ao_cnt - 1;
+
+    if (ooc->ao_cnt <= ooc->ao_cap) {
+      ooc_sel(ooc);
+      return false;
+    }
+  } else if (ooc->ao_chk != ooc->ao_cnt) {
+    ooc->ao_stg = OOC_ERR;
+    return false;
+  }
+
+  ooc->ao_chk = 0;
+
+  if (ooc->ao_stg == OOC_COL) {
+    ooc_sel(ooc);
+    return false;
+  }
+
+  ooc_nrw(ooc);
+  if (ooc->ao_stg == OOC_COL) {
+    ooc->ao_len = 0;
+    ooc->ao_abv = (AGGSTAT_FLT)INFINITY;
+  }
+
+  return ooc->ao_stg != OOC_ERR;
+}
+
+/// Obtain the aggregated value of the stream.
+/// @return success/failure indication
+///
+/// @param[in]  ooc out-of-core aggregate function
+/// @param[out] val aggregated value
+bool
+aggstat_ooc_get(const struct aggstat_ooc *restrict ooc, AGGSTAT_FLT *restrict val)
+{
+  if (ooc->ao_hst == NULL) {
+    return aggstat_get(&ooc->ao_agg, val);
+  }
+
+  *val = ooc->ao_res;
+  return ooc->ao_stg == OOC_END;
+}
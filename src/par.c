@@ -0,0 +1,360 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <math.h>
+
+#include "agg.h"
+#include "sel.h"
+
+
+// Number of buckets delimited by the splitters (must be a power of two).
+#define PAR_BKT 1024
+
+// Number of sampled values per bucket.
+#define PAR_SMP 16
+
+// Marker of a bucket that contains no requested order statistic.
+#define PAR_NON SIZE_MAX
+
+// Number of values obtained from the reader at once.
+#define PAR_BLK 4096
+
+/// Part of the values processed by a single thread.
+struct par_wrk {
+  void             (*pw_rdr)(AGGSTAT_FLT*, const void*, size_t, size_t, uint32_t, uint8_t);
+                             ///< Reader of the values, or NULL.
+  const void*        pw_src; ///< Source of the values.
+  uint32_t           pw_wid; ///< Index of the part.
+  size_t             pw_lop; ///< Start of the part.
+  size_t             pw_hip; ///< End of the part (exclusive).
+  const AGGSTAT_FLT* pw_spl; ///< Splitters of the buckets.
+  const size_t*      pw_map; ///< Slot of each bucket in the output, or PAR_NON.
+  size_t*            pw_hst; ///< Number of values of the part in each bucket.
+  AGGSTAT_FLT*       pw_out; ///< Values of the requested buckets.
+  pthread_t          pw_thr; ///< Thread.
+  bool               pw_run; ///< Thread was started.
+  bool               pw_cpy; ///< Copy the values instead of counting them.
+};
+
+/// Find the bucket of a value.
+/// @return index of the bucket
+///
+/// The bucket is the number of splitters that are not greater than the value, found by a binary
+/// search without branches.
+///
+/// @param[in] spl splitters
+/// @param[in] val value
+static size_t
+par_bkt(const AGGSTAT_FLT *restrict spl, const AGGSTAT_FLT val)
+{
+  size_t pos;
+  size_t stp;
+
+  pos = 0;
+  for (stp = PAR_BKT / 2; stp > 0; stp /= 2) {
+    pos += spl[pos + stp - 1] <= val ? stp : 0;
+  }
+
+  return pos;
+}
+
+/// Count the values of a part in each bucket, or copy the values of the requested buckets to the
+/// positions reserved for the part.
+/// @return NULL
+///
+/// @param[in] arg part of the array
+static void*
+par_run(void* arg)
+{
+  struct par_wrk*    wrk;
+  const AGGSTAT_FLT* ptr;
+  AGGSTAT_FLT        buf[PAR_BLK];
+  size_t             idx;
+  size_t             jdx;
+  size_t             len;
+  size_t             bkt;
+
+  wrk = arg;
+  for (idx = wrk->pw_lop; idx < wrk->pw_hip; idx += len) {
+    len = wrk->pw_hip - idx < PAR_BLK ? wrk->pw_hip - idx : PAR_BLK;
+
+    // Values of an array are processed in place, whereas other sources are read in blocks.
+    if (wrk->pw_rdr == NULL) {
+      ptr = (const AGGSTAT_FLT*)wrk->pw_src + idx;
+    } else {
+      wrk->pw_rdr(buf, wrk->pw_src, idx, len, wrk->pw_wid,
+                  wrk->pw_cpy == false ? AGGSTAT_RDR_CNT : AGGSTAT_RDR_CPY);
+      ptr = buf;
+    }
+
+    for (jdx = 0; jdx < len; jdx += 1) {
+      bkt = par_bkt(wrk->pw_spl, ptr[jdx]);
+      if (wrk->pw_cpy == false) {
+        wrk->pw_hst[bkt] += 1;
+      } else if (wrk->pw_map[bkt] != PAR_NON) {
+        wrk->pw_out[wrk->pw_hst[bkt]] = ptr[jdx];
+        wrk->pw_hst[bkt] += 1;
+      }
+    }
+  }
+
+  return NULL;
+}
+
+/// Process all parts of the array, each by its own thread.
+///
+/// A part whose thread can not be started is processed by the calling thread.
+///
+/// @param[in] wrk parts of the array
+/// @param[in] thr number of parts
+static void
+par_all(struct par_wrk* wrk, const uint32_t thr)
+{
+  uint32_t idx;
+
+  for (idx = 1; idx < thr; idx += 1) {
+    wrk[idx].pw_run = pthread_create(&wrk[idx].pw_thr, NULL, par_run, &wrk[idx]) == 0;
+  }
+
+  (void)par_run(&wrk[0]);
+  for (idx = 1; idx < thr; idx += 1) {
+    if (wrk[idx].pw_run == true) {
+      (void)pthread_join(wrk[idx].pw_thr, NULL);
+    } else {
+      (void)par_run(&wrk[idx]);
+    }
+  }
+}
+
+/// Select the splitters of the buckets from a regular sample of the values.
+///
+/// @param[out] spl splitters
+/// @param[in]  smp memory of the sample
+/// @param[in]  wrk first part, which determines the reader and the source
+/// @param[in]  len number of values
+static void
+par_spl(      AGGSTAT_FLT    *restrict spl,
+              AGGSTAT_FLT    *restrict smp,
+        const struct par_wrk *restrict wrk,
+        const size_t                   len)
+{
+  size_t cnt;
+  size_t idx;
+
+  cnt = len < PAR_BKT * PAR_SMP ? len : PAR_BKT * PAR_SMP;
+  for (idx = 0; idx < cnt; idx += 1) {
+    if (wrk->pw_rdr == NULL) {
+      smp[idx] = ((const AGGSTAT_FLT*)wrk->pw_src)[idx * (len / cnt)];
+    } else {
+      wrk->pw_rdr(&smp[idx], wrk->pw_src, idx * (len / cnt), 1, 0, AGGSTAT_RDR_SMP);
+    }
+  }
+
+  (void)qsort((void*)smp, cnt, sizeof(AGGSTAT_FLT), sel_cmp);
+  for (idx = 0; idx + 1 < PAR_BKT; idx += 1) {
+    spl[idx] = smp[(idx + 1) * cnt / PAR_BKT];
+  }
+}
+
+/// Compute exact p-quantiles of values obtained from a reader with multiple threads.
+/// @return success/failure indication
+///
+/// The threads count the values of their parts of the source in buckets delimited by splitters
+/// from a sample of the source, and the counts determine the buckets that contain the order
+/// statistics of all quantiles. The threads then copy only the values of those buckets, and the
+/// order statistics are selected within each bucket. The results are equal to those of
+/// `aggstat_run` over all values of the source, which must not contain values that are not a
+/// number.
+///
+/// The reader converts a block of consecutive values of the source, given the index of the first
+/// value and their number, into the floating-point type. The calling thread first reads the
+/// single values of the sample with the part index zero (`AGGSTAT_RDR_SMP`). Part `wid` of
+/// `num` parts spans the values from `len * wid / num` to `len * (wid + 1) / num`, where `num`
+/// is the number of threads, at least one and at most `len`. Each part is then read in increasing
+/// blocks by its own thread, first to count the values (`AGGSTAT_RDR_CNT`), and once more to copy
+/// them (`AGGSTAT_RDR_CPY`), so that the reader is called concurrently for different parts. A
+/// null reader reads the source as an array of values in place.
+///
+/// @param[out] val p-quantiles
+/// @param[in]  rdr reader of the values (optional)
+/// @param[in]  src source of the values
+/// @param[in]  len number of values
+/// @param[in]  par array of parameters
+/// @param[in]  cnt number of parameters
+/// @param[in]  thr number of threads
+bool
+aggstat_run_par_rdr(      AGGSTAT_FLT *restrict val,
+                    void (*rdr)(AGGSTAT_FLT*, const void*, size_t, size_t, uint32_t, uint8_t),
+                    const void        *restrict src,
+                    const AGGSTAT_INT           len,
+                    const AGGSTAT_FLT *restrict par,
+                    const size_t                cnt,
+                    const uint32_t              thr)
+{
+  struct par_wrk* wrk;
+  AGGSTAT_FLT*    spl;
+  AGGSTAT_FLT*    out;
+  AGGSTAT_FLT     inp;
+  AGGSTAT_FLT     frp;
+  AGGSTAT_FLT     ord[2];
+  size_t*         hst;
+  size_t*         map;
+  size_t          beg[PAR_BKT];
+  size_t          tot;
+  size_t          rnk;
+  size_t          bkt;
+  size_t          idx;
+  uint32_t        num;
+  uint32_t        wid;
+  uint8_t         sel;
+
+  if (len == 0) {
+    return false;
+  }
+
+  for (idx = 0; idx < cnt; idx += 1) {
+    if (par[idx] < AGGSTAT_0_0 || par[idx] > AGGSTAT_1_0) {
+      return false;
+    }
+  }
+
+  // Ensure that each thread has a part of the array.
+  num = thr > 0 ? thr : 1;
+  num = (size_t)num < (size_t)len ? num : (uint32_t)len;
+
+  wrk = malloc(num * sizeof(*wrk));
+  spl = malloc((PAR_BKT + PAR_BKT * PAR_SMP) * sizeof(AGGSTAT_FLT));
+  hst = calloc((size_t)num * PAR_BKT, sizeof(size_t));
+  map = malloc(PAR_BKT * sizeof(size_t));
+  out = NULL;
+  if (wrk == NULL || spl == NULL || hst == NULL || map == NULL) {
+    free(wrk);
+    free(spl);
+    free(hst);
+    free(map);
+    return false;
+  }
+
+  for (wid = 0; wid < num; wid += 1) {
+    wrk[wid].pw_rdr = rdr;
+    wrk[wid].pw_src = src;
+    wrk[wid].pw_wid = wid;
+    wrk[wid].pw_lop = (size_t)len * wid / num;
+    wrk[wid].pw_hip = (size_t)len * (wid + 1) / num;
+    wrk[wid].pw_spl = spl;
+    wrk[wid].pw_map = map;
+    wrk[wid].pw_hst = hst + (size_t)wid * PAR_BKT;
+    wrk[wid].pw_cpy = false;
+  }
+
+  par_spl(spl, spl + PAR_BKT, &wrk[0], (size_t)len);
+  par_all(wrk, num);
+
+  // Determine the first rank of each bucket, and mark the buckets of the requested ranks.
+  tot = 0;
+  for (bkt = 0; bkt < PAR_BKT; bkt += 1) {
+    beg[bkt] = tot;
+    map[bkt] = PAR_NON;
+    for (wid = 0; wid < num; wid += 1) {
+      tot += wrk[wid].pw_hst[bkt];
+    }
+  }
+
+  for (idx = 0; idx < cnt; idx += 1) {
+    (void)AGGSTAT_MODF((AGGSTAT_FLT)(len - 1) * par[idx], &inp);
+    for (sel = 0; sel < 2; sel += 1) {
+      rnk = (size_t)inp + sel < (size_t)len ? (size_t)inp + sel : (size_t)len - 1;
+      for (bkt = PAR_BKT - 1; beg[bkt] > rnk; bkt -= 1) {
+      }
+
+      map[bkt] = 0;
+    }
+  }
+
+  // Reserve the positions of the values of the requested buckets, consecutive for each bucket and
+  // each part of the array within it.
+  tot = 0;
+  for (bkt = 0; bkt < PAR_BKT; bkt += 1) {
+    if (map[bkt] == PAR_NON) {
+      continue;
+    }
+
+    map[bkt] = tot;
+    for (wid = 0; wid < num; wid += 1) {
+      rnk                   = wrk[wid].pw_hst[bkt];
+      wrk[wid].pw_hst[bkt]  = tot;
+      tot                  += rnk;
+    }
+  }
+
+  out = malloc((tot > 0 ? tot : 1) * sizeof(AGGSTAT_FLT));
+  if (out == NULL) {
+    free(wrk);
+    free(spl);
+    free(hst);
+    free(map);
+    return false;
+  }
+
+  for (wid = 0; wid < num; wid += 1) {
+    wrk[wid].pw_out = out;
+    wrk[wid].pw_cpy = true;
+  }
+
+  par_all(wrk, num);
+
+  // Select the order statistics within their buckets, and interpolate as the off-line algorithm.
+  for (idx = 0; idx < cnt; idx += 1) {
+    frp = AGGSTAT_MODF((AGGSTAT_FLT)(len - 1) * par[idx], &inp);
+    for (sel = 0; sel < 2; sel += 1) {
+      rnk = (size_t)inp + sel < (size_t)len ? (size_t)inp + sel : (size_t)len - 1;
+      for (bkt = PAR_BKT - 1; beg[bkt] > rnk; bkt -= 1) {
+      }
+
+      // The end of the bucket is the reserved position of the bucket that follows it.
+      tot = wrk[num - 1].pw_hst[bkt];
+      sel_kth(out, map[bkt], tot, map[bkt] + rnk - beg[bkt]);
+      ord[sel] = out[map[bkt] + rnk - beg[bkt]];
+    }
+
+    if ((size_t)inp == (size_t)len - 1) {
+      val[idx] = ord[0];
+    } else {
+      val[idx] = ord[0] + frp * (ord[1] - ord[0]);
+    }
+  }
+
+  free(wrk);
+  free(spl);
+  free(hst);
+  free(map);
+  free(out);
+  return true;
+}
+
+/// Compute exact p-quantiles of an array with multiple threads.
+/// @return success/failure indication
+///
+/// The array is read twice and not modified, as described by `aggstat_run_par_rdr`.
+///
+/// @param[out] val p-quantiles
+/// @param[in]  arr array of values
+/// @param[in]  len length of the array
+/// @param[in]  par array of parameters
+/// @param[in]  cnt number of parameters
+/// @param[in]  thr number of threads
+bool
+aggstat_run_par(      AGGSTAT_FLT *restrict val,
+                const AGGSTAT_FLT *restrict arr,
+                const AGGSTAT_INT           len,
+                const AGGSTAT_FLT *restrict par,
+                const size_t                cnt,
+                const uint32_t              thr)
+{
+  return aggstat_run_par_rdr(val, NULL, arr, len, par, cnt, thr);
+}
@@ -4,12 +4,41 @@
 // Distributed under the terms of the 2-clause BSD License. The full
 // license is in the file LICENSE, distributed as part of this software.
 
-#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
 #include <math.h>
 
 #include "agg.h"
 
 
+// Divisor of the number of values that limits each step of a weighted quantile update.
+#define PUT_STP 16
+
+// Counting of internal events, which expands to nothing unless it is enabled.
+#if AGGSTAT_CTR == 1
+  #define PUT_CTR(F, N) put_ctr.F += (uint64_t)(N)
+  #define PUT_INP(V)    put_inp(V)
+#else
+  #define PUT_CTR(F, N)
+  #define PUT_INP(V)
+#endif
+
+#if AGGSTAT_CTR == 1
+/// Counters of internal events of the calling thread.
+static __thread struct aggstat_ctr put_ctr;
+
+/// Count an input value and whether it is not a number or infinite.
+///
+/// @param[in] inp input value
+static void
+put_inp(const AGGSTAT_FLT inp)
+{
+  PUT_CTR(ac_inp, 1);
+  PUT_CTR(ac_nan, inp != inp);
+  PUT_CTR(ac_inf, inp == inp && inp - inp != inp - inp);
+}
+#endif
+
 /// Update the first value of the stream.
 ///
 /// @param[in] agg aggregate function
@@ -196,106 +225,122 @@ put_krt(struct aggstat* agg, const AGGSTAT_FLT inp)
   snd_mnt(agg);
 }
 
-/// Linear extrapolation between two heights.
-/// @return
+/// Order two heights of the sorting network.
+///
+/// @param[in] val heights
+/// @param[in] fst index of the first height
+/// @param[in] snd index of the second height
+static void
+qnt_swp(AGGSTAT_FLT* val, const uint8_t fst, const uint8_t snd)
+{
+  AGGSTAT_FLT x;
+  AGGSTAT_FLT y;
+
+  x = val[fst];
+  y = val[snd];
+
+  val[fst] = y < x ? y : x;
+  val[snd] = y < x ? x : y;
+}
+
+/// Sort the first five heights.
 ///
-/// This function works with the assumption that the `idx` argument
-/// is never the first (0) or the last (4) element of the array.
+/// The heights are sorted by an optimal sorting network of nine comparators, which is free of both
+/// function calls and data-dependent branches.
 ///
-/// @param[in] agg aggregate function
-/// @param[in] idx index of the value to adjust
-/// @param[in] dir direction of the change
-static AGGSTAT_FLT
-qnt_lin(struct aggstat* agg, const AGGSTAT_INT idx, const int8_t dir)
+/// @param[in] val heights
+static void
+qnt_srt(AGGSTAT_FLT* val)
 {
-  return agg->ag_val[idx]       + (AGGSTAT_FLT)dir
-      * (agg->ag_val[idx + dir] - agg->ag_val[idx])
-      / (agg->ag_cnt[idx + dir] - agg->ag_cnt[idx]);
+  qnt_swp(val, 0, 1);
+  qnt_swp(val, 3, 4);
+  qnt_swp(val, 2, 4);
+  qnt_swp(val, 2, 3);
+  qnt_swp(val, 0, 3);
+  qnt_swp(val, 0, 2);
+  qnt_swp(val, 1, 4);
+  qnt_swp(val, 1, 3);
+  qnt_swp(val, 1, 2);
 }
 
-/// Parabolic extrapolation between two heights.
-/// @return
+/// Estimate the height of a marker after its movement.
+/// @return estimated height
 ///
-/// This function works with the assumption that the `idx` argument
-/// is never the first (0) or the last (4) element of the array.
+/// The piecewise parabolic estimate is evaluated with a single division by folding its three
+/// denominators together. In case it would result in out of order values, the linear estimate is
+/// used instead. The movement can span multiple positions, as long as the marker does not reach
+/// its neighbours.
 ///
 /// @param[in] agg aggregate
-/// @param[in] idx index of
-/// @param[in] dir direction of the extrapolation
+/// @param[in] idx index of the value to readjust
+/// @param[in] dir signed number of positions to move
+/// @param[in] lft distance to the left neighbour
+/// @param[in] rgt distance to the right neighbour
 static AGGSTAT_FLT
-qnt_prb(struct aggstat* agg, const AGGSTAT_INT idx, const int8_t dir)
+qnt_est(const struct aggstat* agg,
+        const uint8_t         idx,
+        const AGGSTAT_FLT     dir,
+        const AGGSTAT_FLT     lft,
+        const AGGSTAT_FLT     rgt)
 {
-  AGGSTAT_FLT x;
-  AGGSTAT_FLT y;
+  AGGSTAT_FLT hgt;
+  AGGSTAT_FLT est;
+
+  hgt = agg->ag_val[idx];
 
-  x = (AGGSTAT_FLT)(agg->ag_cnt[idx]     - agg->ag_cnt[idx  - 1] + dir)
-    *              (agg->ag_val[idx + 1] - agg->ag_val[idx])
-    / (AGGSTAT_FLT)(agg->ag_cnt[idx + 1] - agg->ag_cnt[idx]);
+  // Piecewise parabolic estimation.
+  est = hgt + dir
+      * ((lft + dir) * (agg->ag_val[idx + 1] - hgt) * lft
+       + (rgt - dir) * (hgt - agg->ag_val[idx - 1]) * rgt)
+      / ((lft + rgt) * lft * rgt);
 
-  y = (AGGSTAT_FLT)(agg->ag_cnt[idx + 1] - agg->ag_cnt[idx] - dir)
-    *              (agg->ag_val[idx]     - agg->ag_val[idx  - 1])
-    / (AGGSTAT_FLT)(agg->ag_cnt[idx]     - agg->ag_cnt[idx  - 1]);
+  if (agg->ag_val[idx - 1] < est && est < agg->ag_val[idx + 1]) {
+    PUT_CTR(ac_prb, 1);
+    return est;
+  }
 
-  return agg->ag_val[idx] + dir
-       * (x + y)
-       / (AGGSTAT_FLT)(agg->ag_cnt[idx + 1] - agg->ag_cnt[idx - 1]);
+  // Linear estimation towards the neighbour in the direction of the movement.
+  PUT_CTR(ac_lin, 1);
+  if (dir > AGGSTAT_0_0) {
+    return hgt + dir * (agg->ag_val[idx + 1] - hgt) / rgt;
+  } else {
+    return hgt + dir * (hgt - agg->ag_val[idx - 1]) / lft;
+  }
 }
 
 /// Readjust values after a new value was applied.
 ///
+/// The distances between the counts are converted to the floating-point type before any
+/// subtraction that could be negative, so that the unsigned counts never wrap around.
+///
 /// @param[in] agg aggregate
 /// @param[in] idx index of the value to readjust
 static void
-qnt_adj(struct aggstat* agg, const AGGSTAT_INT idx)
+qnt_adj(struct aggstat* agg, const uint8_t idx)
 {
   AGGSTAT_FLT dlt;
-  AGGSTAT_FLT par;
-  int8_t      dir;
-  bool        ord[2];
+  AGGSTAT_FLT lft;
+  AGGSTAT_FLT rgt;
+  bool        inc;
+  bool        dec;
 
-  // Compute the current differences.
-  dlt    = agg->ag_val[idx + 5] - (AGGSTAT_FLT)agg->ag_cnt[idx];
-  ord[0] = agg->ag_cnt[idx + 1] > (agg->ag_cnt[idx] + 1);
-  ord[1] = agg->ag_cnt[idx - 1] < (agg->ag_cnt[idx] - 1);
+  // Compute the distances to the neighbouring counts.
+  lft = (AGGSTAT_FLT)(agg->ag_cnt[idx]     - agg->ag_cnt[idx - 1]);
+  rgt = (AGGSTAT_FLT)(agg->ag_cnt[idx + 1] - agg->ag_cnt[idx]);
 
   // Only continue with the readjustment if the values are out of order.
-  if ((dlt >= AGGSTAT_1_0 && ord[0]) || (dlt <= -AGGSTAT_1_0 && ord[1])) {
-    // Decide the movement direction.
-    dir = (int8_t)AGGSTAT_SIGN(AGGSTAT_1_0, dlt);
-
-    // Determine which estimation to use.
-    par = qnt_prb(agg, idx, dir);
-
-    // In case the piecewise parabolic estimation would result in out of order values, revert to
-    // the linear estimation.
-    if (agg->ag_val[idx - 1] < par && par < agg->ag_val[idx + 1]) {
-      agg->ag_val[idx] = par;
-    } else {
-      agg->ag_val[idx] = qnt_lin(agg, idx, dir);
-    }
-
-    agg->ag_cnt[idx] += dir;
+  dlt = agg->ag_val[idx + 5] - (AGGSTAT_FLT)agg->ag_cnt[idx];
+  inc = (dlt >=  AGGSTAT_1_0) & (rgt > AGGSTAT_1_0);
+  dec = (dlt <= -AGGSTAT_1_0) & (lft > AGGSTAT_1_0);
+  if ((inc | dec) == false) {
+    return;
   }
-}
-
-/// Compare two elements of the stream.
-/// @return comparison
-/// @retval 0 elements are equal
-/// @retval 1 first element is greater
-/// @retval -1 second element is greater
-///
-/// @param[in] a first element
-/// @param[in] b second element
-static int
-qnt_cmp(const void* a, const void* b)
-{
-  AGGSTAT_FLT x;
-  AGGSTAT_FLT y;
-
-  x = *(AGGSTAT_FLT*)a;
-  y = *(AGGSTAT_FLT*)b;
 
-  return (x > y) - (x < y);
+  // Move by a single position in the decided direction.
+  PUT_CTR(ac_mov, 1);
+  agg->ag_val[idx]  = qnt_est(agg, idx, (AGGSTAT_FLT)inc - (AGGSTAT_FLT)dec, lft, rgt);
+  agg->ag_cnt[idx] += inc;
+  agg->ag_cnt[idx] -= dec;
 }
 
 /// Update the p-quantile of the stream.
@@ -305,8 +350,6 @@ qnt_cmp(const void* a, const void* b)
 static void
 put_qnt(struct aggstat* agg, const AGGSTAT_FLT inp)
 {
-  AGGSTAT_INT inc[3];
-
   // Perform a sorted insert of the first 5 elements.
   if (agg->ag_cnt[4] < 4) {
     agg->ag_val[agg->ag_cnt[4]] = inp;
@@ -320,7 +363,7 @@ put_qnt(struct aggstat* agg, const AGGSTAT_FLT inp)
     agg->ag_val[4] = inp;
 
     // Sort the values.
-    (void)qsort(agg->ag_val, 5, sizeof(AGGSTAT_FLT), qnt_cmp);
+    qnt_srt(agg->ag_val);
 
     // Initialise the counts.
     agg->ag_cnt[0] = 0; // Will get incremented by `aggstat_put`.
@@ -339,20 +382,16 @@ put_qnt(struct aggstat* agg, const AGGSTAT_FLT inp)
     return;
   }
 
-  // Determine which counts need to be incremented.
-  inc[0] = !!(inp < agg->ag_val[1]);
-  inc[1] = !!(inp < agg->ag_val[2]);
-  inc[2] = !!(inp < agg->ag_val[3]);
-
-  // Increment the counts.
-  agg->ag_cnt[1] += inc[0];
-  agg->ag_cnt[2] += inc[0] || inc[1];
-  agg->ag_cnt[3] += inc[0] || inc[1] || inc[2];
+  // Increment the counts of all markers above the value. As the heights are kept in order, each
+  // comparison directly decides one count, without any branches.
+  agg->ag_cnt[1] += inp < agg->ag_val[1];
+  agg->ag_cnt[2] += inp < agg->ag_val[2];
+  agg->ag_cnt[3] += inp < agg->ag_val[3];
   agg->ag_cnt[4] += 1;
 
   // Adjust minimum and maximum.
-  agg->ag_val[0] = AGGSTAT_FMIN(agg->ag_val[0], inp);
-  agg->ag_val[4] = AGGSTAT_FMAX(agg->ag_val[4], inp);
+  agg->ag_val[0] = inp < agg->ag_val[0] ? inp : agg->ag_val[0];
+  agg->ag_val[4] = inp > agg->ag_val[4] ? inp : agg->ag_val[4];
 
   // Increment the desired counts.
   agg->ag_val[6] += agg->ag_par / AGGSTAT_2_0;
@@ -380,6 +419,410 @@ put_med(struct aggstat* agg, const AGGSTAT_FLT inp)
   put_qnt(agg, inp);
 }
 
+/// Update the time-weighted state of the stream with a timestamped value.
+///
+/// The stream is treated as a step function that holds each value until the timestamp of the next
+/// value. The state consists of the first and last timestamp, the last value, the integral of the
+/// step function and the first value. Timestamps that precede the last timestamp contribute no
+/// duration.
+///
+/// @param[in] agg aggregate function
+/// @param[in] tim timestamp
+/// @param[in] inp input value
+static void
+put_tim(struct aggstat* agg, const AGGSTAT_FLT tim, const AGGSTAT_FLT inp)
+{
+  AGGSTAT_FLT dur;
+
+  if (agg->ag_cnt[0] == 0) {
+    agg->ag_val[0] = tim;
+    agg->ag_val[1] = tim;
+    agg->ag_val[4] = inp;
+  }
+
+  // Hold the previous value until the current timestamp.
+  dur = tim - agg->ag_val[1];
+  dur = dur > AGGSTAT_0_0 ? dur : AGGSTAT_0_0;
+
+  agg->ag_val[1] += dur;
+  agg->ag_val[3] += agg->ag_val[2] * dur;
+  agg->ag_val[2]  = inp;
+}
+
+/// Update the time-weighted average of the stream.
+///
+/// The timestamp of the value is its position in the stream.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+static void
+put_twa(struct aggstat* agg, const AGGSTAT_FLT inp)
+{
+  put_tim(agg, (AGGSTAT_FLT)agg->ag_cnt[0], inp);
+}
+
+/// Update the time integral of the stream.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+static void
+put_itg(struct aggstat* agg, const AGGSTAT_FLT inp)
+{
+  put_twa(agg, inp);
+}
+
+/// Update the rate of change of the stream.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+static void
+put_rat(struct aggstat* agg, const AGGSTAT_FLT inp)
+{
+  put_twa(agg, inp);
+}
+
+/// Update the first value of the stream with a weighted value.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+/// @param[in] wgt weight (unused)
+static void
+wgt_fst(struct aggstat* agg, const AGGSTAT_FLT inp, const AGGSTAT_INT wgt)
+{
+  (void)wgt;
+  put_fst(agg, inp);
+}
+
+/// Update the last value of the stream with a weighted value.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+/// @param[in] wgt weight (unused)
+static void
+wgt_lst(struct aggstat* agg, const AGGSTAT_FLT inp, const AGGSTAT_INT wgt)
+{
+  (void)wgt;
+  put_lst(agg, inp);
+}
+
+/// Update the number of values in the stream with a weighted value.
+///
+/// @param[in] agg aggregate function (unused)
+/// @param[in] inp input value (unused)
+/// @param[in] wgt weight (unused)
+static void
+wgt_cnt(struct aggstat* agg, const AGGSTAT_FLT inp, const AGGSTAT_INT wgt)
+{
+  (void)agg;
+  (void)inp;
+  (void)wgt;
+}
+
+/// Update the sum of values in the stream with a weighted value.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+/// @param[in] wgt weight
+static void
+wgt_sum(struct aggstat* agg, const AGGSTAT_FLT inp, const AGGSTAT_INT wgt)
+{
+  agg->ag_val[0] += inp * (AGGSTAT_FLT)wgt;
+}
+
+/// Update the minimal value in the stream with a weighted value.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+/// @param[in] wgt weight (unused)
+static void
+wgt_min(struct aggstat* agg, const AGGSTAT_FLT inp, const AGGSTAT_INT wgt)
+{
+  (void)wgt;
+  put_min(agg, inp);
+}
+
+/// Update the maximal value in the stream with a weighted value.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+/// @param[in] wgt weight (unused)
+static void
+wgt_max(struct aggstat* agg, const AGGSTAT_FLT inp, const AGGSTAT_INT wgt)
+{
+  (void)wgt;
+  put_max(agg, inp);
+}
+
+/// Pre-compute temporary variables for a weighted value.
+///
+/// The weighted value is treated as a group of identical values, which is merged into the current
+/// state. The variables generalise those of `set_tmp`, which is the special case of a unit weight.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+/// @param[in] wgt weight
+static void
+wgt_tmp(struct aggstat* agg, const AGGSTAT_FLT inp, const AGGSTAT_INT wgt)
+{
+  AGGSTAT_FLT x;
+  AGGSTAT_FLT z;
+
+  x = inp - agg->ag_val[0];
+  z = x / (AGGSTAT_FLT)(agg->ag_cnt[0] + wgt);
+
+  agg->ag_val[4] = z * (AGGSTAT_FLT)wgt;
+  agg->ag_val[5] = z;
+  agg->ag_val[6] = x * agg->ag_val[4] * (AGGSTAT_FLT)agg->ag_cnt[0];
+}
+
+/// Update the third moment with a weighted value.
+///
+/// @param[in] agg aggregate function
+/// @param[in] wgt weight
+static void
+wgt_trd(struct aggstat* agg, const AGGSTAT_INT wgt)
+{
+  agg->ag_val[2] += agg->ag_val[6] * agg->ag_val[5]
+                  * ((AGGSTAT_FLT)agg->ag_cnt[0] - (AGGSTAT_FLT)wgt)
+                  - AGGSTAT_3_0    * agg->ag_val[4] * agg->ag_val[1];
+}
+
+/// Update the fourth moment with a weighted value.
+///
+/// @param[in] agg aggregate function
+/// @param[in] wgt weight
+static void
+wgt_fth(struct aggstat* agg, const AGGSTAT_INT wgt)
+{
+  AGGSTAT_FLT x;
+  AGGSTAT_FLT y;
+
+  x = (AGGSTAT_FLT)agg->ag_cnt[0];
+  y = (AGGSTAT_FLT)wgt;
+  agg->ag_val[3] += agg->ag_val[6]
+                  * agg->ag_val[5] * agg->ag_val[5]
+                  * (x * x - x * y + y * y)
+                  + AGGSTAT_6_0 * agg->ag_val[4] * agg->ag_val[4] * agg->ag_val[1]
+                  - AGGSTAT_4_0 * agg->ag_val[4] * agg->ag_val[2];
+}
+
+/// Update the average value in the stream with a weighted value.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+/// @param[in] wgt weight
+static void
+wgt_avg(struct aggstat* agg, const AGGSTAT_FLT inp, const AGGSTAT_INT wgt)
+{
+  wgt_tmp(agg, inp, wgt);
+  fst_mnt(agg);
+}
+
+/// Update the variance of the stream with a weighted value.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+/// @param[in] wgt weight
+static void
+wgt_var(struct aggstat* agg, const AGGSTAT_FLT inp, const AGGSTAT_INT wgt)
+{
+  wgt_tmp(agg, inp, wgt);
+  fst_mnt(agg);
+  snd_mnt(agg);
+}
+
+/// Update the standard deviation of the stream with a weighted value.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+/// @param[in] wgt weight
+static void
+wgt_dev(struct aggstat* agg, const AGGSTAT_FLT inp, const AGGSTAT_INT wgt)
+{
+  wgt_var(agg, inp, wgt);
+}
+
+/// Update the skewness of the stream with a weighted value.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+/// @param[in] wgt weight
+static void
+wgt_skw(struct aggstat* agg, const AGGSTAT_FLT inp, const AGGSTAT_INT wgt)
+{
+  wgt_tmp(agg, inp, wgt);
+  fst_mnt(agg);
+  wgt_trd(agg, wgt);
+  snd_mnt(agg);
+}
+
+/// Update the kurtosis of the stream with a weighted value.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+/// @param[in] wgt weight
+static void
+wgt_krt(struct aggstat* agg, const AGGSTAT_FLT inp, const AGGSTAT_INT wgt)
+{
+  wgt_tmp(agg, inp, wgt);
+  fst_mnt(agg);
+  wgt_fth(agg, wgt);
+  wgt_trd(agg, wgt);
+  snd_mnt(agg);
+}
+
+/// Move a marker towards its desired count by any number of positions.
+///
+/// @param[in] agg aggregate
+/// @param[in] idx index of the value to readjust
+static void
+qnt_mov(struct aggstat* agg, const uint8_t idx)
+{
+  AGGSTAT_FLT dlt;
+  AGGSTAT_FLT lft;
+  AGGSTAT_FLT rgt;
+  AGGSTAT_FLT dir;
+
+  // Compute the distances to the neighbouring counts.
+  lft = (AGGSTAT_FLT)(agg->ag_cnt[idx]     - agg->ag_cnt[idx - 1]);
+  rgt = (AGGSTAT_FLT)(agg->ag_cnt[idx + 1] - agg->ag_cnt[idx]);
+
+  // Move by the whole number of positions towards the desired count, without reaching either of
+  // the neighbours.
+  dlt = agg->ag_val[idx + 5] - (AGGSTAT_FLT)agg->ag_cnt[idx];
+  if (dlt >= AGGSTAT_1_0) {
+    dir = AGGSTAT_FMIN(dlt, rgt - AGGSTAT_1_0);
+  } else if (dlt <= -AGGSTAT_1_0) {
+    dir = AGGSTAT_FMAX(dlt, AGGSTAT_1_0 - lft);
+  } else {
+    return;
+  }
+
+  (void)AGGSTAT_MODF(dir, &dir);
+  if (dir == AGGSTAT_0_0) {
+    return;
+  }
+
+  PUT_CTR(ac_mov, 1);
+  agg->ag_val[idx] = qnt_est(agg, idx, dir, lft, rgt);
+  if (dir > AGGSTAT_0_0) {
+    agg->ag_cnt[idx] += (AGGSTAT_INT)dir;
+  } else {
+    agg->ag_cnt[idx] -= (AGGSTAT_INT)-dir;
+  }
+}
+
+/// Update the p-quantile of the stream with a weighted value.
+///
+/// A weighted value is equivalent to the given number of repetitions of the value. The initial
+/// five values are inserted one by one, whereas afterwards the weight is applied in steps of at
+/// most a sixteenth of the values so far, in which the counts are incremented at once and the
+/// markers move by multiple positions. The markers thus reach the same positions as under the
+/// repeated application, and their heights are interpolated over steps short enough to follow the
+/// parabola. A weight that exceeds all previous values takes a number of steps logarithmic in
+/// their ratio.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+/// @param[in] wgt weight
+static void
+wgt_qnt(struct aggstat* agg, const AGGSTAT_FLT inp, const AGGSTAT_INT wgt)
+{
+  AGGSTAT_FLT flt;
+  AGGSTAT_INT rem;
+  AGGSTAT_INT stp;
+
+  // Perform the initial insertions and steps of a single value one by one, as if the value was
+  // applied repeatedly, so that a unit weight yields the result of `aggstat_put`.
+  rem = wgt;
+  while (rem > 0) {
+    stp = agg->ag_cnt[4] < 5 ? 1 : agg->ag_cnt[4] / PUT_STP;
+    stp = stp > 1 ? stp : 1;
+    stp = stp < rem ? stp : rem;
+    rem -= stp;
+
+    if (stp == 1) {
+      put_qnt(agg, inp);
+      agg->ag_cnt[0] += 1;
+      continue;
+    }
+
+    // Increment the counts of all markers above the value.
+    agg->ag_cnt[1] += stp * (inp < agg->ag_val[1]);
+    agg->ag_cnt[2] += stp * (inp < agg->ag_val[2]);
+    agg->ag_cnt[3] += stp * (inp < agg->ag_val[3]);
+    agg->ag_cnt[4] += stp;
+
+    // Adjust minimum and maximum.
+    agg->ag_val[0] = inp < agg->ag_val[0] ? inp : agg->ag_val[0];
+    agg->ag_val[4] = inp > agg->ag_val[4] ? inp : agg->ag_val[4];
+
+    // Increment the desired counts.
+    flt = (AGGSTAT_FLT)stp;
+    agg->ag_val[6] += flt * agg->ag_par / AGGSTAT_2_0;
+    agg->ag_val[7] += flt * agg->ag_par;
+    agg->ag_val[8] += flt * (AGGSTAT_1_0 + agg->ag_par) / AGGSTAT_2_0;
+    agg->ag_val[9] += flt;
+
+    // Adjust the middle values, the upper ones first when they move up and the lower ones first
+    // when they move down, so that no marker is blocked by a neighbour that is yet to move.
+    qnt_mov(agg, 3);
+    qnt_mov(agg, 2);
+    qnt_mov(agg, 1);
+    qnt_mov(agg, 1);
+    qnt_mov(agg, 2);
+    qnt_mov(agg, 3);
+  }
+}
+
+/// Update the median of the stream with a weighted value.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+/// @param[in] wgt weight
+static void
+wgt_med(struct aggstat* agg, const AGGSTAT_FLT inp, const AGGSTAT_INT wgt)
+{
+  wgt_qnt(agg, inp, wgt);
+}
+
+/// Update the time-weighted average of the stream with a weighted value.
+///
+/// The value is held for the number of positions given by its weight.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+/// @param[in] wgt weight
+static void
+wgt_twa(struct aggstat* agg, const AGGSTAT_FLT inp, const AGGSTAT_INT wgt)
+{
+  put_twa(agg, inp);
+  agg->ag_val[1] += (AGGSTAT_FLT)(wgt - 1);
+  agg->ag_val[3] += (AGGSTAT_FLT)(wgt - 1) * inp;
+}
+
+/// Update the time integral of the stream with a weighted value.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+/// @param[in] wgt weight
+static void
+wgt_itg(struct aggstat* agg, const AGGSTAT_FLT inp, const AGGSTAT_INT wgt)
+{
+  wgt_twa(agg, inp, wgt);
+}
+
+/// Update the rate of change of the stream with a weighted value.
+///
+/// @param[in] agg aggregate function
+/// @param[in] inp input value
+/// @param[in] wgt weight
+static void
+wgt_rat(struct aggstat* agg, const AGGSTAT_FLT inp, const AGGSTAT_INT wgt)
+{
+  wgt_twa(agg, inp, wgt);
+}
+
 /// Function table for put_* functions based on ag_fnc.
 static void (*put_fnc[])(struct aggstat*, const AGGSTAT_FLT) = {
   NULL,
@@ -395,7 +838,31 @@ static void (*put_fnc[])(struct aggstat*, const AGGSTAT_FLT) = {
   put_skw,
   put_krt,
   put_qnt,
-  put_med
+  put_med,
+  put_twa,
+  put_itg,
+  put_rat
+};
+
+/// Function table for wgt_* functions based on ag_fnc.
+static void (*wgt_fnc[])(struct aggstat*, const AGGSTAT_FLT, const AGGSTAT_INT) = {
+  NULL,
+  wgt_fst,
+  wgt_lst,
+  wgt_cnt,
+  wgt_sum,
+  wgt_min,
+  wgt_max,
+  wgt_avg,
+  wgt_var,
+  wgt_dev,
+  wgt_skw,
+  wgt_krt,
+  wgt_qnt,
+  wgt_med,
+  wgt_twa,
+  wgt_itg,
+  wgt_rat
 };
 
 /// Update the aggregated value.
@@ -405,6 +872,158 @@ static void (*put_fnc[])(struct aggstat*, const AGGSTAT_FLT) = {
 void
 aggstat_put(struct aggstat* agg, const AGGSTAT_FLT inp)
 {
+  PUT_INP(inp);
   put_fnc[agg->ag_fnc](agg, inp);
   agg->ag_cnt[0] += 1;
 }
+
+/// Update the aggregated value with an array of values.
+///
+/// The function is selected only once for the whole array.
+///
+/// @param[in] agg aggregated value
+/// @param[in] arr array of input values
+/// @param[in] len length of the array
+void
+aggstat_put_arr(struct aggstat    *restrict agg,
+                const AGGSTAT_FLT *restrict arr,
+                const AGGSTAT_INT           len)
+{
+  void      (*fnc)(struct aggstat*, const AGGSTAT_FLT);
+  AGGSTAT_INT idx;
+
+  fnc = put_fnc[agg->ag_fnc];
+  for (idx = 0; idx < len; idx += 1) {
+    PUT_INP(arr[idx]);
+    fnc(agg, arr[idx]);
+    agg->ag_cnt[0] += 1;
+  }
+}
+
+/// Update the aggregated value with a weighted value.
+///
+/// The weight denotes the number of occurrences of the value, and the update is equivalent to the
+/// repeated application of `aggstat_put`, alas in constant time. The streaming quantile and median
+/// approximate the repeated application: the markers reach the same positions, whereas their
+/// heights differ by up to 0.5 % of the range of the values for weights of up to a hundred, and by
+/// up to 5 % when a few weights dominate the stream.
+///
+/// @param[in] agg aggregated value
+/// @param[in] inp input value
+/// @param[in] wgt weight
+void
+aggstat_put_w(struct aggstat* agg, const AGGSTAT_FLT inp, const AGGSTAT_INT wgt)
+{
+  if (wgt == 0) {
+    return;
+  }
+
+  // The quantile functions count the values themselves, as their initial values are inserted one
+  // by one.
+  PUT_INP(inp);
+  wgt_fnc[agg->ag_fnc](agg, inp, wgt);
+  if (agg->ag_fnc != AGGSTAT_FNC_QNT && agg->ag_fnc != AGGSTAT_FNC_MED) {
+    agg->ag_cnt[0] += wgt;
+  }
+}
+
+/// Update the aggregated value with a timestamped value.
+///
+/// The time-weighted average, time integral and rate of change functions use the timestamp, whereas
+/// all other functions ignore it. Timestamps are expected to be non-decreasing.
+///
+/// @param[in] agg aggregated value
+/// @param[in] tim timestamp
+/// @param[in] inp input value
+void
+aggstat_put_t(struct aggstat* agg, const AGGSTAT_FLT tim, const AGGSTAT_FLT inp)
+{
+  if (agg->ag_fnc < AGGSTAT_FNC_TWA) {
+    aggstat_put(agg, inp);
+    return;
+  }
+
+  PUT_INP(inp);
+  put_tim(agg, tim, inp);
+  agg->ag_cnt[0] += 1;
+}
+
+/// Update the aggregated value with arrays of timestamps and values.
+///
+/// The state of the time-weighted functions is kept in local variables for the duration of the
+/// loop, so that the update does not round-trip through memory for each value.
+///
+/// @param[in] agg aggregated value
+/// @param[in] tim array of timestamps
+/// @param[in] arr array of input values
+/// @param[in] len length of the arrays
+void
+aggstat_put_t_arr(struct aggstat    *restrict agg,
+                  const AGGSTAT_FLT *restrict tim,
+                  const AGGSTAT_FLT *restrict arr,
+                  const AGGSTAT_INT           len)
+{
+  AGGSTAT_INT idx;
+  AGGSTAT_FLT lst;
+  AGGSTAT_FLT val;
+  AGGSTAT_FLT itg;
+  AGGSTAT_FLT dur;
+
+  if (len == 0) {
+    return;
+  }
+
+  if (agg->ag_fnc < AGGSTAT_FNC_TWA) {
+    for (idx = 0; idx < len; idx += 1) {
+      aggstat_put(agg, arr[idx]);
+    }
+    return;
+  }
+
+  // Start the stream with the first value.
+  PUT_INP(arr[0]);
+  put_tim(agg, tim[0], arr[0]);
+
+  lst = agg->ag_val[1];
+  val = agg->ag_val[2];
+  itg = agg->ag_val[3];
+
+  for (idx = 1; idx < len; idx += 1) {
+    PUT_INP(arr[idx]);
+    dur  = tim[idx] - lst;
+    dur  = dur > AGGSTAT_0_0 ? dur : AGGSTAT_0_0;
+    lst += dur;
+    itg += val * dur;
+    val  = arr[idx];
+  }
+
+  agg->ag_val[1]  = lst;
+  agg->ag_val[2]  = val;
+  agg->ag_val[3]  = itg;
+  agg->ag_cnt[0] += len;
+}
+
+/// Obtain the counters of internal events of the calling thread.
+///
+/// The counters are always zero unless the library was compiled with the `AGGSTAT_CTR` macro set
+/// to 1.
+///
+/// @param[out] ctr counters
+void
+aggstat_ctr_get(struct aggstat_ctr* ctr)
+{
+#if AGGSTAT_CTR == 1
+  *ctr = put_ctr;
+#else
+  (void)memset(ctr, 0, sizeof(*ctr));
+#endif
+}
+
+/// Reset the counters of internal events of the calling thread.
+void
+aggstat_ctr_rst(void)
+{
+#if AGGSTAT_CTR == 1
+  (void)memset(&put_ctr, 0, sizeof(put_ctr));
+#endif
+}
@@ -0,0 +1,314 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include "agg.h"
+
+
+/// Obtain the bucket of a level that is present in its ring.
+/// @return bucket, or NULL if the bucket is not present
+///
+/// @param[in] rol rollup
+/// @param[in] lvl level
+/// @param[in] bid bucket identifier
+static struct aggstat*
+rol_at(const struct aggstat_rol* rol, const uint8_t lvl, const uint64_t bid)
+{
+  if (bid > rol->ar_top[lvl] || bid + rol->ar_len[lvl] <= rol->ar_top[lvl]) {
+    return NULL;
+  }
+
+  return &rol->ar_bkt[lvl][bid % rol->ar_len[lvl]];
+}
+
+/// Determine the end of the time span whose values a bucket holds.
+/// @return end in buckets of the finest level, or zero if the bucket is not present
+///
+/// A bucket of a coarser level holds the values of its buckets of the preceding level that were
+/// closed. A bucket that is newer than the newest bucket of its level is empty.
+///
+/// @param[in] rol rollup
+/// @param[in] lvl level
+/// @param[in] bid bucket identifier
+static uint64_t
+rol_end(const struct aggstat_rol* rol, const uint8_t lvl, const uint64_t bid)
+{
+  uint64_t end;
+  uint64_t cls;
+
+  if (bid <= rol->ar_top[lvl] && rol_at(rol, lvl, bid) == NULL) {
+    return 0;
+  }
+
+  end = (bid + 1) * (rol->ar_gra[lvl] / rol->ar_gra[0]);
+  if (lvl > 0) {
+    cls = rol->ar_cls[lvl - 1] * (rol->ar_gra[lvl - 1] / rol->ar_gra[0]);
+    end = end < cls ? end : cls;
+  }
+
+  return end;
+}
+
+/// Advance the ring of a level to a bucket, resetting the buckets that it reuses.
+/// @return bucket, or NULL if the bucket is no longer present
+///
+/// @param[in] rol rollup
+/// @param[in] lvl level
+/// @param[in] bid bucket identifier
+static struct aggstat*
+rol_adv(struct aggstat_rol* rol, const uint8_t lvl, const uint64_t bid)
+{
+  struct aggstat* bkt;
+  uint64_t        idx;
+
+  if (bid > rol->ar_top[lvl]) {
+    idx = bid - rol->ar_top[lvl] < rol->ar_len[lvl] ? rol->ar_top[lvl] + 1
+                                                    : bid + 1 - rol->ar_len[lvl];
+    for (; idx <= bid; idx += 1) {
+      bkt = &rol->ar_bkt[lvl][idx % rol->ar_len[lvl]];
+      aggstat_new(bkt, rol->ar_fnc, rol->ar_par);
+    }
+
+    rol->ar_top[lvl] = bid;
+  }
+
+  return rol_at(rol, lvl, bid);
+}
+
+/// Close the buckets whose end, extended by the tolerated lateness, has passed, and merge them into
+/// the buckets of the coarser level.
+///
+/// Buckets newer than the newest bucket of a level, as well as buckets that are no longer present
+/// in its ring, are empty and only skipped.
+///
+/// @param[in] rol rollup
+static void
+rol_cls(struct aggstat_rol* rol)
+{
+  struct aggstat* src;
+  struct aggstat* dst;
+  uint64_t        lim;
+  uint64_t        bid;
+  uint8_t         lvl;
+
+  for (lvl = 0; lvl + 1 < rol->ar_cnt; lvl += 1) {
+    if (rol->ar_wtm < rol->ar_lat) {
+      return;
+    }
+
+    lim = (rol->ar_wtm - rol->ar_lat) / rol->ar_gra[lvl];
+    if (lim <= rol->ar_cls[lvl]) {
+      continue;
+    }
+
+    bid = rol->ar_cls[lvl];
+    if (bid + rol->ar_len[lvl] <= rol->ar_top[lvl]) {
+      bid = rol->ar_top[lvl] + 1 - rol->ar_len[lvl];
+    }
+
+    for (; bid < lim && bid <= rol->ar_top[lvl]; bid += 1) {
+      src = rol_at(rol, lvl, bid);
+      if (src->ag_cnt[0] == 0) {
+        continue;
+      }
+
+      dst = rol_adv(rol, lvl + 1, bid * rol->ar_gra[lvl] / rol->ar_gra[lvl + 1]);
+      if (dst != NULL) {
+        (void)aggstat_mrg(dst, src);
+      }
+    }
+
+    rol->ar_cls[lvl] = lim;
+  }
+}
+
+/// Initialise the rollup.
+/// @return success/failure indication
+///
+/// Each level is a ring of buckets of a fixed granularity, e.g. 120 buckets of a second, 120
+/// buckets of a minute and 48 buckets of an hour. The granularity of each level must be a multiple
+/// of the granularity of the preceding level. The rings are provided by the caller as a single
+/// array of buckets, in the order of the levels. Values can arrive late by up to the tolerated
+/// lateness, and thus the ring of each level but the last must span the lateness and one more
+/// bucket. The quantile and median functions are not supported, as their buckets can not be
+/// merged.
+///
+/// @param[in] rol rollup
+/// @param[in] fnc function type
+/// @param[in] par function parameter
+/// @param[in] bkt buckets of all levels
+/// @param[in] gra granularity of each level
+/// @param[in] len number of buckets of each level
+/// @param[in] cnt number of levels
+/// @param[in] lat tolerated lateness
+bool
+aggstat_rol_new(struct aggstat_rol *restrict rol,
+                const uint8_t                fnc,
+                const AGGSTAT_FLT            par,
+                struct aggstat     *restrict bkt,
+                const uint64_t     *restrict gra,
+                const uint64_t     *restrict len,
+                const uint8_t                cnt,
+                const uint64_t               lat)
+{
+  uint64_t idx;
+  uint8_t  lvl;
+
+  if (fnc == AGGSTAT_FNC_QNT || fnc == AGGSTAT_FNC_MED) {
+    return false;
+  }
+
+  if (cnt == 0 || cnt > AGGSTAT_ROL_LVL) {
+    return false;
+  }
+
+  for (lvl = 0; lvl < cnt; lvl += 1) {
+    if (gra[lvl] == 0 || len[lvl] == 0) {
+      return false;
+    }
+
+    if (lvl > 0 && (gra[lvl] <= gra[lvl - 1] || gra[lvl] % gra[lvl - 1] != 0)) {
+      return false;
+    }
+
+    if (lvl + 1 < cnt && (len[lvl] - 1) * gra[lvl] < lat) {
+      return false;
+    }
+  }
+
+  rol->ar_fnc = fnc;
+  rol->ar_cnt = cnt;
+  rol->ar_par = par;
+  rol->ar_lat = lat;
+  rol->ar_wtm = 0;
+  rol->ar_fst = UINT64_MAX;
+
+  for (lvl = 0; lvl < cnt; lvl += 1) {
+    rol->ar_gra[lvl] = gra[lvl];
+    rol->ar_len[lvl] = len[lvl];
+    rol->ar_top[lvl] = 0;
+    rol->ar_cls[lvl] = 0;
+    rol->ar_bkt[lvl] = bkt;
+
+    for (idx = 0; idx < len[lvl]; idx += 1) {
+      aggstat_new(&bkt[idx], fnc, par);
+    }
+
+    bkt += len[lvl];
+  }
+
+  return true;
+}
+
+/// Update the rollup with a timestamped value.
+/// @return success/failure indication
+///
+/// The value is added to the bucket of the finest level, and the buckets that closed since the
+/// previous update are merged into the coarser levels. The function fails if the value is older
+/// than the newest timestamp by more than the tolerated lateness.
+///
+/// @param[in] rol rollup
+/// @param[in] tim timestamp
+/// @param[in] val value
+bool
+aggstat_rol_put(struct aggstat_rol* rol, const uint64_t tim, const AGGSTAT_FLT val)
+{
+  struct aggstat* bkt;
+  uint64_t        bid;
+
+  if (tim + rol->ar_lat < rol->ar_wtm) {
+    return false;
+  }
+
+  if (tim > rol->ar_wtm) {
+    rol->ar_wtm = tim;
+    rol_cls(rol);
+  }
+
+  bid = tim / rol->ar_gra[0];
+  bkt = rol_adv(rol, 0, bid);
+  if (bkt == NULL) {
+    return false;
+  }
+
+  rol->ar_fst = bid < rol->ar_fst ? bid : rol->ar_fst;
+  aggstat_put_t(bkt, (AGGSTAT_FLT)tim, val);
+  return true;
+}
+
+/// Obtain the aggregated value of the buckets that intersect a time range.
+/// @return success/failure indication
+///
+/// The range is covered from its start by the coarsest buckets that lie within it and are present
+/// in their ring. A bucket that is not complete holds the values of its closed buckets of the
+/// preceding level, and the finer levels cover the rest. Thus a range of a day with the levels of
+/// seconds, minutes and hours combines 24 hourly buckets, a minute bucket and the seconds within
+/// the tolerated lateness. Parts of the range that are no longer present in the finer levels are
+/// widened to the containing bucket of the finest level that retains them, and the function fails
+/// if no level retains them.
+///
+/// @param[in]  rol rollup
+/// @param[in]  beg start of the range
+/// @param[in]  end end of the range (exclusive)
+/// @param[out] val aggregated value
+bool
+aggstat_rol_get(const struct aggstat_rol *restrict rol,
+                const uint64_t                     beg,
+                const uint64_t                     end,
+                AGGSTAT_FLT              *restrict val)
+{
+  struct aggstat  agg;
+  struct aggstat* bkt;
+  uint64_t        pos;
+  uint64_t        lst;
+  uint64_t        nxt;
+  uint64_t        rat;
+  uint8_t         lvl;
+
+  aggstat_new(&agg, rol->ar_fnc, rol->ar_par);
+
+  // Limit the range to the buckets of the finest level that contain values.
+  pos = beg / rol->ar_gra[0];
+  lst = end / rol->ar_gra[0] + (end % rol->ar_gra[0] != 0);
+  pos = pos > rol->ar_fst ? pos : rol->ar_fst;
+  lst = lst < rol->ar_top[0] + 1 ? lst : rol->ar_top[0] + 1;
+
+  while (pos < lst) {
+    // Select the coarsest bucket that starts at the position and whose values lie within the range.
+    for (lvl = rol->ar_cnt; lvl > 0; lvl -= 1) {
+      rat = rol->ar_gra[lvl - 1] / rol->ar_gra[0];
+      if (pos % rat == 0) {
+        nxt = rol_end(rol, lvl - 1, pos / rat);
+        if (nxt > pos && nxt <= lst) {
+          break;
+        }
+      }
+    }
+
+    // Otherwise widen the range to the finest bucket that contains the position.
+    if (lvl == 0) {
+      for (lvl = 1; lvl <= rol->ar_cnt; lvl += 1) {
+        rat = rol->ar_gra[lvl - 1] / rol->ar_gra[0];
+        nxt = rol_end(rol, lvl - 1, pos / rat);
+        if (nxt > pos) {
+          break;
+        }
+      }
+
+      if (lvl > rol->ar_cnt) {
+        return false;
+      }
+    }
+
+    bkt = rol_at(rol, lvl - 1, pos / rat);
+    if (bkt != NULL) {
+      (void)aggstat_mrg(&agg, bkt);
+    }
+
+    pos = nxt;
+  }
+
+  return aggstat_get(&agg, val);
+}
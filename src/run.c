@@ -8,6 +8,7 @@
 #include <math.h>
 
 #include "agg.h"
+#include "sel.h"
 
 
 /// Compute the first value in the stream given the full stream information.
@@ -323,24 +324,38 @@ run_krt(      AGGSTAT_FLT *restrict out,
   return true;
 }
 
-/// Compare two elements of the stream.
-/// @return comparison
-/// @retval 0 elements are equal
-/// @retval 1 first element is greater
-/// @retval -1 second element is greater
+/// Interpolate the p-quantile between the order statistics of the stream.
 ///
-/// @param[in] a first element
-/// @param[in] b second element
-static int
-qnt_cmp(const void* a, const void* b)
+/// The array must contain the order statistics at the integral part of the decimal index and at
+/// the following index in their sorted positions, which is the case for a sorted array.
+///
+/// @param[out] out p-quantile of values
+/// @param[in]  arr array representing the stream
+/// @param[in]  len array length
+/// @param[in]  par parameter
+static void
+qnt_itp(      AGGSTAT_FLT *restrict out,
+        const AGGSTAT_FLT *restrict arr,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
 {
-  AGGSTAT_FLT x;
-  AGGSTAT_FLT y;
+  AGGSTAT_INT idx;
+  AGGSTAT_FLT inp;
+  AGGSTAT_FLT frp;
 
-  x = *(AGGSTAT_FLT*)a;
-  y = *(AGGSTAT_FLT*)b;
+  // Select the appropriate field. This is achieved by finding the precise decimal index, followed
+  // by decomposition of the number into the integral and fractional parts.
+  frp = AGGSTAT_MODF((len - 1) * par, &inp);
+  idx = (AGGSTAT_INT)inp;
 
-  return (x > y) - (x < y);
+  // Perform linear interpolation between the two candidate values. The first of the values
+  // corresponds to the integral part, whereas the parameter for the linear interpolation is the
+  // fractional part.
+  if (idx == (len - 1)) {
+    *out = arr[idx];
+  } else {
+    *out = arr[idx] + frp * (arr[idx + 1] - arr[idx]);
+  }
 }
 
 /// Compute the p-quantile of the values in the stream given full stream information.
@@ -356,10 +371,6 @@ run_qnt(      AGGSTAT_FLT *restrict out,
         const AGGSTAT_INT           len,
         const AGGSTAT_FLT           par)
 {
-  AGGSTAT_INT idx;
-  AGGSTAT_FLT inp;
-  AGGSTAT_FLT frp;
-
   // Validate the stream length.
   if (len == 0) {
     return false;
@@ -371,22 +382,9 @@ run_qnt(      AGGSTAT_FLT *restrict out,
   }
 
   // Sort the stream.
-  (void)qsort((void*)arr, len, sizeof(AGGSTAT_FLT), qnt_cmp);
-
-  // Select the appropriate field. This is achieved by finding the precise decimal index, followed
-  // by decomposition of the number into the integral and fractional parts.
-  frp = AGGSTAT_MODF((len - 1) * par, &inp);
-  idx = (AGGSTAT_INT)inp;
-
-  // Perform linear interpolation between the two candidate values. The first of the values
-  // corresponds to the integral part, whereas the parameter for the linear interpolation is the
-  // fractional part.
-  if (idx == (len - 1)) {
-    *out = arr[idx];
-  } else {
-    *out = arr[idx] + frp * (arr[idx + 1] - arr[idx]);
-  }
+  (void)qsort((void*)arr, len, sizeof(AGGSTAT_FLT), sel_cmp);
 
+  qnt_itp(out, arr, len, par);
   return true;
 }
 
@@ -407,6 +405,91 @@ run_med(      AGGSTAT_FLT *restrict out,
   return run_qnt(out, arr, len, AGGSTAT_0_5);
 }
 
+/// Compute a time-weighted aggregate of the values in the stream using the streaming algorithm.
+/// @return success/failure indication
+///
+/// @param[out] out aggregate of values
+/// @param[in]  tim array of timestamps (optional)
+/// @param[in]  arr array representing the stream
+/// @param[in]  len array length
+/// @param[in]  fnc aggregate function
+static bool
+run_tim(      AGGSTAT_FLT *restrict out,
+        const AGGSTAT_FLT *restrict tim,
+        const AGGSTAT_FLT *restrict arr,
+        const AGGSTAT_INT           len,
+        const uint8_t               fnc)
+{
+  struct aggstat agg;
+  AGGSTAT_INT    idx;
+
+  if (len == 0) {
+    return false;
+  }
+
+  aggstat_new(&agg, fnc, AGGSTAT_0_0);
+  if (tim == NULL) {
+    for (idx = 0; idx < len; idx += 1) {
+      aggstat_put(&agg, arr[idx]);
+    }
+  } else {
+    aggstat_put_t_arr(&agg, tim, arr, len);
+  }
+
+  return aggstat_get(&agg, out);
+}
+
+/// Compute the time-weighted average of the values in the stream given full stream information.
+/// @return success/failure indication
+///
+/// @param[out] out time-weighted average of values
+/// @param[in]  arr array representing the stream
+/// @param[in]  len array length
+/// @param[in]  par parameter (unused)
+static bool
+run_twa(      AGGSTAT_FLT *restrict out,
+        const AGGSTAT_FLT *restrict arr,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  (void)par;
+  return run_tim(out, NULL, arr, len, AGGSTAT_FNC_TWA);
+}
+
+/// Compute the time integral of the values in the stream given full stream information.
+/// @return success/failure indication
+///
+/// @param[out] out time integral of values
+/// @param[in]  arr array representing the stream
+/// @param[in]  len array length
+/// @param[in]  par parameter (unused)
+static bool
+run_itg(      AGGSTAT_FLT *restrict out,
+        const AGGSTAT_FLT *restrict arr,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  (void)par;
+  return run_tim(out, NULL, arr, len, AGGSTAT_FNC_ITG);
+}
+
+/// Compute the rate of change of the values in the stream given full stream information.
+/// @return success/failure indication
+///
+/// @param[out] out rate of change of values
+/// @param[in]  arr array representing the stream
+/// @param[in]  len array length
+/// @param[in]  par parameter (unused)
+static bool
+run_rat(      AGGSTAT_FLT *restrict out,
+        const AGGSTAT_FLT *restrict arr,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  (void)par;
+  return run_tim(out, NULL, arr, len, AGGSTAT_FNC_RAT);
+}
+
 /// Function table for push_* functions based on ag_typ.
 static bool (*run_fnc[])(AGGSTAT_FLT*, const AGGSTAT_FLT*, const AGGSTAT_INT, const AGGSTAT_FLT) = {
   NULL,
@@ -422,7 +505,10 @@ static bool (*run_fnc[])(AGGSTAT_FLT*, const AGGSTAT_FLT*, const AGGSTAT_INT, co
   run_skw,
   run_krt,
   run_qnt,
-  run_med
+  run_med,
+  run_twa,
+  run_itg,
+  run_rat
 };
 
 /// Compute an aggregate of a stream with full information.
@@ -442,3 +528,963 @@ aggstat_run(      AGGSTAT_FLT *restrict val,
 {
   return run_fnc[fnc](val, arr, len, par);
 }
+
+/// Highest order of the moments required by each function in the fused computation, based on
+/// ag_fnc. The first order denotes the pass that computes the sum, minimum and maximum.
+static const uint8_t many_ord[] = {
+  0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 3, 4, 0, 0, 0, 0, 0
+};
+
+/// Determine the parameter of a quantile request.
+/// @return success/failure indication
+///
+/// @param[out] out quantile parameter
+/// @param[in]  fnc aggregate function
+/// @param[in]  par parameter
+static bool
+many_qnt(AGGSTAT_FLT* out, const uint8_t fnc, const AGGSTAT_FLT par)
+{
+  if (fnc == AGGSTAT_FNC_MED) {
+    *out = AGGSTAT_0_5;
+    return true;
+  }
+
+  *out = par;
+  return fnc == AGGSTAT_FNC_QNT && par >= AGGSTAT_0_0 && par <= AGGSTAT_1_0;
+}
+
+/// Determine whether any quantile request needs an order statistic within a range.
+/// @return decision
+///
+/// @param[in] lop start of the range
+/// @param[in] hip end of the range (exclusive)
+/// @param[in] len array length
+/// @param[in] fnc array of aggregate functions
+/// @param[in] par array of parameters
+/// @param[in] cnt number of requests
+static bool
+sel_has(const size_t                lop,
+        const size_t                hip,
+        const AGGSTAT_INT           len,
+        const uint8_t     *restrict fnc,
+        const AGGSTAT_FLT *restrict par,
+        const size_t                cnt)
+{
+  AGGSTAT_FLT qnt;
+  AGGSTAT_FLT inp;
+  size_t      req;
+  size_t      idx;
+
+  for (req = 0; req < cnt; req += 1) {
+    if (many_qnt(&qnt, fnc[req], par[req]) == false) {
+      continue;
+    }
+
+    (void)AGGSTAT_MODF((len - 1) * qnt, &inp);
+    idx = (size_t)inp;
+    if (idx + 1 >= lop && idx < hip) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/// Move all order statistics required by the quantile requests to their sorted positions.
+///
+/// The ranges are partitioned recursively as in quickselect, but both parts are followed if they
+/// contain a required position, and all other parts are left unordered. This selects multiple
+/// quantiles in time proportional to the array length times the logarithm of their count. The
+/// recursion falls back to sorting once its depth exceeds the limit.
+///
+/// @param[in] arr array
+/// @param[in] lop start of the range
+/// @param[in] hip end of the range (exclusive)
+/// @param[in] dep remaining recursion depth
+/// @param[in] len array length
+/// @param[in] fnc array of aggregate functions
+/// @param[in] par array of parameters
+/// @param[in] cnt number of requests
+static void
+sel_mul(      AGGSTAT_FLT *restrict arr,
+        const size_t                lop,
+        const size_t                hip,
+        const uint32_t              dep,
+        const AGGSTAT_INT           len,
+        const uint8_t     *restrict fnc,
+        const AGGSTAT_FLT *restrict par,
+        const size_t                cnt)
+{
+  size_t mid;
+
+  if (sel_has(lop, hip, len, fnc, par, cnt) == false) {
+    return;
+  }
+
+  if (hip - lop <= SEL_INS) {
+    sel_ins(arr, lop, hip);
+    return;
+  }
+
+  if (dep == 0) {
+    (void)qsort((void*)(arr + lop), hip - lop, sizeof(AGGSTAT_FLT), sel_cmp);
+    return;
+  }
+
+  mid = sel_prt(arr, lop, hip);
+  sel_mul(arr, lop,     mid + 1, dep - 1, len, fnc, par, cnt);
+  sel_mul(arr, mid + 1, hip,     dep - 1, len, fnc, par, cnt);
+}
+
+/// Compute an aggregate from the results of the fused passes.
+/// @return success/failure indication
+///
+/// The quantile and median are obtained from the array, which must contain their order statistics
+/// in the sorted positions, and all other functions that do not depend on the fused passes are
+/// computed directly from the array.
+///
+/// @param[out] out aggregate of the stream
+/// @param[in]  mnt sum, minimum, maximum, mean and the second, third and fourth central moment sums
+/// @param[in]  arr array representing the stream
+/// @param[in]  len length of the stream
+/// @param[in]  fnc aggregate function
+/// @param[in]  par parameter
+static bool
+many_get(      AGGSTAT_FLT *restrict out,
+         const AGGSTAT_FLT *restrict mnt,
+         const AGGSTAT_FLT *restrict arr,
+         const AGGSTAT_INT           len,
+         const uint8_t               fnc,
+         const AGGSTAT_FLT           par)
+{
+  AGGSTAT_FLT dev;
+  AGGSTAT_FLT qnt;
+
+  if (fnc == AGGSTAT_FNC_SUM) {
+    *out = mnt[0];
+    return true;
+  }
+
+  if (len == 0) {
+    return run_fnc[fnc](out, arr, len, par);
+  }
+
+  if (fnc == AGGSTAT_FNC_QNT || fnc == AGGSTAT_FNC_MED) {
+    if (many_qnt(&qnt, fnc, par) == false) {
+      return false;
+    }
+
+    qnt_itp(out, arr, len, qnt);
+    return true;
+  }
+
+  if (many_ord[fnc] == 0) {
+    return run_fnc[fnc](out, arr, len, par);
+  }
+
+  dev = len > 1 ? AGGSTAT_SQRT(mnt[4] / ((AGGSTAT_FLT)len - AGGSTAT_1_0)) : AGGSTAT_0_0;
+  switch (fnc) {
+    case AGGSTAT_FNC_MIN:
+      *out = mnt[1];
+      return true;
+
+    case AGGSTAT_FNC_MAX:
+      *out = mnt[2];
+      return true;
+
+    case AGGSTAT_FNC_AVG:
+      *out = mnt[3];
+      return true;
+
+    case AGGSTAT_FNC_VAR:
+      *out = dev * dev;
+      return true;
+
+    case AGGSTAT_FNC_DEV:
+      *out = dev;
+      return true;
+
+    case AGGSTAT_FNC_SKW:
+      *out = mnt[5] / (AGGSTAT_FLT)len / (dev * dev * dev);
+      return len > 1;
+
+    default:
+      *out = mnt[6] / (AGGSTAT_FLT)len / (dev * dev * dev * dev) - AGGSTAT_3_0;
+      return len > 1;
+  }
+}
+
+/// Compute multiple aggregates of a stream with full information.
+/// @return success/failure indication
+///
+/// The requests share their work: a single pass computes the sum, minimum and maximum, a second
+/// pass computes all central moments, and a single multi-selection places the order statistics of
+/// all quantiles and medians. The results are equal to those of `aggstat_run` up to rounding
+/// errors. The function fails if any of the requests fails.
+///
+/// @param[out] val array of aggregates of the stream
+/// @param[in]  arr array representing the stream (reordered if any quantile is requested)
+/// @param[in]  len length of the stream
+/// @param[in]  fnc array of aggregate functions
+/// @param[in]  par array of parameters
+/// @param[in]  cnt number of requests
+bool
+aggstat_run_many(      AGGSTAT_FLT *restrict val,
+                       AGGSTAT_FLT *restrict arr,
+                 const AGGSTAT_INT           len,
+                 const uint8_t     *restrict fnc,
+                 const AGGSTAT_FLT *restrict par,
+                 const size_t                cnt)
+{
+  AGGSTAT_FLT mnt[7];
+  AGGSTAT_FLT qnt;
+  AGGSTAT_FLT x;
+  AGGSTAT_FLT y;
+  AGGSTAT_INT idx;
+  size_t      req;
+  uint8_t     ord;
+  uint32_t    dep;
+  bool        sel;
+  bool        ret;
+
+  // Determine the shared work.
+  ord = 0;
+  sel = false;
+  for (req = 0; req < cnt; req += 1) {
+    if (fnc[req] == 0 || fnc[req] > AGGSTAT_FNC_RAT) {
+      return false;
+    }
+
+    ord  = many_ord[fnc[req]] > ord ? many_ord[fnc[req]] : ord;
+    sel |= many_qnt(&qnt, fnc[req], par[req]);
+  }
+
+  // First pass: sum, minimum and maximum.
+  mnt[0] = AGGSTAT_0_0;
+  mnt[1] = len > 0 ? arr[0] : AGGSTAT_0_0;
+  mnt[2] = mnt[1];
+  if (ord > 0) {
+    for (idx = 0; idx < len; idx += 1) {
+      mnt[0] += arr[idx];
+      mnt[1]  = arr[idx] < mnt[1] ? arr[idx] : mnt[1];
+      mnt[2]  = arr[idx] > mnt[2] ? arr[idx] : mnt[2];
+    }
+  }
+  mnt[3] = len > 0 ? mnt[0] / (AGGSTAT_FLT)len : AGGSTAT_0_0;
+
+  // Second pass: central moments.
+  mnt[4] = AGGSTAT_0_0;
+  mnt[5] = AGGSTAT_0_0;
+  mnt[6] = AGGSTAT_0_0;
+  if (ord == 2) {
+    for (idx = 0; idx < len; idx += 1) {
+      x       = arr[idx] - mnt[3];
+      mnt[4] += x * x;
+    }
+  } else if (ord > 2) {
+    for (idx = 0; idx < len; idx += 1) {
+      x       = arr[idx] - mnt[3];
+      y       = x * x;
+      mnt[4] += y;
+      mnt[5] += y * x;
+      mnt[6] += y * y;
+    }
+  }
+
+  // Answer the requests that depend on the order of the stream before it is reordered.
+  ret = true;
+  for (req = 0; req < cnt; req += 1) {
+    if (fnc[req] != AGGSTAT_FNC_QNT && fnc[req] != AGGSTAT_FNC_MED) {
+      ret &= many_get(&val[req], mnt, arr, len, fnc[req], par[req]);
+    }
+  }
+
+  // Select the order statistics of all quantiles at once, with the recursion depth limited to
+  // twice the logarithm of the length.
+  if (sel == true && len > 0) {
+    dep = sel_dep(len);
+    sel_mul(arr, 0, len, dep, len, fnc, par, cnt);
+  }
+
+  for (req = 0; req < cnt; req += 1) {
+    if (fnc[req] == AGGSTAT_FNC_QNT || fnc[req] == AGGSTAT_FNC_MED) {
+      ret &= many_get(&val[req], mnt, arr, len, fnc[req], par[req]);
+    }
+  }
+
+  return ret;
+}
+
+/// Compute the first value with a non-zero weight in the stream given the full stream information.
+/// @return success/failure indication
+///
+/// @param[out] out first value
+/// @param[in]  arr array representing the stream
+/// @param[in]  wgt array of weights
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+wgt_fst(      AGGSTAT_FLT *restrict out,
+              AGGSTAT_FLT *restrict arr,
+              AGGSTAT_INT *restrict wgt,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  AGGSTAT_INT idx;
+
+  (void)par;
+
+  for (idx = 0; idx < len; idx += 1) {
+    if (wgt[idx] > 0) {
+      *out = arr[idx];
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/// Compute the last value with a non-zero weight in the stream given the full stream information.
+/// @return success/failure indication
+///
+/// @param[out] out last value
+/// @param[in]  arr array representing the stream
+/// @param[in]  wgt array of weights
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+wgt_lst(      AGGSTAT_FLT *restrict out,
+              AGGSTAT_FLT *restrict arr,
+              AGGSTAT_INT *restrict wgt,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  AGGSTAT_INT idx;
+
+  (void)par;
+
+  for (idx = len; idx > 0; idx -= 1) {
+    if (wgt[idx - 1] > 0) {
+      *out = arr[idx - 1];
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/// Compute the sum of weights in the stream given the full stream information.
+/// @return always true
+///
+/// @param[out] out sum of weights
+/// @param[in]  arr array representing the stream (unused)
+/// @param[in]  wgt array of weights
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+wgt_cnt(      AGGSTAT_FLT *restrict out,
+              AGGSTAT_FLT *restrict arr,
+              AGGSTAT_INT *restrict wgt,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  AGGSTAT_INT idx;
+  AGGSTAT_INT cnt;
+
+  (void)arr;
+  (void)par;
+
+  cnt = 0;
+  for (idx = 0; idx < len; idx += 1) {
+    cnt += wgt[idx];
+  }
+
+  *out = (AGGSTAT_FLT)cnt;
+  return true;
+}
+
+/// Compute the weighted sum of values in the stream given the full stream information.
+/// @return always true
+///
+/// @param[out] out weighted sum of values
+/// @param[in]  arr array representing the stream
+/// @param[in]  wgt array of weights
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+wgt_sum(      AGGSTAT_FLT *restrict out,
+              AGGSTAT_FLT *restrict arr,
+              AGGSTAT_INT *restrict wgt,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  AGGSTAT_INT idx;
+  AGGSTAT_FLT sum;
+
+  (void)par;
+
+  sum = AGGSTAT_0_0;
+  for (idx = 0; idx < len; idx += 1) {
+    sum += arr[idx] * (AGGSTAT_FLT)wgt[idx];
+  }
+
+  *out = sum;
+  return true;
+}
+
+/// Compute the minimal value with a non-zero weight in the stream given the full stream
+/// information.
+/// @return success/failure indication
+///
+/// @param[out] out minimal value
+/// @param[in]  arr array representing the stream
+/// @param[in]  wgt array of weights
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+wgt_min(      AGGSTAT_FLT *restrict out,
+              AGGSTAT_FLT *restrict arr,
+              AGGSTAT_INT *restrict wgt,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  AGGSTAT_INT idx;
+  AGGSTAT_FLT min;
+
+  if (wgt_fst(&min, arr, wgt, len, par) == false) {
+    return false;
+  }
+
+  for (idx = 0; idx < len; idx += 1) {
+    if (wgt[idx] > 0) {
+      min = AGGSTAT_FMIN(min, arr[idx]);
+    }
+  }
+
+  *out = min;
+  return true;
+}
+
+/// Compute the maximal value with a non-zero weight in the stream given the full stream
+/// information.
+/// @return success/failure indication
+///
+/// @param[out] out maximal value
+/// @param[in]  arr array representing the stream
+/// @param[in]  wgt array of weights
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+wgt_max(      AGGSTAT_FLT *restrict out,
+              AGGSTAT_FLT *restrict arr,
+              AGGSTAT_INT *restrict wgt,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  AGGSTAT_INT idx;
+  AGGSTAT_FLT max;
+
+  if (wgt_fst(&max, arr, wgt, len, par) == false) {
+    return false;
+  }
+
+  for (idx = 0; idx < len; idx += 1) {
+    if (wgt[idx] > 0) {
+      max = AGGSTAT_FMAX(max, arr[idx]);
+    }
+  }
+
+  *out = max;
+  return true;
+}
+
+/// Compute the weighted average value in the stream given the full stream information.
+/// @return success/failure indication
+///
+/// @param[out] out weighted average value
+/// @param[in]  arr array representing the stream
+/// @param[in]  wgt array of weights
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+wgt_avg(      AGGSTAT_FLT *restrict out,
+              AGGSTAT_FLT *restrict arr,
+              AGGSTAT_INT *restrict wgt,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  AGGSTAT_FLT cnt;
+  AGGSTAT_FLT sum;
+
+  (void)wgt_cnt(&cnt, arr, wgt, len, par);
+  if (cnt == AGGSTAT_0_0) {
+    return false;
+  }
+
+  (void)wgt_sum(&sum, arr, wgt, len, par);
+  *out = sum / cnt;
+  return true;
+}
+
+/// Compute the weighted central moment of the given order in the stream.
+/// @return central moment multiplied by the sum of weights
+///
+/// @param[in] arr array representing the stream
+/// @param[in] wgt array of weights
+/// @param[in] len length of the stream
+/// @param[in] avg weighted average value
+/// @param[in] ord order of the moment
+static AGGSTAT_FLT
+wgt_mnt(const AGGSTAT_FLT *restrict arr,
+        const AGGSTAT_INT *restrict wgt,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           avg,
+        const AGGSTAT_FLT           ord)
+{
+  AGGSTAT_INT idx;
+  AGGSTAT_FLT mnt;
+
+  mnt = AGGSTAT_0_0;
+  for (idx = 0; idx < len; idx += 1) {
+    mnt += AGGSTAT_POW(arr[idx] - avg, ord) * (AGGSTAT_FLT)wgt[idx];
+  }
+
+  return mnt;
+}
+
+/// Compute the weighted variance of values in the stream given the full stream information.
+/// @return success/failure indication
+///
+/// Weights are treated as frequencies, and the variance therefore uses the sum of weights
+/// decreased by one as the divisor.
+///
+/// @param[out] out weighted variance of values
+/// @param[in]  arr array representing the stream
+/// @param[in]  wgt array of weights
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+wgt_var(      AGGSTAT_FLT *restrict out,
+              AGGSTAT_FLT *restrict arr,
+              AGGSTAT_INT *restrict wgt,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  AGGSTAT_FLT avg;
+  AGGSTAT_FLT cnt;
+
+  (void)wgt_cnt(&cnt, arr, wgt, len, par);
+  if (cnt == AGGSTAT_0_0) {
+    return false;
+  }
+
+  if (cnt == AGGSTAT_1_0) {
+    *out = AGGSTAT_0_0;
+    return true;
+  }
+
+  (void)wgt_sum(&avg, arr, wgt, len, par);
+  avg /= cnt;
+  *out = wgt_mnt(arr, wgt, len, avg, AGGSTAT_2_0) / (cnt - AGGSTAT_1_0);
+  return true;
+}
+
+/// Compute the weighted standard deviation of values in the stream given the full stream
+/// information.
+/// @return success/failure indication
+///
+/// @param[out] out weighted standard deviation of values
+/// @param[in]  arr array representing the stream
+/// @param[in]  wgt array of weights
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+wgt_dev(      AGGSTAT_FLT *restrict out,
+              AGGSTAT_FLT *restrict arr,
+              AGGSTAT_INT *restrict wgt,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  AGGSTAT_FLT var;
+
+  if (wgt_var(&var, arr, wgt, len, par) == false) {
+    return false;
+  }
+
+  *out = AGGSTAT_SQRT(var);
+  return true;
+}
+
+/// Compute the weighted skewness of values in the stream given the full stream information.
+/// @return success/failure indication
+///
+/// @param[out] out weighted skewness of values
+/// @param[in]  arr array representing the stream
+/// @param[in]  wgt array of weights
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+wgt_skw(      AGGSTAT_FLT *restrict out,
+              AGGSTAT_FLT *restrict arr,
+              AGGSTAT_INT *restrict wgt,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  AGGSTAT_FLT cnt;
+  AGGSTAT_FLT avg;
+  AGGSTAT_FLT dev;
+
+  (void)wgt_cnt(&cnt, arr, wgt, len, par);
+  if (cnt < AGGSTAT_2_0) {
+    return false;
+  }
+
+  (void)wgt_sum(&avg, arr, wgt, len, par);
+  avg /= cnt;
+  dev = AGGSTAT_SQRT(wgt_mnt(arr, wgt, len, avg, AGGSTAT_2_0) / (cnt - AGGSTAT_1_0));
+
+  *out = wgt_mnt(arr, wgt, len, avg, AGGSTAT_3_0) / cnt / AGGSTAT_POW(dev, AGGSTAT_3_0);
+  return true;
+}
+
+/// Compute the weighted kurtosis of values in the stream given the full stream information.
+/// @return success/failure indication
+///
+/// @param[out] out weighted kurtosis of values
+/// @param[in]  arr array representing the stream
+/// @param[in]  wgt array of weights
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+wgt_krt(      AGGSTAT_FLT *restrict out,
+              AGGSTAT_FLT *restrict arr,
+              AGGSTAT_INT *restrict wgt,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  AGGSTAT_FLT cnt;
+  AGGSTAT_FLT avg;
+  AGGSTAT_FLT dev;
+
+  (void)wgt_cnt(&cnt, arr, wgt, len, par);
+  if (cnt < AGGSTAT_2_0) {
+    return false;
+  }
+
+  (void)wgt_sum(&avg, arr, wgt, len, par);
+  avg /= cnt;
+  dev = AGGSTAT_SQRT(wgt_mnt(arr, wgt, len, avg, AGGSTAT_2_0) / (cnt - AGGSTAT_1_0));
+
+  *out = wgt_mnt(arr, wgt, len, avg, AGGSTAT_4_0) / cnt / AGGSTAT_POW(dev, AGGSTAT_4_0)
+       - AGGSTAT_3_0;
+  return true;
+}
+
+/// Restore the heap property of the paired arrays below the given node.
+///
+/// @param[in] arr array representing the stream
+/// @param[in] wgt array of weights
+/// @param[in] idx index of the node
+/// @param[in] len length of the heap
+static void
+wgt_sft(AGGSTAT_FLT *restrict arr,
+        AGGSTAT_INT *restrict wgt,
+        AGGSTAT_INT           idx,
+        const AGGSTAT_INT     len)
+{
+  AGGSTAT_INT chd;
+  AGGSTAT_FLT val;
+  AGGSTAT_INT cnt;
+
+  val = arr[idx];
+  cnt = wgt[idx];
+
+  while ((chd = 2 * idx + 1) < len) {
+    if (chd + 1 < len && arr[chd + 1] > arr[chd]) {
+      chd += 1;
+    }
+
+    if ((val < arr[chd]) == false) {
+      break;
+    }
+
+    arr[idx] = arr[chd];
+    wgt[idx] = wgt[chd];
+    idx      = chd;
+  }
+
+  arr[idx] = val;
+  wgt[idx] = cnt;
+}
+
+/// Sort the paired arrays of values and weights by values in ascending order.
+///
+/// The standard library sorting function is unable to sort two arrays in lockstep, and therefore
+/// the arrays are sorted with an in-place heap sort.
+///
+/// @param[in] arr array representing the stream
+/// @param[in] wgt array of weights
+/// @param[in] len length of the stream
+static void
+wgt_srt(AGGSTAT_FLT *restrict arr, AGGSTAT_INT *restrict wgt, const AGGSTAT_INT len)
+{
+  AGGSTAT_INT idx;
+  AGGSTAT_FLT val;
+  AGGSTAT_INT cnt;
+
+  for (idx = len / 2; idx > 0; idx -= 1) {
+    wgt_sft(arr, wgt, idx - 1, len);
+  }
+
+  for (idx = len; idx > 1; idx -= 1) {
+    val = arr[0];
+    cnt = wgt[0];
+
+    arr[0] = arr[idx - 1];
+    wgt[0] = wgt[idx - 1];
+    arr[idx - 1] = val;
+    wgt[idx - 1] = cnt;
+
+    wgt_sft(arr, wgt, 0, idx - 1);
+  }
+}
+
+/// Compute a weighted time-weighted aggregate of the values using the streaming algorithm.
+/// @return success/failure indication
+///
+/// @param[out] out aggregate of values
+/// @param[in]  arr array representing the stream
+/// @param[in]  wgt array of weights
+/// @param[in]  len length of the stream
+/// @param[in]  fnc aggregate function
+static bool
+wgt_tim(      AGGSTAT_FLT *restrict out,
+        const AGGSTAT_FLT *restrict arr,
+        const AGGSTAT_INT *restrict wgt,
+        const AGGSTAT_INT           len,
+        const uint8_t               fnc)
+{
+  struct aggstat agg;
+  AGGSTAT_INT    idx;
+
+  aggstat_new(&agg, fnc, AGGSTAT_0_0);
+  for (idx = 0; idx < len; idx += 1) {
+    aggstat_put_w(&agg, arr[idx], wgt[idx]);
+  }
+
+  return aggstat_get(&agg, out);
+}
+
+/// Compute the weighted p-quantile of the values in the stream given full stream information.
+/// @return success/failure indication
+///
+/// The result is equal to the p-quantile of the stream in which each value is repeated according
+/// to its weight. Both arrays are sorted in-place.
+///
+/// @param[out] out weighted p-quantile of values
+/// @param[in]  arr array representing the stream
+/// @param[in]  wgt array of weights
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter
+static bool
+wgt_qnt(      AGGSTAT_FLT *restrict out,
+              AGGSTAT_FLT *restrict arr,
+              AGGSTAT_INT *restrict wgt,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  AGGSTAT_INT idx;
+  AGGSTAT_INT pos;
+  AGGSTAT_INT cnt;
+  AGGSTAT_FLT inp;
+  AGGSTAT_FLT frp;
+
+  // Validate the parameter.
+  if (AGGSTAT_0_0 > par || par > AGGSTAT_1_0) {
+    return false;
+  }
+
+  // Validate the sum of weights.
+  (void)wgt_cnt(&frp, arr, wgt, len, par);
+  if (frp == AGGSTAT_0_0) {
+    return false;
+  }
+
+  // Sort the stream.
+  wgt_srt(arr, wgt, len);
+
+  // Find the index in the expanded stream, along with the fractional part for the interpolation.
+  frp = AGGSTAT_MODF((frp - AGGSTAT_1_0) * par, &inp);
+  pos = (AGGSTAT_INT)inp;
+
+  // Find the value that covers the index in the expanded stream.
+  cnt = 0;
+  for (idx = 0; idx < len; idx += 1) {
+    cnt += wgt[idx];
+    if (cnt > pos) {
+      break;
+    }
+  }
+
+  // Perform linear interpolation if the next index in the expanded stream belongs to the next
+  // value with a non-zero weight.
+  *out = arr[idx];
+  if (cnt == pos + 1 && frp > AGGSTAT_0_0) {
+    for (idx += 1; idx < len && wgt[idx] == 0; idx += 1);
+    *out += frp * (arr[idx] - *out);
+  }
+
+  return true;
+}
+
+/// Compute the weighted median of the values in the stream given full stream information.
+/// @return success/failure indication
+///
+/// @param[out] out weighted median of values
+/// @param[in]  arr array representing the stream
+/// @param[in]  wgt array of weights
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+wgt_med(      AGGSTAT_FLT *restrict out,
+              AGGSTAT_FLT *restrict arr,
+              AGGSTAT_INT *restrict wgt,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  (void)par;
+  return wgt_qnt(out, arr, wgt, len, AGGSTAT_0_5);
+}
+
+/// Compute the weighted time-weighted average of the values given full stream information.
+/// @return success/failure indication
+///
+/// @param[out] out time-weighted average of values
+/// @param[in]  arr array representing the stream
+/// @param[in]  wgt array of weights
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+wgt_twa(      AGGSTAT_FLT *restrict out,
+              AGGSTAT_FLT *restrict arr,
+              AGGSTAT_INT *restrict wgt,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  (void)par;
+  return wgt_tim(out, arr, wgt, len, AGGSTAT_FNC_TWA);
+}
+
+/// Compute the weighted time integral of the values given full stream information.
+/// @return success/failure indication
+///
+/// @param[out] out time integral of values
+/// @param[in]  arr array representing the stream
+/// @param[in]  wgt array of weights
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+wgt_itg(      AGGSTAT_FLT *restrict out,
+              AGGSTAT_FLT *restrict arr,
+              AGGSTAT_INT *restrict wgt,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  (void)par;
+  return wgt_tim(out, arr, wgt, len, AGGSTAT_FNC_ITG);
+}
+
+/// Compute the weighted rate of change of the values given full stream information.
+/// @return success/failure indication
+///
+/// @param[out] out rate of change of values
+/// @param[in]  arr array representing the stream
+/// @param[in]  wgt array of weights
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+wgt_rat(      AGGSTAT_FLT *restrict out,
+              AGGSTAT_FLT *restrict arr,
+              AGGSTAT_INT *restrict wgt,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  (void)par;
+  return wgt_tim(out, arr, wgt, len, AGGSTAT_FNC_RAT);
+}
+
+/// Function table for wgt_* functions based on ag_fnc.
+static bool (*wgt_fnc[])(AGGSTAT_FLT*,
+                         AGGSTAT_FLT*,
+                         AGGSTAT_INT*,
+                         const AGGSTAT_INT,
+                         const AGGSTAT_FLT) = {
+  NULL,
+  wgt_fst,
+  wgt_lst,
+  wgt_cnt,
+  wgt_sum,
+  wgt_min,
+  wgt_max,
+  wgt_avg,
+  wgt_var,
+  wgt_dev,
+  wgt_skw,
+  wgt_krt,
+  wgt_qnt,
+  wgt_med,
+  wgt_twa,
+  wgt_itg,
+  wgt_rat
+};
+
+/// Compute an aggregate of a weighted stream with full information.
+/// @return success/failure indication
+///
+/// Weights denote the number of occurrences of each value, and the result is equal to the one of
+/// `aggstat_run` over the stream with each value repeated accordingly. Values with zero weight are
+/// ignored. The quantile functions sort both arrays in-place.
+///
+/// @param[out] val aggregate of the stream
+/// @param[in]  arr array representing the stream
+/// @param[in]  wgt array of weights
+/// @param[in]  len length of the stream
+/// @param[in]  fnc aggregate function
+/// @param[in]  par parameter
+bool
+aggstat_run_w(      AGGSTAT_FLT *restrict val,
+                    AGGSTAT_FLT *restrict arr,
+                    AGGSTAT_INT *restrict wgt,
+              const AGGSTAT_INT           len,
+              const uint8_t               fnc,
+              const AGGSTAT_FLT           par)
+{
+  return wgt_fnc[fnc](val, arr, wgt, len, par);
+}
+
+/// Compute an aggregate of a timestamped stream with full information.
+/// @return success/failure indication
+///
+/// The time-weighted average, time integral and rate of change functions use the timestamps,
+/// whereas all other functions ignore them and are equal to `aggstat_run`.
+///
+/// @param[out] val aggregate of the stream
+/// @param[in]  tim array of timestamps
+/// @param[in]  arr array representing the stream
+/// @param[in]  len length of the stream
+/// @param[in]  fnc aggregate function
+/// @param[in]  par parameter
+bool
+aggstat_run_t(      AGGSTAT_FLT *restrict val,
+              const AGGSTAT_FLT *restrict tim,
+              const AGGSTAT_FLT *restrict arr,
+              const AGGSTAT_INT           len,
+              const uint8_t               fnc,
+              const AGGSTAT_FLT           par)
+{
+  if (fnc < AGGSTAT_FNC_TWA) {
+    return aggstat_run(val, arr, len, fnc, par);
+  }
+
+  return run_tim(val, tim, arr, len, fnc);
+}
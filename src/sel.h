@@ -0,0 +1,204 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#ifndef AGGSTAT_SEL_H
+#define AGGSTAT_SEL_H
+
+// Selection of order statistics shared by the static algorithms. The header is internal to the
+// library, and must be included after agg.h.
+
+#include <stdlib.h>
+
+
+// Ranges that are at most this long are sorted by insertion.
+#define SEL_INS 16
+
+/// Compare two elements of the stream.
+/// @return comparison
+/// @retval 0 elements are equal
+/// @retval 1 first element is greater
+/// @retval -1 second element is greater
+///
+/// @param[in] a first element
+/// @param[in] b second element
+static inline int
+sel_cmp(const void* a, const void* b)
+{
+  AGGSTAT_FLT x;
+  AGGSTAT_FLT y;
+
+  x = *(AGGSTAT_FLT*)a;
+  y = *(AGGSTAT_FLT*)b;
+
+  return (x > y) - (x < y);
+}
+
+/// Exchange two values of the array.
+///
+/// @param[in] arr array
+/// @param[in] idx position of the first value
+/// @param[in] jdx position of the second value
+static inline void
+sel_swp(AGGSTAT_FLT* arr, const size_t idx, const size_t jdx)
+{
+  AGGSTAT_FLT tmp;
+
+  tmp      = arr[idx];
+  arr[idx] = arr[jdx];
+  arr[jdx] = tmp;
+}
+
+/// Sort a range of the array by insertion.
+///
+/// @param[in] arr array
+/// @param[in] lop start of the range
+/// @param[in] hip end of the range (exclusive)
+static inline void
+sel_ins(AGGSTAT_FLT* arr, const size_t lop, const size_t hip)
+{
+  AGGSTAT_FLT val;
+  size_t      idx;
+  size_t      jdx;
+
+  for (idx = lop + 1; idx < hip; idx += 1) {
+    val = arr[idx];
+    for (jdx = idx; jdx > lop && arr[jdx - 1] > val; jdx -= 1) {
+      arr[jdx] = arr[jdx - 1];
+    }
+
+    arr[jdx] = val;
+  }
+}
+
+/// Move the median of the first, middle and last value of a range to its start.
+///
+/// @param[in] arr array
+/// @param[in] lop start of the range
+/// @param[in] hip end of the range (exclusive)
+static inline void
+sel_mdn(AGGSTAT_FLT* arr, const size_t lop, const size_t hip)
+{
+  size_t mid;
+
+  mid = lop + (hip - lop) / 2;
+  if (arr[mid] < arr[lop]) {
+    sel_swp(arr, mid, lop);
+  }
+
+  if (arr[hip - 1] < arr[mid]) {
+    sel_swp(arr, hip - 1, mid);
+    if (arr[mid] < arr[lop]) {
+      sel_swp(arr, mid, lop);
+    }
+  }
+
+  sel_swp(arr, mid, lop);
+}
+
+/// Partition a range of the array around its first value.
+/// @return last position of the lower part
+///
+/// The lower part contains values that are not greater than the pivot, and the upper part values
+/// that are not lower than the pivot. Both parts are non-empty.
+///
+/// @param[in] arr array
+/// @param[in] lop start of the range
+/// @param[in] hip end of the range (exclusive)
+static inline size_t
+sel_hoa(AGGSTAT_FLT* arr, const size_t lop, const size_t hip)
+{
+  AGGSTAT_FLT piv;
+  size_t      idx;
+  size_t      jdx;
+
+  piv = arr[lop];
+  idx = lop;
+  jdx = hip - 1;
+  while (true) {
+    while (arr[idx] < piv) {
+      idx += 1;
+    }
+
+    while (arr[jdx] > piv) {
+      jdx -= 1;
+    }
+
+    if (idx >= jdx) {
+      return jdx;
+    }
+
+    sel_swp(arr, idx, jdx);
+    idx += 1;
+    jdx -= 1;
+  }
+}
+
+/// Partition a range of the array around the median of its first, middle and last value.
+/// @return last position of the lower part
+///
+/// @param[in] arr array
+/// @param[in] lop start of the range
+/// @param[in] hip end of the range (exclusive)
+static inline size_t
+sel_prt(AGGSTAT_FLT* arr, const size_t lop, const size_t hip)
+{
+  sel_mdn(arr, lop, hip);
+  return sel_hoa(arr, lop, hip);
+}
+
+/// Determine the recursion depth after which a selection falls back to sorting.
+/// @return depth limit
+///
+/// @param[in] len length of the range
+static inline uint32_t
+sel_dep(size_t len)
+{
+  uint32_t dep;
+
+  for (dep = 2; len > 1; len /= 2) {
+    dep += 2;
+  }
+
+  return dep;
+}
+
+/// Move the order statistic of a rank to its sorted position.
+///
+/// The values before the position are not greater than the order statistic, and the values after
+/// it are not lower. The range is partitioned as in quickselect, and sorted once the number of
+/// partitions exceeds twice the logarithm of its length, which bounds the worst case.
+///
+/// @param[in] arr array
+/// @param[in] lop start of the range
+/// @param[in] hip end of the range (exclusive)
+/// @param[in] rnk position of the order statistic
+static inline void
+sel_kth(AGGSTAT_FLT* arr, size_t lop, size_t hip, const size_t rnk)
+{
+  uint32_t dep;
+  size_t   mid;
+
+  dep = sel_dep(hip - lop);
+  while (hip - lop > SEL_INS) {
+    if (dep == 0) {
+      (void)qsort((void*)(arr + lop), hip - lop, sizeof(AGGSTAT_FLT), sel_cmp);
+      return;
+    }
+
+    mid = sel_prt(arr, lop, hip);
+    if (rnk <= mid) {
+      hip = mid + 1;
+    } else {
+      lop = mid + 1;
+    }
+
+    dep -= 1;
+  }
+
+  sel_ins(arr, lop, hip);
+}
+
+#endif
@@ -0,0 +1,158 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include <string.h>
+#include <sched.h>
+
+#include "agg.h"
+
+
+/// Reset all aggregates of a copy, retaining their functions and parameters.
+///
+/// @param[in] agg aggregates
+/// @param[in] len number of aggregates
+static void
+snp_rst(struct aggstat* agg, const uint32_t len)
+{
+  uint32_t idx;
+
+  for (idx = 0; idx < len; idx += 1) {
+    aggstat_new(&agg[idx], agg[idx].ag_fnc, agg[idx].ag_par);
+  }
+}
+
+/// Initialise the snapshot of an array of aggregates.
+/// @return success/failure indication
+///
+/// Both copies of the array are initialised from the given aggregates, which select the function
+/// and parameter of each aggregate. The memory is provided by the caller and must hold
+/// `AGGSTAT_SNP_SIZ(len)` bytes.
+///
+/// @param[out] snp snapshot
+/// @param[in]  ini initialised aggregates
+/// @param[in]  mem memory of both copies
+/// @param[in]  len number of aggregates
+bool
+aggstat_snp_new(struct aggstat_snp*   snp,
+                const struct aggstat* ini,
+                void*                 mem,
+                const uint32_t        len)
+{
+  if (ini == NULL || mem == NULL || len == 0) {
+    return false;
+  }
+
+  snp->as_agg[0] = mem;
+  snp->as_agg[1] = snp->as_agg[0] + len;
+  snp->as_len    = len;
+  snp->as_epc    = 0;
+  snp->as_wrt[0] = 0;
+  snp->as_wrt[1] = 0;
+
+  (void)memcpy(snp->as_agg[0], ini, len * sizeof(struct aggstat));
+  (void)memcpy(snp->as_agg[1], ini, len * sizeof(struct aggstat));
+  snp_rst(snp->as_agg[0], len);
+  snp_rst(snp->as_agg[1], len);
+
+  return true;
+}
+
+/// Enter the active copy of the aggregates.
+/// @return active copy
+///
+/// The writer announces itself in the copy selected by the epoch, and then confirms that the epoch
+/// did not change in the meantime. Otherwise the reader might have already waited for the writers
+/// of that copy, and the writer retries with the new epoch. As both steps are sequentially
+/// consistent, either the writer observes the new epoch, or the reader observes the writer.
+///
+/// @param[in] snp snapshot
+struct aggstat*
+aggstat_snp_bgn(struct aggstat_snp* snp)
+{
+  uint64_t epc;
+
+  while (true) {
+    epc = __atomic_load_n(&snp->as_epc, __ATOMIC_SEQ_CST);
+    (void)__atomic_fetch_add(&snp->as_wrt[epc & 1], 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&snp->as_epc, __ATOMIC_SEQ_CST) == epc) {
+      return snp->as_agg[epc & 1];
+    }
+
+    (void)__atomic_fetch_sub(&snp->as_wrt[epc & 1], 1, __ATOMIC_RELEASE);
+  }
+}
+
+/// Leave the copy of the aggregates that was entered.
+///
+/// The release ordering publishes all updates of the copy to the reader that waits for its writers.
+///
+/// @param[in] snp snapshot
+/// @param[in] agg copy obtained by `aggstat_snp_bgn`
+void
+aggstat_snp_end(struct aggstat_snp* snp, const struct aggstat* agg)
+{
+  (void)__atomic_fetch_sub(&snp->as_wrt[agg == snp->as_agg[1]], 1, __ATOMIC_RELEASE);
+}
+
+/// Update an aggregate of the active copy with a single value.
+///
+/// @param[in] snp snapshot
+/// @param[in] idx index of the aggregate
+/// @param[in] val input value
+void
+aggstat_snp_put(struct aggstat_snp* snp, const uint32_t idx, const AGGSTAT_FLT val)
+{
+  struct aggstat* agg;
+
+  agg = aggstat_snp_bgn(snp);
+  aggstat_put(&agg[idx], val);
+  aggstat_snp_end(snp, agg);
+}
+
+/// Update an aggregate of the active copy with an array of values.
+///
+/// @param[in] snp snapshot
+/// @param[in] idx index of the aggregate
+/// @param[in] arr input values
+/// @param[in] len number of values
+void
+aggstat_snp_put_arr(struct aggstat_snp *restrict snp,
+                    const uint32_t               idx,
+                    const AGGSTAT_FLT  *restrict arr,
+                    const AGGSTAT_INT            len)
+{
+  struct aggstat* agg;
+
+  agg = aggstat_snp_bgn(snp);
+  aggstat_put_arr(&agg[idx], arr, len);
+  aggstat_snp_end(snp, agg);
+}
+
+/// Swap the copies of the aggregates and obtain the retired copy.
+/// @return retired copy
+///
+/// The inactive copy, which was retired by the previous swap, is reset and becomes the active copy
+/// by the increment of the epoch. The function then waits for the writers that entered the retired
+/// copy before the swap, which only update a few values each, and returns the retired copy. It
+/// remains unchanged until the next swap, and thus can be read without any synchronisation. Swaps
+/// must not be performed concurrently.
+///
+/// @param[in] snp snapshot
+const struct aggstat*
+aggstat_snp_swp(struct aggstat_snp* snp)
+{
+  uint64_t epc;
+
+  epc = __atomic_load_n(&snp->as_epc, __ATOMIC_RELAXED);
+  snp_rst(snp->as_agg[(epc + 1) & 1], snp->as_len);
+  __atomic_store_n(&snp->as_epc, epc + 1, __ATOMIC_SEQ_CST);
+
+  while (__atomic_load_n(&snp->as_wrt[epc & 1], __ATOMIC_SEQ_CST) != 0) {
+    (void)sched_yield();
+  }
+
+  return snp->as_agg[epc & 1];
+}
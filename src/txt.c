@@ -0,0 +1,571 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "agg.h"
+
+
+// Limits of the exact fast path: all integers up to the mantissa limit and all powers of ten up to
+// the exponent limit are exactly representable in the working type, and thus their product or
+// quotient is correctly rounded. The integer limit is additionally bounded by the 64-bit
+// accumulator of the decimal digits. Single-precision numbers are computed in double precision,
+// which covers most numbers with up to nine significant digits, and rounded again.
+#if AGGSTAT_FLT_BIT == 32
+  #define TXT_FLT     double
+  #define TXT_POW(E)  1.0e ## E
+  #define TXT_MAN_MAX ((uint64_t)1 << 53)
+  #define TXT_EXP_MAX 22
+#elif AGGSTAT_FLT_BIT == 64
+  #define TXT_FLT     double
+  #define TXT_POW(E)  1.0e ## E
+  #define TXT_MAN_MAX ((uint64_t)1 << 53)
+  #define TXT_EXP_MAX 22
+#elif AGGSTAT_FLT_BIT == 80
+  #define TXT_FLT     long double
+  #define TXT_POW(E)  1.0e ## E ## L
+  #define TXT_MAN_MAX UINT64_MAX
+  #define TXT_EXP_MAX 27
+#else
+  #define TXT_FLT     __float128
+  #define TXT_POW(E)  1.0e ## E ## Q
+  #define TXT_MAN_MAX UINT64_MAX
+  #define TXT_EXP_MAX 48
+#endif
+
+// Maximal number of decimal digits that fit into the 64-bit accumulator.
+#define TXT_DIG_MAX 19
+
+// Maximal length of a field that is passed to the fallback conversion.
+#define TXT_STR_MAX 128
+
+// Number of values that are collected before they are applied to the aggregates.
+#define TXT_BAT 512
+
+// Byte patterns for the word-wide search.
+#define TXT_ONE 0x0101010101010101ULL
+#define TXT_MSB 0x8080808080808080ULL
+
+/// Exact powers of ten.
+static const TXT_FLT txt_pow[] = {
+  TXT_POW(0),  TXT_POW(1),  TXT_POW(2),  TXT_POW(3),  TXT_POW(4),  TXT_POW(5),
+  TXT_POW(6),  TXT_POW(7),  TXT_POW(8),  TXT_POW(9),  TXT_POW(10), TXT_POW(11),
+  TXT_POW(12), TXT_POW(13), TXT_POW(14), TXT_POW(15), TXT_POW(16), TXT_POW(17),
+  TXT_POW(18), TXT_POW(19), TXT_POW(20), TXT_POW(21), TXT_POW(22)
+#if TXT_EXP_MAX > 22
+  ,
+  TXT_POW(23), TXT_POW(24), TXT_POW(25), TXT_POW(26), TXT_POW(27)
+#endif
+#if TXT_EXP_MAX > 27
+  ,
+  TXT_POW(28), TXT_POW(29), TXT_POW(30), TXT_POW(31), TXT_POW(32), TXT_POW(33),
+  TXT_POW(34), TXT_POW(35), TXT_POW(36), TXT_POW(37), TXT_POW(38), TXT_POW(39),
+  TXT_POW(40), TXT_POW(41), TXT_POW(42), TXT_POW(43), TXT_POW(44), TXT_POW(45),
+  TXT_POW(46), TXT_POW(47), TXT_POW(48)
+#endif
+};
+
+/// Powers of ten for the accumulation of digits.
+static const uint64_t txt_dec[] = {
+  1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000
+};
+
+/// Determine whether a character is a blank that surrounds a number.
+/// @return decision
+///
+/// @param[in] chr character
+static inline bool
+txt_spc(const char chr)
+{
+  return chr == ' ' || chr == '\t' || chr == '\r';
+}
+
+/// Determine whether a field consists of blanks only.
+/// @return decision
+///
+/// @param[in] str start of the field
+/// @param[in] len length of the field
+static bool
+txt_emp(const char* str, const size_t len)
+{
+  size_t idx;
+
+  for (idx = 0; idx < len; idx += 1) {
+    if (txt_spc(str[idx]) == false) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/// Mark the bytes of a word that are equal to the pattern byte.
+/// @return non-zero if any byte is equal
+///
+/// The marks above the first equal byte might be spurious, as the borrow propagates, but the word
+/// is marked if and only if it contains an equal byte.
+///
+/// @param[in] wrd word of eight bytes
+/// @param[in] pat pattern byte repeated in all bytes
+static inline uint64_t
+txt_has(const uint64_t wrd, const uint64_t pat)
+{
+  uint64_t x;
+
+  x = wrd ^ pat;
+  return (x - TXT_ONE) & ~x & TXT_MSB;
+}
+
+/// Find the first delimiter or newline.
+/// @return position of the character, or the end of the buffer
+///
+/// The buffer is scanned eight bytes at a time. On little-endian targets, the lowest mark of the
+/// word is the first character, and otherwise the word is searched byte by byte.
+///
+/// @param[in] cur start of the buffer
+/// @param[in] end end of the buffer
+/// @param[in] dlm delimiter
+static const char*
+txt_fnd(const char* cur, const char* end, const char dlm)
+{
+  uint64_t wrd;
+  uint64_t msk;
+  uint64_t nln;
+  uint64_t sep;
+
+  nln = TXT_ONE * (uint64_t)(unsigned char)'\n';
+  sep = TXT_ONE * (uint64_t)(unsigned char)dlm;
+
+  while (end - cur >= 8) {
+    memcpy(&wrd, cur, sizeof(wrd));
+    msk = txt_has(wrd, nln) | txt_has(wrd, sep);
+    if (msk != 0) {
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+      return cur + (unsigned)__builtin_ctzll(msk) / 8;
+#else
+      break;
+#endif
+    }
+
+    cur += 8;
+  }
+
+  while (cur < end && *cur != '\n' && *cur != dlm) {
+    cur += 1;
+  }
+
+  return cur;
+}
+
+/// Accumulate a run of decimal digits.
+/// @return end of the run
+///
+/// The accumulator wraps around once it holds more than the maximal number of digits, which is
+/// detected by the caller through the number of digits. On little-endian targets, the digits are
+/// classified and converted eight at a time by arithmetic on 64-bit words, which avoids a branch
+/// for every digit.
+///
+/// @param[in]     cur start of the run
+/// @param[in]     end end of the buffer
+/// @param[in,out] man accumulated value
+/// @param[in,out] dig number of accumulated digits
+static inline const char*
+txt_dig(const char* cur, const char* end, uint64_t* man, size_t* dig)
+{
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  uint64_t wrd;
+  uint64_t msk;
+  uint64_t val;
+  unsigned cnt;
+
+  while (end - cur >= 8) {
+    memcpy(&wrd, cur, sizeof(wrd));
+
+    // Mark the bytes that are not digits. Borrows and carries only affect bytes that follow the
+    // first such byte, and thus the number of leading digits is exact.
+    wrd -= TXT_ONE * (uint64_t)'0';
+    msk  = ((wrd + TXT_ONE * (uint64_t)0x76) | wrd) & TXT_MSB;
+    cnt  = msk == 0 ? 8 : (unsigned)__builtin_ctzll(msk) / 8;
+    if (cnt == 0) {
+      return cur;
+    }
+
+    // Shift the leading digits to the top of the word, which pads them with leading zeros, and
+    // combine pairs, quadruples and octuples of digits.
+    val  = wrd << (64 - 8 * cnt);
+    val  = val * 10 + (val >> 8);
+    val  = ((val & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))
+         + ((val >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32))) >> 32;
+
+    *man  = *man * txt_dec[cnt] + val;
+    *dig += cnt;
+    cur  += cnt;
+    if (cnt < 8) {
+      return cur;
+    }
+  }
+#endif
+
+  while (cur < end && (unsigned char)(*cur - '0') < 10) {
+    *man  = *man * 10 + (uint64_t)(*cur - '0');
+    *dig += 1;
+    cur  += 1;
+  }
+
+  return cur;
+}
+
+/// Convert a number by the standard library.
+/// @return success/failure indication
+///
+/// @param[out] val value
+/// @param[in]  str start of the number
+/// @param[in]  len length of the number
+static bool
+txt_std(AGGSTAT_FLT *restrict val, const char *restrict str, const size_t len)
+{
+  char  tmp[TXT_STR_MAX];
+  char* end;
+
+  if (len >= sizeof(tmp)) {
+    return false;
+  }
+
+  memcpy(tmp, str, len);
+  tmp[len] = '\0';
+
+  *val = AGGSTAT_STRTO(tmp, &end);
+  return end == tmp + len;
+}
+
+/// Parse a decimal number by the exact fast path.
+/// @return end of the number, or NULL if the fast path does not apply
+///
+/// The number is read up to the first character that can not continue it, which is not required
+/// to be a delimiter, and must not be preceded by blanks. Numbers that are not decimal, that have
+/// more digits than the accumulator holds, or whose exponent is beyond the exact limits are
+/// rejected, and left to the caller.
+///
+/// @param[out] val value
+/// @param[in]  cur start of the number
+/// @param[in]  end end of the buffer
+static const char*
+txt_num(AGGSTAT_FLT *restrict val, const char* cur, const char* end)
+{
+  TXT_FLT  wid;
+  uint64_t man;
+  int64_t  ten;
+  int64_t  esx;
+  size_t   dig;
+  size_t   pnt;
+  bool     neg;
+  bool     eng;
+#if AGGSTAT_FLT_BIT == 32
+  uint64_t bit;
+#endif
+
+  neg = cur < end && *cur == '-';
+  if (cur < end && (*cur == '-' || *cur == '+')) {
+    cur += 1;
+  }
+
+  // Integer and fractional part.
+  man = 0;
+  dig = 0;
+  ten = 0;
+  cur = txt_dig(cur, end, &man, &dig);
+  if (cur < end && *cur == '.') {
+    pnt = dig;
+    cur = txt_dig(cur + 1, end, &man, &dig);
+    ten = -(int64_t)(dig - pnt);
+  }
+
+  if (dig == 0 || dig > TXT_DIG_MAX) {
+    return NULL;
+  }
+
+  // Exponent part. Its value is saturated, as it is relevant only within the fast path limits.
+  if (cur < end && (*cur == 'e' || *cur == 'E')) {
+    cur += 1;
+    eng = cur < end && *cur == '-';
+    if (cur < end && (*cur == '-' || *cur == '+')) {
+      cur += 1;
+    }
+
+    if (cur == end || (unsigned char)(*cur - '0') >= 10) {
+      return NULL;
+    }
+
+    esx = 0;
+    while (cur < end && (unsigned char)(*cur - '0') < 10) {
+      esx  = esx < 100000 ? esx * 10 + (*cur - '0') : esx;
+      cur += 1;
+    }
+
+    ten += eng == true ? -esx : esx;
+  }
+
+  if (man == 0) {
+    *val = neg == true ? -AGGSTAT_0_0 : AGGSTAT_0_0;
+    return cur;
+  }
+
+  if (man > TXT_MAN_MAX || ten > TXT_EXP_MAX || ten < -TXT_EXP_MAX) {
+    return NULL;
+  }
+
+  wid = (TXT_FLT)man;
+  wid = ten < 0 ? wid / txt_pow[-ten] : wid * txt_pow[ten];
+
+#if AGGSTAT_FLT_BIT == 32
+  // The second rounding differs from the direct rounding only if the first one ends exactly
+  // halfway between two single-precision numbers, which is left to the standard library.
+  memcpy(&bit, &wid, sizeof(bit));
+  if ((bit & 0x1FFFFFFFULL) == 0x10000000ULL) {
+    return NULL;
+  }
+#endif
+
+  *val = (AGGSTAT_FLT)wid;
+  *val = neg == true ? -*val : *val;
+
+  return cur;
+}
+
+/// Parse a decimal number.
+/// @return success/failure indication
+///
+/// The number consists of an optional sign, decimal digits with an optional decimal point, and an
+/// optional decimal exponent, and might be surrounded by blanks. Numbers whose significant digits
+/// and exponent are within the exact limits of the floating-point type are converted by a single
+/// multiplication or division, which is correctly rounded. All other numbers, including the
+/// infinities and not-a-number, are converted by the standard library.
+///
+/// @param[out] val value
+/// @param[in]  str start of the number
+/// @param[in]  len length of the number
+bool
+aggstat_txt_flt(AGGSTAT_FLT *restrict val, const char *restrict str, const size_t len)
+{
+  const char* beg;
+  const char* end;
+  const char* nxt;
+
+  beg = str;
+  end = str + len;
+  while (beg < end && txt_spc(*beg) == true) {
+    beg += 1;
+  }
+
+  while (end > beg && txt_spc(end[-1]) == true) {
+    end -= 1;
+  }
+
+  if (beg == end) {
+    return false;
+  }
+
+  nxt = txt_num(val, beg, end);
+  if (nxt == end) {
+    return true;
+  }
+
+  return txt_std(val, beg, (size_t)(end - beg));
+}
+
+/// Append a part of the selected field to the carried field.
+///
+/// @param[in] txt parser
+/// @param[in] cur start of the part
+/// @param[in] end end of the part
+static void
+txt_cry(struct aggstat_txt *restrict txt, const char* cur, const char* end)
+{
+  size_t len;
+
+  len = (size_t)(end - cur);
+  if (len > sizeof(txt->at_fld) - txt->at_len) {
+    txt->at_ovf = true;
+    return;
+  }
+
+  memcpy(txt->at_fld + txt->at_len, cur, len);
+  txt->at_len += (uint8_t)len;
+}
+
+/// Apply the collected values to all aggregates.
+///
+/// @param[in] agg array of aggregated values
+/// @param[in] cnt number of aggregated values
+/// @param[in] arr collected values
+/// @param[in] len number of collected values
+static void
+txt_fls(struct aggstat    *restrict agg,
+        const size_t                cnt,
+        const AGGSTAT_FLT *restrict arr,
+        const size_t                len)
+{
+  size_t idx;
+
+  for (idx = 0; idx < cnt; idx += 1) {
+    aggstat_put_arr(&agg[idx], arr, (AGGSTAT_INT)len);
+  }
+}
+
+/// Initialise the parser.
+///
+/// The parser reads lines of fields separated by the delimiter, and selects the field at the
+/// column index, starting from zero. A newline delimiter selects one value per line and requires
+/// the column index zero. Quoted fields are not supported.
+///
+/// @param[in] txt parser
+/// @param[in] dlm delimiter of columns
+/// @param[in] col index of the selected column
+void
+aggstat_txt_new(struct aggstat_txt* txt, const char dlm, const uint32_t col)
+{
+  (void)memset(txt, 0, sizeof(*txt));
+  txt->at_dlm = dlm;
+  txt->at_col = col;
+}
+
+/// Parse a buffer of text and apply the numbers in the selected column to all aggregates.
+///
+/// The buffer can end at any position, including the middle of a line or field: the parser
+/// carries the partial state over to the next buffer. Empty fields and lines that are too short
+/// are skipped, and all other fields that are not numbers are counted as errors. The parsed values
+/// are applied in batches, so that the aggregates see the same sequence of values as through
+/// individual updates.
+///
+/// @param[in] txt parser
+/// @param[in] buf buffer
+/// @param[in] len length of the buffer
+/// @param[in] agg array of aggregated values
+/// @param[in] cnt number of aggregated values
+void
+aggstat_txt_put(struct aggstat_txt *restrict txt,
+                const char         *restrict buf,
+                const size_t                 len,
+                struct aggstat     *restrict agg,
+                const size_t                 cnt)
+{
+  AGGSTAT_FLT arr[TXT_BAT];
+  const char* cur;
+  const char* end;
+  const char* nxt;
+  const char* fld;
+  size_t      fln;
+  size_t      num;
+  bool        ovf;
+
+  cur = buf;
+  end = buf + len;
+  num = 0;
+  while (cur < end) {
+    // Skip the rest of the line after the selected column.
+    if (txt->at_cur > txt->at_col) {
+      nxt = txt_fnd(cur, end, '\n');
+      if (nxt == end) {
+        break;
+      }
+
+      txt->at_cur = 0;
+      cur         = nxt + 1;
+      continue;
+    }
+
+    // Parse the selected field in place, which succeeds for most fields, and verify that it is
+    // followed by a delimiter. The field is otherwise found first, and parsed again.
+    if (txt->at_cur == txt->at_col && txt->at_len == 0 && txt->at_ovf == false) {
+      nxt = txt_num(&arr[num], cur, end);
+      while (nxt != NULL && nxt < end && *nxt != txt->at_dlm && txt_spc(*nxt) == true) {
+        nxt += 1;
+      }
+
+      if (nxt != NULL && nxt < end && (*nxt == txt->at_dlm || *nxt == '\n')) {
+        num         += 1;
+        txt->at_cnt += 1;
+        if (num == TXT_BAT) {
+          txt_fls(agg, cnt, arr, num);
+          num = 0;
+        }
+
+        txt->at_cur = *nxt == '\n' ? 0 : txt->at_cur + 1;
+        cur         = nxt + 1;
+        continue;
+      }
+    }
+
+    nxt = txt_fnd(cur, end, txt->at_dlm);
+    if (txt->at_cur == txt->at_col) {
+      // Carry the field over to the next buffer.
+      if (nxt == end) {
+        txt_cry(txt, cur, nxt);
+        break;
+      }
+
+      // Complete the field carried over from the previous buffer.
+      fld = cur;
+      fln = (size_t)(nxt - cur);
+      ovf = false;
+      if (txt->at_len > 0 || txt->at_ovf == true) {
+        txt_cry(txt, cur, nxt);
+        fld = txt->at_fld;
+        fln = txt->at_len;
+        ovf = txt->at_ovf;
+        txt->at_len = 0;
+        txt->at_ovf = false;
+      }
+
+      if (ovf == false && aggstat_txt_flt(&arr[num], fld, fln) == true) {
+        num         += 1;
+        txt->at_cnt += 1;
+      } else if (ovf == true || txt_emp(fld, fln) == false) {
+        txt->at_err += 1;
+      }
+
+      if (num == TXT_BAT) {
+        txt_fls(agg, cnt, arr, num);
+        num = 0;
+      }
+    } else if (nxt == end) {
+      break;
+    }
+
+    txt->at_cur = *nxt == '\n' ? 0 : txt->at_cur + 1;
+    cur         = nxt + 1;
+  }
+
+  txt_fls(agg, cnt, arr, num);
+}
+
+/// Finish the parsing of the text, and apply the last field in case the text does not end with a
+/// newline. The parser is ready to parse a new text afterwards.
+///
+/// @param[in] txt parser
+/// @param[in] agg array of aggregated values
+/// @param[in] cnt number of aggregated values
+void
+aggstat_txt_end(struct aggstat_txt *restrict txt,
+                struct aggstat     *restrict agg,
+                const size_t                 cnt)
+{
+  AGGSTAT_FLT val;
+
+  if (txt->at_cur == txt->at_col && (txt->at_len > 0 || txt->at_ovf == true)) {
+    if (txt->at_ovf == false && aggstat_txt_flt(&val, txt->at_fld, txt->at_len) == true) {
+      txt_fls(agg, cnt, &val, 1);
+      txt->at_cnt += 1;
+    } else if (txt->at_ovf == true || txt_emp(txt->at_fld, txt->at_len) == false) {
+      txt->at_err += 1;
+    }
+  }
+
+  txt->at_len = 0;
+  txt->at_ovf = false;
+  txt->at_cur = 0;
+}
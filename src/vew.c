@@ -0,0 +1,629 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "agg.h"
+
+
+/// Non-contiguous view of a stream that is read in-place.
+struct view {
+  const char*        vw_ptr; ///< Address of the first value.
+  const AGGSTAT_INT* vw_idx; ///< Positions of the values (optional).
+  size_t             vw_str; ///< Distance between two consecutive positions in bytes.
+};
+
+/// Obtain a value of the stream.
+/// @return value
+///
+/// Strided views select the position directly, whereas gather views look up the position in the
+/// array of indices. Once inlined into a loop, the compiler can unswitch the loop on the kind of
+/// the view, and vectorize the gather where the target supports it.
+///
+/// @param[in] vew view of the stream
+/// @param[in] pos position in the view
+static inline AGGSTAT_FLT
+vew_at(const struct view *restrict vew, const AGGSTAT_INT pos)
+{
+  AGGSTAT_INT off;
+
+  off = vew->vw_idx == NULL ? pos : vew->vw_idx[pos];
+  return *(const AGGSTAT_FLT*)(vew->vw_ptr + (size_t)off * vew->vw_str);
+}
+
+/// Number of values that are gathered into a block, which fits into the first level of the cache.
+#define VEW_BLK 256
+
+/// Compute the central moments of the values in the stream.
+///
+/// The stream is read only once: the values are gathered in blocks into a small buffer that
+/// remains in the cache, the central moments of each block are computed by two passes over the
+/// buffer, and the blocks are merged by the pairwise update formulas. Compared to multiple passes
+/// over the stream, this reads each cache line once, which matters for large strides, and compared
+/// to the naive power sums, it does not suffer from catastrophic cancellation.
+///
+/// @param[out] mnt count, mean and the second, third and fourth central moment sums
+/// @param[in]  vew view of the stream
+/// @param[in]  len length of the stream
+/// @param[in]  ord highest order of the moments to compute
+static void
+vew_mnt(      AGGSTAT_FLT *restrict mnt,
+        const struct view *restrict vew,
+        const AGGSTAT_INT           len,
+        const uint8_t               ord)
+{
+  AGGSTAT_FLT buf[VEW_BLK];
+  AGGSTAT_FLT blk[5];
+  AGGSTAT_FLT dlt;
+  AGGSTAT_FLT dln;
+  AGGSTAT_FLT na;
+  AGGSTAT_FLT nb;
+  AGGSTAT_FLT x;
+  AGGSTAT_INT idx;
+  AGGSTAT_INT cnt;
+  AGGSTAT_INT jdx;
+
+  mnt[0] = AGGSTAT_0_0;
+  mnt[1] = AGGSTAT_0_0;
+  mnt[2] = AGGSTAT_0_0;
+  mnt[3] = AGGSTAT_0_0;
+  mnt[4] = AGGSTAT_0_0;
+
+  for (idx = 0; idx < len; idx += cnt) {
+    cnt = len - idx < VEW_BLK ? len - idx : VEW_BLK;
+
+    // Gather the block and compute its mean.
+    blk[1] = AGGSTAT_0_0;
+    for (jdx = 0; jdx < cnt; jdx += 1) {
+      buf[jdx] = vew_at(vew, idx + jdx);
+      blk[1] += buf[jdx];
+    }
+    blk[0]  = (AGGSTAT_FLT)cnt;
+    blk[1] /= blk[0];
+
+    // Compute the central moments of the block.
+    blk[2] = AGGSTAT_0_0;
+    blk[3] = AGGSTAT_0_0;
+    blk[4] = AGGSTAT_0_0;
+    if (ord == 2) {
+      for (jdx = 0; jdx < cnt; jdx += 1) {
+        x       = buf[jdx] - blk[1];
+        blk[2] += x * x;
+      }
+    } else if (ord > 2) {
+      for (jdx = 0; jdx < cnt; jdx += 1) {
+        x       = buf[jdx] - blk[1];
+        blk[2] += x * x;
+        blk[3] += x * x * x;
+        blk[4] += x * x * x * x;
+      }
+    }
+
+    // Merge the block into the accumulated moments.
+    na  = mnt[0];
+    nb  = blk[0];
+    dlt = blk[1] - mnt[1];
+    dln = dlt / (na + nb);
+
+    mnt[4] += blk[4]
+            + dlt * dln * dln * dln * na * nb * (na * na - na * nb + nb * nb)
+            + AGGSTAT_6_0 * dln * dln * (na * na * blk[2] + nb * nb * mnt[2])
+            + AGGSTAT_4_0 * dln * (na * blk[3] - nb * mnt[3]);
+    mnt[3] += blk[3]
+            + dlt * dln * dln * na * nb * (na - nb)
+            + AGGSTAT_3_0 * dln * (na * blk[2] - nb * mnt[2]);
+    mnt[2] += blk[2] + dlt * dln * na * nb;
+    mnt[1] += dln * nb;
+    mnt[0] += nb;
+  }
+}
+
+/// Compute the first value in the stream given the view of the stream.
+/// @return success/failure indication
+///
+/// @param[out] out first value
+/// @param[in]  vew view of the stream
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+vew_fst(      AGGSTAT_FLT *restrict out,
+        const struct view *restrict vew,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  (void)par;
+
+  if (len == 0) {
+    return false;
+  }
+
+  *out = vew_at(vew, 0);
+  return true;
+}
+
+/// Compute the last value in the stream given the view of the stream.
+/// @return success/failure indication
+///
+/// @param[out] out last value
+/// @param[in]  vew view of the stream
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+vew_lst(      AGGSTAT_FLT *restrict out,
+        const struct view *restrict vew,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  (void)par;
+
+  if (len == 0) {
+    return false;
+  }
+
+  *out = vew_at(vew, len - 1);
+  return true;
+}
+
+/// Compute the number of values in the stream given the view of the stream.
+/// @return always true
+///
+/// @param[out] out number of values
+/// @param[in]  vew view of the stream (unused)
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+vew_cnt(      AGGSTAT_FLT *restrict out,
+        const struct view *restrict vew,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  (void)vew;
+  (void)par;
+
+  *out = (AGGSTAT_FLT)len;
+  return true;
+}
+
+/// Compute the sum of values in the stream given the view of the stream.
+/// @return always true
+///
+/// @param[out] out sum of values
+/// @param[in]  vew view of the stream
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+vew_sum(      AGGSTAT_FLT *restrict out,
+        const struct view *restrict vew,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  AGGSTAT_INT idx;
+  AGGSTAT_FLT sum;
+
+  (void)par;
+
+  sum = AGGSTAT_0_0;
+  for (idx = 0; idx < len; idx += 1) {
+    sum += vew_at(vew, idx);
+  }
+
+  *out = sum;
+  return true;
+}
+
+/// Compute the minimal value in the stream given the view of the stream.
+/// @return success/failure indication
+///
+/// @param[out] out minimal value
+/// @param[in]  vew view of the stream
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+vew_min(      AGGSTAT_FLT *restrict out,
+        const struct view *restrict vew,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  AGGSTAT_INT idx;
+  AGGSTAT_FLT min;
+  AGGSTAT_FLT val;
+
+  (void)par;
+
+  if (len == 0) {
+    return false;
+  }
+
+  min = vew_at(vew, 0);
+  for (idx = 1; idx < len; idx += 1) {
+    val = vew_at(vew, idx);
+    min = val < min ? val : min;
+  }
+
+  *out = min;
+  return true;
+}
+
+/// Compute the maximal value in the stream given the view of the stream.
+/// @return success/failure indication
+///
+/// @param[out] out maximal value
+/// @param[in]  vew view of the stream
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+vew_max(      AGGSTAT_FLT *restrict out,
+        const struct view *restrict vew,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  AGGSTAT_INT idx;
+  AGGSTAT_FLT max;
+  AGGSTAT_FLT val;
+
+  (void)par;
+
+  if (len == 0) {
+    return false;
+  }
+
+  max = vew_at(vew, 0);
+  for (idx = 1; idx < len; idx += 1) {
+    val = vew_at(vew, idx);
+    max = val > max ? val : max;
+  }
+
+  *out = max;
+  return true;
+}
+
+/// Compute the average value in the stream given the view of the stream.
+/// @return success/failure indication
+///
+/// @param[out] out average value
+/// @param[in]  vew view of the stream
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+vew_avg(      AGGSTAT_FLT *restrict out,
+        const struct view *restrict vew,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  if (len == 0) {
+    return false;
+  }
+
+  (void)vew_sum(out, vew, len, par);
+  *out /= (AGGSTAT_FLT)len;
+  return true;
+}
+
+/// Compute the variance of values in the stream given the view of the stream.
+/// @return success/failure indication
+///
+/// @param[out] out variance of values
+/// @param[in]  vew view of the stream
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+vew_var(      AGGSTAT_FLT *restrict out,
+        const struct view *restrict vew,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  AGGSTAT_FLT mnt[5];
+
+  (void)par;
+
+  if (len == 0) {
+    return false;
+  }
+
+  if (len == 1) {
+    *out = AGGSTAT_0_0;
+    return true;
+  }
+
+  vew_mnt(mnt, vew, len, 2);
+  *out = mnt[2] / (mnt[0] - AGGSTAT_1_0);
+  return true;
+}
+
+/// Compute the standard deviation of values in the stream given the view of the stream.
+/// @return success/failure indication
+///
+/// @param[out] out standard deviation of values
+/// @param[in]  vew view of the stream
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+vew_dev(      AGGSTAT_FLT *restrict out,
+        const struct view *restrict vew,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  AGGSTAT_FLT var;
+
+  if (vew_var(&var, vew, len, par) == false) {
+    return false;
+  }
+
+  *out = AGGSTAT_SQRT(var);
+  return true;
+}
+
+/// Compute the skewness of values in the stream given the view of the stream.
+/// @return success/failure indication
+///
+/// @param[out] out skewness of values
+/// @param[in]  vew view of the stream
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+vew_skw(      AGGSTAT_FLT *restrict out,
+        const struct view *restrict vew,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  AGGSTAT_FLT mnt[5];
+  AGGSTAT_FLT dev;
+
+  (void)par;
+
+  if (len < 2) {
+    return false;
+  }
+
+  vew_mnt(mnt, vew, len, 3);
+  dev  = AGGSTAT_SQRT(mnt[2] / (mnt[0] - AGGSTAT_1_0));
+  *out = mnt[3] / mnt[0] / (dev * dev * dev);
+  return true;
+}
+
+/// Compute the kurtosis of values in the stream given the view of the stream.
+/// @return success/failure indication
+///
+/// @param[out] out kurtosis of values
+/// @param[in]  vew view of the stream
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+vew_krt(      AGGSTAT_FLT *restrict out,
+        const struct view *restrict vew,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  AGGSTAT_FLT mnt[5];
+  AGGSTAT_FLT var;
+
+  (void)par;
+
+  if (len < 2) {
+    return false;
+  }
+
+  vew_mnt(mnt, vew, len, 4);
+  var  = mnt[2] / (mnt[0] - AGGSTAT_1_0);
+  *out = mnt[4] / mnt[0] / (var * var) - AGGSTAT_3_0;
+  return true;
+}
+
+/// Compute the p-quantile of the values in the stream given the view of the stream.
+/// @return success/failure indication
+///
+/// The quantile requires the values to be sorted, and as the view must not be modified, the values
+/// are copied into a temporary buffer. This is the only function that allocates memory.
+///
+/// @param[out] out p-quantile of values
+/// @param[in]  vew view of the stream
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter
+static bool
+vew_qnt(      AGGSTAT_FLT *restrict out,
+        const struct view *restrict vew,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  AGGSTAT_FLT* arr;
+  AGGSTAT_INT  idx;
+  bool         ret;
+
+  if (len == 0) {
+    return false;
+  }
+
+  arr = malloc((size_t)len * sizeof(AGGSTAT_FLT));
+  if (arr == NULL) {
+    return false;
+  }
+
+  for (idx = 0; idx < len; idx += 1) {
+    arr[idx] = vew_at(vew, idx);
+  }
+
+  ret = aggstat_run(out, arr, len, AGGSTAT_FNC_QNT, par);
+  free(arr);
+
+  return ret;
+}
+
+/// Compute the median of the values in the stream given the view of the stream.
+/// @return success/failure indication
+///
+/// @param[out] out median of values
+/// @param[in]  vew view of the stream
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+vew_med(      AGGSTAT_FLT *restrict out,
+        const struct view *restrict vew,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  (void)par;
+  return vew_qnt(out, vew, len, AGGSTAT_0_5);
+}
+
+/// Compute a time-weighted aggregate of the values using the streaming algorithm.
+/// @return success/failure indication
+///
+/// @param[out] out aggregate of values
+/// @param[in]  vew view of the stream
+/// @param[in]  len length of the stream
+/// @param[in]  fnc aggregate function
+static bool
+vew_tim(      AGGSTAT_FLT *restrict out,
+        const struct view *restrict vew,
+        const AGGSTAT_INT           len,
+        const uint8_t               fnc)
+{
+  struct aggstat agg;
+  AGGSTAT_INT    idx;
+
+  if (len == 0) {
+    return false;
+  }
+
+  aggstat_new(&agg, fnc, AGGSTAT_0_0);
+  for (idx = 0; idx < len; idx += 1) {
+    aggstat_put(&agg, vew_at(vew, idx));
+  }
+
+  return aggstat_get(&agg, out);
+}
+
+/// Compute the time-weighted average of the values given the view of the stream.
+/// @return success/failure indication
+///
+/// @param[out] out time-weighted average of values
+/// @param[in]  vew view of the stream
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+vew_twa(      AGGSTAT_FLT *restrict out,
+        const struct view *restrict vew,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  (void)par;
+  return vew_tim(out, vew, len, AGGSTAT_FNC_TWA);
+}
+
+/// Compute the time integral of the values given the view of the stream.
+/// @return success/failure indication
+///
+/// @param[out] out time integral of values
+/// @param[in]  vew view of the stream
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+vew_itg(      AGGSTAT_FLT *restrict out,
+        const struct view *restrict vew,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  (void)par;
+  return vew_tim(out, vew, len, AGGSTAT_FNC_ITG);
+}
+
+/// Compute the rate of change of the values given the view of the stream.
+/// @return success/failure indication
+///
+/// @param[out] out rate of change of values
+/// @param[in]  vew view of the stream
+/// @param[in]  len length of the stream
+/// @param[in]  par parameter (unused)
+static bool
+vew_rat(      AGGSTAT_FLT *restrict out,
+        const struct view *restrict vew,
+        const AGGSTAT_INT           len,
+        const AGGSTAT_FLT           par)
+{
+  (void)par;
+  return vew_tim(out, vew, len, AGGSTAT_FNC_RAT);
+}
+
+/// Function table for vew_* functions based on ag_fnc.
+static bool (*vew_fnc[])(AGGSTAT_FLT*, const struct view*, const AGGSTAT_INT, const AGGSTAT_FLT) = {
+  NULL,
+  vew_fst,
+  vew_lst,
+  vew_cnt,
+  vew_sum,
+  vew_min,
+  vew_max,
+  vew_avg,
+  vew_var,
+  vew_dev,
+  vew_skw,
+  vew_krt,
+  vew_qnt,
+  vew_med,
+  vew_twa,
+  vew_itg,
+  vew_rat
+};
+
+/// Compute an aggregate of a strided stream with full information.
+/// @return success/failure indication
+///
+/// The stream consists of values that are a constant number of bytes apart, such as a single field
+/// of an array of structures. The values are read in-place, and must be suitably aligned.
+///
+/// @param[out] val aggregate of the stream
+/// @param[in]  ptr address of the first value
+/// @param[in]  str distance between two consecutive values in bytes
+/// @param[in]  len length of the stream
+/// @param[in]  fnc aggregate function
+/// @param[in]  par parameter
+bool
+aggstat_run_strided(      AGGSTAT_FLT *restrict val,
+                    const void        *restrict ptr,
+                    const size_t                str,
+                    const AGGSTAT_INT           len,
+                    const uint8_t               fnc,
+                    const AGGSTAT_FLT           par)
+{
+  struct view vew;
+
+  vew.vw_ptr = ptr;
+  vew.vw_idx = NULL;
+  vew.vw_str = str;
+
+  return vew_fnc[fnc](val, &vew, len, par);
+}
+
+/// Compute an aggregate of a subset of an array with full information.
+/// @return success/failure indication
+///
+/// The stream consists of the array values at the given indices, in the order of the indices. The
+/// values are read in-place.
+///
+/// @param[out] val aggregate of the stream
+/// @param[in]  arr array of values
+/// @param[in]  idx array of indices into the array of values
+/// @param[in]  len length of the stream
+/// @param[in]  fnc aggregate function
+/// @param[in]  par parameter
+bool
+aggstat_run_idx(      AGGSTAT_FLT *restrict val,
+                const AGGSTAT_FLT *restrict arr,
+                const AGGSTAT_INT *restrict idx,
+                const AGGSTAT_INT           len,
+                const uint8_t               fnc,
+                const AGGSTAT_FLT           par)
+{
+  struct view vew;
+
+  vew.vw_ptr = (const char*)arr;
+  vew.vw_idx = idx;
+  vew.vw_str = sizeof(AGGSTAT_FLT);
+
+  return vew_fnc[fnc](val, &vew, len, par);
+}
@@ -0,0 +1,232 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "../src/agg.h"
+
+
+// Number of values in each generated file, which spans several blocks and parts of the tool.
+#define TEST_LEN 100003
+
+// Relative error tolerated between the merged results of the tool and the static algorithms.
+#define TEST_EPS AGGSTAT_NUM(1, 0, -, 9)
+
+// Requested functions, in the order of the lines printed by the tool.
+#define TEST_FNC "fst,lst,cnt,sum,min,max,avg,var,dev,skw,krt,qnt:0.9,qnt:0,med,twa,itg,rat"
+
+/// Requested functions.
+static const uint8_t fncs[] = {
+  AGGSTAT_FNC_FST, AGGSTAT_FNC_LST, AGGSTAT_FNC_CNT, AGGSTAT_FNC_SUM, AGGSTAT_FNC_MIN,
+  AGGSTAT_FNC_MAX, AGGSTAT_FNC_AVG, AGGSTAT_FNC_VAR, AGGSTAT_FNC_DEV, AGGSTAT_FNC_SKW,
+  AGGSTAT_FNC_KRT, AGGSTAT_FNC_QNT, AGGSTAT_FNC_QNT, AGGSTAT_FNC_MED, AGGSTAT_FNC_TWA,
+  AGGSTAT_FNC_ITG, AGGSTAT_FNC_RAT
+};
+
+/// Parameters of the requested functions.
+static const AGGSTAT_FLT pars[] = {
+  AGGSTAT_0_0, AGGSTAT_0_0, AGGSTAT_0_0, AGGSTAT_0_0, AGGSTAT_0_0, AGGSTAT_0_0, AGGSTAT_0_0,
+  AGGSTAT_0_0, AGGSTAT_0_0, AGGSTAT_0_0, AGGSTAT_0_0, AGGSTAT_0_9, AGGSTAT_0_0, AGGSTAT_0_0,
+  AGGSTAT_0_0, AGGSTAT_0_0, AGGSTAT_0_0
+};
+
+/// Margins of error of the streaming algorithms for the number of values, listed in ERROR.md,
+/// which apply on top of the relative error of the merged results.
+static const AGGSTAT_FLT errs[] = {
+  AGGSTAT_0_0, AGGSTAT_0_0, AGGSTAT_0_0, AGGSTAT_0_0, AGGSTAT_0_0, AGGSTAT_0_0, AGGSTAT_0_0,
+  AGGSTAT_0_0, AGGSTAT_0_0, AGGSTAT_NUM(1, 0, -, 6), AGGSTAT_NUM(1, 0, -, 4), AGGSTAT_0_0,
+  AGGSTAT_0_0, AGGSTAT_0_0, AGGSTAT_0_0, AGGSTAT_0_0, AGGSTAT_0_0
+};
+
+/// Generate a next random number from the inclusive interval (0.0, 10.0).
+/// @return random number
+static AGGSTAT_FLT
+random_number(void)
+{
+  static uint32_t num = 77;
+  uint32_t per;
+
+  per = ((uint32_t)1 << 31) - 1;
+  num = (num * 214013 + 2531011) & per;
+
+  return (AGGSTAT_FLT)num / (AGGSTAT_FLT)per * AGGSTAT_NUM(10, 0, +, 0);
+}
+
+/// Report the outcome of a single check.
+///
+/// @param[out] res result
+/// @param[in]  nam name of the check
+/// @param[in]  ret outcome of the check
+static void
+check(bool* res, const char* nam, const bool ret)
+{
+  if (ret == true) {
+    (void)printf("%*s -> \e[32mokay\e[0m\n", 24, nam);
+  } else {
+    (void)printf("%*s -> \e[31mfail\e[0m\n", 24, nam);
+  }
+
+  *res = *res && ret;
+}
+
+/// Write the values to a file in the raw binary format of the given type.
+/// @return success/failure indication
+///
+/// @param[in] pth path to the file
+/// @param[in] typ type of the values
+/// @param[in] arr values
+/// @param[in] len number of values
+static bool
+write_file(const char* pth, const char* typ, const AGGSTAT_FLT* arr, const size_t len)
+{
+  FILE*   fil;
+  float   f32;
+  double  f64;
+  int64_t i64;
+  size_t  idx;
+  size_t  ret;
+
+  fil = fopen(pth, "wb");
+  if (fil == NULL) {
+    return false;
+  }
+
+  ret = 0;
+  for (idx = 0; idx < len; idx += 1) {
+    if (strcmp(typ, "f32") == 0) {
+      f32  = (float)arr[idx];
+      ret += fwrite(&f32, sizeof(f32), 1, fil);
+    } else if (strcmp(typ, "f64") == 0) {
+      f64  = (double)arr[idx];
+      ret += fwrite(&f64, sizeof(f64), 1, fil);
+    } else {
+      i64  = (int64_t)arr[idx];
+      ret += fwrite(&i64, sizeof(i64), 1, fil);
+    }
+  }
+
+  return fclose(fil) == 0 && ret == len;
+}
+
+/// Run the tool on a file and compare each printed result to the result of `aggstat_run` on the
+/// values as they are stored in the file.
+/// @return success/failure indication
+///
+/// @param[in] typ type of the values
+/// @param[in] thr number of worker threads
+/// @param[in] arr values, rounded to the type
+/// @param[in] tmp memory of the values reordered by the quantiles
+/// @param[in] len number of values
+static bool
+test_cli(const char*        typ,
+         const unsigned     thr,
+         const AGGSTAT_FLT* arr,
+         AGGSTAT_FLT*       tmp,
+         const size_t       len)
+{
+  FILE*       out;
+  char        cmd[256];
+  char        lin[256];
+  char*       sep;
+  AGGSTAT_FLT act;
+  AGGSTAT_FLT val;
+  size_t      idx;
+  bool        ret;
+  bool        res;
+
+  (void)snprintf(cmd, sizeof(cmd), "../cli/bin/aggstat -t %s -n %u -f %s bin/cli_%s.bin",
+                 typ, thr, TEST_FNC, typ);
+  out = popen(cmd, "r");
+  if (out == NULL) {
+    return false;
+  }
+
+  res = true;
+  for (idx = 0; idx < sizeof(fncs) / sizeof(fncs[0]); idx += 1) {
+    if (fgets(lin, sizeof(lin), out) == NULL) {
+      res = false;
+      break;
+    }
+
+    // The result follows the last space, and is not available if it could not be computed.
+    (void)memcpy(tmp, arr, len * sizeof(AGGSTAT_FLT));
+    ret = aggstat_run(&val, tmp, (AGGSTAT_INT)len, fncs[idx], pars[idx]);
+    sep = strrchr(lin, ' ');
+    if (sep == NULL || strncmp(sep + 1, "n/a", 3) == 0) {
+      res = res && ret == false;
+      continue;
+    }
+
+    act = (AGGSTAT_FLT)strtold(sep + 1, NULL);
+    res = res && ret == true
+       && AGGSTAT_ABS(act - val) <= TEST_EPS * AGGSTAT_FMAX(AGGSTAT_1_0, AGGSTAT_ABS(val))
+                                  + errs[idx];
+  }
+
+  return pclose(out) == 0 && res;
+}
+
+/// The goal of the test is to verify that the command-line tool produces the same results as the
+/// static algorithms for all types of files and for several numbers of worker threads, in
+/// particular across the parts and the blocks of both passes over the file.
+int
+main(void)
+{
+  static AGGSTAT_FLT arr[TEST_LEN];
+  static AGGSTAT_FLT cpy[TEST_LEN];
+  static AGGSTAT_FLT tmp[TEST_LEN];
+  const char*        typ[] = {"f32", "f64", "i64"};
+  char               pth[64];
+  size_t             idx;
+  size_t             jdx;
+  bool               res;
+  bool               ret;
+
+  res = true;
+
+  for (idx = 0; idx < TEST_LEN; idx += 1) {
+    arr[idx] = random_number() * AGGSTAT_NUM(1, 0, +, 2) - AGGSTAT_NUM(5, 0, +, 2);
+  }
+
+  for (jdx = 0; jdx < sizeof(typ) / sizeof(typ[0]); jdx += 1) {
+    (void)printf("%s\n", typ[jdx]);
+
+    // Round the values as they are stored in the file.
+    for (idx = 0; idx < TEST_LEN; idx += 1) {
+      if (strcmp(typ[jdx], "f32") == 0) {
+        cpy[idx] = (AGGSTAT_FLT)(float)arr[idx];
+      } else if (strcmp(typ[jdx], "f64") == 0) {
+        cpy[idx] = (AGGSTAT_FLT)(double)arr[idx];
+      } else {
+        cpy[idx] = (AGGSTAT_FLT)(int64_t)arr[idx];
+      }
+    }
+
+    (void)snprintf(pth, sizeof(pth), "bin/cli_%s.bin", typ[jdx]);
+    ret = write_file(pth, typ[jdx], arr, TEST_LEN);
+    check(&res, "write", ret);
+
+    ret = test_cli(typ[jdx], 1, cpy, tmp, TEST_LEN);
+    check(&res, "one thread vs run", ret);
+
+    ret = test_cli(typ[jdx], 3, cpy, tmp, TEST_LEN);
+    check(&res, "three threads vs run", ret);
+
+    (void)printf("\n");
+  }
+
+  // Ensure that the process succeeds only and only if all tests passed.
+  if (res == true) {
+    return EXIT_SUCCESS;
+  } else {
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,31 @@
+#!/bin/bash
+# Copyright (c) 2019-2021 Daniel Lovasko
+# All Rights Reserved
+#
+# Distributed under the terms of the 2-clause BSD License. The full
+# license is in the file LICENSE, distributed as part of this software.
+
+# Build the command-line tool and run it on generated files, comparing its
+# results to the static algorithms compiled for the same floating-point and
+# integer types as the tool.
+
+# Ensure that all relative paths remain correct.
+cd $(dirname $0)
+
+# C compilation settings.
+CC="cc"
+OPT="-O2"
+CFLAGS="-D_POSIX_C_SOURCE=201912 -std=c99 -Wall -Wextra -Werror"
+DEFS="-DAGGSTAT_FLT_BIT=64 -DAGGSTAT_INT_BIT=64"
+LDFLAGS="-lm"
+SRCS="cli.c ../src/get.c ../src/put.c ../src/new.c ../src/run.c ../src/mrg.c"
+
+# Ensure all program invocations are logged.
+set -x
+set -e
+
+bash ../cli/cli.sh
+
+${CC} ${CFLAGS} ${DEFS} ${OPT} -o bin/cli ${SRCS} ${LDFLAGS}
+
+./bin/cli
@@ -6,11 +6,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <inttypes.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <math.h>
 #include <time.h>
+#include <pthread.h>
 
 #include "../src/agg.h"
 #include "err.h"
@@ -22,6 +24,13 @@
 // Define a type-correct constant for ten.
 #define AGGSTAT_10_0 AGGSTAT_NUM(10, 0, +, 0)
 
+// Relative error tolerated by the checks of results that are not computed exactly.
+#if AGGSTAT_FLT_BIT == 32
+  #define TEST_EPS AGGSTAT_NUM(1, 0, -, 3)
+#else
+  #define TEST_EPS AGGSTAT_NUM(1, 0, -, 9)
+#endif
+
 /// Generate a next random number from the inclusive interval (0.0, 1.0).
 /// @return random number
 static AGGSTAT_FLT
@@ -178,6 +187,1769 @@ test(bool* res, const uint8_t fnc, const AGGSTAT_FLT par)
   (void)printf("\n");
 }
 
+/// Report the outcome of a single check.
+///
+/// @param[out] res result
+/// @param[in]  nam name of the check
+/// @param[in]  ret outcome of the check
+static void
+check(bool* res, const char* nam, const bool ret)
+{
+  if (ret == true) {
+    (void)printf("%*s -> \e[32mokay\e[0m\n", 24, nam);
+  } else {
+    (void)printf("%*s -> \e[31mfail\e[0m\n", 24, nam);
+  }
+
+  *res = *res && ret;
+}
+
+/// Determine whether two results are equal within the tolerated relative error.
+/// @return equality indication
+///
+/// @param[in] act actual result
+/// @param[in] exp expected result
+static bool
+near(const AGGSTAT_FLT act, const AGGSTAT_FLT exp)
+{
+  return AGGSTAT_ABS(act - exp) <= TEST_EPS * AGGSTAT_FMAX(AGGSTAT_1_0, AGGSTAT_ABS(exp));
+}
+
+/// Compare the aggregates of integer values to the aggregates of the same values converted to the
+/// floating-point type, and verify the exact results at the extremes of both integer types.
+///
+/// @param[out] res result
+static void
+test_int(bool* res)
+{
+  static const uint8_t fnc[] = {
+    AGGSTAT_FNC_CNT, AGGSTAT_FNC_SUM, AGGSTAT_FNC_MIN, AGGSTAT_FNC_MAX,
+    AGGSTAT_FNC_AVG, AGGSTAT_FNC_VAR, AGGSTAT_FNC_DEV
+  };
+  struct aggstat_int agg;
+  int64_t            sig[1000];
+  uint64_t           uns[1000];
+  AGGSTAT_FLT        arr[1000];
+  AGGSTAT_FLT        val[2];
+  int64_t            sgv[2];
+  uint64_t           usv[1];
+  AGGSTAT_INT        idx;
+  size_t             fix;
+  bool               ret;
+
+  // Small values are converted exactly, and so are their sums, minima and maxima.
+  for (idx = 0; idx < 1000; idx += 1) {
+    sig[idx] = (int64_t)(random_number() * AGGSTAT_10_0 * AGGSTAT_10_0) - 500;
+    uns[idx] = (uint64_t)(random_number() * AGGSTAT_10_0 * AGGSTAT_10_0);
+  }
+
+  ret = true;
+  for (fix = 0; fix < sizeof(fnc) / sizeof(fnc[0]); fix += 1) {
+    for (idx = 0; idx < 1000; idx += 1) {
+      arr[idx] = (AGGSTAT_FLT)sig[idx];
+    }
+
+    ret = ret && aggstat_run_i64(&val[0], sig, 1000, fnc[fix]) == true;
+    ret = ret && aggstat_run(&val[1], arr, 1000, fnc[fix], AGGSTAT_0_0) == true;
+    ret = ret && (fnc[fix] < AGGSTAT_FNC_AVG ? val[0] == val[1] : near(val[0], val[1]));
+
+    for (idx = 0; idx < 1000; idx += 1) {
+      arr[idx] = (AGGSTAT_FLT)uns[idx];
+    }
+
+    ret = ret && aggstat_run_u64(&val[0], uns, 1000, fnc[fix]) == true;
+    ret = ret && aggstat_run(&val[1], arr, 1000, fnc[fix], AGGSTAT_0_0) == true;
+    ret = ret && (fnc[fix] < AGGSTAT_FNC_AVG ? val[0] == val[1] : near(val[0], val[1]));
+  }
+  check(res, "run vs run_i64/u64", ret);
+
+  // The array variant accumulates the same exact sum as the single values.
+  ret = aggstat_new_int(&agg, AGGSTAT_FNC_SUM, true);
+  for (idx = 0; idx < 1000; idx += 1) {
+    aggstat_put_i64(&agg, sig[idx]);
+  }
+  ret = ret && aggstat_get_i64(&agg, &sgv[0]) == true;
+  ret = ret && aggstat_new_int(&agg, AGGSTAT_FNC_SUM, true) == true;
+  aggstat_put_i64_arr(&agg, sig, 1000);
+  ret = ret && aggstat_get_i64(&agg, &sgv[1]) == true;
+  check(res, "put vs put_arr", ret && sgv[0] == sgv[1]);
+
+  // Signed extremes.
+  sig[0] = INT64_MIN;
+  sig[1] = INT64_MAX;
+  sig[2] = -1;
+  sig[3] = 0;
+  ret = aggstat_new_int(&agg, AGGSTAT_FNC_MIN, true);
+  aggstat_put_i64_arr(&agg, sig, 4);
+  ret = ret && aggstat_get_i64(&agg, &sgv[0]) == true && sgv[0] == INT64_MIN;
+  ret = ret && aggstat_new_int(&agg, AGGSTAT_FNC_MAX, true) == true;
+  aggstat_put_i64_arr(&agg, sig, 4);
+  ret = ret && aggstat_get_i64(&agg, &sgv[0]) == true && sgv[0] == INT64_MAX;
+  ret = ret && aggstat_new_int(&agg, AGGSTAT_FNC_SUM, true) == true;
+  aggstat_put_i64_arr(&agg, sig, 4);
+  ret = ret && aggstat_get_i64(&agg, &sgv[0]) == true && sgv[0] == -2;
+  ret = ret && aggstat_get_u64(&agg, &usv[0]) == false;
+  aggstat_put_i64(&agg, INT64_MIN);
+  ret = ret && aggstat_get_i64(&agg, &sgv[0]) == false;
+  check(res, "signed extremes", ret);
+
+  // Unsigned extremes, whose sum exceeds 64 bits.
+  uns[0] = UINT64_MAX;
+  uns[1] = 0;
+  uns[2] = (uint64_t)1 << 63;
+  ret = aggstat_new_int(&agg, AGGSTAT_FNC_MIN, false);
+  aggstat_put_u64_arr(&agg, uns, 3);
+  ret = ret && aggstat_get_u64(&agg, &usv[0]) == true && usv[0] == 0;
+  ret = ret && aggstat_new_int(&agg, AGGSTAT_FNC_MAX, false) == true;
+  aggstat_put_u64_arr(&agg, uns, 3);
+  ret = ret && aggstat_get_u64(&agg, &usv[0]) == true && usv[0] == UINT64_MAX;
+  ret = ret && aggstat_new_int(&agg, AGGSTAT_FNC_SUM, false) == true;
+  aggstat_put_u64_arr(&agg, uns, 2);
+  ret = ret && aggstat_get_u64(&agg, &usv[0]) == true && usv[0] == UINT64_MAX;
+  ret = ret && aggstat_get_i64(&agg, &sgv[0]) == false;
+  aggstat_put_u64(&agg, 1);
+  ret = ret && aggstat_get_u64(&agg, &usv[0]) == false;
+  ret = ret && aggstat_get_int(&agg, &val[0]) == true;
+  ret = ret && near(val[0], AGGSTAT_2_0 * (AGGSTAT_FLT)((uint64_t)1 << 63));
+  check(res, "unsigned extremes", ret);
+
+  // Functions other than the supported ones are rejected.
+  check(res, "unsupported function", aggstat_new_int(&agg, AGGSTAT_FNC_QNT, false) == false);
+}
+
+/// Determine whether the markers of the streaming quantile are in order, with the first marker at
+/// the first position.
+/// @return order indication
+///
+/// @param[in] agg aggregate function
+static bool
+order_qnt(const struct aggstat* agg)
+{
+  uint8_t idx;
+
+  if (agg->ag_cnt[0] != 1) {
+    return false;
+  }
+
+  for (idx = 1; idx < 5; idx += 1) {
+    if (agg->ag_cnt[idx] <= agg->ag_cnt[idx - 1] || agg->ag_val[idx] < agg->ag_val[idx - 1]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/// Compare the aggregates of weighted values to the aggregates of the same stream with each value
+/// repeated by its weight, both for the on-line and the off-line algorithms.
+///
+/// @param[out] res result
+static void
+test_wgt(bool* res)
+{
+  struct aggstat agg[2];
+  AGGSTAT_FLT    arr[200];
+  AGGSTAT_INT    wgt[200];
+  AGGSTAT_FLT    cpy[200];
+  AGGSTAT_INT    cwg[200];
+  AGGSTAT_FLT    rep[1000];
+  AGGSTAT_FLT    val[2];
+  AGGSTAT_FLT*   all;
+  AGGSTAT_FLT    par;
+  AGGSTAT_INT    len;
+  AGGSTAT_INT    idx;
+  AGGSTAT_INT    occ;
+  uint8_t        fnc;
+  bool           ret[2];
+
+  // Weights of zero are included, even as the first weight.
+  len = 0;
+  for (idx = 0; idx < 200; idx += 1) {
+    arr[idx] = random_number();
+    wgt[idx] = idx == 0 ? 0 : (AGGSTAT_INT)(random_number() / AGGSTAT_2_0);
+    for (occ = 0; occ < wgt[idx]; occ += 1) {
+      rep[len] = arr[idx];
+      len     += 1;
+    }
+  }
+
+  ret[0] = true;
+  ret[1] = true;
+  for (fnc = AGGSTAT_FNC_FST; fnc <= AGGSTAT_FNC_MED; fnc += 1) {
+    par = fnc == AGGSTAT_FNC_QNT ? AGGSTAT_0_9 : AGGSTAT_0_0;
+
+    // The quantiles are estimated differently by the on-line algorithm, and thus only the moments
+    // are expected to be equal.
+    if (fnc < AGGSTAT_FNC_QNT) {
+      aggstat_new(&agg[0], fnc, par);
+      aggstat_new(&agg[1], fnc, par);
+      for (idx = 0; idx < 200; idx += 1) {
+        aggstat_put_w(&agg[0], arr[idx], wgt[idx]);
+      }
+      aggstat_put_arr(&agg[1], rep, len);
+
+      ret[0] = ret[0] && aggstat_get(&agg[0], &val[0]) == true;
+      ret[0] = ret[0] && aggstat_get(&agg[1], &val[1]) == true;
+      ret[0] = ret[0] && near(val[0], val[1]);
+    } else {
+      // Unit weights update the quantiles exactly as the values themselves, and count each value
+      // once.
+      aggstat_new(&agg[0], fnc, par);
+      aggstat_new(&agg[1], fnc, par);
+      for (idx = 0; idx < 200; idx += 1) {
+        aggstat_put_w(&agg[0], arr[idx], 1);
+      }
+      aggstat_put_arr(&agg[1], arr, 200);
+
+      ret[0] = ret[0] && aggstat_get(&agg[0], &val[0]) == true;
+      ret[0] = ret[0] && aggstat_get(&agg[1], &val[1]) == true;
+      ret[0] = ret[0] && val[0] == val[1] && agg[0].ag_cnt[0] == agg[1].ag_cnt[0];
+    }
+
+    // The off-line algorithm reorders the arrays.
+    for (idx = 0; idx < 200; idx += 1) {
+      cpy[idx] = arr[idx];
+      cwg[idx] = wgt[idx];
+    }
+
+    ret[1] = ret[1] && aggstat_run_w(&val[0], cpy, cwg, 200, fnc, par) == true;
+    ret[1] = ret[1] && aggstat_run(&val[1], rep, len, fnc, par) == true;
+    ret[1] = ret[1] && near(val[0], val[1]);
+  }
+
+  check(res, "put_w vs repeated put", ret[0]);
+  check(res, "run_w vs repeated run", ret[1]);
+
+  // Large weights after the initial values keep the markers in order, and the median recovers
+  // once the stream continues with single values. The upper quantile recovers as slowly as after
+  // the repeated values, and is compared to them below.
+  all = malloc(2110 * sizeof(AGGSTAT_FLT));
+  if (all == NULL) {
+    check(res, "memory", false);
+    return;
+  }
+
+  ret[0] = true;
+  for (fnc = AGGSTAT_FNC_QNT; fnc <= AGGSTAT_FNC_MED; fnc += 1) {
+    aggstat_new(&agg[0], fnc, AGGSTAT_0_9);
+    for (idx = 0; idx < 10; idx += 1) {
+      all[idx] = random_number();
+      aggstat_put(&agg[0], all[idx]);
+    }
+
+    aggstat_put_w(&agg[0], (AGGSTAT_FLT)100, 50);
+    aggstat_put_w(&agg[0], (AGGSTAT_FLT)200, 50);
+    ret[0] = ret[0] && order_qnt(&agg[0]) == true && agg[0].ag_cnt[4] == 110;
+    for (idx = 10; idx < 60; idx += 1) {
+      all[idx]      = (AGGSTAT_FLT)100;
+      all[idx + 50] = (AGGSTAT_FLT)200;
+    }
+
+    for (idx = 110; idx < 2110; idx += 1) {
+      all[idx] = random_number();
+      aggstat_put(&agg[0], all[idx]);
+    }
+
+    par    = fnc == AGGSTAT_FNC_QNT ? AGGSTAT_0_9 : AGGSTAT_0_5;
+    ret[0] = ret[0] && order_qnt(&agg[0]) == true && aggstat_get(&agg[0], &val[0]) == true;
+    ret[0] = ret[0] && aggstat_run(&val[1], all, 2110, AGGSTAT_FNC_QNT, par) == true;
+    ret[0] = ret[0] && (fnc == AGGSTAT_FNC_QNT || AGGSTAT_ABS(val[0] - val[1]) < AGGSTAT_0_5);
+  }
+  check(res, "put_w markers", ret[0]);
+
+  // Weighted quantiles approximate the repeated values within 0.5 % of the range of the values,
+  // and within 5 % if a few weights dominate the stream.
+  ret[0] = true;
+  for (fnc = AGGSTAT_FNC_QNT; fnc <= AGGSTAT_FNC_MED; fnc += 1) {
+    aggstat_new(&agg[0], fnc, AGGSTAT_0_9);
+    aggstat_new(&agg[1], fnc, AGGSTAT_0_9);
+    for (idx = 0; idx < 1000; idx += 1) {
+      val[0] = random_number();
+      occ    = 1 + (AGGSTAT_INT)(random_number() * AGGSTAT_5_0);
+      aggstat_put_w(&agg[0], val[0], occ);
+      for (; occ > 0; occ -= 1) {
+        aggstat_put(&agg[1], val[0]);
+      }
+    }
+
+    ret[0] = ret[0] && aggstat_get(&agg[0], &val[0]) == true;
+    ret[0] = ret[0] && aggstat_get(&agg[1], &val[1]) == true;
+    ret[0] = ret[0] && AGGSTAT_ABS(val[0] - val[1]) <= AGGSTAT_NUM(5, 0, -, 2);
+
+    aggstat_new(&agg[0], fnc, AGGSTAT_0_9);
+    aggstat_new(&agg[1], fnc, AGGSTAT_0_9);
+    for (idx = 0; idx < 10; idx += 1) {
+      val[0] = random_number();
+      aggstat_put(&agg[0], val[0]);
+      aggstat_put(&agg[1], val[0]);
+    }
+
+    aggstat_put_w(&agg[0], (AGGSTAT_FLT)100, 50);
+    aggstat_put_w(&agg[0], (AGGSTAT_FLT)200, 50);
+    for (idx = 0; idx < 100; idx += 1) {
+      aggstat_put(&agg[1], idx < 50 ? (AGGSTAT_FLT)100 : (AGGSTAT_FLT)200);
+    }
+
+    ret[0] = ret[0] && aggstat_get(&agg[0], &val[0]) == true;
+    ret[0] = ret[0] && aggstat_get(&agg[1], &val[1]) == true;
+    ret[0] = ret[0] && AGGSTAT_ABS(val[0] - val[1]) <= AGGSTAT_NUM(1, 0, +, 1);
+  }
+  check(res, "put_w vs repeated qnt", ret[0]);
+
+  free(all);
+}
+
+/// Compare the aggregates after the retraction of values to the aggregates rebuilt from the
+/// remaining values, including the retraction of the last remaining value.
+///
+/// @param[out] res result
+static void
+test_del(bool* res)
+{
+  static const uint8_t fnc[] = {
+    AGGSTAT_FNC_CNT, AGGSTAT_FNC_SUM, AGGSTAT_FNC_AVG, AGGSTAT_FNC_VAR,
+    AGGSTAT_FNC_DEV, AGGSTAT_FNC_SKW, AGGSTAT_FNC_KRT
+  };
+  struct aggstat agg[2];
+  AGGSTAT_FLT    arr[300];
+  AGGSTAT_FLT    val[2];
+  AGGSTAT_INT    idx;
+  size_t         fix;
+  bool           ret[3];
+
+  for (idx = 0; idx < 300; idx += 1) {
+    arr[idx] = random_number();
+  }
+
+  ret[0] = true;
+  ret[1] = true;
+  for (fix = 0; fix < sizeof(fnc) / sizeof(fnc[0]); fix += 1) {
+    aggstat_new(&agg[0], fnc[fix], AGGSTAT_0_0);
+    aggstat_new(&agg[1], fnc[fix], AGGSTAT_0_0);
+    aggstat_put_arr(&agg[0], arr, 300);
+    aggstat_put_arr(&agg[1], arr + 100, 200);
+
+    // Retract the oldest third of the values.
+    ret[0] = ret[0] && aggstat_del_arr(&agg[0], arr, 100) == true;
+    ret[0] = ret[0] && aggstat_get(&agg[0], &val[0]) == true;
+    ret[0] = ret[0] && aggstat_get(&agg[1], &val[1]) == true;
+    ret[0] = ret[0] && near(val[0], val[1]);
+
+    // Retract all remaining values one by one, which resets the state, and apply two values.
+    for (idx = 100; idx < 300; idx += 1) {
+      ret[1] = ret[1] && aggstat_del(&agg[0], arr[idx]) == true;
+    }
+    ret[1] = ret[1] && agg[0].ag_cnt[0] == 0;
+    ret[1] = ret[1] && aggstat_del(&agg[0], arr[0]) == false;
+
+    aggstat_new(&agg[1], fnc[fix], AGGSTAT_0_0);
+    aggstat_put_arr(&agg[0], arr, 2);
+    aggstat_put_arr(&agg[1], arr, 2);
+    ret[2] = aggstat_get(&agg[0], &val[0]);
+    ret[1] = ret[1] && ret[2] == aggstat_get(&agg[1], &val[1]);
+    ret[1] = ret[1] && (ret[2] == false || val[0] == val[1]);
+  }
+
+  check(res, "del vs rebuilt", ret[0]);
+  check(res, "del of last value", ret[1]);
+
+  // Functions that can not be inverted are rejected, and so are arrays longer than the stream.
+  aggstat_new(&agg[0], AGGSTAT_FNC_MIN, AGGSTAT_0_0);
+  aggstat_put(&agg[0], arr[0]);
+  ret[2] = aggstat_del(&agg[0], arr[0]) == false;
+  aggstat_new(&agg[0], AGGSTAT_FNC_QNT, AGGSTAT_0_9);
+  aggstat_put(&agg[0], arr[0]);
+  ret[2] = ret[2] && aggstat_del(&agg[0], arr[0]) == false;
+  aggstat_new(&agg[0], AGGSTAT_FNC_SUM, AGGSTAT_0_0);
+  aggstat_put_arr(&agg[0], arr, 2);
+  ret[2] = ret[2] && aggstat_del_arr(&agg[0], arr, 3) == false && agg[0].ag_cnt[0] == 2;
+  check(res, "unsupported retraction", ret[2]);
+}
+
+/// Compare the aggregates of strided and indexed streams to the aggregates of the same values
+/// gathered into a contiguous array.
+///
+/// @param[out] res result
+static void
+test_vew(bool* res)
+{
+  struct {
+    uint32_t    r_key;
+    AGGSTAT_FLT r_val;
+  }              rec[500];
+  AGGSTAT_FLT    arr[500];
+  AGGSTAT_INT    idx[400];
+  AGGSTAT_FLT    gth[400];
+  AGGSTAT_FLT    cpy[500];
+  AGGSTAT_FLT    val[2];
+  AGGSTAT_FLT    par;
+  AGGSTAT_INT    pos;
+  uint8_t        fnc;
+  bool           ret[2];
+
+  for (pos = 0; pos < 500; pos += 1) {
+    rec[pos].r_key = (uint32_t)pos;
+    rec[pos].r_val = random_number();
+    arr[pos]       = rec[pos].r_val;
+  }
+
+  // The indices are in random order and repeat some of the values.
+  for (pos = 0; pos < 400; pos += 1) {
+    idx[pos] = (AGGSTAT_INT)(random_number() * AGGSTAT_10_0 * AGGSTAT_5_0) % 500;
+    gth[pos] = arr[idx[pos]];
+  }
+
+  ret[0] = true;
+  ret[1] = true;
+  for (fnc = AGGSTAT_FNC_FST; fnc <= AGGSTAT_FNC_RAT; fnc += 1) {
+    par = fnc == AGGSTAT_FNC_QNT ? AGGSTAT_0_75 : AGGSTAT_0_0;
+
+    // The off-line algorithm sorts the array in-place for the quantiles.
+    for (pos = 0; pos < 500; pos += 1) {
+      cpy[pos] = arr[pos];
+    }
+
+    ret[0] = ret[0] && aggstat_run_strided(&val[0], &rec[0].r_val, sizeof(rec[0]), 500, fnc, par);
+    ret[0] = ret[0] && aggstat_run(&val[1], cpy, 500, fnc, par) == true;
+    ret[0] = ret[0] && near(val[0], val[1]);
+
+    for (pos = 0; pos < 400; pos += 1) {
+      cpy[pos] = gth[pos];
+    }
+
+    ret[1] = ret[1] && aggstat_run_idx(&val[0], arr, idx, 400, fnc, par) == true;
+    ret[1] = ret[1] && aggstat_run(&val[1], cpy, 400, fnc, par) == true;
+    ret[1] = ret[1] && near(val[0], val[1]);
+  }
+
+  check(res, "run_strided vs run", ret[0]);
+  check(res, "run_idx vs run", ret[1]);
+}
+
+/// Compare the parsing of numbers to the standard library, and the aggregates of a delimited text
+/// passed in buffers of various lengths to the aggregates of the same text passed at once.
+///
+/// @param[out] res result
+static void
+test_txt(bool* res)
+{
+  static const size_t siz[] = {1, 2, 3, 7, 8, 13, 64, 4096};
+  struct aggstat_txt  txt;
+  struct aggstat      agg[2][2];
+  AGGSTAT_FLT         arr[300];
+  AGGSTAT_FLT         val[2];
+  char                str[40];
+  char                buf[16384];
+  char*               end;
+  size_t              len;
+  size_t              pos;
+  size_t              six;
+  size_t              num;
+  int                 dig;
+  int                 pnt;
+  int                 idx;
+  bool                ret;
+
+  // Numbers with up to 19 significant digits, a random decimal point and an optional exponent
+  // cover both the fast path and the fallback to the standard library.
+  ret = true;
+  for (idx = 0; idx < 5000; idx += 1) {
+    len = 0;
+    if (random_number() < AGGSTAT_5_0) {
+      str[len++] = '-';
+    }
+
+    num = 1 + (size_t)(random_number() * AGGSTAT_2_0) % 19;
+    pnt = (int)(random_number() * AGGSTAT_2_0) % (int)(num + 1);
+    for (dig = 0; dig < (int)num; dig += 1) {
+      if (dig == pnt && dig > 0) {
+        str[len++] = '.';
+      }
+
+      str[len++] = (char)('0' + (int)random_number() % 10);
+    }
+
+    if (random_number() < AGGSTAT_5_0) {
+      len += (size_t)sprintf(str + len, "e%d", (int)(random_number() * AGGSTAT_5_0) - 25);
+    }
+    str[len] = '\0';
+
+    ret = ret && aggstat_txt_flt(&val[0], str, len) == true;
+    val[1] = AGGSTAT_STRTO(str, &end);
+    ret = ret && val[0] == val[1];
+  }
+  check(res, "fast path vs strtod", ret);
+
+  // Blanks, infinities and fields that are not numbers.
+  ret = aggstat_txt_flt(&val[0], " \t1.75\r", 7) == true && val[0] == AGGSTAT_1_0 + AGGSTAT_0_75;
+  ret = ret && aggstat_txt_flt(&val[0], "-inf", 4) == true && val[0] < AGGSTAT_0_0;
+  ret = ret && aggstat_txt_flt(&val[0], "  ", 2) == false;
+  ret = ret && aggstat_txt_flt(&val[0], "1.5x", 4) == false;
+  check(res, "blanks and errors", ret);
+
+  // Lines alternate between CRLF and LF, and the selected column is sometimes empty or not a
+  // number. The last line does not end with a newline.
+  len = 0;
+  num = 0;
+  for (idx = 0; idx < 300; idx += 1) {
+    if (idx % 7 == 3) {
+      len += (size_t)sprintf(buf + len, "%d,,tail", idx);
+    } else if (idx % 11 == 5) {
+      len += (size_t)sprintf(buf + len, "%d,x1,tail", idx);
+    } else {
+      pos  = len + (size_t)sprintf(buf + len, "%d,", idx);
+      len  = pos + (size_t)sprintf(buf + pos, "%s%d.%03d",
+                                   idx % 2 == 0 ? "-" : " ",
+                                   (int)(random_number() * AGGSTAT_10_0 * AGGSTAT_10_0),
+                                   (int)(random_number() * AGGSTAT_10_0 * AGGSTAT_10_0) % 1000);
+      arr[num] = AGGSTAT_STRTO(buf + pos, &end);
+      num     += 1;
+      len     += (size_t)sprintf(buf + len, ",tail");
+    }
+
+    if (idx < 299) {
+      len += (size_t)sprintf(buf + len, idx % 2 == 0 ? "\r\n" : "\n");
+    }
+  }
+
+  (void)aggstat_new(&agg[1][0], AGGSTAT_FNC_SUM, AGGSTAT_0_0);
+  (void)aggstat_new(&agg[1][1], AGGSTAT_FNC_MAX, AGGSTAT_0_0);
+  aggstat_put_arr(&agg[1][0], arr, (AGGSTAT_INT)num);
+  aggstat_put_arr(&agg[1][1], arr, (AGGSTAT_INT)num);
+
+  ret = true;
+  for (six = 0; six < sizeof(siz) / sizeof(siz[0]); six += 1) {
+    aggstat_txt_new(&txt, ',', 1);
+    (void)aggstat_new(&agg[0][0], AGGSTAT_FNC_SUM, AGGSTAT_0_0);
+    (void)aggstat_new(&agg[0][1], AGGSTAT_FNC_MAX, AGGSTAT_0_0);
+    for (pos = 0; pos < len; pos += siz[six]) {
+      aggstat_txt_put(&txt, buf + pos, len - pos < siz[six] ? len - pos : siz[six], agg[0], 2);
+    }
+    aggstat_txt_end(&txt, agg[0], 2);
+
+    ret = ret && txt.at_cnt == (AGGSTAT_INT)num && txt.at_err == 23;
+    ret = ret && aggstat_get(&agg[0][0], &val[0]) == true;
+    ret = ret && aggstat_get(&agg[1][0], &val[1]) == true && val[0] == val[1];
+    ret = ret && aggstat_get(&agg[0][1], &val[0]) == true;
+    ret = ret && aggstat_get(&agg[1][1], &val[1]) == true && val[0] == val[1];
+  }
+  check(res, "split buffers vs put_arr", ret);
+}
+
+/// Compare the shared computation of multiple aggregates to the aggregates computed separately,
+/// both for distinct values and for values with many duplicates.
+///
+/// @param[out] res result
+static void
+test_many(bool* res)
+{
+  uint8_t     fnc[20];
+  AGGSTAT_FLT par[20];
+  AGGSTAT_FLT arr[2000];
+  AGGSTAT_FLT cpy[2000];
+  AGGSTAT_FLT val[20];
+  AGGSTAT_FLT exp;
+  AGGSTAT_INT pos;
+  size_t      req;
+  uint8_t     dup;
+  bool        ret;
+
+  // All functions, and additional quantiles at both ends of the order.
+  for (req = 0; req < AGGSTAT_FNC_RAT; req += 1) {
+    fnc[req] = (uint8_t)(req + 1);
+    par[req] = fnc[req] == AGGSTAT_FNC_QNT ? AGGSTAT_0_75 : AGGSTAT_0_0;
+  }
+
+  fnc[16] = AGGSTAT_FNC_QNT;
+  par[16] = AGGSTAT_0_0;
+  fnc[17] = AGGSTAT_FNC_QNT;
+  par[17] = AGGSTAT_0_1;
+  fnc[18] = AGGSTAT_FNC_QNT;
+  par[18] = AGGSTAT_0_99;
+  fnc[19] = AGGSTAT_FNC_QNT;
+  par[19] = AGGSTAT_1_0;
+
+  for (dup = 0; dup < 2; dup += 1) {
+    for (pos = 0; pos < 2000; pos += 1) {
+      arr[pos] = dup == 0 ? random_number() : (AGGSTAT_FLT)(int)random_number();
+      cpy[pos] = arr[pos];
+    }
+
+    ret = aggstat_run_many(val, cpy, 2000, fnc, par, 20) == true;
+    for (req = 0; req < 20; req += 1) {
+      // The off-line algorithm sorts the array in-place for the quantiles.
+      for (pos = 0; pos < 2000; pos += 1) {
+        cpy[pos] = arr[pos];
+      }
+
+      ret = ret && aggstat_run(&exp, cpy, 2000, fnc[req], par[req]) == true;
+      if (fnc[req] == AGGSTAT_FNC_QNT || fnc[req] == AGGSTAT_FNC_MED) {
+        ret = ret && val[req] == exp;
+      } else {
+        ret = ret && near(val[req], exp);
+      }
+    }
+
+    check(res, dup == 0 ? "run_many vs run" : "run_many vs run (dup)", ret);
+  }
+
+  // A single invalid request fails all of them.
+  fnc[0] = 0;
+  check(res, "invalid request", aggstat_run_many(val, cpy, 2000, fnc, par, 20) == false);
+}
+
+/// Pass a stream to the out-of-core aggregate function in chunks, as many times as requested.
+/// @return number of passes
+///
+/// @param[in] ooc out-of-core aggregate function
+/// @param[in] arr array representing the stream
+/// @param[in] len length of the stream
+static uint32_t
+pass_ooc(struct aggstat_ooc* ooc, const AGGSTAT_FLT* arr, const AGGSTAT_INT len)
+{
+  AGGSTAT_INT pos;
+  uint32_t    cnt;
+
+  cnt = 0;
+  do {
+    for (pos = 0; pos < len; pos += 100) {
+      aggstat_ooc_put(ooc, arr + pos, len - pos < 100 ? len - pos : 100);
+    }
+    cnt += 1;
+  } while (aggstat_ooc_end(ooc) == true);
+
+  return cnt;
+}
+
+/// Compare the out-of-core aggregates to the off-line aggregates, with a memory budget that fits
+/// the whole stream and with one that requires multiple passes, both for distinct values and for
+/// values with many duplicates.
+///
+/// @param[out] res result
+static void
+test_ooc(bool* res)
+{
+  static const size_t siz[] = {1024, 65536};
+  struct aggstat_ooc  ooc;
+  struct aggstat      agg;
+  AGGSTAT_FLT         arr[3000];
+  AGGSTAT_FLT         cpy[3000];
+  AGGSTAT_FLT         val[2];
+  AGGSTAT_FLT         par;
+  AGGSTAT_INT         pos;
+  void*               mem;
+  uint32_t            cnt;
+  size_t              six;
+  uint8_t             fnc;
+  uint8_t             dup;
+  bool                ret[3];
+
+  mem = malloc(65536);
+  if (mem == NULL) {
+    check(res, "malloc", false);
+    return;
+  }
+
+  for (dup = 0; dup < 2; dup += 1) {
+    for (pos = 0; pos < 3000; pos += 1) {
+      arr[pos] = dup == 0 ? random_number() - AGGSTAT_5_0 : (AGGSTAT_FLT)((int)random_number() - 5);
+    }
+
+    // Functions other than the quantiles need a single pass without any memory, and their results
+    // are those of the on-line algorithm.
+    ret[0] = true;
+    for (fnc = AGGSTAT_FNC_FST; fnc <= AGGSTAT_FNC_KRT; fnc += 1) {
+      ret[0] = ret[0] && aggstat_ooc_new(&ooc, fnc, AGGSTAT_0_0, NULL, 0) == true;
+      ret[0] = ret[0] && pass_ooc(&ooc, arr, 3000) == 1;
+      ret[0] = ret[0] && aggstat_ooc_get(&ooc, &val[0]) == true;
+      aggstat_new(&agg, fnc, AGGSTAT_0_0);
+      aggstat_put_arr(&agg, arr, 3000);
+      ret[0] = ret[0] && aggstat_get(&agg, &val[1]) == true;
+      ret[0] = ret[0] && near(val[0], val[1]);
+    }
+
+    // The quantiles need a single pass only if the stream fits into the budget.
+    ret[1] = true;
+    ret[2] = true;
+    for (six = 0; six < 2; six += 1) {
+      for (par = AGGSTAT_0_0; par <= AGGSTAT_1_0; par += AGGSTAT_0_1) {
+        for (pos = 0; pos < 3000; pos += 1) {
+          cpy[pos] = arr[pos];
+        }
+
+        ret[six + 1] = ret[six + 1] && aggstat_ooc_new(&ooc, AGGSTAT_FNC_QNT, par, mem, siz[six]);
+        cnt          = pass_ooc(&ooc, arr, 3000);
+        ret[six + 1] = ret[six + 1] && (six == 0 ? cnt > 1 : cnt == 1);
+        ret[six + 1] = ret[six + 1] && aggstat_ooc_get(&ooc, &val[0]) == true;
+        ret[six + 1] = ret[six + 1] && aggstat_run(&val[1], cpy, 3000, AGGSTAT_FNC_QNT, par);
+        ret[six + 1] = ret[six + 1] && val[0] == val[1];
+      }
+    }
+
+    check(res, dup == 0 ? "ooc vs put_arr" : "ooc vs put_arr (dup)", ret[0]);
+    check(res, dup == 0 ? "multi-pass vs run" : "multi-pass vs run (dup)", ret[1]);
+    check(res, dup == 0 ? "single-pass vs run" : "single-pass vs run (dup)", ret[2]);
+  }
+
+  // A stream that differs between the passes is detected.
+  ret[0] = aggstat_ooc_new(&ooc, AGGSTAT_FNC_MED, AGGSTAT_0_0, mem, siz[0]);
+  for (pos = 0; pos < 3000; pos += 100) {
+    aggstat_ooc_put(&ooc, arr + pos, 100);
+  }
+  ret[0] = ret[0] && aggstat_ooc_end(&ooc) == true;
+  aggstat_ooc_put(&ooc, arr, 100);
+  ret[0] = ret[0] && aggstat_ooc_end(&ooc) == false;
+  ret[0] = ret[0] && aggstat_ooc_get(&ooc, &val[0]) == false;
+  check(res, "changed stream", ret[0]);
+
+  free(mem);
+}
+
+/// Compare the quantiles of a buffer that is queried repeatedly while it grows to the off-line
+/// quantiles of the values appended so far, both for distinct values and for values with many
+/// duplicates.
+///
+/// @param[out] res result
+static void
+test_buf(bool* res)
+{
+  struct aggstat_buf buf[2];
+  AGGSTAT_FLT        arr[3000];
+  AGGSTAT_FLT        cpy[3000];
+  AGGSTAT_FLT        val[2];
+  AGGSTAT_INT        pos;
+  AGGSTAT_INT        end;
+  uint8_t            dup;
+  bool               ret;
+
+  for (dup = 0; dup < 2; dup += 1) {
+    for (pos = 0; pos < 3000; pos += 1) {
+      arr[pos] = dup == 0 ? random_number() : (AGGSTAT_FLT)(int)random_number();
+    }
+
+    ret = aggstat_buf_new(&buf[0], AGGSTAT_FNC_QNT, AGGSTAT_0_9) == true;
+    ret = ret && aggstat_buf_new(&buf[1], AGGSTAT_FNC_MED, AGGSTAT_0_0) == true;
+
+    // Append single values and arrays in turns, and query after each of them.
+    for (end = 0; end < 3000; end += 250) {
+      if (end % 500 == 0) {
+        ret = ret && aggstat_buf_put_arr(&buf[0], arr + end, 250) == true;
+        ret = ret && aggstat_buf_put_arr(&buf[1], arr + end, 250) == true;
+      } else {
+        for (pos = end; pos < end + 250; pos += 1) {
+          ret = ret && aggstat_buf_put(&buf[0], arr[pos]) == true;
+          ret = ret && aggstat_buf_put(&buf[1], arr[pos]) == true;
+        }
+      }
+
+      // The off-line algorithm sorts the array in-place for the quantiles.
+      for (pos = 0; pos < end + 250; pos += 1) {
+        cpy[pos] = arr[pos];
+      }
+
+      ret = ret && aggstat_buf_get(&buf[0], &val[0]) == true;
+      ret = ret && aggstat_run(&val[1], cpy, end + 250, AGGSTAT_FNC_QNT, AGGSTAT_0_9) == true;
+      ret = ret && val[0] == val[1];
+      ret = ret && aggstat_buf_get(&buf[1], &val[0]) == true;
+      ret = ret && aggstat_run(&val[1], cpy, end + 250, AGGSTAT_FNC_MED, AGGSTAT_0_0) == true;
+      ret = ret && val[0] == val[1];
+    }
+
+    aggstat_buf_free(&buf[0]);
+    aggstat_buf_free(&buf[1]);
+    check(res, dup == 0 ? "buf vs run" : "buf vs run (dup)", ret);
+  }
+
+  // Empty buffers, functions other than the quantiles and invalid parameters are rejected.
+  ret = aggstat_buf_new(&buf[0], AGGSTAT_FNC_QNT, AGGSTAT_0_5) == true;
+  ret = ret && aggstat_buf_get(&buf[0], &val[0]) == false;
+  ret = ret && aggstat_buf_new(&buf[0], AGGSTAT_FNC_AVG, AGGSTAT_0_0) == false;
+  ret = ret && aggstat_buf_new(&buf[0], AGGSTAT_FNC_QNT, AGGSTAT_2_0) == false;
+  check(res, "invalid buffer", ret);
+}
+
+/// Compare the aggregates of time ranges of a rollup to the aggregates of the values within the
+/// same ranges, including ranges that are widened to the buckets that retain them.
+///
+/// @param[out] res result
+static void
+test_rol(bool* res)
+{
+  static const uint8_t  fnc[] = {
+    AGGSTAT_FNC_CNT, AGGSTAT_FNC_SUM, AGGSTAT_FNC_MIN, AGGSTAT_FNC_MAX,
+    AGGSTAT_FNC_AVG, AGGSTAT_FNC_VAR
+  };
+  static const uint64_t gra[] = {1, 10, 100};
+  static const uint64_t len[] = {20, 20, 10};
+  static const uint64_t rng[][3] = {
+    {985, 1000,  985}, // finest level only
+    {900, 1000,  900}, // minutes and seconds
+    {0,   1000,    0}, // all levels
+    {250,  995,  200}, // widened to the start of an hour
+    {503,  997,  500}, // widened to the start of an hour, ending within the seconds
+  };
+  struct aggstat_rol rol;
+  struct aggstat     bkt[50];
+  struct aggstat     agg;
+  AGGSTAT_FLT        arr[1000];
+  AGGSTAT_FLT        val[2];
+  uint64_t           tim;
+  uint64_t           pos;
+  size_t             fix;
+  size_t             rix;
+  bool               ret;
+
+  for (tim = 0; tim < 1000; tim += 1) {
+    arr[tim] = random_number();
+  }
+
+  ret = true;
+  for (fix = 0; fix < sizeof(fnc) / sizeof(fnc[0]); fix += 1) {
+    ret = ret && aggstat_rol_new(&rol, fnc[fix], AGGSTAT_0_0, bkt, gra, len, 3, 5) == true;
+
+    // The values arrive in reverse order within groups of four, which is within the tolerated
+    // lateness.
+    for (tim = 0; tim < 1000; tim += 1) {
+      pos = tim - tim % 4 + 3 - tim % 4;
+      ret = ret && aggstat_rol_put(&rol, pos, arr[pos]) == true;
+    }
+
+    for (rix = 0; rix < sizeof(rng) / sizeof(rng[0]); rix += 1) {
+      aggstat_new(&agg, fnc[fix], AGGSTAT_0_0);
+      aggstat_put_arr(&agg, arr + rng[rix][2], (AGGSTAT_INT)(rng[rix][1] - rng[rix][2]));
+      ret = ret && aggstat_get(&agg, &val[1]) == true;
+      ret = ret && aggstat_rol_get(&rol, rng[rix][0], rng[rix][1], &val[0]) == true;
+      ret = ret && near(val[0], val[1]);
+    }
+  }
+  check(res, "rol vs put_arr", ret);
+
+  // Values later than the tolerated lateness are rejected, and ranges that are no longer retained
+  // by any level can not be aggregated.
+  ret = aggstat_rol_put(&rol, 993, AGGSTAT_1_0) == false;
+  for (tim = 1000; tim < 1500; tim += 1) {
+    ret = ret && aggstat_rol_put(&rol, tim, AGGSTAT_1_0) == true;
+  }
+  ret = ret && aggstat_rol_get(&rol, 0, 100, &val[0]) == false;
+  ret = ret && aggstat_rol_get(&rol, 600, 1500, &val[0]) == true;
+  check(res, "lateness and retention", ret);
+
+  // The quantiles can not be merged, and the rings must span the lateness.
+  ret = aggstat_rol_new(&rol, AGGSTAT_FNC_QNT, AGGSTAT_0_5, bkt, gra, len, 3, 5) == false;
+  ret = ret && aggstat_rol_new(&rol, AGGSTAT_FNC_SUM, AGGSTAT_0_0, bkt, gra, len, 3, 20) == false;
+  check(res, "invalid rollup", ret);
+}
+
+/// Verify the counts of the frequent values against the true counts of the stream.
+/// @return success/failure indication
+///
+/// @param[in] frq frequent values
+/// @param[in] tru true counts of the values 0 to 4
+/// @param[in] tot number of values
+static bool
+bound_frq(struct aggstat_frq* frq, const uint64_t* tru, const uint64_t tot)
+{
+  AGGSTAT_FLT val[32];
+  uint64_t    cnt[32];
+  uint64_t    err[32];
+  uint64_t    exp;
+  uint32_t    num;
+  uint32_t    idx;
+  uint32_t    fnd;
+  bool        ret;
+
+  num = aggstat_frq_top(frq, val, cnt, err, 32);
+  ret = num == 32 && frq->af_tot == tot;
+
+  // The counts overestimate the true counts by at most their bounds, which are at most the number
+  // of values divided by the number of counters. All values that occur more often are found.
+  fnd = 0;
+  for (idx = 0; idx < num; idx += 1) {
+    exp = val[idx] < AGGSTAT_5_0 ? tru[(int)val[idx]] : 2;
+    fnd = fnd + (val[idx] < AGGSTAT_5_0 ? 1 : 0);
+    ret = ret && cnt[idx] >= exp && cnt[idx] - err[idx] <= exp && err[idx] <= tot / 32;
+    ret = ret && (idx == 0 || cnt[idx] <= cnt[idx - 1]);
+  }
+
+  return ret && fnd == 5;
+}
+
+/// Compare the frequent values of a stream to the true counts of its values, including the values
+/// passed as an array and merged from two halves of the stream.
+///
+/// @param[out] res result
+static void
+test_frq(bool* res)
+{
+  struct aggstat_frq frq[3];
+  AGGSTAT_FLT        arr[20000];
+  AGGSTAT_FLT        val[2][32];
+  uint64_t           cnt[2][32];
+  uint64_t           err[2][32];
+  uint64_t           tru[5];
+  AGGSTAT_FLT        num;
+  void*              mem[3];
+  AGGSTAT_INT        pos;
+  uint32_t           idx;
+  bool               ret;
+
+  mem[0] = malloc(AGGSTAT_FRQ_SIZ(32));
+  mem[1] = malloc(AGGSTAT_FRQ_SIZ(32));
+  mem[2] = malloc(AGGSTAT_FRQ_SIZ(32));
+  if (mem[0] == NULL || mem[1] == NULL || mem[2] == NULL) {
+    free(mem[0]);
+    free(mem[1]);
+    free(mem[2]);
+    check(res, "malloc", false);
+    return;
+  }
+
+  // Half of the values are skewed among five frequent values, and the others are distinct. Each
+  // value occurs twice in a row.
+  for (idx = 0; idx < 5; idx += 1) {
+    tru[idx] = 0;
+  }
+
+  for (pos = 0; pos < 20000; pos += 2) {
+    num = random_number();
+    if (num < AGGSTAT_5_0) {
+      arr[pos] = (AGGSTAT_FLT)(int)(num * num / AGGSTAT_5_0);
+      tru[(int)arr[pos]] += 2;
+    } else {
+      arr[pos] = AGGSTAT_10_0 + (AGGSTAT_FLT)pos;
+    }
+
+    arr[pos + 1] = arr[pos];
+  }
+
+  ret = aggstat_frq_new(&frq[0], mem[0], 32) == true;
+  for (pos = 0; pos < 20000; pos += 1) {
+    aggstat_frq_put(&frq[0], arr[pos]);
+  }
+  aggstat_frq_put(&frq[0], (AGGSTAT_FLT)NAN);
+  check(res, "frq bounds", ret && bound_frq(&frq[0], tru, 20000));
+
+  // The runs of equal values of an array are counted at once, with the same result.
+  ret = aggstat_frq_new(&frq[1], mem[1], 32) == true;
+  aggstat_frq_put_arr(&frq[1], arr, 20000);
+  ret = ret && aggstat_frq_top(&frq[0], val[0], cnt[0], err[0], 32) == 32;
+  ret = ret && aggstat_frq_top(&frq[1], val[1], cnt[1], err[1], 32) == 32;
+  for (idx = 0; idx < 32; idx += 1) {
+    ret = ret && val[0][idx] == val[1][idx] && cnt[0][idx] == cnt[1][idx];
+    ret = ret && err[0][idx] == err[1][idx];
+  }
+  check(res, "put vs put_arr", ret);
+
+  // The merged halves retain the bounds of the whole stream.
+  ret = aggstat_frq_new(&frq[1], mem[1], 32) == true;
+  ret = ret && aggstat_frq_new(&frq[2], mem[2], 32) == true;
+  aggstat_frq_put_arr(&frq[1], arr, 10000);
+  aggstat_frq_put_arr(&frq[2], arr + 10000, 10000);
+  aggstat_frq_mrg(&frq[1], &frq[2]);
+  check(res, "merged bounds", ret && bound_frq(&frq[1], tru, 20000));
+
+  // The index of the counters must not overflow.
+  ret = aggstat_frq_new(&frq[2], mem[2], 0) == false;
+  ret = ret && aggstat_frq_new(&frq[2], mem[2], (uint32_t)1 << 31) == false;
+  ret = ret && aggstat_frq_new(&frq[2], NULL, 32) == false;
+  check(res, "invalid counters", ret);
+
+  free(mem[0]);
+  free(mem[1]);
+  free(mem[2]);
+}
+
+/// Compare the aggregates of the lanes of a bank to the aggregates of each lane updated on its own,
+/// which must be exactly equal.
+///
+/// @param[out] res result
+static void
+test_bnk(bool* res)
+{
+  struct aggstat_bnk bnk;
+  struct aggstat     agg[13];
+  AGGSTAT_FLT        row[13];
+  AGGSTAT_FLT        val[2][13];
+  AGGSTAT_FLT        mem[4 * 13];
+  uint32_t           lan;
+  uint32_t           pos;
+  uint8_t            fnc;
+  bool               ret;
+
+  // The number of lanes is not a multiple of any vector width. A lane of the minimum and maximum
+  // receives a value that is not a number, which is ignored as by the on-line algorithm.
+  ret = true;
+  for (fnc = AGGSTAT_FNC_FST; fnc <= AGGSTAT_FNC_KRT; fnc += 1) {
+    ret = ret && aggstat_bnk_new(&bnk, fnc, mem, 13) == true;
+    for (lan = 0; lan < 13; lan += 1) {
+      aggstat_new(&agg[lan], fnc, AGGSTAT_0_0);
+    }
+
+    for (pos = 0; pos < 500; pos += 1) {
+      for (lan = 0; lan < 13; lan += 1) {
+        row[lan] = random_number() * (AGGSTAT_FLT)(lan + 1) - AGGSTAT_5_0;
+      }
+
+      if (pos == 100 && (fnc == AGGSTAT_FNC_MIN || fnc == AGGSTAT_FNC_MAX)) {
+        row[5] = (AGGSTAT_FLT)NAN;
+      }
+
+      aggstat_bnk_put_row(&bnk, row);
+      for (lan = 0; lan < 13; lan += 1) {
+        aggstat_put(&agg[lan], row[lan]);
+      }
+    }
+
+    ret = ret && aggstat_bnk_get(&bnk, val[0]) == true;
+    for (lan = 0; lan < 13; lan += 1) {
+      ret = ret && aggstat_get(&agg[lan], &val[1][lan]) == true;
+      ret = ret && val[0][lan] == val[1][lan];
+    }
+  }
+  check(res, "bnk vs put", ret);
+
+  // The quantile, median and time-weighted functions are not supported.
+  ret = aggstat_bnk_new(&bnk, AGGSTAT_FNC_QNT, mem, 13) == false;
+  ret = ret && aggstat_bnk_new(&bnk, AGGSTAT_FNC_TWA, mem, 13) == false;
+  check(res, "unsupported function", ret);
+}
+
+/// Compare the quantiles computed by multiple threads to those of the off-line algorithm, which
+/// must be exactly equal.
+///
+/// @param[out] res result
+static void
+test_par(bool* res)
+{
+  AGGSTAT_FLT* arr;
+  AGGSTAT_FLT* cpy;
+  AGGSTAT_FLT  par[11];
+  AGGSTAT_FLT  val[2][11];
+  uint32_t     thr[6] = {0, 1, 2, 3, 8, 64};
+  size_t       idx;
+  size_t       num;
+  uint8_t      dup;
+  bool         ret;
+
+  arr = malloc(20000 * sizeof(AGGSTAT_FLT));
+  cpy = malloc(20000 * sizeof(AGGSTAT_FLT));
+  if (arr == NULL || cpy == NULL) {
+    free(arr);
+    free(cpy);
+    check(res, "memory", false);
+    return;
+  }
+
+  for (idx = 0; idx < 11; idx += 1) {
+    par[idx] = (AGGSTAT_FLT)idx / (AGGSTAT_FLT)10;
+  }
+
+  // The values are either distinct, or few distinct values are repeated so that the order
+  // statistics of several quantiles fall into the same bucket. The number of threads does not
+  // divide the length of the array.
+  ret = true;
+  for (dup = 0; dup < 2; dup += 1) {
+    for (idx = 0; idx < 20000; idx += 1) {
+      arr[idx] = random_number() - AGGSTAT_5_0;
+      if (dup == 1) {
+        arr[idx] = (AGGSTAT_FLT)(int)arr[idx];
+      }
+    }
+
+    for (idx = 0; idx < 11; idx += 1) {
+      (void)memcpy(cpy, arr, 20000 * sizeof(AGGSTAT_FLT));
+      ret = ret && aggstat_run(&val[1][idx], cpy, 20000, AGGSTAT_FNC_QNT, par[idx]) == true;
+    }
+
+    for (num = 0; num < 6; num += 1) {
+      (void)memcpy(cpy, arr, 20000 * sizeof(AGGSTAT_FLT));
+      ret = ret && aggstat_run_par(val[0], arr, 20000, par, 11, thr[num]) == true;
+      ret = ret && memcmp(arr, cpy, 20000 * sizeof(AGGSTAT_FLT)) == 0;
+      for (idx = 0; idx < 11; idx += 1) {
+        ret = ret && val[0][idx] == val[1][idx];
+      }
+    }
+  }
+  check(res, "par vs run", ret);
+
+  // More threads than values, and a single value.
+  ret = aggstat_run_par(val[0], arr, 3, par, 11, 8) == true;
+  for (idx = 0; idx < 11; idx += 1) {
+    (void)memcpy(cpy, arr, 3 * sizeof(AGGSTAT_FLT));
+    ret = ret && aggstat_run(&val[1][idx], cpy, 3, AGGSTAT_FNC_QNT, par[idx]) == true;
+    ret = ret && val[0][idx] == val[1][idx];
+  }
+  ret = ret && aggstat_run_par(val[0], arr, 1, par, 11, 4) == true;
+  for (idx = 0; idx < 11; idx += 1) {
+    ret = ret && val[0][idx] == arr[0];
+  }
+  check(res, "short arrays", ret);
+
+  // The array must not be empty and the parameters must be probabilities.
+  ret = aggstat_run_par(val[0], arr, 0, par, 11, 4) == false;
+  par[3] = AGGSTAT_1_0 + AGGSTAT_0_5;
+  ret = ret && aggstat_run_par(val[0], arr, 20000, par, 11, 4) == false;
+  check(res, "invalid requests", ret);
+
+  free(arr);
+  free(cpy);
+}
+
+/// Decode a half-precision or bfloat16 value from its fields.
+/// @return decoded value
+///
+/// @param[in] bit bit pattern
+/// @param[in] man number of mantissa bits
+/// @param[in] bia exponent bias
+static double
+decode_hlf(const uint16_t bit, const int man, const int bia)
+{
+  double sgn;
+  int    exp;
+  int    frc;
+
+  sgn = (bit & 0x8000) != 0 ? -1.0 : 1.0;
+  exp = (bit & 0x7fff) >> man;
+  frc = bit & ((1 << man) - 1);
+
+  if (exp == (0x7fff >> man)) {
+    return frc == 0 ? sgn * (double)INFINITY : (double)NAN;
+  }
+
+  if (exp == 0) {
+    return sgn * ldexp((double)frc, 1 - bia - man);
+  }
+
+  return sgn * ldexp((double)(frc + (1 << man)), exp - bia - man);
+}
+
+/// Compare the conversion of all half-precision and bfloat16 bit patterns to their values decoded
+/// from the fields, which must be exactly equal.
+///
+/// @param[out] res result
+static void
+test_hlf(bool* res)
+{
+  struct aggstat agg;
+  AGGSTAT_FLT    val[2];
+  AGGSTAT_FLT    blk[256];
+  uint16_t       arr[256];
+  uint32_t       bit;
+  uint32_t       idx;
+  bool           ret[2];
+
+  // Each pattern is converted on its own, including zeros of both signs, subnormal values,
+  // infinities and NaNs.
+  ret[0] = true;
+  ret[1] = true;
+  for (bit = 0; bit < 65536; bit += 1) {
+    arr[0] = (uint16_t)bit;
+
+    aggstat_new(&agg, AGGSTAT_FNC_LST, AGGSTAT_0_0);
+    aggstat_put_f16_arr(&agg, arr, 1);
+    val[1] = (AGGSTAT_FLT)decode_hlf(arr[0], 10, 15);
+    ret[0] = ret[0] && aggstat_get(&agg, &val[0]) == true;
+    ret[0] = ret[0] && (val[0] == val[1] || (isnan(val[0]) && isnan(val[1])));
+    ret[0] = ret[0] && (isnan(val[1]) || signbit(val[0]) == signbit(val[1]));
+
+    aggstat_new(&agg, AGGSTAT_FNC_LST, AGGSTAT_0_0);
+    aggstat_put_b16_arr(&agg, arr, 1);
+    val[1] = (AGGSTAT_FLT)decode_hlf(arr[0], 7, 127);
+    ret[1] = ret[1] && aggstat_get(&agg, &val[0]) == true;
+    ret[1] = ret[1] && (val[0] == val[1] || (isnan(val[0]) && isnan(val[1])));
+    ret[1] = ret[1] && (isnan(val[1]) || signbit(val[0]) == signbit(val[1]));
+  }
+  check(res, "f16 patterns", ret[0]);
+  check(res, "b16 patterns", ret[1]);
+
+  // The conversion in blocks yields quiet NaNs, which the maximum ignores, including those that
+  // were signaling.
+  ret[0] = true;
+  aggstat_new(&agg, AGGSTAT_FNC_MAX, AGGSTAT_0_0);
+  for (bit = 0; bit < 0x7f00; bit += 256) {
+    for (idx = 0; idx < 256; idx += 1) {
+      arr[idx] = (uint16_t)(bit + idx);
+    }
+
+    aggstat_put_f16_arr(&agg, arr, 256);
+  }
+  ret[0] = ret[0] && aggstat_get(&agg, &val[0]) == true && val[0] == (AGGSTAT_FLT)INFINITY;
+
+  aggstat_new(&agg, AGGSTAT_FNC_MAX, AGGSTAT_0_0);
+  for (bit = 0x7800; bit < 0x8000; bit += 256) {
+    for (idx = 0; idx < 256; idx += 1) {
+      arr[idx] = (uint16_t)(bit + idx);
+    }
+
+    aggstat_put_b16_arr(&agg, arr, 256);
+  }
+  ret[0] = ret[0] && aggstat_get(&agg, &val[0]) == true && val[0] == (AGGSTAT_FLT)INFINITY;
+
+  for (idx = 0; idx < 256; idx += 1) {
+    arr[idx] = (uint16_t)(0x7bff - idx);
+  }
+  ret[0] = ret[0] && aggstat_run_f16(&val[0], arr, 256, AGGSTAT_FNC_MAX, AGGSTAT_0_0) == true;
+  ret[0] = ret[0] && val[0] == (AGGSTAT_FLT)65504;
+  ret[0] = ret[0] && aggstat_run_b16(&val[0], arr, 256, AGGSTAT_FNC_CNT, AGGSTAT_0_0) == true;
+  ret[0] = ret[0] && val[0] == (AGGSTAT_FLT)256;
+  check(res, "blocks", ret[0]);
+
+  // The quantile and median functions are exact, and leave the array in its order.
+  ret[0] = true;
+  for (idx = 0; idx < 256; idx += 1) {
+    blk[idx] = (AGGSTAT_FLT)decode_hlf(arr[idx], 10, 15);
+  }
+  ret[0] = ret[0] && aggstat_run_f16(&val[0], arr, 256, AGGSTAT_FNC_QNT, AGGSTAT_0_9) == true;
+  ret[0] = ret[0] && aggstat_run(&val[1], blk, 256, AGGSTAT_FNC_QNT, AGGSTAT_0_9) == true;
+  ret[0] = ret[0] && val[0] == val[1];
+
+  for (idx = 0; idx < 256; idx += 1) {
+    blk[idx] = (AGGSTAT_FLT)decode_hlf(arr[idx], 7, 127);
+  }
+  ret[0] = ret[0] && aggstat_run_b16(&val[0], arr, 256, AGGSTAT_FNC_MED, AGGSTAT_0_0) == true;
+  ret[0] = ret[0] && aggstat_run(&val[1], blk, 256, AGGSTAT_FNC_MED, AGGSTAT_0_0) == true;
+  ret[0] = ret[0] && val[0] == val[1];
+
+  for (idx = 0; idx < 256; idx += 1) {
+    ret[0] = ret[0] && arr[idx] == (uint16_t)(0x7bff - idx);
+  }
+  ret[0] = ret[0] && aggstat_run_f16(&val[0], arr, 0, AGGSTAT_FNC_MED, AGGSTAT_0_0) == false;
+  check(res, "quantiles", ret[0]);
+}
+
+/// Compare the values decoded from a compressed block to the encoded values, which must be exactly
+/// equal after their conversion to double precision, and verify that malformed blocks fail.
+///
+/// @param[out] res result
+static void
+test_gor(bool* res)
+{
+  struct aggstat_gor gor;
+  struct aggstat     agg[2][3];
+  AGGSTAT_FLT        arr[3][3000];
+  AGGSTAT_FLT        val[2];
+  uint64_t           tim[3000];
+  uint64_t*          blk;
+  uint64_t           bad[5];
+  size_t             siz;
+  size_t             idx;
+  uint8_t            fnc[3] = {AGGSTAT_FNC_SUM, AGGSTAT_FNC_MAX, AGGSTAT_FNC_TWA};
+  bool               ret;
+
+  blk = malloc(AGGSTAT_GOR_SIZ(3000));
+  if (blk == NULL) {
+    check(res, "memory", false);
+    return;
+  }
+
+  // The timestamps mostly follow a regular interval with some jitter, and occasionally jump so
+  // that the widest code is needed. The values are repeated, have few meaningful bits, or are
+  // random, and one of them is infinite.
+  tim[0] = 1000000;
+  for (idx = 0; idx < 3000; idx += 1) {
+    if (idx > 0) {
+      tim[idx] = tim[idx - 1] + 10 + (idx % 7 == 0 ? 3 : 0) + (idx % 100 == 0 ? 100000 : 0);
+    }
+
+    if (idx % 5 == 0 && idx > 0) {
+      arr[0][idx] = arr[0][idx - 1];
+    } else if (idx % 3 == 0) {
+      arr[0][idx] = (AGGSTAT_FLT)(int)(random_number() * AGGSTAT_5_0);
+    } else {
+      arr[0][idx] = random_number() - AGGSTAT_5_0;
+    }
+  }
+  arr[0][1234] = (AGGSTAT_FLT)INFINITY;
+
+  ret = aggstat_gor_new(&gor, blk, AGGSTAT_GOR_SIZ(3000)) == true;
+  for (idx = 0; idx < 3000; idx += 1) {
+    ret = ret && aggstat_gor_put(&gor, tim[idx], arr[0][idx]) == true;
+  }
+
+  siz = aggstat_gor_siz(&gor);
+  ret = ret && siz <= AGGSTAT_GOR_SIZ(3000) && blk[0] == 3000;
+  ret = ret && aggstat_gor_dec(arr[1], arr[2], blk, siz) == true;
+  for (idx = 0; idx < 3000; idx += 1) {
+    ret = ret && arr[1][idx] == (AGGSTAT_FLT)tim[idx];
+    ret = ret && arr[2][idx] == (AGGSTAT_FLT)(double)arr[0][idx];
+  }
+  check(res, "round trip", ret);
+
+  // The timestamps are optional, and the aggregates of the block are those of the decoded arrays.
+  ret = aggstat_gor_dec(NULL, arr[2], blk, siz) == true;
+  for (idx = 0; idx < 3; idx += 1) {
+    aggstat_new(&agg[0][idx], fnc[idx], AGGSTAT_0_0);
+    aggstat_new(&agg[1][idx], fnc[idx], AGGSTAT_0_0);
+    aggstat_put_t_arr(&agg[1][idx], arr[1], arr[2], 3000);
+  }
+  ret = ret && aggstat_gor_agg(agg[0], 3, blk, siz) == true;
+  for (idx = 0; idx < 3; idx += 1) {
+    ret = ret && aggstat_get(&agg[0][idx], &val[0]) == aggstat_get(&agg[1][idx], &val[1]);
+    ret = ret && (val[0] == val[1] || (isnan(val[0]) && isnan(val[1])));
+  }
+  check(res, "aggregates", ret);
+
+  // A block of the given size holds at least the given number of values, and a value is appended
+  // only while the value of the largest size fits.
+  ret = aggstat_gor_new(&gor, blk, AGGSTAT_GOR_SIZ(10)) == true;
+  for (idx = 0; idx < 3000 && aggstat_gor_put(&gor, tim[idx], arr[0][idx]) == true; idx += 1) {
+  }
+  ret = ret && idx >= 10 && idx < 3000 && blk[0] == idx;
+  ret = ret && aggstat_gor_siz(&gor) <= AGGSTAT_GOR_SIZ(10);
+  ret = ret && aggstat_gor_dec(arr[1], arr[2], blk, aggstat_gor_siz(&gor)) == true;
+  ret = ret && arr[2][idx - 1] == (AGGSTAT_FLT)(double)arr[0][idx - 1];
+  ret = ret && aggstat_gor_new(&gor, blk, AGGSTAT_GOR_SIZ(1) - 1) == false;
+  ret = ret && aggstat_gor_new(&gor, NULL, AGGSTAT_GOR_SIZ(1)) == false;
+  check(res, "capacity", ret);
+
+  // A block that is truncated, or that claims more values than it holds, fails. The arrays hold
+  // the number of values that the block claims.
+  ret = aggstat_gor_dec(arr[1], arr[2], blk, 0) == false;
+  ret = ret && aggstat_gor_dec(arr[1], arr[2], NULL, siz) == false;
+  (void)aggstat_gor_new(&gor, blk, AGGSTAT_GOR_SIZ(3000));
+  for (idx = 0; idx < 1000; idx += 1) {
+    (void)aggstat_gor_put(&gor, tim[idx], arr[0][idx]);
+  }
+  siz = aggstat_gor_siz(&gor);
+  ret = ret && aggstat_gor_dec(arr[1], arr[2], blk, siz) == true;
+  ret = ret && aggstat_gor_dec(arr[1], arr[2], blk, siz - 64) == false;
+  blk[0] = 3000;
+  ret = ret && aggstat_gor_dec(arr[1], arr[2], blk, siz) == false;
+
+  // The value after the first one either reuses a window that was not established, or declares a
+  // window of 31 leading zero bits and 63 meaningful bits.
+  bad[0] = 2;
+  bad[1] = 1000;
+  bad[2] = 0;
+  bad[3] = (uint64_t)2 << 61;
+  bad[4] = 0;
+  ret = ret && aggstat_gor_dec(arr[1], arr[2], bad, sizeof(bad)) == false;
+  bad[3] = (uint64_t)0x1fff << 50;
+  ret = ret && aggstat_gor_dec(arr[1], arr[2], bad, sizeof(bad)) == false;
+  bad[3] = 0;
+  ret = ret && aggstat_gor_dec(arr[1], arr[2], bad, sizeof(bad)) == true;
+  check(res, "malformed blocks", ret);
+
+  free(blk);
+}
+
+/// Compare the forward-decayed aggregates to the weighted statistics computed from all values, and
+/// to the aggregates without decay for a rate of zero.
+///
+/// @param[out] res result
+static void
+test_fwd(bool* res)
+{
+  struct aggstat_fwd fwd[2];
+  struct aggstat     agg;
+  AGGSTAT_FLT        tim[3000];
+  AGGSTAT_FLT        arr[3000];
+  AGGSTAT_FLT        tru[7];
+  AGGSTAT_FLT        mnt[5];
+  AGGSTAT_FLT        val[2];
+  AGGSTAT_FLT        wgt;
+  AGGSTAT_FLT        dlt;
+  AGGSTAT_FLT        rat;
+  AGGSTAT_INT        idx;
+  uint8_t            fnc;
+  bool               ret;
+
+  // The timestamps span an exponent of 75, so that the landmark is moved several times.
+  for (idx = 0; idx < 3000; idx += 1) {
+    tim[idx] = (AGGSTAT_FLT)idx * AGGSTAT_0_5;
+    arr[idx] = random_number();
+  }
+
+  // A rate of zero yields the aggregates without decay, and the columns update the state exactly
+  // as the values one by one. The quantile is exactly representable, so that the desired positions
+  // of the markers are not rounded differently.
+  ret = true;
+  for (fnc = AGGSTAT_FNC_CNT; fnc <= AGGSTAT_FNC_MED; fnc += 1) {
+    if (fnc == AGGSTAT_FNC_MIN || fnc == AGGSTAT_FNC_MAX) {
+      continue;
+    }
+
+    ret = ret && aggstat_fwd_new(&fwd[0], fnc, AGGSTAT_0_75, AGGSTAT_0_0) == true;
+    ret = ret && aggstat_fwd_new(&fwd[1], fnc, AGGSTAT_0_75, AGGSTAT_0_0) == true;
+    aggstat_new(&agg, fnc, AGGSTAT_0_75);
+    for (idx = 0; idx < 3000; idx += 1) {
+      aggstat_fwd_put(&fwd[0], tim[idx], arr[idx]);
+      aggstat_put(&agg, arr[idx]);
+    }
+    aggstat_fwd_put_arr(&fwd[1], tim, arr, 3000);
+
+    ret = ret && memcmp(&fwd[0], &fwd[1], sizeof(fwd[0])) == 0;
+    ret = ret && aggstat_fwd_get(&fwd[0], tim[2999], &val[0]) == true;
+    ret = ret && aggstat_get(&agg, &val[1]) == true && near(val[0], val[1]);
+  }
+  check(res, "zero rate", ret);
+
+  // The weight of each value relative to the query follows from its distance to the query, and
+  // the moments are weighted central moments.
+  rat    = AGGSTAT_NUM(5, 0, -, 2);
+  mnt[0] = AGGSTAT_0_0;
+  mnt[1] = AGGSTAT_0_0;
+  for (idx = 0; idx < 3000; idx += 1) {
+    wgt     = AGGSTAT_EXP(rat * (tim[idx] - tim[2999]));
+    mnt[0] += wgt;
+    mnt[1] += wgt * arr[idx];
+  }
+
+  tru[0] = mnt[0] * AGGSTAT_EXP(-rat * AGGSTAT_2_0);
+  tru[1] = mnt[1] * AGGSTAT_EXP(-rat * AGGSTAT_2_0);
+  tru[2] = mnt[1] / mnt[0];
+
+  mnt[1] = AGGSTAT_0_0;
+  mnt[2] = AGGSTAT_0_0;
+  mnt[3] = AGGSTAT_0_0;
+  mnt[4] = AGGSTAT_0_0;
+  for (idx = 0; idx < 3000; idx += 1) {
+    wgt     = AGGSTAT_EXP(rat * (tim[idx] - tim[2999]));
+    dlt     = arr[idx] - tru[2];
+    mnt[1] += wgt * wgt;
+    mnt[2] += wgt * dlt * dlt;
+    mnt[3] += wgt * dlt * dlt * dlt;
+    mnt[4] += wgt * dlt * dlt * dlt * dlt;
+  }
+
+  tru[3] = mnt[2] / (mnt[0] - mnt[1] / mnt[0]);
+  tru[4] = AGGSTAT_SQRT(tru[3]);
+  tru[5] = AGGSTAT_SQRT(mnt[0]) * mnt[3] / AGGSTAT_POW(mnt[2], AGGSTAT_1_5);
+  tru[6] = mnt[0] * mnt[4] / (mnt[2] * mnt[2]) - AGGSTAT_3_0;
+
+  // The count and sum are queried two units of time after the last value.
+  ret = true;
+  for (fnc = AGGSTAT_FNC_CNT; fnc <= AGGSTAT_FNC_KRT; fnc += 1) {
+    if (fnc == AGGSTAT_FNC_MIN || fnc == AGGSTAT_FNC_MAX) {
+      continue;
+    }
+
+    ret = ret && aggstat_fwd_new(&fwd[0], fnc, AGGSTAT_0_0, rat) == true;
+    aggstat_fwd_put_arr(&fwd[0], tim, arr, 3000);
+    ret = ret && aggstat_fwd_get(&fwd[0], tim[2999] + AGGSTAT_2_0, &val[0]) == true;
+    ret = ret && near(val[0], tru[fnc < AGGSTAT_FNC_AVG ? fnc - AGGSTAT_FNC_CNT : fnc - 5]);
+  }
+  check(res, "decayed moments", ret);
+
+  // The relative weight of a value halves with every half-life, and the older values barely
+  // affect the median of the recent values, which are larger by ten.
+  ret = aggstat_fwd_new(&fwd[0], AGGSTAT_FNC_CNT, AGGSTAT_0_0, AGGSTAT_1_0) == true;
+  aggstat_fwd_put(&fwd[0], AGGSTAT_1_0, AGGSTAT_1_0);
+  ret = ret && aggstat_fwd_get(&fwd[0], AGGSTAT_NUM(1, 6931471805599453, +, 0), &val[0]) == true;
+  ret = ret && near(val[0], AGGSTAT_0_5);
+
+  ret = ret && aggstat_fwd_new(&fwd[0], AGGSTAT_FNC_MED, AGGSTAT_0_0, rat) == true;
+  for (idx = 0; idx < 3000; idx += 1) {
+    aggstat_fwd_put(&fwd[0], tim[idx], idx < 1500 ? arr[idx] : arr[idx] + AGGSTAT_NUM(10, 0, +, 0));
+  }
+  ret = ret && aggstat_fwd_get(&fwd[0], tim[2999], &val[0]) == true;
+  ret = ret && val[0] > AGGSTAT_NUM(13, 0, +, 0) && val[0] < AGGSTAT_NUM(17, 0, +, 0);
+  check(res, "decayed median", ret);
+
+  // The minimum, maximum, first, last and time-weighted functions are not supported, the rate
+  // must not be negative, and the aggregates of no values are defined only for count and sum.
+  ret = aggstat_fwd_new(&fwd[0], AGGSTAT_FNC_MIN, AGGSTAT_0_0, rat) == false;
+  ret = ret && aggstat_fwd_new(&fwd[0], AGGSTAT_FNC_FST, AGGSTAT_0_0, rat) == false;
+  ret = ret && aggstat_fwd_new(&fwd[0], AGGSTAT_FNC_TWA, AGGSTAT_0_0, rat) == false;
+  ret = ret && aggstat_fwd_new(&fwd[0], AGGSTAT_FNC_AVG, AGGSTAT_0_0, -rat) == false;
+  ret = ret && aggstat_fwd_new(&fwd[0], AGGSTAT_FNC_AVG, AGGSTAT_0_0, (AGGSTAT_FLT)NAN) == false;
+  ret = ret && aggstat_fwd_new(&fwd[0], AGGSTAT_FNC_SUM, AGGSTAT_0_0, rat) == true;
+  ret = ret && aggstat_fwd_get(&fwd[0], AGGSTAT_0_0, &val[0]) == true && val[0] == AGGSTAT_0_0;
+  ret = ret && aggstat_fwd_new(&fwd[0], AGGSTAT_FNC_AVG, AGGSTAT_0_0, rat) == true;
+  ret = ret && aggstat_fwd_get(&fwd[0], AGGSTAT_0_0, &val[0]) == false;
+  ret = ret && aggstat_fwd_new(&fwd[0], AGGSTAT_FNC_QNT, AGGSTAT_0_9, rat) == true;
+  ret = ret && aggstat_fwd_get(&fwd[0], AGGSTAT_0_0, &val[0]) == false;
+  check(res, "invalid aggregates", ret);
+}
+
+/// Writer of a snapshot in its own thread.
+struct snp_wrt {
+  struct aggstat_snp* sw_snp; ///< Snapshot.
+  uint32_t*           sw_don; ///< Number of writers that finished.
+  uint32_t            sw_idx; ///< Index of the first aggregate of the writer.
+  uint8_t             sw_pad[4]; ///< Padding (unused).
+};
+
+/// Update the aggregates of a writer, which are the count and sum of the same arrays of values
+/// updated together, and the sum of single values.
+/// @return NULL
+///
+/// @param[in] arg writer
+static void*
+write_snp(void* arg)
+{
+  struct snp_wrt* wrt;
+  struct aggstat* agg;
+  AGGSTAT_FLT     arr[64];
+  uint32_t        idx;
+
+  for (idx = 0; idx < 64; idx += 1) {
+    arr[idx] = AGGSTAT_2_0;
+  }
+
+  // The arrays are long enough that the writers are often within the copy that is retired, and
+  // the count of all values fits into the smallest integer type.
+  wrt = arg;
+  for (idx = 0; idx < 1000; idx += 1) {
+    agg = aggstat_snp_bgn(wrt->sw_snp);
+    aggstat_put_arr(&agg[wrt->sw_idx],     arr, 64);
+    aggstat_put_arr(&agg[wrt->sw_idx + 1], arr, 64);
+    aggstat_snp_end(wrt->sw_snp, agg);
+
+    aggstat_snp_put(wrt->sw_snp, wrt->sw_idx + 2, AGGSTAT_1_0);
+  }
+
+  (void)__atomic_fetch_add(wrt->sw_don, 1, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+/// Swap the copies of a snapshot while multiple threads write, and verify that each retired copy
+/// holds whole updates of the writers, and that no value is lost or counted twice.
+///
+/// @param[out] res result
+static void
+test_snp(bool* res)
+{
+  struct aggstat_snp    snp;
+  struct aggstat        ini[3 * 8];
+  struct snp_wrt        wrt[8];
+  const struct aggstat* out;
+  pthread_t             tid[8];
+  AGGSTAT_FLT           val[3];
+  AGGSTAT_FLT           tot[3 * 8];
+  void*                 mem;
+  uint32_t              thr[4] = {1, 2, 4, 8};
+  uint32_t              num;
+  uint32_t              idx;
+  uint32_t              don;
+  bool                  fin;
+  bool                  ret;
+
+  mem = malloc(AGGSTAT_SNP_SIZ(3 * 8));
+  if (mem == NULL) {
+    check(res, "memory", false);
+    return;
+  }
+
+  for (idx = 0; idx < 8; idx += 1) {
+    aggstat_new(&ini[3 * idx],     AGGSTAT_FNC_CNT, AGGSTAT_0_0);
+    aggstat_new(&ini[3 * idx + 1], AGGSTAT_FNC_SUM, AGGSTAT_0_0);
+    aggstat_new(&ini[3 * idx + 2], AGGSTAT_FNC_SUM, AGGSTAT_0_0);
+  }
+
+  // The reader swaps the copies until all writers finished, and a final swap retires the updates
+  // that remain in the active copy.
+  ret = true;
+  for (num = 0; num < 4; num += 1) {
+    ret = ret && aggstat_snp_new(&snp, ini, mem, 3 * thr[num]) == true;
+    (void)memset(tot, 0, sizeof(tot));
+    don = 0;
+    for (idx = 0; idx < thr[num]; idx += 1) {
+      wrt[idx].sw_snp = &snp;
+      wrt[idx].sw_don = &don;
+      wrt[idx].sw_idx = 3 * idx;
+      ret = ret && pthread_create(&tid[idx], NULL, write_snp, &wrt[idx]) == 0;
+    }
+
+    fin = false;
+    while (fin == false) {
+      fin = __atomic_load_n(&don, __ATOMIC_ACQUIRE) == thr[num];
+      out = aggstat_snp_swp(&snp);
+      for (idx = 0; idx < thr[num]; idx += 1) {
+        ret = ret && aggstat_get(&out[3 * idx],     &val[0]) == true;
+        ret = ret && aggstat_get(&out[3 * idx + 1], &val[1]) == true;
+        ret = ret && aggstat_get(&out[3 * idx + 2], &val[2]) == true;
+        ret = ret && val[1] == AGGSTAT_2_0 * val[0];
+
+        tot[3 * idx]     += val[0];
+        tot[3 * idx + 1] += val[1];
+        tot[3 * idx + 2] += val[2];
+      }
+    }
+
+    for (idx = 0; idx < thr[num]; idx += 1) {
+      ret = ret && pthread_join(tid[idx], NULL) == 0;
+      ret = ret && tot[3 * idx]     == (AGGSTAT_FLT)64000;
+      ret = ret && tot[3 * idx + 1] == (AGGSTAT_FLT)128000;
+      ret = ret && tot[3 * idx + 2] == (AGGSTAT_FLT)1000;
+    }
+  }
+  check(res, "concurrent swaps", ret);
+
+  // The retired copy is reset before it becomes active again.
+  ret = aggstat_snp_new(&snp, ini, mem, 3) == true;
+  aggstat_snp_put(&snp, 0, AGGSTAT_1_0);
+  out = aggstat_snp_swp(&snp);
+  ret = ret && aggstat_get(&out[0], &val[0]) == true && val[0] == AGGSTAT_1_0;
+  out = aggstat_snp_swp(&snp);
+  ret = ret && aggstat_get(&out[0], &val[0]) == true && val[0] == AGGSTAT_0_0;
+  out = aggstat_snp_swp(&snp);
+  ret = ret && aggstat_get(&out[0], &val[0]) == true && val[0] == AGGSTAT_0_0;
+  ret = ret && aggstat_snp_new(&snp, ini, mem, 0) == false;
+  ret = ret && aggstat_snp_new(&snp, NULL, mem, 3) == false;
+  check(res, "reset copies", ret);
+
+  free(mem);
+}
+
+/// Compare the counters of internal events to the events of known streams. The counters read as
+/// zero unless the counting is enabled.
+///
+/// @param[out] res result
+static void
+test_ctr(bool* res)
+{
+  struct aggstat_ctr ctr;
+  struct aggstat     agg;
+  AGGSTAT_FLT        arr[100];
+  AGGSTAT_INT        idx;
+  bool               ret;
+
+  for (idx = 0; idx < 100; idx += 1) {
+    arr[idx] = random_number();
+  }
+  arr[10] = (AGGSTAT_FLT)NAN;
+  arr[20] = (AGGSTAT_FLT)INFINITY;
+  arr[30] = -(AGGSTAT_FLT)INFINITY;
+
+  // Each value is counted once by each of the update functions, including a weighted value of
+  // the quantile, whose initial occurrences are inserted one by one.
+  aggstat_ctr_rst();
+  aggstat_new(&agg, AGGSTAT_FNC_SUM, AGGSTAT_0_0);
+  aggstat_put_arr(&agg, arr, 100);
+  aggstat_put(&agg, arr[10]);
+  aggstat_put_t(&agg, AGGSTAT_1_0, arr[20]);
+  aggstat_put_w(&agg, AGGSTAT_1_0, 50);
+  aggstat_new(&agg, AGGSTAT_FNC_MED, AGGSTAT_0_0);
+  aggstat_put_w(&agg, AGGSTAT_1_0, 50);
+  aggstat_put_w(&agg, AGGSTAT_2_0, 50);
+  aggstat_ctr_get(&ctr);
+
+#if AGGSTAT_CTR == 1
+  ret = ctr.ac_inp == 105 && ctr.ac_nan == 2 && ctr.ac_inf == 3;
+#else
+  ret = ctr.ac_inp == 0 && ctr.ac_nan == 0 && ctr.ac_inf == 0;
+#endif
+  check(res, "input counters", ret);
+
+  // Each movement of a quantile marker is estimated either by the parabola or by the line, and
+  // the line is needed for repeated values.
+  aggstat_ctr_rst();
+  aggstat_new(&agg, AGGSTAT_FNC_MED, AGGSTAT_0_0);
+  for (idx = 0; idx < 1000; idx += 1) {
+    aggstat_put(&agg, (AGGSTAT_FLT)(idx % 2));
+  }
+  aggstat_ctr_get(&ctr);
+
+#if AGGSTAT_CTR == 1
+  ret = ctr.ac_inp == 1000 && ctr.ac_mov > 0 && ctr.ac_lin > 0;
+  ret = ret && ctr.ac_prb + ctr.ac_lin == ctr.ac_mov;
+#else
+  ret = ctr.ac_mov == 0 && ctr.ac_prb == 0 && ctr.ac_lin == 0;
+#endif
+  check(res, "marker counters", ret);
+}
+
+/// Compare the time-weighted aggregates of short streams to their integrals and rates computed by
+/// hand, for all ways of updating, computing and merging them.
+///
+/// @param[out] res result
+static void
+test_tim(bool* res)
+{
+  struct aggstat agg[3];
+  AGGSTAT_FLT    tim[6] = {1, 3, 4, 4, 2, 10};
+  AGGSTAT_FLT    arr[6] = {2, 5, -1, 7, 3, 4};
+  AGGSTAT_FLT    rep[6] = {2, 2, 2, 5, -1, -1};
+  AGGSTAT_FLT    exp[3];
+  AGGSTAT_FLT    val;
+  AGGSTAT_INT    idx;
+  AGGSTAT_INT    spl;
+  uint8_t        fnc;
+  bool           ret;
+
+  // Each value is held until the next timestamp. The value at an equal timestamp and the value at
+  // an earlier timestamp replace the held value without any duration, so that the integral is
+  // 2 * 2 + 5 * 1 + 3 * 6 over the 9 units of time, and the rate is (4 - 2) / 9.
+  exp[0] = (AGGSTAT_FLT)3;
+  exp[1] = (AGGSTAT_FLT)27;
+  exp[2] = (AGGSTAT_FLT)2 / (AGGSTAT_FLT)9;
+
+  ret = true;
+  for (fnc = AGGSTAT_FNC_TWA; fnc <= AGGSTAT_FNC_RAT; fnc += 1) {
+    aggstat_new(&agg[0], fnc, AGGSTAT_0_0);
+    aggstat_new(&agg[1], fnc, AGGSTAT_0_0);
+    for (idx = 0; idx < 6; idx += 1) {
+      aggstat_put_t(&agg[0], tim[idx], arr[idx]);
+    }
+    aggstat_put_t_arr(&agg[1], tim, arr, 6);
+
+    ret = ret && aggstat_get(&agg[0], &val) == true && near(val, exp[fnc - AGGSTAT_FNC_TWA]);
+    ret = ret && aggstat_get(&agg[1], &val) == true && near(val, exp[fnc - AGGSTAT_FNC_TWA]);
+    ret = ret && aggstat_run_t(&val, tim, arr, 6, fnc, AGGSTAT_0_0) == true;
+    ret = ret && near(val, exp[fnc - AGGSTAT_FNC_TWA]);
+  }
+  check(res, "irregular timestamps", ret);
+
+  // The preceding stream holds its last value until the first timestamp of the succeeding stream,
+  // which is either equal to its last timestamp or later, and an empty stream adopts the other.
+  ret = true;
+  for (fnc = AGGSTAT_FNC_TWA; fnc <= AGGSTAT_FNC_RAT; fnc += 1) {
+    for (spl = 2; spl <= 3; spl += 1) {
+      aggstat_new(&agg[0], fnc, AGGSTAT_0_0);
+      aggstat_new(&agg[1], fnc, AGGSTAT_0_0);
+      aggstat_new(&agg[2], fnc, AGGSTAT_0_0);
+      aggstat_put_t_arr(&agg[0], tim, arr, spl);
+      aggstat_put_t_arr(&agg[1], tim + spl, arr + spl, 6 - spl);
+      ret = ret && aggstat_mrg(&agg[0], &agg[1]) == true;
+      ret = ret && aggstat_mrg(&agg[2], &agg[0]) == true;
+      ret = ret && aggstat_get(&agg[2], &val) == true && near(val, exp[fnc - AGGSTAT_FNC_TWA]);
+    }
+  }
+  check(res, "merged streams", ret);
+
+  // The timestamps of values without them are their positions, and a weighted value is held for
+  // the number of positions given by its weight.
+  aggstat_new(&agg[0], AGGSTAT_FNC_TWA, AGGSTAT_0_0);
+  aggstat_put(&agg[0], arr[0]);
+  aggstat_put(&agg[0], arr[1]);
+  aggstat_put(&agg[0], arr[2]);
+  ret = aggstat_get(&agg[0], &val) == true && val == (AGGSTAT_FLT)7 / AGGSTAT_2_0;
+  ret = ret && aggstat_run(&val, arr, 3, AGGSTAT_FNC_TWA, AGGSTAT_0_0) == true;
+  ret = ret && val == (AGGSTAT_FLT)7 / AGGSTAT_2_0;
+
+  exp[0] = AGGSTAT_2_0;
+  exp[1] = (AGGSTAT_FLT)10;
+  exp[2] = (AGGSTAT_FLT)-3 / AGGSTAT_5_0;
+  for (fnc = AGGSTAT_FNC_TWA; fnc <= AGGSTAT_FNC_RAT; fnc += 1) {
+    aggstat_new(&agg[0], fnc, AGGSTAT_0_0);
+    aggstat_new(&agg[1], fnc, AGGSTAT_0_0);
+    aggstat_put_w(&agg[0], arr[0], 3);
+    aggstat_put_w(&agg[0], arr[1], 1);
+    aggstat_put_w(&agg[0], arr[2], 2);
+    aggstat_put_arr(&agg[1], rep, 6);
+
+    ret = ret && aggstat_get(&agg[0], &val) == true && near(val, exp[fnc - AGGSTAT_FNC_TWA]);
+    ret = ret && aggstat_get(&agg[1], &val) == true && near(val, exp[fnc - AGGSTAT_FNC_TWA]);
+  }
+  check(res, "implicit timestamps", ret);
+
+  // A single timestamp has no duration: the average is the value, the integral is zero, and the
+  // rate is not defined.
+  aggstat_new(&agg[0], AGGSTAT_FNC_TWA, AGGSTAT_0_0);
+  aggstat_new(&agg[1], AGGSTAT_FNC_ITG, AGGSTAT_0_0);
+  aggstat_new(&agg[2], AGGSTAT_FNC_RAT, AGGSTAT_0_0);
+  ret = aggstat_get(&agg[0], &val) == false;
+  for (idx = 0; idx < 3; idx += 1) {
+    aggstat_put_t(&agg[idx], tim[0], arr[0]);
+    aggstat_put_t(&agg[idx], tim[0], arr[1]);
+  }
+  ret = ret && aggstat_get(&agg[0], &val) == true && val == arr[1];
+  ret = ret && aggstat_get(&agg[1], &val) == true && val == AGGSTAT_0_0;
+  ret = ret && aggstat_get(&agg[2], &val) == false;
+  check(res, "single timestamp", ret);
+}
+
 /// The goal of the test suite is to compare the on-line and off-line
 /// implementations of the aggregate functions and to determine the error
 /// between the two - and crucially - whether that error is of an acceptable
@@ -239,6 +2011,60 @@ main(void)
   (void)printf("med\n");
   test(&res, AGGSTAT_FNC_MED, AGGSTAT_0_0);
 
+  (void)printf("int\n");
+  test_int(&res);
+
+  (void)printf("wgt\n");
+  test_wgt(&res);
+
+  (void)printf("del\n");
+  test_del(&res);
+
+  (void)printf("vew\n");
+  test_vew(&res);
+
+  (void)printf("txt\n");
+  test_txt(&res);
+
+  (void)printf("many\n");
+  test_many(&res);
+
+  (void)printf("ooc\n");
+  test_ooc(&res);
+
+  (void)printf("buf\n");
+  test_buf(&res);
+
+  (void)printf("rol\n");
+  test_rol(&res);
+
+  (void)printf("frq\n");
+  test_frq(&res);
+
+  (void)printf("bnk\n");
+  test_bnk(&res);
+
+  (void)printf("par\n");
+  test_par(&res);
+
+  (void)printf("hlf\n");
+  test_hlf(&res);
+
+  (void)printf("gor\n");
+  test_gor(&res);
+
+  (void)printf("fwd\n");
+  test_fwd(&res);
+
+  (void)printf("snp\n");
+  test_snp(&res);
+
+  (void)printf("ctr\n");
+  test_ctr(&res);
+
+  (void)printf("tim\n");
+  test_tim(&res);
+
   // Ensure that the process succeeds only and only if all tests passed.
   if (res == true) {
     return EXIT_SUCCESS;
@@ -17,8 +17,8 @@ cd $(dirname $0)
 CC="cc"
 OPT="-flto -march=native -mtune=native"
 CFLAGS="-D_POSIX_C_SOURCE=201912 -std=c99 -Wall -Wextra -Werror"
-LDFLAGS="-lm"
-SRCS="err.c ../src/get.c ../src/put.c ../src/new.c ../src/run.c"
+LDFLAGS="-lm -lpthread"
+SRCS="err.c ../src/get.c ../src/put.c ../src/new.c ../src/run.c ../src/int.c ../src/del.c ../src/vew.c ../src/mrg.c ../src/txt.c ../src/ooc.c ../src/buf.c ../src/rol.c ../src/frq.c ../src/bnk.c ../src/par.c ../src/hlf.c ../src/gor.c ../src/fwd.c ../src/snp.c"
 ARGS="${CFLAGS} ${OPT} ${SRCS} ${LDFLAGS}"
 
 # Ensure all program invocations are logged.
@@ -52,6 +52,13 @@ ${CC} -DAGGSTAT_FLT_BIT=80 -DAGGSTAT_INT_BIT=64 -o bin/err_o0_f80_i64 -O0 ${ARGS
 ./bin/err_o0_f80_i32
 ./bin/err_o0_f80_i64
 
+# The counters of internal events are compiled out by default, and are tested
+# in a separate build that enables them.
+${CC} -DAGGSTAT_FLT_BIT=64 -DAGGSTAT_INT_BIT=64 -DAGGSTAT_CTR=1 -DAGGSTAT_STD=0 \
+  -o bin/err_o0_f64_i64_ctr -O0 ${ARGS}
+
+./bin/err_o0_f64_i64_ctr
+
 # The second part is mostly informational as to whether increased optimizations
 # and the fast math mode that disables full IEEE compliance, errno-setting, and
 # assumes all math is finite, still produces valid results within the expected
@@ -0,0 +1,170 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// The header must restore the definition of the macro by the including code.
+#define restrict __restrict__
+#include "../src/agg.hpp"
+#ifndef restrict
+  #error "the definition of restrict was not restored"
+#endif
+#undef restrict
+
+
+// Relative error tolerated between the streaming and the static algorithms.
+#if AGGSTAT_FLT_BIT == 32
+  #define TEST_EPS AGGSTAT_NUM(1, 0, -, 3)
+#else
+  #define TEST_EPS AGGSTAT_NUM(1, 0, -, 9)
+#endif
+
+/// Generate a next random number from the inclusive interval (0.0, 10.0).
+/// @return random number
+static AGGSTAT_FLT
+random_number()
+{
+  static uint32_t num = 77;
+  uint32_t per;
+
+  per = (uint32_t(1) << 31) - 1;
+  num = (num * 214013 + 2531011) & per;
+
+  return AGGSTAT_FLT(num) / AGGSTAT_FLT(per) * AGGSTAT_NUM(10, 0, +, 0);
+}
+
+/// Report the outcome of a single check.
+///
+/// @param[out] res result
+/// @param[in]  nam name of the check
+/// @param[in]  ret outcome of the check
+static void
+check(bool* res, const char* nam, const bool ret)
+{
+  if (ret == true) {
+    (void)std::printf("%*s -> \e[32mokay\e[0m\n", 24, nam);
+  } else {
+    (void)std::printf("%*s -> \e[31mfail\e[0m\n", 24, nam);
+  }
+
+  *res = *res && ret;
+}
+
+/// Determine whether two results are both defined and equal within the tolerated relative error.
+/// @return equality indication
+///
+/// @param[in] act actual result
+/// @param[in] exp expected result
+static bool
+near(const std::optional<AGGSTAT_FLT> act, const std::optional<AGGSTAT_FLT> exp)
+{
+  if (act.has_value() == false || exp.has_value() == false) {
+    return false;
+  }
+
+  return AGGSTAT_ABS(*act - *exp) <= TEST_EPS * AGGSTAT_FMAX(AGGSTAT_1_0, AGGSTAT_ABS(*exp));
+}
+
+/// Compare the inlined update of the stream to the update by the C API, which must produce the
+/// same state.
+/// @return success/failure indication
+///
+/// @param[in] arr values
+template <class F>
+static bool
+test_put(const std::vector<AGGSTAT_FLT>& arr)
+{
+  agg::stream<F> str;
+  struct aggstat agg;
+  AGGSTAT_FLT    val;
+
+  aggstat_new(&agg, F::fnc, AGGSTAT_0_0);
+  for (const AGGSTAT_FLT inp : arr) {
+    aggstat_put(&agg, inp);
+  }
+  str.put(std::span<const AGGSTAT_FLT>(arr));
+
+  return aggstat_get(&agg, &val) == true && str.get() == val
+      && agg::stream<F>(str.state()).get() == val;
+}
+
+/// Compare the aggregate of a span under the parallel execution policy to the static aggregate.
+/// @return success/failure indication
+///
+/// @param[in] arr values
+/// @param[in] par function parameter
+template <class F>
+static bool
+test_run(const std::vector<AGGSTAT_FLT>& arr, const AGGSTAT_FLT par = AGGSTAT_0_0)
+{
+  std::vector<AGGSTAT_FLT> cpy(arr);
+  std::optional<AGGSTAT_FLT> act;
+  std::optional<AGGSTAT_FLT> exp;
+
+  act = agg::run<F>(std::execution::par, arr, par);
+  exp = agg::run<F>(cpy, par);
+  return near(act, exp);
+}
+
+/// The goal of the test suite is to verify that the C++ layer produces the same results as the C
+/// functions that it wraps, in particular across the parts of the parallel static algorithm.
+int
+main()
+{
+  std::vector<AGGSTAT_FLT> arr(200000);
+  bool                     res;
+  bool                     ret;
+
+  res = true;
+
+  (void)std::printf(" *** FLT=%d INT=%d *** \n\n", AGGSTAT_FLT_BIT, AGGSTAT_INT_BIT);
+
+  // The span covers several parts of the parallel static algorithm, and its last part is partial.
+  for (AGGSTAT_FLT& inp : arr) {
+    inp = random_number();
+  }
+
+  (void)std::printf("stream\n");
+  ret = test_put<agg::fst>(arr) && test_put<agg::lst>(arr) && test_put<agg::cnt>(arr)
+     && test_put<agg::sum>(arr) && test_put<agg::min>(arr) && test_put<agg::max>(arr)
+     && test_put<agg::avg>(arr) && test_put<agg::var>(arr) && test_put<agg::dev>(arr)
+     && test_put<agg::skw>(arr) && test_put<agg::krt>(arr) && test_put<agg::twa>(arr);
+  check(&res, "stream vs put", ret);
+
+  (void)std::printf("run\n");
+  ret = test_run<agg::fst>(arr) && test_run<agg::lst>(arr) && test_run<agg::cnt>(arr)
+     && test_run<agg::sum>(arr) && test_run<agg::min>(arr) && test_run<agg::max>(arr)
+     && test_run<agg::avg>(arr) && test_run<agg::var>(arr) && test_run<agg::dev>(arr);
+  check(&res, "par vs run", ret);
+
+  ret = test_run<agg::twa>(arr) && test_run<agg::itg>(arr) && test_run<agg::rat>(arr);
+  check(&res, "par vs run (time)", ret);
+
+  ret = test_run<agg::qnt>(arr, AGGSTAT_0_9) && test_run<agg::med>(arr);
+  check(&res, "par vs run (qnt)", ret);
+
+#if AGGSTAT_CTR == 1
+  // The inlined updates are made by the C API, which counts every value.
+  (void)std::printf("ctr\n");
+  struct aggstat_ctr ctr;
+  agg::stream<agg::avg> avg;
+
+  aggstat_ctr_rst();
+  avg.put(std::span<const AGGSTAT_FLT>(arr));
+  avg.put(AGGSTAT_0_0, AGGSTAT_1_0);
+  aggstat_ctr_get(&ctr);
+  check(&res, "counted inputs", ctr.ac_inp == arr.size() + 1);
+#endif
+
+  // Ensure that the process succeeds only and only if all tests passed.
+  if (res == true) {
+    return EXIT_SUCCESS;
+  } else {
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,44 @@
+#!/bin/bash
+# Copyright (c) 2019-2021 Daniel Lovasko
+# All Rights Reserved
+#
+# Distributed under the terms of the 2-clause BSD License. The full
+# license is in the file LICENSE, distributed as part of this software.
+
+# Build and run the test of the C++ layer, which links the C sources compiled
+# for the same floating-point and integer types, once more with the counters of
+# internal events enabled.
+
+# Ensure that all relative paths remain correct.
+cd $(dirname $0)
+
+# C and C++ compilation settings.
+CC="cc"
+CXX="c++"
+OPT="-O2"
+CFLAGS="-D_POSIX_C_SOURCE=201912 -std=c99 -Wall -Wextra -Werror"
+CXXFLAGS="-std=c++20 -Wall -Wextra -Werror"
+DEFS="-DAGGSTAT_FLT_BIT=64 -DAGGSTAT_INT_BIT=64"
+LDFLAGS="-lm -lpthread -ltbb"
+SRCS="../src/get.c ../src/put.c ../src/new.c ../src/run.c ../src/int.c ../src/del.c ../src/vew.c ../src/mrg.c ../src/txt.c ../src/ooc.c ../src/buf.c ../src/rol.c ../src/frq.c ../src/bnk.c ../src/par.c ../src/hlf.c ../src/gor.c ../src/fwd.c ../src/snp.c"
+
+# Ensure all program invocations are logged.
+set -x
+set -e
+
+# Build and run the test with the given name and additional definitions.
+run_hpp() {
+  OBJS=""
+  for SRC in ${SRCS}; do
+    OBJ=bin/$1_$(basename ${SRC} .c).o
+    ${CC} ${CFLAGS} ${DEFS} $2 ${OPT} -c -o ${OBJ} ${SRC}
+    OBJS="${OBJS} ${OBJ}"
+  done
+
+  ${CXX} ${CXXFLAGS} ${DEFS} $2 ${OPT} -o bin/$1 hpp.cpp ${OBJS} ${LDFLAGS}
+
+  ./bin/$1
+}
+
+run_hpp hpp ""
+run_hpp hpp_ctr "-DAGGSTAT_CTR=1 -DAGGSTAT_STD=0"
@@ -0,0 +1,107 @@
+// Copyright (c) 2019-2021 Daniel Lovasko
+// All Rights Reserved
+//
+// Distributed under the terms of the 2-clause BSD License. The full
+// license is in the file LICENSE, distributed as part of this software.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../src/agg.h"
+
+
+// The file is compiled once for each pair of widths, and each compilation defines its own check,
+// suffixed by the widths. The compilation with TEST_MAIN defined calls all checks.
+#define TEST_CAT(F, I) test_f ## F ## _i ## I
+#define TEST_SYM(F, I) TEST_CAT(F, I)
+#define test_sfx       TEST_SYM(AGGSTAT_FLT_BIT, AGGSTAT_INT_BIT)
+
+/// Aggregate values by the instantiation of the library selected by this compilation.
+/// @return success/failure indication
+///
+/// The sum of 2^24 + 1 and zero is exact in the 64-bit floating-point type, whereas it is rounded
+/// to 2^24 in the 32-bit type, so that the result reveals the type of the instantiation.
+///
+/// @param[out] sum sum of the values
+/// @param[out] siz size of the aggregate
+bool
+test_sfx(double* sum, size_t* siz)
+{
+  struct aggstat agg;
+  AGGSTAT_FLT    arr[2];
+  AGGSTAT_FLT    val;
+  AGGSTAT_FLT    run;
+
+  arr[0] = (AGGSTAT_FLT)16777217.0;
+  arr[1] = AGGSTAT_0_0;
+
+  aggstat_new(&agg, AGGSTAT_FNC_SUM, AGGSTAT_0_0);
+  aggstat_put_arr(&agg, arr, 2);
+  if (aggstat_get(&agg, &val) == false) {
+    return false;
+  }
+
+  if (aggstat_run(&run, arr, 2, AGGSTAT_FNC_SUM, AGGSTAT_0_0) == false || run != val) {
+    return false;
+  }
+
+  *sum = (double)val;
+  *siz = sizeof(agg);
+  return true;
+}
+
+#ifdef TEST_MAIN
+
+bool test_f32_i32(double* sum, size_t* siz);
+bool test_f64_i64(double* sum, size_t* siz);
+
+/// Report the outcome of a single check.
+///
+/// @param[out] res result
+/// @param[in]  nam name of the check
+/// @param[in]  ret outcome of the check
+static void
+check(bool* res, const char* nam, const bool ret)
+{
+  if (ret == true) {
+    (void)printf("%*s -> \e[32mokay\e[0m\n", 24, nam);
+  } else {
+    (void)printf("%*s -> \e[31mfail\e[0m\n", 24, nam);
+  }
+
+  *res = *res && ret;
+}
+
+/// The goal of the test is to verify that two instantiations of the library with suffixed names
+/// link into a single binary, and that each of them computes in its own types.
+int
+main(void)
+{
+  double sum[2];
+  size_t siz[2];
+  bool   res;
+  bool   ret;
+
+  res = true;
+
+  (void)printf("sfx\n");
+  ret = test_f32_i32(&sum[0], &siz[0]) == true && sum[0] == 16777216.0;
+  check(&res, "f32 i32", ret);
+
+  ret = test_f64_i64(&sum[1], &siz[1]) == true && sum[1] == 16777217.0;
+  check(&res, "f64 i64", ret);
+
+  ret = siz[0] < siz[1];
+  check(&res, "sizes", ret);
+
+  // Ensure that the process succeeds only and only if all tests passed.
+  if (res == true) {
+    return EXIT_SUCCESS;
+  } else {
+    return EXIT_FAILURE;
+  }
+}
+
+#endif
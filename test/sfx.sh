@@ -0,0 +1,34 @@
+#!/bin/bash
+# Copyright (c) 2019-2021 Daniel Lovasko
+# All Rights Reserved
+#
+# Distributed under the terms of the 2-clause BSD License. The full
+# license is in the file LICENSE, distributed as part of this software.
+
+# Build the archive of all suffixed instantiations of the library, and link
+# two of them, with different floating-point and integer widths, into a
+# single test binary.
+
+# Ensure that all relative paths remain correct.
+cd $(dirname $0)
+
+# C compilation settings.
+CC="cc"
+OPT="-O2"
+CFLAGS="-D_POSIX_C_SOURCE=201912 -std=c99 -Wall -Wextra -Werror -DAGGSTAT_SFX=1"
+LDFLAGS="-lm"
+
+# Ensure all program invocations are logged.
+set -x
+set -e
+
+bash ../lib/lib.sh
+
+${CC} ${CFLAGS} ${OPT} -DAGGSTAT_FLT_BIT=32 -DAGGSTAT_INT_BIT=32 \
+  -c -o bin/sfx_f32_i32.o sfx.c
+${CC} ${CFLAGS} ${OPT} -DAGGSTAT_FLT_BIT=64 -DAGGSTAT_INT_BIT=64 -DTEST_MAIN \
+  -c -o bin/sfx_f64_i64.o sfx.c
+
+${CC} -o bin/sfx bin/sfx_f32_i32.o bin/sfx_f64_i64.o ../lib/bin/libaggstat.a ${LDFLAGS}
+
+./bin/sfx